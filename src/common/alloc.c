@@ -1,8 +1,17 @@
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <stdatomic.h>
 
 #include "errors.h"
+#include "alloc.h"
+
+// the macros in alloc.h are for callers, these are the ones under them
+#undef _REALLOC
+#undef _FREE
 
 #ifdef USE_GC
 #include "gc.h"
@@ -15,36 +24,56 @@
 #define _FREE free
 #endif
 
-void* _mem_alloc(size_t size) {
+#ifdef MEMORY_DEBUG
+static void track_alloc(void* ptr, size_t size, const char* file, int line);
+static bool track_free(void* ptr, const char* file, int line);
+#define TRACK_ALLOC(p, s, f, l) track_alloc((p), (s), (f), (l))
+#define TRACK_FREE(p, f, l) track_free((p), (f), (l))
+#else
+#define TRACK_ALLOC(p, s, f, l) ((void)(f), (void)(l))
+#define TRACK_FREE(p, f, l) ((void)(f), (void)(l), true)
+#endif
+
+/*
+ * The file and line are where the caller is, when it was built with
+ * MEMORY_DEBUG. Without it they are NULL and 0.
+ */
+void* _mem_alloc_at(size_t size, const char* file, int line) {
 
     void* ptr = _MALLOC(size);
     if(ptr == NULL)
         FATAL("cannot allocate %lu bytes", size);
 
     memset(ptr, 0, size);
+    TRACK_ALLOC(ptr, size, file, line);
     return ptr;
 }
 
-void* _mem_realloc(void* optr, size_t size) {
+void* _mem_realloc_at(void* optr, size_t size, const char* file, int line) {
+
+    if(optr != NULL && !TRACK_FREE(optr, file, line))
+        return _mem_alloc_at(size, file, line);
 
     void* nptr = _REALLOC(optr, size);
     if(nptr == NULL)
         FATAL("cannot re-allocate %lu bytes", size);
 
+    TRACK_ALLOC(nptr, size, file, line);
     return nptr;
 }
 
-void* _mem_copy(void* optr, size_t size) {
+void* _mem_copy_at(void* optr, size_t size, const char* file, int line) {
 
     void* nptr = _MALLOC(size);
     if(nptr == NULL)
         FATAL("cannot allocate to copy %lu bytes", size);
 
     memcpy(nptr, optr, size);
+    TRACK_ALLOC(nptr, size, file, line);
     return nptr;
 }
 
-char* _mem_copy_string(const char* str) {
+char* _mem_copy_string_at(const char* str, const char* file, int line) {
 
     size_t len;
     if(str != NULL)
@@ -61,11 +90,527 @@ char* _mem_copy_string(const char* str) {
     else
         ptr[0] = '\0';
 
+    TRACK_ALLOC(ptr, len, file, line);
     return ptr;
 }
 
-void _mem_free(void* ptr) {
+void _mem_free_at(void* ptr, const char* file, int line) {
 
-    if(ptr != NULL)
+    if(ptr != NULL && TRACK_FREE(ptr, file, line))
         _FREE(ptr);
 }
+
+void* _mem_alloc(size_t size) {
+
+    return _mem_alloc_at(size, NULL, 0);
+}
+
+void* _mem_realloc(void* optr, size_t size) {
+
+    return _mem_realloc_at(optr, size, NULL, 0);
+}
+
+void* _mem_copy(void* optr, size_t size) {
+
+    return _mem_copy_at(optr, size, NULL, 0);
+}
+
+char* _mem_copy_string(const char* str) {
+
+    return _mem_copy_string_at(str, NULL, 0);
+}
+
+void _mem_free(void* ptr) {
+
+    _mem_free_at(ptr, NULL, 0);
+}
+
+#ifdef MEMORY_DEBUG
+/*
+ * Every block that was handed out is kept in a table by its address, with
+ * its size and the call site that made it. A block that is freed stays in
+ * the table, marked, until malloc() hands out the address again, so a
+ * second free can say where the first one was. The call sites are kept in
+ * a second table with their counts. Both tables use malloc() directly and
+ * are never freed. One lock covers them, the scanner can run on a thread.
+ *
+ * At exit the sites are printed by peak bytes, and the blocks that are
+ * still live are printed by site as leaks.
+ */
+#define REPORT_SITES 20
+
+typedef struct {
+    const char* file;
+    int line;
+    long allocs;
+    long frees;
+    size_t live;
+    size_t peak;
+    size_t total;
+} alloc_site_t;
+
+typedef struct {
+    void* ptr;
+    size_t size;
+    alloc_site_t* site;
+    // where it was freed, NULL while it is live
+    const char* free_file;
+    int free_line;
+} alloc_block_t;
+
+typedef struct {
+    void* items;
+    int len;
+    int cap;
+} track_table_t;
+
+static track_table_t sites;
+static track_table_t blocks;
+static atomic_bool track_lock = false;
+static size_t live_bytes = 0;
+static size_t peak_bytes = 0;
+static long total_allocs = 0;
+static long bad_frees = 0;
+
+static inline size_t hash_ptr(const void* ptr) {
+
+    uintptr_t val = (uintptr_t)ptr;
+    val ^= val >> 33;
+    val *= 0xff51afd7ed558ccdULL;
+    val ^= val >> 33;
+    return (size_t)val;
+}
+
+static inline size_t hash_site(const char* file, int line) {
+
+    return hash_ptr(file) ^ ((size_t)line * 0x9e3779b97f4a7c15ULL);
+}
+
+static void lock_tracking(void) {
+
+    while(atomic_exchange_explicit(&track_lock, true, memory_order_acquire)) {
+    }
+}
+
+static void unlock_tracking(void) {
+
+    atomic_store_explicit(&track_lock, false, memory_order_release);
+}
+
+static alloc_site_t* find_site(const char* file, int line);
+static alloc_block_t* find_block(void* ptr);
+
+/*
+ * Double the table when it is half full. The entries are put back with
+ * the find function of the table.
+ */
+static void grow_table(track_table_t* tab, size_t item_size, bool is_sites) {
+
+    if(tab->len * 2 < tab->cap)
+        return;
+
+    track_table_t old = *tab;
+    tab->cap = (old.cap == 0) ? 1024 : old.cap * 2;
+    tab->len = 0;
+    tab->items = calloc(tab->cap, item_size);
+    if(tab->items == NULL)
+        FATAL("cannot allocate the memory tracking table");
+
+    for(int i = 0; i < old.cap; i++) {
+        if(is_sites) {
+            alloc_site_t* src = &((alloc_site_t*)old.items)[i];
+            if(src->file != NULL || src->line != 0)
+                *find_site(src->file, src->line) = *src;
+        }
+        else {
+            alloc_block_t* src = &((alloc_block_t*)old.items)[i];
+            if(src->ptr != NULL)
+                *find_block(src->ptr) = *src;
+        }
+    }
+    free(old.items);
+}
+
+/*
+ * Find the entry of a site or the empty slot for it. A site of NULL and 0
+ * is the callers that were not built with MEMORY_DEBUG, it is kept in its
+ * own entry.
+ */
+static alloc_site_t* find_site(const char* file, int line) {
+
+    static alloc_site_t unknown;
+    if(file == NULL)
+        return &unknown;
+
+    alloc_site_t* items = sites.items;
+    size_t mask = sites.cap - 1;
+    for(size_t i = hash_site(file, line) & mask;; i = (i + 1) & mask) {
+        if(items[i].file == NULL) {
+            items[i].file = file;
+            items[i].line = line;
+            sites.len++;
+            return &items[i];
+        }
+        if(items[i].line == line && (items[i].file == file || !strcmp(items[i].file, file)))
+            return &items[i];
+    }
+}
+
+static alloc_block_t* find_block(void* ptr) {
+
+    alloc_block_t* items = blocks.items;
+    size_t mask = blocks.cap - 1;
+    for(size_t i = hash_ptr(ptr) & mask;; i = (i + 1) & mask) {
+        if(items[i].ptr == NULL) {
+            items[i].ptr = ptr;
+            blocks.len++;
+            return &items[i];
+        }
+        if(items[i].ptr == ptr)
+            return &items[i];
+    }
+}
+
+static const char* site_to_str(const char* file, int line, char* buf, size_t size) {
+
+    if(file == NULL)
+        return "unknown";
+
+    snprintf(buf, size, "%s:%d", file, line);
+    return buf;
+}
+
+static int by_peak(const void* a, const void* b) {
+
+    size_t pa = (*(alloc_site_t**)a)->peak;
+    size_t pb = (*(alloc_site_t**)b)->peak;
+    return (pa < pb) ? 1 : (pa > pb) ? -1 : 0;
+}
+
+static int by_live(const void* a, const void* b) {
+
+    size_t la = (*(alloc_site_t**)a)->live;
+    size_t lb = (*(alloc_site_t**)b)->live;
+    return (la < lb) ? 1 : (la > lb) ? -1 : 0;
+}
+
+static void print_memory_report(void) {
+
+    lock_tracking();
+
+    int nsites = 0;
+    alloc_site_t** list = malloc((sites.cap + 1) * sizeof(alloc_site_t*));
+    for(int i = 0; i < sites.cap; i++)
+        if(((alloc_site_t*)sites.items)[i].file != NULL)
+            list[nsites++] = &((alloc_site_t*)sites.items)[i];
+    alloc_site_t* unknown = find_site(NULL, 0);
+    if(unknown->allocs > 0)
+        list[nsites++] = unknown;
+
+    long leaks = 0;
+    for(int i = 0; i < blocks.cap; i++) {
+        alloc_block_t* blk = &((alloc_block_t*)blocks.items)[i];
+        if(blk->ptr != NULL && blk->free_file == NULL && blk->site != NULL)
+            leaks++;
+    }
+
+    char buf[256];
+    fprintf(stderr, "memory: %ld allocations from %d sites, peak %zu bytes, %zu bytes in %ld blocks live at exit, "
+            "%ld bad frees\n", total_allocs, nsites, peak_bytes, live_bytes, leaks, bad_frees);
+
+    qsort(list, nsites, sizeof(alloc_site_t*), by_peak);
+    fprintf(stderr, "top allocators by peak bytes:\n");
+    fprintf(stderr, "%12s %12s %12s %10s %10s  %s\n", "peak", "live", "total", "allocs", "frees", "site");
+    for(int i = 0; i < nsites && i < REPORT_SITES; i++)
+        fprintf(stderr, "%12zu %12zu %12zu %10ld %10ld  %s\n", list[i]->peak, list[i]->live, list[i]->total,
+                list[i]->allocs, list[i]->frees, site_to_str(list[i]->file, list[i]->line, buf, sizeof(buf)));
+
+    qsort(list, nsites, sizeof(alloc_site_t*), by_live);
+    if(nsites > 0 && list[0]->live > 0) {
+        fprintf(stderr, "leaks by site:\n");
+        for(int i = 0; i < nsites && i < REPORT_SITES && list[i]->live > 0; i++)
+            fprintf(stderr, "%12zu bytes in %ld blocks  %s\n", list[i]->live, list[i]->allocs - list[i]->frees,
+                    site_to_str(list[i]->file, list[i]->line, buf, sizeof(buf)));
+    }
+
+    free(list);
+    unlock_tracking();
+}
+
+static void track_alloc(void* ptr, size_t size, const char* file, int line) {
+
+    lock_tracking();
+
+    if(blocks.cap == 0)
+        atexit(print_memory_report);
+    grow_table(&sites, sizeof(alloc_site_t), true);
+    grow_table(&blocks, sizeof(alloc_block_t), false);
+
+    alloc_site_t* site = find_site(file, line);
+    site->allocs++;
+    site->total += size;
+    site->live += size;
+    if(site->live > site->peak)
+        site->peak = site->live;
+
+    alloc_block_t* blk = find_block(ptr);
+    blk->size = size;
+    blk->site = site;
+    blk->free_file = NULL;
+    blk->free_line = 0;
+
+    total_allocs++;
+    live_bytes += size;
+    if(live_bytes > peak_bytes)
+        peak_bytes = live_bytes;
+
+    unlock_tracking();
+}
+
+/*
+ * Returns false when the block is not live, then it must not be given to
+ * free().
+ */
+static bool track_free(void* ptr, const char* file, int line) {
+
+    char here[256];
+    char there[256];
+    bool live = false;
+
+    lock_tracking();
+    alloc_block_t* blk = (blocks.cap > 0) ? find_block(ptr) : NULL;
+    if(blk == NULL || blk->site == NULL) {
+        // find_block() made an entry for it, it was never allocated here
+        if(blk != NULL) {
+            blk->ptr = NULL;
+            blocks.len--;
+        }
+        fprintf(stderr, "memory: %s: free of a block that was not allocated: %p\n",
+                site_to_str(file, line, here, sizeof(here)), ptr);
+        bad_frees++;
+    }
+    else if(blk->free_file != NULL) {
+        fprintf(stderr, "memory: %s: double free of %zu bytes from %s, first freed at %s:%d\n",
+                site_to_str(file, line, here, sizeof(here)), blk->size,
+                site_to_str(blk->site->file, blk->site->line, there, sizeof(there)), blk->free_file, blk->free_line);
+        bad_frees++;
+    }
+    else {
+        blk->free_file = (file != NULL) ? file : "unknown";
+        blk->free_line = line;
+        blk->site->frees++;
+        blk->site->live -= blk->size;
+        live_bytes -= blk->size;
+        live = true;
+    }
+    unlock_tracking();
+
+    return live;
+}
+#endif
+
+/*
+ * Slabs for small objects of a fixed size that are made and destroyed all
+ * through a compile, like tokens and hash nodes. Sizes are rounded up to a
+ * class of 16 bytes, up to SLAB_MAX_SIZE. Each class carves page sized
+ * slabs into objects and keeps the free ones on a list, so an object that
+ * is freed is the next one handed out. Slabs are never given back.
+ *
+ * Each thread keeps a short list of its own for every class, which takes
+ * no lock. It is filled from and spilled to the shared list a batch at a
+ * time. A thread that ends must call flush_slab_cache().
+ *
+ * Build with NO_SLAB to send everything to malloc(), for a memory checker.
+ * MEMORY_DEBUG does the same, so that each object is tracked.
+ */
+#if !defined(NO_SLAB) && !defined(MEMORY_DEBUG)
+
+#define SLAB_SIZE 4096
+#define SLAB_STEP 16
+#define SLAB_CLASSES (SLAB_MAX_SIZE / SLAB_STEP)
+// objects moved between a thread and the shared list at a time
+#define SLAB_BATCH 32
+
+typedef struct _slab_object_t_ {
+    struct _slab_object_t_* next;
+} slab_object_t;
+
+typedef struct {
+    atomic_bool lock;
+    slab_object_t* free;
+    int slabs;
+    _Atomic long allocs;
+    _Atomic long frees;
+} slab_class_t;
+
+typedef struct {
+    slab_object_t* free;
+    int count;
+} slab_cache_t;
+
+static slab_class_t slab_classes[SLAB_CLASSES];
+static __thread slab_cache_t slab_cache[SLAB_CLASSES];
+
+static inline int slab_class(size_t size) {
+
+    return (size == 0) ? 0 : (int)((size - 1) / SLAB_STEP);
+}
+
+static void lock_slab_class(slab_class_t* cls) {
+
+    while(atomic_exchange_explicit(&cls->lock, true, memory_order_acquire)) {
+    }
+}
+
+static void unlock_slab_class(slab_class_t* cls) {
+
+    atomic_store_explicit(&cls->lock, false, memory_order_release);
+}
+
+/*
+ * Carve a new slab into objects and put them on the shared list. The lock
+ * is held.
+ */
+static void grow_slab_class(slab_class_t* cls, size_t size) {
+
+    char* slab = _MALLOC(SLAB_SIZE);
+    if(slab == NULL)
+        FATAL("cannot allocate a slab of %d bytes", SLAB_SIZE);
+
+    for(size_t offset = 0; offset + size <= SLAB_SIZE; offset += size) {
+        slab_object_t* obj = (slab_object_t*)&slab[offset];
+        obj->next = cls->free;
+        cls->free = obj;
+    }
+    cls->slabs++;
+}
+
+static void fill_slab_cache(int idx) {
+
+    slab_class_t* cls = &slab_classes[idx];
+    slab_cache_t* cache = &slab_cache[idx];
+
+    lock_slab_class(cls);
+    while(cache->count < SLAB_BATCH) {
+        if(cls->free == NULL)
+            grow_slab_class(cls, (size_t)(idx + 1) * SLAB_STEP);
+        slab_object_t* obj = cls->free;
+        cls->free = obj->next;
+        obj->next = cache->free;
+        cache->free = obj;
+        cache->count++;
+    }
+    unlock_slab_class(cls);
+}
+
+static void spill_slab_cache(int idx, int keep) {
+
+    slab_class_t* cls = &slab_classes[idx];
+    slab_cache_t* cache = &slab_cache[idx];
+
+    lock_slab_class(cls);
+    while(cache->count > keep) {
+        slab_object_t* obj = cache->free;
+        cache->free = obj->next;
+        obj->next = cls->free;
+        cls->free = obj;
+        cache->count--;
+    }
+    unlock_slab_class(cls);
+}
+
+void* _slab_alloc(size_t size) {
+
+    if(size > SLAB_MAX_SIZE)
+        return _mem_alloc(size);
+
+    int idx = slab_class(size);
+    slab_cache_t* cache = &slab_cache[idx];
+    if(cache->free == NULL)
+        fill_slab_cache(idx);
+
+    slab_object_t* obj = cache->free;
+    cache->free = obj->next;
+    cache->count--;
+    atomic_fetch_add_explicit(&slab_classes[idx].allocs, 1, memory_order_relaxed);
+
+    memset(obj, 0, size);
+    return obj;
+}
+
+void _slab_free(void* ptr, size_t size) {
+
+    if(ptr == NULL)
+        return;
+
+    if(size > SLAB_MAX_SIZE) {
+        _mem_free(ptr);
+        return;
+    }
+
+    int idx = slab_class(size);
+    slab_cache_t* cache = &slab_cache[idx];
+    slab_object_t* obj = ptr;
+    obj->next = cache->free;
+    cache->free = obj;
+    cache->count++;
+    atomic_fetch_add_explicit(&slab_classes[idx].frees, 1, memory_order_relaxed);
+
+    if(cache->count > 2 * SLAB_BATCH)
+        spill_slab_cache(idx, SLAB_BATCH);
+}
+
+/*
+ * Give the objects that this thread keeps back to the shared lists.
+ */
+void flush_slab_cache(void) {
+
+    for(int i = 0; i < SLAB_CLASSES; i++)
+        if(slab_cache[i].count > 0)
+            spill_slab_cache(i, 0);
+}
+
+/*
+ * Print the occupancy of each class that has a slab. Objects are the ones
+ * carved, live are the ones in use now and reused is how many times an
+ * object that was freed was handed out again.
+ */
+void print_slab_stats(FILE* fp) {
+
+    fprintf(fp, "%6s %6s %8s %8s %10s %10s\n", "size", "slabs", "objects", "live", "allocs", "reused");
+    for(int i = 0; i < SLAB_CLASSES; i++) {
+        slab_class_t* cls = &slab_classes[i];
+        if(cls->slabs == 0)
+            continue;
+
+        size_t size = (size_t)(i + 1) * SLAB_STEP;
+        long objects = (long)cls->slabs * (SLAB_SIZE / size);
+        long allocs = atomic_load(&cls->allocs);
+        long live = allocs - atomic_load(&cls->frees);
+        long reused = (allocs > objects) ? allocs - objects : 0;
+        fprintf(fp, "%6zu %6d %8ld %8ld %10ld %10ld\n", size, cls->slabs, objects, live, allocs, reused);
+    }
+}
+
+#else
+
+void* _slab_alloc(size_t size) {
+
+    return _mem_alloc(size);
+}
+
+void _slab_free(void* ptr, size_t size) {
+
+    (void)size;
+    _mem_free(ptr);
+}
+
+void flush_slab_cache(void) {
+}
+
+void print_slab_stats(FILE* fp) {
+
+    fprintf(fp, "slabs are off in this build\n");
+}
+
+#endif
@@ -2,8 +2,22 @@
 #ifndef _ALLOC_H_
 #define _ALLOC_H_
 
+#include <stdio.h>
 #include <stddef.h>
 
+#ifdef MEMORY_DEBUG
+// every block is tracked by the call site that made it, see alloc.c
+#define _ALLOC(s) _mem_alloc_at((s), __FILE__, __LINE__)
+#define _ALLOC_TYPE(t) (t*)_mem_alloc_at(sizeof(t), __FILE__, __LINE__)
+#define _ALLOC_ARRAY(t, n) (t*)_mem_alloc_at(sizeof(t) * (n), __FILE__, __LINE__)
+#define _REALLOC(p, s) _mem_realloc_at((void*)(p), (s), __FILE__, __LINE__)
+#define _REALLOC_ARRAY(p, t, n) (t*)_mem_realloc_at((void*)(p), sizeof(t) * (n), __FILE__, __LINE__)
+#define _COPY(p, s) _mem_copy_at((void*)(p), (s), __FILE__, __LINE__)
+#define _COPY_TYPE(p, t) (t*)_mem_copy_at((void*)(p), sizeof(t), __FILE__, __LINE__)
+#define _COPY_ARRAY(p, t, n) (t*)_mem_copy_at((void*)(p), sizeof(t) * (n), __FILE__, __LINE__)
+#define _COPY_STRING(s) _mem_copy_string_at((s), __FILE__, __LINE__)
+#define _FREE(p) _mem_free_at((void*)(p), __FILE__, __LINE__)
+#else
 #define _ALLOC(s) _mem_alloc(s)
 #define _ALLOC_TYPE(t) (t*)_mem_alloc(sizeof(t))
 #define _ALLOC_ARRAY(t, n) (t*)_mem_alloc(sizeof(t) * (n))
@@ -14,11 +28,31 @@
 #define _COPY_ARRAY(p, t, n) (t*)_mem_copy((void*)(p), sizeof(t) * (n))
 #define _COPY_STRING(s) _mem_copy_string(s)
 #define _FREE(p) _mem_free((void*)(p))
+#endif
+
+// fixed size objects that come and go, see alloc.c
+#define SLAB_MAX_SIZE 256
+#ifdef MEMORY_DEBUG
+#define _ALLOC_SLAB(t) (t*)_mem_alloc_at(sizeof(t), __FILE__, __LINE__)
+#define _FREE_SLAB(p, t) _mem_free_at((void*)(p), __FILE__, __LINE__)
+#else
+#define _ALLOC_SLAB(t) (t*)_slab_alloc(sizeof(t))
+#define _FREE_SLAB(p, t) _slab_free((void*)(p), sizeof(t))
+#endif
 
 void* _mem_alloc(size_t);
 void* _mem_realloc(void*, size_t);
 void* _mem_copy(void*, size_t);
 char* _mem_copy_string(const char*);
 void _mem_free(void*);
+void* _mem_alloc_at(size_t, const char*, int);
+void* _mem_realloc_at(void*, size_t, const char*, int);
+void* _mem_copy_at(void*, size_t, const char*, int);
+char* _mem_copy_string_at(const char*, const char*, int);
+void _mem_free_at(void*, const char*, int);
+void* _slab_alloc(size_t);
+void _slab_free(void*, size_t);
+void flush_slab_cache(void);
+void print_slab_stats(FILE* fp);
 
 #endif /* _ALLOC_H_ */
@@ -269,7 +269,9 @@ void destroy_cmdline(void) {
             _FREE(ptr);
         }
 
+        destroy_ptr_list(cmdline->args);
         _FREE(cmdline);
+        cmdline = NULL;
     }
 }
 
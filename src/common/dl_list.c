@@ -25,7 +25,7 @@ void destroy_dl_list(dl_list_t* lst) {
 
 dl_list_node_t* create_dl_list_node(void* data, size_t size) {
 
-    dl_list_node_t* ptr = _ALLOC_TYPE(dl_list_node_t);
+    dl_list_node_t* ptr = _ALLOC_SLAB(dl_list_node_t);
     ptr->data = _COPY(data, size);
     ptr->size = size;
 
@@ -35,7 +35,7 @@ dl_list_node_t* create_dl_list_node(void* data, size_t size) {
 void destroy_dl_list_node(dl_list_node_t* node) {
 
     _FREE(node->data);
-    _FREE(node);
+    _FREE_SLAB(node, dl_list_node_t);
 }
 
 
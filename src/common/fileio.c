@@ -7,9 +7,11 @@
 #include <glob.h>
 #include <sys/stat.h>
 #include <limits.h>
+#include <unistd.h>
 
 #include "string_list.h"
 #include "pointer_list.h"
+#include "hash.h"
 #include "alloc.h"
 #include "errors.h"
 
@@ -19,6 +21,12 @@ static const char* base_file_name = NULL;
 static string_list_t* common_env = NULL;
 static char buffer[_POSIX_PATH_MAX]; // returning a pointer to this
 
+// files that have been found, by the directory the search was made in and
+// the name that was searched for
+static hash_table_t* found_files = NULL;
+// the directory that the search path was made in, since it is relative
+static char* env_dir = NULL;
+
 /**
  * @brief Handle errors around realpath().
  *
@@ -102,9 +110,10 @@ static bool file_exists(const char* fname) {
  * @brief Create the internal finder path environment.
  *
  */
-static void setup_env(void) {
+static void setup_env(const char* cwd) {
 
     common_env = create_string_list();
+    env_dir = _COPY_STRING(cwd);
 
     add_env("TOY_PATH");
     add_dirs("..");
@@ -114,6 +123,11 @@ static void setup_env(void) {
 /**
  * @brief Find a file. Returns the full path given just the name.
  *
+ * The result is remembered, so a process that finds the same file many times
+ * only walks the search path once. A remembered file that has gone away is
+ * searched for again. The search path and what is remembered belong to the
+ * current directory, which the compile server changes for every request.
+ *
  * @param fname
  * @return const char*
  */
@@ -135,8 +149,36 @@ const char* find_file(const char* fname, const char* ext) {
 
     TRACE("searching for \"%s\"", tmp_name);
 
+    char cwd[_POSIX_PATH_MAX];
+    if(NULL == getcwd(cwd, sizeof(cwd)))
+        FATAL("cannot get the current directory: %s", strerror(errno));
+
+    if(found_files == NULL)
+        found_files = create_hashtable();
+
+    char* key = _ALLOC(strlen(cwd) + strlen(tmp_name) + 2);
+    sprintf(key, "%s:%s", cwd, tmp_name);
+
+    void* data;
+    if(find_hashtable(found_files, key, &data)) {
+        if(file_exists(data)) {
+            TRACE("remembered: %s", (char*)data);
+            _FREE(key);
+            _FREE(tmp_name);
+            RETURN(data);
+        }
+        remove_hashtable(found_files, key);
+        _FREE(data);
+    }
+
+    if(common_env != NULL && strcmp(env_dir, cwd)) {
+        destroy_string_list(common_env);
+        _FREE(env_dir);
+        common_env = NULL;
+    }
+
     if(common_env == NULL)
-        setup_env();
+        setup_env(cwd);
 
     int mark = 0;
     string_t* s;
@@ -154,6 +196,9 @@ const char* find_file(const char* fname, const char* ext) {
         }
     }
 
+    if(found != NULL)
+        insert_hashtable(found_files, key, found);
+    _FREE(key);
     _FREE(tmp_name);
 
     if(found == NULL)
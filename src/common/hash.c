@@ -124,7 +124,7 @@ void destroy_hashtable(hash_table_t* table) {
                     _FREE(table->table[i]->key);
                 }
             }
-            _FREE(table->table[i]);
+            _FREE_SLAB(table->table[i], _hash_node_t);
         }
 
         _FREE(table->table);
@@ -150,7 +150,7 @@ int insert_hashtable(hash_table_t* table, const char* key, void* data) {
         }
     }
     else {
-        table->table[slot] = _ALLOC_TYPE(_hash_node_t);
+        table->table[slot] = _ALLOC_SLAB(_hash_node_t);
     }
 
     table->table[slot]->key = _COPY_STRING(key);
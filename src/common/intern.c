@@ -0,0 +1,63 @@
+/*
+ * The intern table is a regular hash table where the data for each key is
+ * the canonical copy of the string. Interned strings live until the table
+ * is destroyed.
+ */
+#include <stddef.h>
+
+#include "alloc.h"
+#include "hash.h"
+#include "intern.h"
+
+static hash_table_t* intern_table = NULL;
+
+/*
+ * Return the canonical copy of the string. The same pointer is returned for
+ * every string with the same contents.
+ */
+const char* intern_string(const char* str) {
+
+    void* data;
+
+    if(str == NULL)
+        return NULL;
+
+    if(intern_table == NULL)
+        intern_table = create_hashtable();
+
+    if(find_hashtable(intern_table, str, &data))
+        return (const char*)data;
+
+    char* ptr = _COPY_STRING(str);
+    insert_hashtable(intern_table, str, ptr);
+
+    return ptr;
+}
+
+/*
+ * Return the number of distinct strings that have been interned.
+ */
+int len_intern_table(void) {
+
+    if(intern_table != NULL)
+        return intern_table->count;
+    else
+        return 0;
+}
+
+/*
+ * Free all of the interned strings. Any pointer that was returned by
+ * intern_string() is invalid after this.
+ */
+void destroy_intern_table(void) {
+
+    if(intern_table != NULL) {
+        for(int i = 0; i < intern_table->cap; i++) {
+            if(intern_table->table[i] != NULL && intern_table->table[i]->key != NULL)
+                _FREE(intern_table->table[i]->data);
+        }
+
+        destroy_hashtable(intern_table);
+        intern_table = NULL;
+    }
+}
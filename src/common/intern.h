@@ -0,0 +1,17 @@
+/**
+ * @file intern.h
+ *
+ * @brief String interning. Every distinct string is stored exactly once,
+ * so two interned strings are equal if and only if their pointers are
+ * equal. Names are interned when they are resolved so that the symbol
+ * table never has to call strcmp().
+ *
+ */
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+const char* intern_string(const char* str);
+int len_intern_table(void);
+void destroy_intern_table(void);
+
+#endif /* _INTERN_H_ */
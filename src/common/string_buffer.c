@@ -1,4 +1,12 @@
-
+/*
+ * A string buffer keeps its length, so appending copies only the new
+ * characters. The capacity doubles when it runs out, which makes building
+ * a string of n characters O(n) no matter how it is appended. The buffer
+ * is always terminated so raw_string() can be handed to the C library.
+ *
+ * Benchmark build string:
+ * gcc -O2 -DBENCH_STRING -o bs string_buffer.c alloc.c
+ */
 #include <string.h>
 #include <stdarg.h>
 #include <ctype.h>
@@ -6,12 +14,29 @@
 #include "alloc.h"
 #include "string_buffer.h"
 
+// #define BENCH_STRING
+
+#define MIN_CAPACITY (1 << 3)
+
+/*
+ * Make room for len more characters and the terminator.
+ */
+static void grow_string(string_t* buf, int len) {
+
+    if(buf->len + len + 1 > buf->cap) {
+        while(buf->len + len + 1 > buf->cap)
+            buf->cap <<= 1;
+        buf->buffer = _REALLOC_ARRAY(buf->buffer, char, buf->cap);
+    }
+}
+
 string_t* create_string(const char* str) {
 
-    string_t* ptr = _ALLOC_TYPE(string_t);
-    ptr->cap = 1 << 3;
+    string_t* ptr = _ALLOC_SLAB(string_t);
+    ptr->cap = MIN_CAPACITY;
     ptr->len = 0;
     ptr->buffer = _ALLOC_ARRAY(char, ptr->cap);
+    ptr->buffer[0] = '\0';
 
     if(str != NULL)
         append_string(ptr, str);
@@ -22,19 +47,18 @@ string_t* create_string(const char* str) {
 string_t* create_string_fmt(const char* fmt, ...) {
 
     va_list args;
+    string_t* ptr = create_string(NULL);
 
     va_start(args, fmt);
-    size_t len = vsnprintf(NULL, 0, fmt, args);
+    int len = vsnprintf(NULL, 0, fmt, args);
     va_end(args);
 
-    char* str = _ALLOC(len + 1);
+    grow_string(ptr, len);
 
     va_start(args, fmt);
-    vsprintf(str, fmt, args);
+    vsnprintf(ptr->buffer, ptr->cap, fmt, args);
     va_end(args);
-
-    string_t* ptr = create_string(str);
-    _FREE(str);
+    ptr->len = len;
 
     return ptr;
 }
@@ -43,52 +67,49 @@ void destroy_string(string_t* buf) {
 
     if(buf != NULL) {
         _FREE(buf->buffer);
-        _FREE(buf);
+        _FREE_SLAB(buf, string_t);
     }
 }
 
-string_t* append_string(string_t* buf, const char* str) {
+/*
+ * Append len characters. The characters do not have to be terminated.
+ */
+string_t* append_string_n(string_t* buf, const char* str, int len) {
 
-    int len = strlen(str);
-    if(len + buf->len + 1 > buf->cap) {
-        while(len + buf->len + 1 > buf->cap)
-            buf->cap <<= 1;
-        buf->buffer = _REALLOC_ARRAY(buf->buffer, char, buf->cap);
-    }
-
-    strcat(buf->buffer, str);
-    buf->len = strlen(buf->buffer);
+    grow_string(buf, len);
+    memcpy(&buf->buffer[buf->len], str, len);
+    buf->len += len;
+    buf->buffer[buf->len] = '\0';
 
     return buf;
 }
 
+string_t* append_string(string_t* buf, const char* str) {
+
+    return append_string_n(buf, str, strlen(str));
+}
+
 string_t* append_string_fmt(string_t* buf, const char* fmt, ...) {
 
     va_list args;
 
     va_start(args, fmt);
-    size_t len = vsnprintf(NULL, 0, fmt, args);
+    int len = vsnprintf(NULL, 0, fmt, args);
     va_end(args);
 
-    char* str = _ALLOC(len + 1);
+    grow_string(buf, len);
 
     va_start(args, fmt);
-    vsprintf(str, fmt, args);
+    vsnprintf(&buf->buffer[buf->len], buf->cap - buf->len, fmt, args);
     va_end(args);
-
-    append_string(buf, str);
-    _FREE(str);
+    buf->len += len;
 
     return buf;
 }
 
 string_t* append_string_char(string_t* buf, int ch) {
 
-    if(buf->len + 1 > buf->cap) {
-        buf->cap <<= 1;
-        buf->buffer = _REALLOC_ARRAY(buf->buffer, char, buf->cap);
-    }
-
+    grow_string(buf, 1);
     buf->buffer[buf->len] = (char)ch;
     buf->len++;
     buf->buffer[buf->len] = '\0';
@@ -98,7 +119,35 @@ string_t* append_string_char(string_t* buf, int ch) {
 
 string_t* append_string_str(string_t* buf, string_t* str) {
 
-    return append_string(buf, str->buffer);
+    return append_string_n(buf, str->buffer, str->len);
+}
+
+/*
+ * Make sure that the buffer can hold at least cap characters without
+ * growing, not counting the terminator.
+ */
+string_t* reserve_string(string_t* buf, int cap) {
+
+    if(cap + 1 > buf->cap) {
+        buf->cap = cap + 1;
+        buf->buffer = _REALLOC_ARRAY(buf->buffer, char, buf->cap);
+    }
+
+    return buf;
+}
+
+/*
+ * Give back the capacity that the string does not use.
+ */
+string_t* shrink_string(string_t* buf) {
+
+    int cap = (buf->len + 1 < MIN_CAPACITY) ? MIN_CAPACITY : buf->len + 1;
+    if(cap < buf->cap) {
+        buf->cap = cap;
+        buf->buffer = _REALLOC_ARRAY(buf->buffer, char, buf->cap);
+    }
+
+    return buf;
 }
 
 void clear_string(string_t* buf) {
@@ -134,11 +183,13 @@ string_t* strip_char(string_t* buf, int ch) {
 
     // strip_space(buf);
 
-    char* temp;
-    while((temp = strrchr(buf->buffer, ch)) != NULL)
-        memmove(temp, temp + 1, strlen(temp) + 1);
+    int len = 0;
+    for(int i = 0; i < buf->len; i++)
+        if(buf->buffer[i] != ch)
+            buf->buffer[len++] = buf->buffer[i];
 
-    buf->len = strlen(buf->buffer);
+    buf->len = len;
+    buf->buffer[len] = '\0';
 
     return buf;
 }
@@ -146,7 +197,7 @@ string_t* strip_char(string_t* buf, int ch) {
 // strip the single character from the ends, such as quotes
 string_t* strip_ends(string_t* buf, int ch) {
 
-    if(buf->buffer[buf->len - 1] == ch) {
+    if(buf->len > 0 && buf->buffer[buf->len - 1] == ch) {
         buf->buffer[buf->len - 1] = '\0';
         buf->len--;
     }
@@ -161,14 +212,17 @@ string_t* strip_ends(string_t* buf, int ch) {
 
 string_t* strip_space(string_t* buf) {
 
-    int len;
-    for(len = strlen(buf->buffer); (isspace(buf->buffer[len]) || buf->buffer[len] == 0) && len >= 0; len--)
-        buf->buffer[len] = '\0';
+    int end = buf->len;
+    while(end > 0 && isspace((unsigned char)buf->buffer[end - 1]))
+        end--;
 
-    for(len = 0; buf->buffer[len] != '\0' && isspace(buf->buffer[len]); len++) {
-    }
+    int start = 0;
+    while(start < end && isspace((unsigned char)buf->buffer[start]))
+        start++;
 
-    memmove(&buf->buffer[0], &buf->buffer[len], strlen(&buf->buffer[len]) + 1);
+    buf->len = end - start;
+    memmove(&buf->buffer[0], &buf->buffer[start], buf->len);
+    buf->buffer[buf->len] = '\0';
 
     return buf;
 }
@@ -263,12 +317,14 @@ string_t* convert(string_t* str) {
 
 string_t* copy_string(string_t* buf) {
 
-    return create_string(buf->buffer);
+    string_t* ptr = create_string(NULL);
+    reserve_string(ptr, buf->len);
+    return append_string_n(ptr, buf->buffer, buf->len);
 }
 
 void emit_string(FILE* fp, string_t* ptr) {
 
-    fputs(ptr->buffer, fp);
+    fwrite(ptr->buffer, 1, ptr->len, fp);
 }
 
 void emit_string_fmt(FILE* fp, const char* fmt, ...) {
@@ -306,3 +362,60 @@ int main(void) {
     return 0;
 }
 #endif
+
+/*
+ * Build a 10 MB string literal the way the scanner does, a character or a
+ * run of characters at a time. The time per MB should stay flat as the
+ * size goes up.
+ */
+#ifdef BENCH_STRING
+
+#include <time.h>
+
+static double elapsed(struct timespec* start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(void) {
+
+    const char* run = "the quick brown fox jumps over the lazy dog";
+    int run_len = strlen(run);
+    struct timespec start;
+
+    const int sizes[] = { 1, 2, 5, 10 };
+
+    for(int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+        int mb = sizes[i];
+        int size = mb * 1024 * 1024;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        string_t* chars = create_string(NULL);
+        while(len_string(chars) < size)
+            append_string_char(chars, 'a' + len_string(chars) % 26);
+        double by_char = elapsed(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        string_t* runs = create_string(NULL);
+        while(len_string(runs) < size) {
+            append_string(runs, run);
+            append_string_char(runs, '\n');
+        }
+        double by_run = elapsed(&start);
+
+        if((int)strlen(raw_string(runs)) != len_string(runs))
+            fprintf(stderr, "length is wrong\n");
+
+        printf("%2d MB: by char %.3f sec (%.3f sec/MB), by run of %d %.3f sec (%.3f sec/MB)\n", mb, by_char,
+               by_char / mb, run_len, by_run, by_run / mb);
+
+        destroy_string(chars);
+        destroy_string(runs);
+    }
+
+    return 0;
+}
+
+#endif
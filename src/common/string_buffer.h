@@ -15,10 +15,13 @@ string_t* create_string(const char* str);
 string_t* create_string_fmt(const char* fmt, ...);
 void destroy_string(string_t* buf);
 string_t* append_string(string_t* buf, const char* str);
+string_t* append_string_n(string_t* buf, const char* str, int len);
 string_t* append_string_str(string_t* buf, string_t* str);
 string_t* append_string_fmt(string_t* buf, const char* fmt, ...);
 string_t* append_string_char(string_t* buf, int ch);
 void clear_string(string_t* buf);
+string_t* reserve_string(string_t* buf, int cap);
+string_t* shrink_string(string_t* buf);
 int len_string(string_t* buf);
 int comp_string(string_t* buf1, string_t* buf2);
 int comp_string_str(string_t* buf1, const char* buf2);
@@ -17,14 +17,16 @@ typedef struct _verbosity_stack_t_ {
 
 static verbosity_stack_t* stack;
 
+// a copy of the top of the stack, so the trace macros read one variable
+int trace_state = 0;
+
 void push_trace_state(int num) {
 
-    verbosity_stack_t* ptr = _ALLOC_TYPE(verbosity_stack_t);
+    verbosity_stack_t* ptr = _ALLOC_SLAB(verbosity_stack_t);
     ptr->verbosity = num;
-
-    if(stack != NULL)
-        ptr->next = ptr;
+    ptr->next = stack;
     stack = ptr;
+    trace_state = num;
 }
 
 void pop_trace_state(void) {
@@ -32,16 +34,15 @@ void pop_trace_state(void) {
     if(stack != NULL) {
         verbosity_stack_t* ptr = stack;
         stack = stack->next;
-        _FREE(ptr);
+        _FREE_SLAB(ptr, verbosity_stack_t);
     }
+
+    trace_state = (stack != NULL) ? stack->verbosity : 0;
 }
 
 int peek_trace_state(void) {
 
-    if(stack != NULL)
-        return stack->verbosity;
-    else
-        return 0;
+    return trace_state;
 }
 
 void increment_trace_depth(void) {
@@ -4,6 +4,11 @@
  * @brief Verbosity sets the level for messages. Trace verbosity is either on
  * or off.
  *
+ * Building with NO_TRACE removes every trace macro, so a function that uses
+ * ENTER and RETURN costs nothing extra. Otherwise the macros test a global
+ * before they do anything and can also record binary events, see
+ * trace_ring.h.
+ *
  * @author Chuck Tilbury (chucktilbury@gmail.com)
  * @version 0.1
  * @date 2025-03-24
@@ -24,34 +29,53 @@
     } while(0)
 
 void init_trace(FILE* fp);
+int get_verbosity(void);
+
+#ifndef NO_TRACE
+
+#include "trace_ring.h"
+
+// the top of the trace state stack, kept in trace.c
+extern int trace_state;
 
-// defined in trace.c
-extern int trace_depth;
+// Record a binary event. The id of the function is looked up once for each
+// place that records one.
+#define TRACE_EVENT(kind, st)                              \
+    do {                                                   \
+        if(trace_ring_on) {                                \
+            static int _trace_id = 0;                      \
+            if(_trace_id == 0)                             \
+                _trace_id = trace_func_id(__func__);       \
+            trace_event(_trace_id, (kind), (st));          \
+        }                                                  \
+    } while(0)
 
 #define PRINT(...)                     \
     do {                               \
-        if(peek_trace_state()) {       \
+        if(trace_state) {              \
             print_indent(__VA_ARGS__); \
         }                              \
     } while(0)
 
 #define TRACE(...)                    \
     do {                              \
-        if(peek_trace_state()) {      \
+        if(trace_state) {             \
             print_trace(__VA_ARGS__); \
         }                             \
     } while(0)
 
 #define ENTER                                          \
     do {                                               \
-        if(peek_trace_state()) {                       \
+        TRACE_EVENT(TRACE_EV_ENTER, 0);                \
+        if(trace_state) {                              \
             print_enter(__FILE__, __LINE__, __func__); \
         }                                              \
     } while(0)
 
 #define RETURN(...)                                                   \
     do {                                                              \
-        if(peek_trace_state()) {                                      \
+        TRACE_EVENT(TRACE_EV_RETURN, 0);                              \
+        if(trace_state) {                                             \
             print_return(__FILE__, __LINE__, __func__, #__VA_ARGS__); \
         }                                                             \
         return __VA_ARGS__;                                           \
@@ -59,7 +83,7 @@ extern int trace_depth;
 
 #define SEPARATOR                               \
     do {                                        \
-        if(peek_trace_state()) {                \
+        if(trace_state) {                       \
             for(int i = 0; i < 80; i++)         \
                 fputc('-', get_trace_handle()); \
             fputc('\n', get_trace_handle());    \
@@ -77,6 +101,38 @@ extern int trace_depth;
 #define POP_TRACE_STATE() pop_trace_state()
 #define PEEK_TRACE_STATE() peek_trace_state()
 
+#else /* NO_TRACE */
+
+// Tracing is compiled out. Nothing is left but the return.
+#define TRACE_EVENT(kind, st) \
+    do {                      \
+    } while(0)
+#define PRINT(...) \
+    do {           \
+    } while(0)
+#define TRACE(...) \
+    do {           \
+    } while(0)
+#define ENTER \
+    do {      \
+    } while(0)
+#define RETURN(...)         \
+    do {                    \
+        return __VA_ARGS__; \
+    } while(0)
+#define SEPARATOR \
+    do {          \
+    } while(0)
+#define TRACE_HEADER \
+    do {             \
+    } while(0)
+
+#define PUSH_TRACE_STATE(n) ((void)(n))
+#define POP_TRACE_STATE() ((void)0)
+#define PEEK_TRACE_STATE() 0
+
+#endif /* NO_TRACE */
+
 void reset_trace_depth(int val);
 void push_trace_state(int num);
 void pop_trace_state(void);
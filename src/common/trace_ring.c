@@ -0,0 +1,176 @@
+/**
+ * @file trace_ring.c
+ *
+ * @brief Per thread ring buffers of binary trace events.
+ *
+ * The fast path is trace_event(). It reads the clock, finds the ring of the
+ * calling thread in thread local storage and stores one event. A ring is
+ * allocated the first time a thread records an event and is pushed on a
+ * list of all rings with a compare and swap, so that it can be written out
+ * later. Function names are registered once per call site and are the only
+ * thing that takes a lock.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "trace_ring.h"
+
+typedef struct _trace_ring_t_ {
+    trace_event_t events[TRACE_RING_SIZE];
+    // events ever recorded, the next one goes at total % TRACE_RING_SIZE
+    uint64_t total;
+    uint32_t thread;
+    struct _trace_ring_t_* next;
+} trace_ring_t;
+
+bool trace_ring_on = false;
+
+static _Thread_local trace_ring_t* local_ring = NULL;
+static _Atomic(trace_ring_t*) all_rings = NULL;
+static atomic_uint thread_count = 0;
+
+static struct timespec start_time;
+static int (*get_position)(void) = NULL;
+
+// function names by id, id 0 is not used
+static const char** names = NULL;
+static int names_len = 1;
+static int names_cap = 0;
+static atomic_flag names_lock = ATOMIC_FLAG_INIT;
+
+static trace_ring_t* create_ring(void) {
+
+    trace_ring_t* ring = _ALLOC_TYPE(trace_ring_t);
+    ring->thread = atomic_fetch_add(&thread_count, 1);
+
+    ring->next = atomic_load(&all_rings);
+    while(!atomic_compare_exchange_weak(&all_rings, &ring->next, ring))
+        ;
+
+    return ring;
+}
+
+static void write_block(FILE* fp, const void* ptr, size_t size, const char* fname) {
+
+    if(fwrite(ptr, 1, size, fp) != size)
+        FATAL("cannot write trace file: %s: %s", fname, strerror(errno));
+}
+
+/*
+ * public interface
+ */
+
+/*
+ * Start recording. The position function gives the index of the current
+ * token. It may be NULL when there are no tokens to report.
+ */
+void start_trace_ring(int (*position)(void)) {
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    get_position = position;
+    trace_ring_on = true;
+}
+
+/*
+ * Give a function name a small id. The name must not be freed, which is true
+ * for __func__. A name that is registered again gets the same id.
+ */
+int trace_func_id(const char* name) {
+
+    while(atomic_flag_test_and_set(&names_lock))
+        ;
+
+    int id;
+    for(id = 1; id < names_len; id++)
+        if(names[id] == name || !strcmp(names[id], name))
+            break;
+
+    if(id == names_len) {
+        if(names_len + 1 > names_cap) {
+            names_cap = (names_cap == 0) ? 64 : names_cap << 1;
+            names = _REALLOC_ARRAY(names, const char*, names_cap);
+        }
+        names[names_len++] = name;
+    }
+
+    atomic_flag_clear(&names_lock);
+    ASSERT(id <= UINT16_MAX, "too many traced functions: %d", id);
+
+    return id;
+}
+
+void trace_event(int func, trace_event_kind_t kind, int state) {
+
+    if(local_ring == NULL)
+        local_ring = create_ring();
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    trace_event_t* ev = &local_ring->events[local_ring->total & (TRACE_RING_SIZE - 1)];
+    ev->time = (uint64_t)(now.tv_sec - start_time.tv_sec) * 1000000000 + (now.tv_nsec - start_time.tv_nsec);
+    ev->token = (get_position != NULL) ? get_position() : -1;
+    ev->state = state;
+    ev->func = (uint16_t)func;
+    ev->kind = (uint8_t)kind;
+    local_ring->total++;
+}
+
+/*
+ * Write every ring to a file. This reads the rings of all threads, so it is
+ * called after the threads that trace have finished.
+ */
+void write_trace_ring(const char* fname) {
+
+    FILE* fp = fopen(fname, "wb");
+    if(fp == NULL)
+        FATAL("cannot open trace file: %s: %s", fname, strerror(errno));
+
+    trace_file_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TRACE_RING_MAGIC, sizeof(hdr.magic));
+    hdr.version = TRACE_RING_VERSION;
+    hdr.nnames = names_len - 1;
+    for(trace_ring_t* ring = atomic_load(&all_rings); ring != NULL; ring = ring->next)
+        hdr.nrings++;
+    write_block(fp, &hdr, sizeof(hdr), fname);
+
+    for(int i = 1; i < names_len; i++) {
+        uint16_t len = (uint16_t)strlen(names[i]);
+        write_block(fp, &len, sizeof(len), fname);
+        write_block(fp, names[i], len, fname);
+    }
+
+    for(trace_ring_t* ring = atomic_load(&all_rings); ring != NULL; ring = ring->next) {
+        trace_ring_header_t rh;
+        rh.thread = ring->thread;
+        rh.count = (ring->total < TRACE_RING_SIZE) ? (uint32_t)ring->total : TRACE_RING_SIZE;
+        rh.lost = ring->total - rh.count;
+        write_block(fp, &rh, sizeof(rh), fname);
+
+        // the oldest event is at the write position once the ring has wrapped
+        uint32_t first = (uint32_t)(rh.lost & (TRACE_RING_SIZE - 1));
+        uint32_t tail = TRACE_RING_SIZE - first;
+        if(tail > rh.count)
+            tail = rh.count;
+        write_block(fp, &ring->events[first], tail * sizeof(trace_event_t), fname);
+        write_block(fp, &ring->events[0], (rh.count - tail) * sizeof(trace_event_t), fname);
+    }
+
+    fclose(fp);
+}
+
+const char* trace_event_kind_to_str(trace_event_kind_t kind) {
+
+    return (kind == TRACE_EV_ENTER)  ? "ENTER" :
+           (kind == TRACE_EV_RETURN) ? "RETURN" :
+           (kind == TRACE_EV_STATE)  ? "STATE" :
+                                       "UNKNOWN";
+}
@@ -0,0 +1,73 @@
+/**
+ * @file trace_ring.h
+ *
+ * @brief Binary trace. When it is on, ENTER, RETURN and TRACE_STATE write a
+ * small fixed size event to a ring buffer instead of formatting a line of
+ * text. Every thread has its own ring, so recording an event takes no lock
+ * and does not touch memory that another thread writes. When the ring is
+ * full the oldest events are overwritten. write_trace_ring() saves the rings
+ * to a file that the tracedump tool decodes.
+ *
+ * File layout, all integers in host byte order:
+ *
+ *     header      magic "TOYTRACE", version, number of names, number of rings
+ *     names       for each function id from 1: uint16_t length, characters
+ *     rings       for each ring a trace_ring_header_t, then its events,
+ *                 oldest first
+ *
+ */
+#ifndef _TRACE_RING_H_
+#define _TRACE_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// events in each ring, a power of two
+#define TRACE_RING_SIZE (1 << 16)
+
+#define TRACE_RING_MAGIC "TOYTRACE"
+#define TRACE_RING_VERSION 1
+
+typedef enum {
+    TRACE_EV_ENTER,
+    TRACE_EV_RETURN,
+    TRACE_EV_STATE,
+} trace_event_kind_t;
+
+typedef struct {
+    // nanoseconds since the trace was started
+    uint64_t time;
+    // index of the current token, or -1
+    int32_t token;
+    // parser state, only for TRACE_EV_STATE
+    int32_t state;
+    uint16_t func;
+    uint8_t kind;
+    uint8_t unused[5];
+} trace_event_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t nnames;
+    uint32_t nrings;
+} trace_file_header_t;
+
+typedef struct {
+    uint32_t thread;
+    uint32_t count;
+    // events that were overwritten before the ring was written
+    uint64_t lost;
+} trace_ring_header_t;
+
+// checked before anything else is done for an event
+extern bool trace_ring_on;
+
+void start_trace_ring(int (*position)(void));
+int trace_func_id(const char* name);
+void trace_event(int func, trace_event_kind_t kind, int state);
+void write_trace_ring(const char* fname);
+
+const char* trace_event_kind_to_str(trace_event_kind_t kind);
+
+#endif /* _TRACE_RING_H_ */
@@ -0,0 +1,161 @@
+/**
+ * @file vector.h
+ *
+ * @brief Type specialized vectors. DEFINE_VEC(name, T) declares name_t
+ * and a set of static inline functions that work on it, named the same
+ * way as the pointer_list functions: create_name(), append_name(),
+ * index_name() and so on. The items are stored by value in an array of
+ * T, so there is no cast, no heap cell per item and no call through a
+ * function pointer. Because the functions are inline, a loop over a
+ * vector compiles to a loop over an array.
+ *
+ * DEFINE_SMALL_VEC(name, T, N) is the same, except that the first N items
+ * are stored in the vector itself and the heap is only used when it grows
+ * past that. A small vector points into itself, so it must not be copied
+ * by value. DEFINE_STACK(name, T, N) is a small vector, which is what a
+ * stack that is usually shallow wants.
+ *
+ * Unlike a pointer list, a vector may hold NULL, so iterate_name() hands
+ * back the item through a pointer and returns false at the end. splice_name()
+ * replaces a run of items with the items of an array, either of which may
+ * be empty.
+ *
+ *     DEFINE_VEC(int_list, int)
+ *
+ *     int_list_t* lst = create_int_list();
+ *     append_int_list(lst, 10);
+ *
+ *     int mark = 0;
+ *     int value;
+ *     while(iterate_int_list(lst, &mark, &value))
+ *         printf("%d\n", value);
+ *
+ */
+#ifndef _VECTOR_H_
+#define _VECTOR_H_
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "errors.h"
+
+// functions that do not depend on where the first items are stored
+#define _DEFINE_VEC_FUNCS(name, T)                                                   \
+    static inline void append_##name(name##_t* vec, T item) {                        \
+        if(vec->len + 1 > vec->cap)                                                  \
+            grow_##name(vec);                                                        \
+        vec->items[vec->len++] = item;                                               \
+    }                                                                                \
+    static inline void push_##name(name##_t* vec, T item) {                          \
+        append_##name(vec, item);                                                    \
+    }                                                                                \
+    static inline T pop_##name(name##_t* vec) {                                      \
+        ASSERT(vec->len > 0, "pop from an empty " #name);                            \
+        return vec->items[--vec->len];                                               \
+    }                                                                                \
+    static inline T peek_##name(name##_t* vec) {                                     \
+        ASSERT(vec->len > 0, "peek at an empty " #name);                             \
+        return vec->items[vec->len - 1];                                             \
+    }                                                                                \
+    static inline T index_##name(name##_t* vec, int index) {                         \
+        ASSERT(index >= 0 && index < vec->len, "index out of range: %d", index);     \
+        return vec->items[index];                                                    \
+    }                                                                                \
+    static inline T* at_##name(name##_t* vec, int index) {                           \
+        ASSERT(index >= 0 && index < vec->len, "index out of range: %d", index);     \
+        return &vec->items[index];                                                   \
+    }                                                                                \
+    static inline int len_##name(name##_t* vec) {                                    \
+        return (vec != NULL) ? vec->len : 0;                                         \
+    }                                                                                \
+    static inline void clear_##name(name##_t* vec) {                                 \
+        vec->len = 0;                                                                \
+    }                                                                                \
+    static inline void truncate_##name(name##_t* vec, int len) {                     \
+        ASSERT(len >= 0 && len <= vec->len, "truncate past the end: %d", len);       \
+        vec->len = len;                                                              \
+    }                                                                                \
+    static inline void splice_##name(name##_t* vec, int index, int remove, T* items, \
+                                     int count) {                                    \
+        ASSERT(index >= 0 && remove >= 0 && index + remove <= vec->len,              \
+               "splice out of range: %d", index);                                    \
+        while(vec->len - remove + count > vec->cap)                                  \
+            grow_##name(vec);                                                        \
+        memmove(&vec->items[index + count], &vec->items[index + remove],             \
+                sizeof(T) * (vec->len - index - remove));                            \
+        if(count > 0)                                                                \
+            memcpy(&vec->items[index], items, sizeof(T) * count);                    \
+        vec->len += count - remove;                                                  \
+    }                                                                                \
+    static inline bool iterate_##name(name##_t* vec, int* mark, T* item) {           \
+        if(vec == NULL || *mark < 0 || *mark >= vec->len)                            \
+            return false;                                                            \
+        *item = vec->items[(*mark)++];                                               \
+        return true;                                                                 \
+    }                                                                                \
+    static inline name##_t* create_##name(void) {                                    \
+        name##_t* vec = _ALLOC_TYPE(name##_t);                                       \
+        init_##name(vec);                                                            \
+        return vec;                                                                  \
+    }                                                                                \
+    static inline void destroy_##name(name##_t* vec) {                               \
+        if(vec != NULL) {                                                            \
+            free_##name(vec);                                                        \
+            _FREE(vec);                                                              \
+        }                                                                            \
+    }
+
+#define DEFINE_VEC(name, T)                                                           \
+    typedef struct {                                                                 \
+        T* items;                                                                    \
+        int len;                                                                     \
+        int cap;                                                                     \
+    } name##_t;                                                                      \
+    static inline void init_##name(name##_t* vec) {                                  \
+        vec->items = NULL;                                                           \
+        vec->len = 0;                                                                \
+        vec->cap = 0;                                                                \
+    }                                                                                \
+    static inline void free_##name(name##_t* vec) {                                  \
+        if(vec->items != NULL)                                                       \
+            _FREE(vec->items);                                                       \
+        init_##name(vec);                                                            \
+    }                                                                                \
+    static inline void grow_##name(name##_t* vec) {                                  \
+        vec->cap = (vec->cap == 0) ? 8 : vec->cap << 1;                              \
+        vec->items = _REALLOC_ARRAY(vec->items, T, vec->cap);                        \
+    }                                                                                \
+    _DEFINE_VEC_FUNCS(name, T)
+
+#define DEFINE_SMALL_VEC(name, T, N)                                                  \
+    typedef struct {                                                                 \
+        T* items;                                                                    \
+        int len;                                                                     \
+        int cap;                                                                     \
+        T small[N];                                                                  \
+    } name##_t;                                                                      \
+    static inline void init_##name(name##_t* vec) {                                  \
+        vec->items = vec->small;                                                     \
+        vec->len = 0;                                                                \
+        vec->cap = (N);                                                              \
+    }                                                                                \
+    static inline void free_##name(name##_t* vec) {                                  \
+        if(vec->items != vec->small)                                                 \
+            _FREE(vec->items);                                                       \
+        init_##name(vec);                                                            \
+    }                                                                                \
+    static inline void grow_##name(name##_t* vec) {                                  \
+        vec->cap <<= 1;                                                              \
+        if(vec->items == vec->small) {                                               \
+            vec->items = _ALLOC_ARRAY(T, vec->cap);                                  \
+            memcpy(vec->items, vec->small, sizeof(T) * (N));                         \
+        }                                                                            \
+        else                                                                         \
+            vec->items = _REALLOC_ARRAY(vec->items, T, vec->cap);                    \
+    }                                                                                \
+    _DEFINE_VEC_FUNCS(name, T)
+
+#define DEFINE_STACK(name, T, N) DEFINE_SMALL_VEC(name, T, N)
+
+#endif /* _VECTOR_H_ */
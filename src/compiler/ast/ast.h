@@ -15,7 +15,24 @@
 
 #include "tokens.h"
 #include "errors.h"
-#include "pointer_list.h"
+#include "vector.h"
+
+/*
+ * Child lists. Most of them hold a handful of items, so the first few are
+ * stored in the list itself.
+ */
+#define AST_LIST_SMALL 4
+
+DEFINE_SMALL_VEC(token_list, token_t*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(symbol_list, struct _symbol_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(ref_element_list, struct _ast_compound_reference_element_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(dss_item_list, struct _ast_dss_initializer_item_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(expr_item_list, struct _ast_primary_expression_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(expr_list, struct _ast_expression_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(body_item_list, struct _ast_function_body_prelist_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(decl_list, struct _ast_data_declaration_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(loop_item_list, struct _ast_loop_body_prelist_t_*, AST_LIST_SMALL)
+DEFINE_SMALL_VEC(unit_item_list, struct _ast_translation_unit_element_t_*, AST_LIST_SMALL)
 
 typedef enum {
     AST_ASSIGNMENT = 512,
@@ -132,7 +149,10 @@ typedef struct _ast_bool_literal_t_ {
  */
 typedef struct _ast_compound_name_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    token_list_t* list;
+    struct _symbol_t_* sym;
+    symbol_list_t* fields;
+    struct _type_t_* type;
 } ast_compound_name_t;
 
 
@@ -155,7 +175,7 @@ typedef struct _ast_compound_name_t_ {
  */
 typedef struct _ast_compound_reference_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    ref_element_list_t* list;
 } ast_compound_reference_t;
 
 
@@ -183,6 +203,7 @@ typedef struct _ast_compound_reference_element_t_ {
     token_t* IDENTIFIER;
     struct _ast_function_reference_t_* function_reference;
     struct _ast_list_reference_t_* list_reference;
+    struct _symbol_t_* sym;
 } ast_compound_reference_element_t;
 
 
@@ -202,6 +223,7 @@ typedef struct _ast_data_declaration_t_ {
     ast_node_t node;
     struct _ast_type_name_t_* type_name;
     token_t* IDENTIFIER;
+    struct _symbol_t_* sym;
 } ast_data_declaration_t;
 
 
@@ -300,7 +322,7 @@ typedef struct _ast_do_clause_t_ {
  */
 typedef struct _ast_dss_initializer_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    dss_item_list_t* list;
 } ast_dss_initializer_t;
 
 
@@ -321,6 +343,7 @@ typedef struct _ast_dss_initializer_item_t_ {
     ast_node_t node;
     token_t* STRING_LITERAL;
     struct _ast_expression_t_* expression;
+    struct _symbol_t_* sym;
 } ast_dss_initializer_item_t;
 
 
@@ -387,12 +410,17 @@ typedef struct _ast_exit_statement_t_ {
  *     primary_expression
  * )
  *
- * Expressions are parsed with Dijkstra's shunting yard algorithm.
+ * Expressions are parsed with Dijkstra's shunting yard algorithm. The list
+ * holds primary_expression items in postfix order. An item with a token is
+ * a literal or an operator. An operator that is flagged is_unary takes one
+ * operand, the others take two. An item whose nterm is a type_name is a
+ * cast of the value below it.
  */
 typedef struct _ast_expression_t_ {
     ast_node_t node;
-    // list of tokens in postfix format
-    pointer_list_t* list;
+    // primary expressions in postfix order
+    expr_item_list_t* list;
+    struct _type_t_* type;
 } ast_expression_t;
 
 
@@ -415,7 +443,7 @@ typedef struct _ast_expression_t_ {
  */
 typedef struct _ast_expression_list_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    expr_list_t* list;
 } ast_expression_list_t;
 
 
@@ -477,6 +505,7 @@ typedef struct _ast_for_clause_t_ {
     token_t* IDENTIFIER;
     struct _ast_expression_t_* expression;
     struct _ast_loop_body_t_* loop_body;
+    struct _symbol_t_* sym;
 } ast_for_clause_t;
 
 
@@ -600,7 +629,7 @@ typedef struct _ast_function_body_element_t_ {
  */
 typedef struct _ast_function_body_list_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    body_item_list_t* list;
 } ast_function_body_list_t;
 
 
@@ -671,6 +700,7 @@ typedef struct _ast_function_name_t_ {
     ast_node_t node;
     struct _ast_type_name_t_* type_name;
     token_t* IDENTIFIER;
+    struct _symbol_t_* sym;
 } ast_function_name_t;
 
 
@@ -699,7 +729,7 @@ typedef struct _ast_function_name_t_ {
  */
 typedef struct _ast_function_parameters_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    decl_list_t* list;
 } ast_function_parameters_t;
 
 
@@ -852,7 +882,7 @@ typedef struct _ast_list_init_t_ {
 typedef struct _ast_list_reference_t_ {
     ast_node_t node;
     token_t* IDENTIFIER;
-    pointer_list_t* list;
+    expr_list_t* list;
 } ast_list_reference_t;
 
 
@@ -954,7 +984,7 @@ typedef struct _ast_loop_body_element_t_ {
  */
 typedef struct _ast_loop_body_list_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    loop_item_list_t* list;
 } ast_loop_body_list_t;
 
 
@@ -1018,6 +1048,8 @@ typedef struct _ast_primary_expression_t_ {
     ast_node_t node;
     token_t* token;
     ast_node_t* nterm;
+    bool is_unary;
+    struct _type_t_* type;
 } ast_primary_expression_t;
 
 
@@ -1062,6 +1094,7 @@ typedef struct _ast_return_statement_t_ {
 typedef struct _ast_start_block_t_ {
     ast_node_t node;
     struct _ast_function_body_t_* function_body;
+    struct _symbol_t_* sym;
 } ast_start_block_t;
 
 
@@ -1088,7 +1121,8 @@ typedef struct _ast_start_block_t_ {
 typedef struct _ast_struct_definition_t_ {
     ast_node_t node;
     token_t* IDENTIFIER;
-    pointer_list_t* list;
+    decl_list_t* list;
+    struct _symbol_t_* sym;
 } ast_struct_definition_t;
 
 
@@ -1126,7 +1160,7 @@ typedef struct _ast_struct_init_t_ {
  */
 typedef struct _ast_translation_unit_t_ {
     ast_node_t node;
-    pointer_list_t* list;
+    unit_item_list_t* list;
 } ast_translation_unit_t;
 
 
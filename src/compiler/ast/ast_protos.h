@@ -61,14 +61,19 @@ void traverse_translation_unit_element(ast_translation_unit_element_t* node);
 void traverse_type_name(ast_type_name_t* node);
 void traverse_while_clause(ast_while_clause_t* node);
 
-#define TRAVERSE_TOKEN(t) PRINT("token: \"%s\": %s: %d\n", t->str->buffer, tok_type_to_str(t), t->line_no)
+#define TRAVERSE_TOKEN(t)                                                                         \
+    do {                                                                                          \
+        char _buf[32];                                                                            \
+        PRINT("token: \"%s\": %s: %d\n", token_to_str(t, _buf, sizeof(_buf)), tok_type_to_str(t), \
+              t->line_no);                                                                        \
+        (void)_buf;                                                                               \
+    } while(0)
 
-#define TRAVERSE_LIST(name)                                         \
-    do {                                                            \
-        int mark = 0;                                               \
-        ast_##name##_t* item;                                       \
-        while(NULL != (item = iterate_ptr_list(node->list, &mark))) \
-            traverse_##name(item);                                  \
+// every AST list is a vector of pointers, whatever its item type
+#define TRAVERSE_LIST(name)                                                        \
+    do {                                                                           \
+        for(int mark = 0; node->list != NULL && mark < node->list->len; mark++)   \
+            traverse_##name(node->list->items[mark]);                              \
     } while(0)
 
 #define TRAVERSE_NODE(name) traverse_##name(node->name)
@@ -43,7 +43,7 @@ void traverse_compound_name(ast_compound_name_t* node) {
 
     int mark = 0;
     token_t* tok;
-    while(NULL != (tok = iterate_ptr_list(node->list, &mark)))
+    while(iterate_token_list(node->list, &mark, &tok))
         TRAVERSE_TOKEN(tok);
 
 
@@ -0,0 +1,1018 @@
+/**
+ * @file codegen.c
+ *
+ * @brief Generate bytecode from the checked AST.
+ *
+ * The type checker left a type on every expression item, so the generator
+ * keeps a stack of types that mirrors the run time stack and uses it to pick
+ * a typed instruction for each operator. A generic instruction is emitted
+ * only when an operand came out of a list or a dict. When such a value is
+ * stored in a typed variable, a CHECK_TYPE is emitted in front of the store
+ * so that a variable always holds a value of its declared type.
+ *
+ * The operators "and" and "or" evaluate both sides. The postfix form of the
+ * expression has no place to put a jump around the right side.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "trace.h"
+#include "cmdline.h"
+#include "alloc.h"
+#include "array.h"
+#include "hash.h"
+#include "intern.h"
+#include "types.h"
+#include "opcode_profile.h"
+#include "passes.h"
+#include "codegen.h"
+
+typedef struct _loop_t_ {
+    // positions of the jumps that leave the loop or go to the next pass
+    array_t* breaks;
+    array_t* continues;
+    struct _loop_t_* outer;
+} loop_t;
+
+typedef struct {
+    module_t* mod;
+    function_t* func;
+    symbol_t* sym;
+    // next free frame slot after the locals of the function
+    int temps;
+    loop_t* loop;
+    // constant key to index + 1
+    hash_table_t* consts;
+} codegen_t;
+
+static type_t* emit_expression(codegen_t* gen, ast_expression_t* node);
+static void emit_function_body(codegen_t* gen, ast_function_body_t* node);
+static void emit_loop_body(codegen_t* gen, ast_loop_body_t* node);
+
+#define EMIT(op) emit_code(gen->func, (op), 0, 0)
+#define EMIT1(op, a) emit_code(gen->func, (op), (a), 0)
+#define EMIT2(op, a, b) emit_code(gen->func, (op), (a), (b))
+#define HERE (gen->func->len)
+
+/*
+ * Constants are kept once per module.
+ */
+static int find_constant(codegen_t* gen, const char* key, constant_t* value) {
+
+    void* data;
+
+    if(find_hashtable(gen->consts, key, &data))
+        return (int)(intptr_t)data - 1;
+
+    int index = add_constant(gen->mod, value);
+    insert_hashtable(gen->consts, key, (void*)(intptr_t)(index + 1));
+
+    return index;
+}
+
+static void emit_int(codegen_t* gen, int64_t value) {
+
+    if(value >= INT32_MIN && value <= INT32_MAX) {
+        EMIT1(OP_PUSH_INT, (int32_t)value);
+        return;
+    }
+
+    char key[32];
+    snprintf(key, sizeof(key), "i:%lld", (long long)value);
+    constant_t c = { .type = VAL_INT, .ival = value };
+    EMIT1(OP_PUSH_CONST, find_constant(gen, key, &c));
+}
+
+static void emit_float(codegen_t* gen, double value) {
+
+    char key[48];
+    snprintf(key, sizeof(key), "f:%a", value);
+    constant_t c = { .type = VAL_FLOAT, .fval = value };
+    EMIT1(OP_PUSH_CONST, find_constant(gen, key, &c));
+}
+
+static void emit_str(codegen_t* gen, const char* value) {
+
+    string_t* key = create_string("s:");
+    append_string(key, value);
+    constant_t c = { .type = VAL_STRING, .sval = intern_string(value) };
+    EMIT1(OP_PUSH_CONST, find_constant(gen, raw_string(key), &c));
+    destroy_string(key);
+}
+
+static int alloc_temp(codegen_t* gen) {
+
+    int slot = gen->temps++;
+    if(gen->temps > gen->func->frame_size)
+        gen->func->frame_size = gen->temps;
+
+    return slot;
+}
+
+static void free_temp(codegen_t* gen) {
+
+    gen->temps--;
+}
+
+/*
+ * A value whose type is only known at run time is checked before it is
+ * stored where a typed value is expected.
+ */
+static void emit_check(codegen_t* gen, type_t* dest, type_t* src) {
+
+    if(IS_TYPE(src, TYPE_ANY) && !IS_UNCHECKED(dest))
+        EMIT2(OP_CHECK_TYPE, type_to_val_type(dest), IS_TYPE(dest, TYPE_STRUCT) ? dest->sym->slot : -1);
+}
+
+static void emit_load(codegen_t* gen, symbol_t* sym) {
+
+    if(sym->kind == SYM_GLOBAL)
+        EMIT1(OP_LOAD_GLOBAL, sym->slot);
+    else
+        EMIT1(OP_LOAD_LOCAL, sym->slot);
+}
+
+static void emit_store(codegen_t* gen, symbol_t* sym) {
+
+    if(sym->kind == SYM_GLOBAL)
+        EMIT1(OP_STORE_GLOBAL, sym->slot);
+    else
+        EMIT1(OP_STORE_LOCAL, sym->slot);
+}
+
+static void emit_get_field(codegen_t* gen, symbol_t* field, token_t* tok) {
+
+    if(field != NULL)
+        EMIT1(OP_GET_FIELD, field->slot);
+    else {
+        constant_t c = { .type = VAL_STRING, .sval = intern_string(raw_string(tok->str)) };
+        string_t* key = create_string_fmt("s:%s", c.sval);
+        EMIT2(OP_GET_MEMBER, find_constant(gen, raw_string(key), &c), gen->mod->ncaches++);
+        destroy_string(key);
+    }
+}
+
+static void emit_set_field(codegen_t* gen, symbol_t* field, token_t* tok) {
+
+    if(field != NULL)
+        EMIT1(OP_SET_FIELD, field->slot);
+    else {
+        constant_t c = { .type = VAL_STRING, .sval = intern_string(raw_string(tok->str)) };
+        string_t* key = create_string_fmt("s:%s", c.sval);
+        EMIT2(OP_SET_MEMBER, find_constant(gen, raw_string(key), &c), gen->mod->ncaches++);
+        destroy_string(key);
+    }
+}
+
+/*
+ * The value that a variable has before anything is assigned to it. A
+ * struct that contains itself gets nothing in the inner field.
+ */
+static void emit_default(codegen_t* gen, type_t* type, type_stack_t* outer) {
+
+    switch(type->kind) {
+        case TYPE_BOOL:
+            EMIT(OP_PUSH_FALSE);
+            break;
+        case TYPE_INT:
+            EMIT1(OP_PUSH_INT, 0);
+            break;
+        case TYPE_FLOAT:
+            emit_float(gen, 0.0);
+            break;
+        case TYPE_STRING:
+            emit_str(gen, "");
+            break;
+        case TYPE_LIST:
+            EMIT1(OP_NEW_LIST, 0);
+            break;
+        case TYPE_DICT:
+            EMIT1(OP_NEW_DICT, 0);
+            break;
+        case TYPE_STRUCT: {
+            int mark = 0;
+            type_t* t;
+            while(iterate_type_stack(outer, &mark, &t)) {
+                if(t == type) {
+                    EMIT(OP_PUSH_NOTHING);
+                    return;
+                }
+            }
+
+            push_type_stack(outer, type);
+            mark = 0;
+            symbol_t* field;
+            while(NULL != (field = iterate_ptr_list(type->sym->members, &mark)))
+                emit_default(gen, field->type, outer);
+            pop_type_stack(outer);
+
+            EMIT1(OP_NEW_STRUCT, type->sym->slot);
+        } break;
+        default:
+            EMIT(OP_PUSH_NOTHING);
+            break;
+    }
+}
+
+static opcode_t typed_opcode(operator_t op, type_t* type) {
+
+    bool is_int = IS_TYPE(type, TYPE_INT);
+    bool is_float = IS_TYPE(type, TYPE_FLOAT);
+    bool is_str = IS_TYPE(type, TYPE_STRING);
+
+    switch(op) {
+        case OPER_ADD:
+            return is_int ? OP_ADD_INT : is_float ? OP_ADD_FLOAT : is_str ? OP_CONCAT_STR : OP_ADD;
+        case OPER_SUB:
+            return is_int ? OP_SUB_INT : is_float ? OP_SUB_FLOAT : OP_SUB;
+        case OPER_MUL:
+            return is_int ? OP_MUL_INT : is_float ? OP_MUL_FLOAT : OP_MUL;
+        case OPER_DIV:
+            return is_int ? OP_DIV_INT : is_float ? OP_DIV_FLOAT : OP_DIV;
+        case OPER_MOD:
+            return is_int ? OP_MOD_INT : OP_MOD;
+        case OPER_POW:
+            return is_int ? OP_POW_INT : is_float ? OP_POW_FLOAT : OP_POW;
+        case OPER_NEG:
+            return is_int ? OP_NEG_INT : is_float ? OP_NEG_FLOAT : OP_NEG;
+        case OPER_EQ:
+            return is_int ? OP_EQ_INT : is_float ? OP_EQ_FLOAT : is_str ? OP_EQ_STR : OP_EQ;
+        case OPER_NE:
+            return is_int ? OP_NE_INT : is_float ? OP_NE_FLOAT : is_str ? OP_NE_STR : OP_NE;
+        case OPER_LT:
+            return is_int ? OP_LT_INT : is_float ? OP_LT_FLOAT : is_str ? OP_LT_STR : OP_LT;
+        case OPER_LE:
+            return is_int ? OP_LE_INT : is_float ? OP_LE_FLOAT : is_str ? OP_LE_STR : OP_LE;
+        case OPER_GT:
+            return is_int ? OP_GT_INT : is_float ? OP_GT_FLOAT : is_str ? OP_GT_STR : OP_GT;
+        case OPER_GE:
+            return is_int ? OP_GE_INT : is_float ? OP_GE_FLOAT : is_str ? OP_GE_STR : OP_GE;
+        case OPER_AND:
+            return OP_AND;
+        case OPER_OR:
+            return OP_OR;
+        case OPER_NOT:
+            return OP_NOT;
+        default:
+            FATAL("internal error: unknown operator: %d", op);
+    }
+
+    return OP_NOP;
+}
+
+/*
+ * The typed instruction is used only when both operands have the same
+ * static type. Anything else was an ANY on one side.
+ */
+static void emit_operator(codegen_t* gen, operator_t op, type_t* left, type_t* right) {
+
+    type_t* type = (left == right) ? left : get_basic_type(TYPE_ANY);
+    EMIT(typed_opcode(op, type));
+}
+
+static void emit_cast(codegen_t* gen, type_t* dest, type_t* src) {
+
+    if(dest == src)
+        return;
+
+    opcode_t op = OP_CAST;
+    switch(src->kind) {
+        case TYPE_INT:
+            op = IS_TYPE(dest, TYPE_FLOAT) ? OP_INT_TO_FLOAT : IS_TYPE(dest, TYPE_STRING) ? OP_INT_TO_STR :
+                    IS_TYPE(dest, TYPE_BOOL)                   ? OP_INT_TO_BOOL :
+                                                                 OP_CAST;
+            break;
+        case TYPE_FLOAT:
+            op = IS_TYPE(dest, TYPE_INT) ? OP_FLOAT_TO_INT : IS_TYPE(dest, TYPE_STRING) ? OP_FLOAT_TO_STR : OP_CAST;
+            break;
+        case TYPE_STRING:
+            op = IS_TYPE(dest, TYPE_INT) ? OP_STR_TO_INT : IS_TYPE(dest, TYPE_FLOAT) ? OP_STR_TO_FLOAT :
+                    IS_TYPE(dest, TYPE_BOOL)                  ? OP_STR_TO_BOOL :
+                                                                OP_CAST;
+            break;
+        case TYPE_BOOL:
+            op = IS_TYPE(dest, TYPE_STRING) ? OP_BOOL_TO_STR : IS_TYPE(dest, TYPE_INT) ? OP_BOOL_TO_INT : OP_CAST;
+            break;
+        default:
+            break;
+    }
+
+    if(op == OP_CAST)
+        EMIT1(OP_CAST, type_to_val_type(dest));
+    else
+        EMIT(op);
+}
+
+static void emit_expression_list(codegen_t* gen, ast_expression_list_t* node) {
+
+    if(node == NULL)
+        return;
+
+    int mark = 0;
+    ast_expression_t* item;
+    while(iterate_expr_list(node->list, &mark, &item))
+        emit_expression(gen, item);
+}
+
+/*
+ * Push a name and a value for each item of a dict.
+ */
+static int emit_dss_items(codegen_t* gen, ast_dss_initializer_t* node) {
+
+    if(node == NULL)
+        return 0;
+
+    int mark = 0;
+    ast_dss_initializer_item_t* item;
+    while(iterate_dss_item_list(node->list, &mark, &item)) {
+        emit_str(gen, raw_string(item->STRING_LITERAL->str));
+        emit_expression(gen, item->expression);
+    }
+
+    return len_dss_item_list(node->list);
+}
+
+/*
+ * The template is compiled into a format program of the module, and only
+ * the values are pushed. A template without placeholders is a plain string
+ * constant, but its values are still evaluated.
+ */
+static void emit_formatted_string(codegen_t* gen, ast_formatted_string_t* node) {
+
+    // a string literal with no values is not a template
+    if(node->dss_initializer == NULL) {
+        emit_str(gen, raw_string(node->STRING_LITERAL->str));
+        return;
+    }
+
+    int nargs = len_dss_item_list(node->dss_initializer->list);
+    const char** names = NULL;
+    value_type_t* types = NULL;
+
+    if(nargs > 0) {
+        names = _ALLOC_ARRAY(const char*, nargs);
+        types = _ALLOC_ARRAY(value_type_t, nargs);
+
+        int mark = 0;
+        ast_dss_initializer_item_t* item;
+        for(int i = 0; iterate_dss_item_list(node->dss_initializer->list, &mark, &item); i++) {
+            names[i] = raw_string(item->STRING_LITERAL->str);
+            types[i] = type_to_val_type(emit_expression(gen, item->expression));
+        }
+    }
+
+    format_t fmt;
+    const char* msg = compile_format(&fmt, raw_string(node->STRING_LITERAL->str), names, types, nargs);
+    if(msg != NULL)
+        FATAL("internal error: formatted string passed the type checker: %s", msg);
+
+    bool has_slots = false;
+    for(int i = 0; i < fmt.nsegs; i++)
+        if(fmt.segs[i].kind != FMT_LITERAL)
+            has_slots = true;
+
+    if(has_slots)
+        EMIT1(OP_FORMAT, add_format(gen->mod, &fmt));
+    else {
+        for(int i = 0; i < nargs; i++)
+            EMIT(OP_POP);
+        emit_str(gen, fmt.text);
+        free_format(&fmt);
+    }
+
+    if(nargs > 0) {
+        _FREE(names);
+        _FREE(types);
+    }
+}
+
+static void emit_call(codegen_t* gen, symbol_t* func, ast_function_reference_t* node) {
+
+    int argc = 0;
+
+    if(node->expression_list != NULL) {
+        int mark = 0;
+        ast_expression_t* arg;
+        while(iterate_expr_list(node->expression_list->list, &mark, &arg)) {
+            type_t* type = emit_expression(gen, arg);
+            emit_check(gen, ((symbol_t*)index_ptr_list(func->members, argc))->type, type);
+            argc++;
+        }
+    }
+
+    EMIT2(OP_CALL, func->slot, argc);
+}
+
+/*
+ * Return the static type of the value that is left on the stack, or
+ * nothing if the reference is a call to a function that returns nothing.
+ */
+static type_t* emit_compound_reference(codegen_t* gen, ast_compound_reference_t* node) {
+
+    type_t* type = NULL;
+
+    int mark = 0;
+    ast_compound_reference_element_t* item;
+    while(iterate_ref_element_list(node->list, &mark, &item)) {
+        if(item->function_reference != NULL) {
+            emit_call(gen, item->sym, item->function_reference);
+            type = item->sym->type;
+            continue;
+        }
+
+        token_t* tok = (item->list_reference != NULL) ? item->list_reference->IDENTIFIER : item->IDENTIFIER;
+        if(mark == 1) {
+            emit_load(gen, item->sym);
+            type = item->sym->type;
+        }
+        else {
+            emit_get_field(gen, item->sym, tok);
+            type = (item->sym != NULL) ? item->sym->type : get_basic_type(TYPE_ANY);
+        }
+
+        if(item->list_reference != NULL) {
+            int m = 0;
+            ast_expression_t* index;
+            while(iterate_expr_list(item->list_reference->list, &m, &index)) {
+                emit_expression(gen, index);
+                EMIT(OP_GET_INDEX);
+                type = IS_TYPE(type, TYPE_STRING) ? type : get_basic_type(TYPE_ANY);
+            }
+        }
+    }
+
+    return type;
+}
+
+static void emit_operand(codegen_t* gen, ast_primary_expression_t* node) {
+
+    if(node->token != NULL) {
+        const char* str = raw_string(node->token->str);
+        switch(node->token->type) {
+            case TOK_INT_LITERAL:
+                emit_int(gen, node->token->ival);
+                break;
+            case TOK_FLOAT_LITERAL:
+                emit_float(gen, node->token->fval);
+                break;
+            case TOK_STRING_LITERAL:
+                emit_str(gen, str);
+                break;
+            case TOK_TRUE:
+                EMIT(OP_PUSH_TRUE);
+                break;
+            case TOK_FALSE:
+                EMIT(OP_PUSH_FALSE);
+                break;
+            default:
+                FATAL("internal AST error: unexpected token in expression: %s", tok_type_to_str(node->token));
+        }
+        return;
+    }
+
+    switch(node->nterm->type) {
+        case AST_COMPOUND_REFERENCE:
+            emit_compound_reference(gen, (ast_compound_reference_t*)node->nterm);
+            break;
+        case AST_FORMATTED_STRING:
+            emit_formatted_string(gen, (ast_formatted_string_t*)node->nterm);
+            break;
+        case AST_BOOL_LITERAL:
+            EMIT((((ast_bool_literal_t*)node->nterm)->tok->type == TOK_TRUE) ? OP_PUSH_TRUE : OP_PUSH_FALSE);
+            break;
+        case AST_EXPRESSION:
+            emit_expression(gen, (ast_expression_t*)node->nterm);
+            break;
+        default:
+            FATAL("internal AST error: unexpected node in expression: %d", node->nterm->type);
+    }
+}
+
+static type_t* emit_expression(codegen_t* gen, ast_expression_t* node) {
+
+    type_stack_t stack;
+    init_type_stack(&stack);
+
+    int mark = 0;
+    ast_primary_expression_t* item;
+    while(iterate_expr_item_list(node->list, &mark, &item)) {
+        operator_t op = get_operator(item);
+
+        if(op != OPER_NONE) {
+            type_t* right = is_unary_operator(op) ? NULL : pop_type_stack(&stack);
+            type_t* left = pop_type_stack(&stack);
+            emit_operator(gen, op, left, is_unary_operator(op) ? left : right);
+        }
+        else if(item->nterm != NULL && item->nterm->type == AST_TYPE_NAME)
+            emit_cast(gen, item->type, pop_type_stack(&stack));
+        else
+            emit_operand(gen, item);
+
+        push_type_stack(&stack, item->type);
+    }
+
+    free_type_stack(&stack);
+
+    return node->type;
+}
+
+static void emit_initializer(codegen_t* gen, type_t* type, ast_initializer_t* node) {
+
+    if(node == NULL) {
+        type_stack_t outer;
+        init_type_stack(&outer);
+        emit_default(gen, type, &outer);
+        free_type_stack(&outer);
+        return;
+    }
+
+    switch(node->nterm->type) {
+        case AST_EXPRESSION:
+            emit_check(gen, type, emit_expression(gen, (ast_expression_t*)node->nterm));
+            break;
+        case AST_LIST_INIT: {
+            ast_list_init_t* n = (ast_list_init_t*)node->nterm;
+            emit_expression_list(gen, n->expression_list);
+            EMIT1(OP_NEW_LIST, (n->expression_list != NULL) ? len_expr_list(n->expression_list->list) : 0);
+        } break;
+        case AST_DICT_INIT:
+            EMIT1(OP_NEW_DICT, emit_dss_items(gen, ((ast_dict_init_t*)node->nterm)->dss_initializer));
+            break;
+        case AST_STRUCT_INIT: {
+            // every field is pushed in slot order, from its item or its default
+            ast_dss_initializer_t* n = ((ast_struct_init_t*)node->nterm)->dss_initializer;
+            type_stack_t outer;
+            init_type_stack(&outer);
+            push_type_stack(&outer, type);
+
+            int mark = 0;
+            symbol_t* field;
+            while(NULL != (field = iterate_ptr_list(type->sym->members, &mark))) {
+                int m = 0;
+                ast_dss_initializer_item_t* item;
+                ast_dss_initializer_item_t* found = NULL;
+                while(iterate_dss_item_list(n->list, &m, &item))
+                    if(item->sym == field) {
+                        found = item;
+                        break;
+                    }
+
+                if(found != NULL)
+                    emit_check(gen, field->type, emit_expression(gen, found->expression));
+                else
+                    emit_default(gen, field->type, &outer);
+            }
+
+            free_type_stack(&outer);
+            EMIT1(OP_NEW_STRUCT, type->sym->slot);
+        } break;
+        default:
+            FATAL("internal AST error: Unknown initializer type: %d", node->nterm->type);
+    }
+}
+
+static void emit_data_definition(codegen_t* gen, ast_data_definition_t* node) {
+
+    symbol_t* sym = node->data_declaration->sym;
+
+    emit_initializer(gen, sym->type, node->initializer);
+    emit_store(gen, sym);
+}
+
+/*
+ * The object that holds the last field is loaded, then the value is stored
+ * into it. A field that is not resolved is set by name.
+ */
+static void emit_assignment(codegen_t* gen, ast_assignment_t* node) {
+
+    ast_compound_name_t* name = node->compound_name;
+    int nfields = len_symbol_list(name->fields);
+
+    if(nfields == 0) {
+        emit_check(gen, name->type, emit_expression(gen, node->expression));
+        emit_store(gen, name->sym);
+        return;
+    }
+
+    emit_load(gen, name->sym);
+    for(int i = 0; i < nfields - 1; i++)
+        emit_get_field(gen, index_symbol_list(name->fields, i), index_token_list(name->list, i + 1));
+
+    emit_check(gen, name->type, emit_expression(gen, node->expression));
+    emit_set_field(gen, index_symbol_list(name->fields, nfields - 1), index_token_list(name->list, nfields));
+}
+
+static void patch_list(codegen_t* gen, array_t* list, int target) {
+
+    int mark = 0;
+    int* pos;
+    while(NULL != (pos = iterate_array_data(list, &mark)))
+        patch_jump(gen->func, *pos, target);
+}
+
+static void begin_loop(codegen_t* gen, loop_t* loop) {
+
+    loop->breaks = create_array(sizeof(int), NULL);
+    loop->continues = create_array(sizeof(int), NULL);
+    loop->outer = gen->loop;
+    gen->loop = loop;
+}
+
+static void end_loop(codegen_t* gen, int cont, int brk) {
+
+    loop_t* loop = gen->loop;
+
+    patch_list(gen, loop->continues, cont);
+    patch_list(gen, loop->breaks, brk);
+    destroy_array(loop->continues);
+    destroy_array(loop->breaks);
+    gen->loop = loop->outer;
+}
+
+/*
+ * An if without a condition was folded to a block that always runs.
+ */
+static void emit_if_clause(codegen_t* gen, ast_if_clause_t* node) {
+
+    if(node->expression == NULL) {
+        emit_function_body(gen, node->function_body);
+        return;
+    }
+
+    array_t* ends = create_array(sizeof(int), NULL);
+
+    emit_expression(gen, node->expression);
+    int next = EMIT1(OP_JUMP_FALSE, 0);
+    emit_function_body(gen, node->function_body);
+
+    if(node->else_clause != NULL) {
+        int pos = EMIT1(OP_JUMP, 0);
+        append_array_data(ends, &pos);
+        patch_jump(gen->func, next, HERE);
+
+        emit_expression(gen, node->else_clause->expression);
+        next = EMIT1(OP_JUMP_FALSE, 0);
+        emit_function_body(gen, node->else_clause->function_body);
+    }
+
+    if(node->final_else_clause != NULL) {
+        int pos = EMIT1(OP_JUMP, 0);
+        append_array_data(ends, &pos);
+        patch_jump(gen->func, next, HERE);
+        emit_function_body(gen, node->final_else_clause->function_body);
+    }
+    else
+        patch_jump(gen->func, next, HERE);
+
+    patch_list(gen, ends, HERE);
+    destroy_array(ends);
+}
+
+static void emit_while_clause(codegen_t* gen, ast_while_clause_t* node) {
+
+    loop_t loop;
+    begin_loop(gen, &loop);
+
+    int top = HERE;
+    int done = -1;
+    if(node->expression != NULL) {
+        emit_expression(gen, node->expression);
+        done = EMIT1(OP_JUMP_FALSE, 0);
+    }
+
+    emit_loop_body(gen, node->loop_body);
+    patch_jump(gen->func, EMIT1(OP_JUMP, 0), top);
+
+    if(done >= 0)
+        patch_jump(gen->func, done, HERE);
+    end_loop(gen, top, HERE);
+}
+
+static void emit_do_clause(codegen_t* gen, ast_do_clause_t* node) {
+
+    loop_t loop;
+    begin_loop(gen, &loop);
+
+    int top = HERE;
+    emit_loop_body(gen, node->loop_body);
+
+    int cont = HERE;
+    if(node->expression != NULL) {
+        emit_expression(gen, node->expression);
+        patch_jump(gen->func, EMIT1(OP_JUMP_TRUE, 0), top);
+    }
+    else
+        patch_jump(gen->func, EMIT1(OP_JUMP, 0), top);
+
+    end_loop(gen, cont, HERE);
+}
+
+/*
+ * See check_for_clause() for the three kinds of for loop. The count and the
+ * iterator live in frame slots past the locals of the function.
+ */
+static void emit_for_clause(codegen_t* gen, ast_for_clause_t* node) {
+
+    loop_t loop;
+    type_t* type = (node->expression != NULL) ? node->expression->type : get_basic_type(TYPE_BOOL);
+    int top, done = -1, temp = -1;
+
+    if(node->IDENTIFIER != NULL) {
+        emit_expression(gen, node->expression);
+        temp = alloc_temp(gen);
+        EMIT1(OP_ITER_INIT, temp);
+
+        begin_loop(gen, &loop);
+        top = HERE;
+        done = EMIT2(OP_ITER_NEXT, temp, 0);
+        emit_check(gen, node->sym->type, IS_TYPE(type, TYPE_STRING) ? type : get_basic_type(TYPE_ANY));
+        emit_store(gen, node->sym);
+    }
+    else if(IS_TYPE(type, TYPE_INT)) {
+        emit_expression(gen, node->expression);
+        temp = alloc_temp(gen);
+        EMIT1(OP_STORE_LOCAL, temp);
+
+        begin_loop(gen, &loop);
+        top = HERE;
+        EMIT1(OP_LOAD_LOCAL, temp);
+        EMIT1(OP_PUSH_INT, 0);
+        EMIT(OP_GT_INT);
+        done = EMIT1(OP_JUMP_FALSE, 0);
+        EMIT1(OP_LOAD_LOCAL, temp);
+        EMIT1(OP_PUSH_INT, 1);
+        EMIT(OP_SUB_INT);
+        EMIT1(OP_STORE_LOCAL, temp);
+    }
+    else {
+        // a condition, evaluated before every pass
+        begin_loop(gen, &loop);
+        top = HERE;
+        if(node->expression != NULL) {
+            emit_expression(gen, node->expression);
+            done = EMIT1(OP_JUMP_FALSE, 0);
+        }
+    }
+
+    emit_loop_body(gen, node->loop_body);
+    patch_jump(gen->func, EMIT1(OP_JUMP, 0), top);
+
+    if(done >= 0)
+        patch_jump(gen->func, done, HERE);
+    end_loop(gen, top, HERE);
+
+    if(temp >= 0)
+        free_temp(gen);
+}
+
+static void emit_function_body_element(codegen_t* gen, ast_function_body_element_t* node) {
+
+    if(node == NULL || node->INLINE != NULL)
+        return;
+
+    add_line(gen->func, node->nterm->line_no, node->nterm->col_no);
+    switch(node->nterm->type) {
+        case AST_ASSIGNMENT:
+            emit_assignment(gen, (ast_assignment_t*)node->nterm);
+            break;
+        case AST_COMPOUND_REFERENCE: {
+            type_t* type = emit_compound_reference(gen, (ast_compound_reference_t*)node->nterm);
+            if(!IS_TYPE(type, TYPE_NOTHING))
+                EMIT(OP_POP);
+        } break;
+        case AST_DATA_DEFINITION:
+            emit_data_definition(gen, (ast_data_definition_t*)node->nterm);
+            break;
+        case AST_STRUCT_DEFINITION:
+            break;
+        case AST_IF_CLAUSE:
+            emit_if_clause(gen, (ast_if_clause_t*)node->nterm);
+            break;
+        case AST_WHILE_CLAUSE:
+            emit_while_clause(gen, (ast_while_clause_t*)node->nterm);
+            break;
+        case AST_DO_CLAUSE:
+            emit_do_clause(gen, (ast_do_clause_t*)node->nterm);
+            break;
+        case AST_FOR_CLAUSE:
+            emit_for_clause(gen, (ast_for_clause_t*)node->nterm);
+            break;
+        case AST_RETURN_STATEMENT: {
+            ast_return_statement_t* n = (ast_return_statement_t*)node->nterm;
+            if(n->expression != NULL) {
+                emit_check(gen, gen->sym->type, emit_expression(gen, n->expression));
+                EMIT(OP_RETURN_VALUE);
+            }
+            else
+                EMIT(OP_RETURN);
+        } break;
+        case AST_EXIT_STATEMENT:
+            emit_expression(gen, ((ast_exit_statement_t*)node->nterm)->expression);
+            EMIT(OP_EXIT);
+            break;
+        default:
+            FATAL("internal AST error: Unknown body element type: %d", node->nterm->type);
+    }
+}
+
+static void emit_function_body(codegen_t* gen, ast_function_body_t* node) {
+
+    if(node == NULL || node->function_body_list == NULL)
+        return;
+
+    int mark = 0;
+    ast_function_body_prelist_t* item;
+    while(iterate_body_item_list(node->function_body_list->list, &mark, &item)) {
+        if(item->nterm->type == AST_FUNCTION_BODY)
+            emit_function_body(gen, (ast_function_body_t*)item->nterm);
+        else
+            emit_function_body_element(gen, (ast_function_body_element_t*)item->nterm);
+    }
+}
+
+static void emit_loop_body(codegen_t* gen, ast_loop_body_t* node) {
+
+    if(node == NULL || node->loop_body_list == NULL)
+        return;
+
+    int mark = 0;
+    ast_loop_body_prelist_t* item;
+    while(iterate_loop_item_list(node->loop_body_list->list, &mark, &item)) {
+        if(item->nterm->type == AST_LOOP_BODY)
+            emit_loop_body(gen, (ast_loop_body_t*)item->nterm);
+        else {
+            ast_loop_body_element_t* elem = (ast_loop_body_element_t*)item->nterm;
+            if(elem->tok == NULL)
+                emit_function_body_element(gen, elem->function_body_element);
+            else if(gen->loop == NULL)
+                TOKEN_ERROR(elem->tok, "\"%s\" is outside of a loop", raw_string(elem->tok->str));
+            else {
+                int pos = EMIT1(OP_JUMP, 0);
+                append_array_data((elem->tok->type == TOK_BREAK) ? gen->loop->breaks : gen->loop->continues, &pos);
+            }
+        }
+    }
+}
+
+static void begin_code(codegen_t* gen, symbol_t* sym) {
+
+    gen->sym = sym;
+    gen->func = &gen->mod->functions[sym->slot];
+    gen->func->name = sym->name;
+    gen->func->nparams = len_ptr_list(sym->members);
+    gen->func->frame_size = sym->frame_size;
+    gen->func->returns_value = !IS_TYPE(sym->type, TYPE_NOTHING);
+    gen->temps = sym->frame_size;
+}
+
+/*
+ * A function that is implemented in C has no code. Its signature is kept
+ * for the FFI, which binds it when the module is loaded.
+ */
+static void emit_foreign(codegen_t* gen, symbol_t* sym) {
+
+    foreign_t* foreign = _ALLOC_TYPE(foreign_t);
+    foreign->symbol = sym->foreign;
+    foreign->ret = type_to_val_type(sym->type);
+    foreign->params = NULL;
+    foreign->bound = NULL;
+
+    int nparams = len_ptr_list(sym->members);
+    if(nparams > 0) {
+        foreign->params = _ALLOC_ARRAY(value_type_t, nparams);
+        for(int i = 0; i < nparams; i++)
+            foreign->params[i] = type_to_val_type(((symbol_t*)index_ptr_list(sym->members, i))->type);
+    }
+
+    gen->func->foreign = foreign;
+}
+
+/*
+ * An import of a shared library makes its functions available to the
+ * functions that are implemented in C. Importing Toy modules is not
+ * supported yet.
+ */
+static void emit_import(codegen_t* gen, ast_import_statement_t* node) {
+
+    const char* path = raw_string(node->STRING_LITERAL->str);
+    const char* ext = strstr(path, ".so");
+
+    if((ext != NULL && (ext[3] == '\0' || ext[3] == '.')) || strstr(path, ".dylib") != NULL)
+        add_library(gen->mod, intern_string(path));
+}
+
+/*
+ * The module tables are laid out from the symbol table. The global
+ * initializers go in a function of their own after the last real one.
+ */
+static void layout_module(codegen_t* gen, symtab_t* tab) {
+
+    gen->mod = create_module(tab->function_count + 1, tab->struct_count, tab->global_count);
+    gen->mod->init = tab->function_count;
+    gen->mod->functions[gen->mod->init].name = intern_string("$init");
+
+    int mark = 0;
+    symbol_t* sym;
+    while(NULL != (sym = iterate_ptr_list(tab->symbols, &mark))) {
+        if(sym->kind == SYM_STRUCT) {
+            struct_info_t* info = &gen->mod->structs[sym->slot];
+            info->name = sym->name;
+            info->nfields = len_ptr_list(sym->members);
+            info->fields = _ALLOC_ARRAY(const char*, info->nfields + 1);
+            for(int i = 0; i < info->nfields; i++)
+                info->fields[i] = ((symbol_t*)index_ptr_list(sym->members, i))->name;
+        }
+        else if(sym->kind == SYM_FUNCTION && sym->decl->type == AST_START_BLOCK)
+            gen->mod->start = sym->slot;
+    }
+}
+
+static void save_profile(module_t* mod, const char* fname) {
+
+    opcode_profile_t* prof = create_opcode_profile();
+
+    for(int i = 0; i < mod->nfunctions; i++)
+        profile_function(prof, &mod->functions[i]);
+    save_opcode_profile(prof, fname);
+
+    destroy_opcode_profile(prof);
+}
+
+/*
+ * public interface
+ */
+module_t* generate_code(symtab_t* tab, ast_node_t* node) {
+
+    if(in_cmd_list("trace", "codegen"))
+        push_trace_state(1);
+    else
+        push_trace_state(0);
+
+    codegen_t gen;
+    memset(&gen, 0, sizeof(codegen_t));
+    gen.consts = create_hashtable();
+    layout_module(&gen, tab);
+
+    function_t* init = &gen.mod->functions[gen.mod->init];
+
+    int mark = 0;
+    ast_translation_unit_element_t* item;
+    while(node != NULL && iterate_unit_item_list(((ast_translation_unit_t*)node)->list, &mark, &item)) {
+        switch(item->nterm->type) {
+            case AST_DATA_DEFINITION:
+                gen.func = init;
+                gen.temps = 0;
+                add_line(init, item->nterm->line_no, item->nterm->col_no);
+                emit_data_definition(&gen, (ast_data_definition_t*)item->nterm);
+                break;
+            case AST_FUNCTION_DEFINITION: {
+                ast_function_definition_t* n = (ast_function_definition_t*)item->nterm;
+                begin_code(&gen, n->function_name->sym);
+                if(n->function_name->sym->foreign != NULL)
+                    emit_foreign(&gen, n->function_name->sym);
+                else {
+                    emit_function_body(&gen, n->function_body);
+                    emit_code(gen.func, OP_RETURN, 0, 0);
+                }
+            } break;
+            case AST_START_BLOCK: {
+                ast_start_block_t* n = (ast_start_block_t*)item->nterm;
+                begin_code(&gen, n->sym);
+                emit_function_body(&gen, n->function_body);
+                emit_code(gen.func, OP_RETURN, 0, 0);
+            } break;
+            case AST_IMPORT_STATEMENT:
+                emit_import(&gen, (ast_import_statement_t*)item->nterm);
+                break;
+            default:
+                break;
+        }
+    }
+
+    emit_code(init, OP_RETURN, 0, 0);
+    destroy_hashtable(gen.consts);
+
+    // a break or continue with no loop to go to
+    if(get_sem_errors() > 0) {
+        destroy_module(gen.mod);
+        pop_trace_state();
+        return NULL;
+    }
+
+    // the profile is of the code before it is fused
+    const char* profile = raw_string(get_cmd_opt("opcode-profile"));
+    if(profile != NULL && profile[0] != '\0')
+        save_profile(gen.mod, profile);
+    fuse_module(gen.mod);
+
+    MSG(5, "codegen: %d functions, %d constants\n", gen.mod->nfunctions, gen.mod->nconsts);
+    if(peek_trace_state())
+        dump_module(get_trace_handle(), gen.mod);
+
+    pop_trace_state();
+
+    return gen.mod;
+}
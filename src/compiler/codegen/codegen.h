@@ -0,0 +1,19 @@
+/**
+ * @file codegen.h
+ *
+ * @brief Public interface for the bytecode generator. This runs after the
+ * type checker, and only when there were no errors. It returns NULL for a
+ * break or continue that is not in a loop, which is reported as an error.
+ *
+ */
+#ifndef _CODEGEN_H_
+#define _CODEGEN_H_
+
+#include "ast.h"
+#include "symtab.h"
+#include "module.h"
+
+module_t* generate_code(symtab_t* tab, ast_node_t* node);
+void fuse_module(module_t* mod);
+
+#endif /* _CODEGEN_H_ */
@@ -0,0 +1,134 @@
+/**
+ * @file fuse.c
+ *
+ * @brief Replace the runs of instructions that have a superinstruction
+ * with it. This runs on the finished code of every function, as the last
+ * step of the code generator.
+ *
+ * A run is never fused across an instruction that something jumps to, or
+ * that starts a line table entry, so every jump target and every source
+ * position stays at the start of an instruction. Only the last instruction
+ * of a run can be a jump. The longest run that matches wins, from left to
+ * right.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "trace.h"
+#include "alloc.h"
+#include "codegen.h"
+
+static inline int jump_target(const uint8_t* code, int pos) {
+
+    int size = OPCODE_SIZE(code[pos]);
+    return pos + size + read_operand(&code[pos + size - (int)sizeof(int32_t)]);
+}
+
+/*
+ * Find the superinstruction for the longest run at pos. Returns -1 when
+ * there is none.
+ */
+static int match_run(function_t* func, int pos, const bool* barrier) {
+
+    int best = -1;
+
+    for(int i = 0; i < fusion_count; i++) {
+        const fusion_t* fuse = &fusion_table[i];
+        if(best >= 0 && fuse->len <= fusion_table[best].len)
+            continue;
+
+        int at = pos;
+        int k;
+        for(k = 0; k < fuse->len && at < func->len; k++) {
+            opcode_t op = (opcode_t)func->code[at];
+            if(op != fuse->parts[k] || (k > 0 && barrier[at]) || (k < fuse->len - 1 && opcode_info[op].jump))
+                break;
+            at += OPCODE_SIZE(op);
+        }
+
+        if(k == fuse->len)
+            best = i;
+    }
+
+    return best;
+}
+
+static void fuse_function(function_t* func) {
+
+    bool* barrier = _ALLOC_ARRAY(bool, func->len + 1);
+    memset(barrier, 0, sizeof(bool) * (func->len + 1));
+
+    for(int pos = 0; pos < func->len; pos += OPCODE_SIZE(func->code[pos]))
+        if(opcode_info[func->code[pos]].jump) {
+            int dest = jump_target(func->code, pos);
+            ASSERT(dest >= 0 && dest <= func->len, "jump out of the function: %d", dest);
+            barrier[dest] = true;
+        }
+    mark_lines(func, barrier);
+
+    // a fused run is never longer than the run, so the code only shrinks
+    uint8_t* code = _ALLOC_ARRAY(uint8_t, func->cap);
+    int* new_pos = _ALLOC_ARRAY(int, func->len + 1);
+    int len = 0;
+    int fused = 0;
+
+    // the jumps are written with the old target, and fixed when every
+    // instruction has its new position
+    for(int pos = 0; pos < func->len;) {
+        int index = match_run(func, pos, barrier);
+        new_pos[pos] = len;
+
+        if(index < 0) {
+            int size = OPCODE_SIZE(func->code[pos]);
+            memcpy(&code[len], &func->code[pos], size);
+            if(opcode_info[func->code[pos]].jump)
+                write_operand(&code[len + size - sizeof(int32_t)], jump_target(func->code, pos));
+            len += size;
+            pos += size;
+            continue;
+        }
+
+        const fusion_t* fuse = &fusion_table[index];
+        code[len++] = (uint8_t)fuse->op;
+        for(int k = 0; k < fuse->len; k++) {
+            int size = OPCODE_SIZE(func->code[pos]);
+            memcpy(&code[len], &func->code[pos + 1], size - 1);
+            if(opcode_info[func->code[pos]].jump)
+                write_operand(&code[len + size - 1 - sizeof(int32_t)], jump_target(func->code, pos));
+            len += size - 1;
+            pos += size;
+        }
+        fused++;
+    }
+    new_pos[func->len] = len;
+
+    for(int pos = 0; pos < len; pos += OPCODE_SIZE(code[pos]))
+        if(opcode_info[code[pos]].jump) {
+            int size = OPCODE_SIZE(code[pos]);
+            uint8_t* operand = &code[pos + size - sizeof(int32_t)];
+            write_operand(operand, new_pos[read_operand(operand)] - (pos + size));
+        }
+
+    MSG(5, "fuse: %s: %d runs, %d bytes to %d\n", func->name, fused, func->len, len);
+
+    remap_lines(func, new_pos);
+    _FREE(func->code);
+    func->code = code;
+    func->len = len;
+
+    _FREE(new_pos);
+    _FREE(barrier);
+}
+
+/*
+ * public interface
+ */
+void fuse_module(module_t* mod) {
+
+    for(int i = 0; i < mod->nfunctions; i++)
+        if(mod->functions[i].code != NULL && mod->functions[i].len > 0)
+            fuse_function(&mod->functions[i]);
+}
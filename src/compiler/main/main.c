@@ -3,14 +3,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "cmdline.h"
 #include "trace.h"
 #include "errors.h"
 #include "parser.h"
+#include "passes.h"
+#include "codegen.h"
+#include "intern.h"
+#include "alloc.h"
 
 #include "tokens.h"
 #include "file_io.h"
+#include "fileio.h"
+#include "server.h"
+#include "module_cache.h"
+#include "watch.h"
+#include "image.h"
+
+// the server parses the command line of every request with its own
+static char** saved_env = NULL;
 
 void cmdline(int argc, char** argv, char** env) {
 
@@ -18,27 +31,49 @@ void cmdline(int argc, char** argv, char** env) {
     add_cmdline('v', "verbosity", "verbosity", "From 0 to 10. Print more information", "0", NULL, CMD_NUM | CMD_ARGS);
     add_cmdline('p', "path", "path", "Add to the import path", "", NULL, CMD_STR | CMD_ARGS | CMD_LIST);
     add_cmdline('t', "trace", "trace", "Trace the state as compiler runs", "", NULL, CMD_STR | CMD_ARGS | CMD_LIST);
+    add_cmdline('T', "trace-file", "trace-file", "Record a binary trace of the compile in a file", "", NULL, CMD_STR | CMD_ARGS);
+    add_cmdline('s', "stats", "stats", "Print statistics about the compiled module", NULL, NULL, CMD_SWITCH);
+    add_cmdline('k', "tokens", "tokens", "Print the tokens and stop", NULL, NULL, CMD_SWITCH);
+    add_cmdline('C', "compile", "compile", "Parse and compile the file instead of printing its tokens", NULL, NULL,
+                CMD_SWITCH);
+    add_cmdline('b', "bytecode", "bytecode", "Write the compiled module to a bytecode image", "", NULL,
+                CMD_STR | CMD_ARGS);
+    add_cmdline('P', "opcode-profile", "opcode-profile", "Add an estimated opcode profile of the code to a file", "",
+                NULL, CMD_STR | CMD_ARGS);
+    add_cmdline('L', "lex", "lex", "How tokens are scanned: demand, batch, file or pipeline", "batch", NULL,
+                CMD_STR | CMD_ARGS);
+    add_cmdline('S', "server", "server", "Serve compile requests on a socket", NULL, NULL, CMD_SWITCH);
+    add_cmdline('c', "client", "client", "Send the compile to the server, compile here if there is none", NULL, NULL,
+                CMD_SWITCH);
+    add_cmdline('w', "watch", "watch", "Compile the files again every time they change", NULL, NULL, CMD_SWITCH);
+    add_cmdline('o', "socket", "socket", "Socket of the compile server", "", NULL, CMD_STR | CMD_ARGS);
     add_cmdline('h', "help", NULL, "Print this helpful information", NULL, cmdline_help, CMD_NONE);
     add_cmdline('V', "version", NULL, "Show the program version", NULL, cmdline_vers, CMD_NONE);
     add_cmdline(0, NULL, NULL, NULL, NULL, NULL, CMD_DIV);
-    add_cmdline(0, NULL, "files", "File name(s) to input", NULL, NULL, CMD_REQD | CMD_ANON);
+    add_cmdline(0, NULL, "files", "File name(s) to input", NULL, NULL, CMD_ANON);
 
     parse_cmdline(argc, argv, env);
 
     INIT_TRACE(NULL);
 }
 
-int main(int argc, char** argv, char** env) {
+static bool set_prefetch(void) {
 
-    cmdline(argc, argv, env);
+    const char* mode = raw_string(get_cmd_opt("lex"));
+    for(prefetch_mode_t m = PREFETCH_DEMAND; m <= PREFETCH_PIPELINE; m++)
+        if(!strcmp(mode, prefetch_to_str(m))) {
+            set_token_prefetch(m);
+            return true;
+        }
 
-    const char* fname = raw_string(get_cmd_opt("files"));
-    if(fname != NULL)
-        open_file(fname);
-    else
-        FATAL("internal error in %s: command line failed", __func__);
+    fprintf(stderr, "toy: unknown lex mode: %s\n", mode);
+    return false;
+}
+
+static void dump_tokens(void) {
 
     token_t* tok;
+    char buf[32];
     init_token_queue();
     while(true) {
         tok = get_token();
@@ -46,9 +81,272 @@ int main(int argc, char** argv, char** env) {
             break;
         fprintf(stderr, "%s \"%s\" \"%s\" %d %d\n",
                 tok_type_to_str(tok), tok_type_to_str(tok),
-                raw_string(tok->str), tok->line_no, tok->col_no);
+                token_to_str(tok, buf, sizeof(buf)), tok->line_no, tok->col_no);
         consume_token();
     }
+}
+
+static void print_stats(compile_stats_t* stats, module_t* mod) {
+
+    int code = 0;
+    for(int i = 0; i < mod->nfunctions; i++)
+        code += mod->functions[i].len;
+
+    printf("%-19s%d\n", "globals:", stats->globals);
+    printf("%-19s%d\n", "functions:", stats->functions);
+    printf("%-19s%d\n", "structs:", stats->structs);
+    printf("%-19s%d\n", "interned strings:", len_intern_table());
+    printf("%-19s%lu\n", "pruned attempts:", get_pruned_attempts());
+    printf("%-19s%d\n", "folded nodes:", stats->fold.folded);
+    printf("%-19s%d\n", "propagated consts:", stats->fold.propagated);
+    printf("%-19s%d\n", "pruned branches:", stats->fold.pruned);
+    printf("%-19s%d\n", "constants:", mod->nconsts);
+    printf("%-19s%d\n", "format programs:", mod->nformats);
+    printf("%-19s%d\n", "member caches:", mod->ncaches);
+    printf("%-19s%d\n", "code bytes:", code);
+    if(get_verbosity() > 1)
+        print_slab_stats(stdout);
+}
+
+#ifndef NO_TRACE
+static const char* trace_file = NULL;
+
+/*
+ * The trace is written when the program exits, so a compile that stops on
+ * an error is recorded too.
+ */
+static void save_trace(void) {
+
+    write_trace_ring(trace_file);
+}
+#endif
+
+static bool tracing(void) {
+
+    int mark = 0;
+    string_t* str;
+    while(NULL != (str = iterate_cmd_opt("trace", &mark)))
+        if(*raw_string(str) != '\0')
+            return true;
+
+    return false;
+}
+
+/*
+ * Run the passes in order. Code is only generated for a module that has no
+ * errors, otherwise NULL is returned. Folding rewrites the AST, so it is
+ * left out for an AST that is kept to be compiled again.
+ */
+static module_t* compile_ast(ast_node_t* ast, compile_stats_t* stats, bool fold) {
+
+    symtab_t* tab = resolve_names(ast);
+    check_types(tab, ast);
+
+    if(get_sem_errors() > 0) {
+        fprintf(stderr, "%d errors\n", get_sem_errors());
+        destroy_symtab(tab);
+        return NULL;
+    }
+
+    if(fold)
+        fold_constants(ast, &stats->fold);
+    else
+        memset(&stats->fold, 0, sizeof(fold_stats_t));
+    module_t* mod = generate_code(tab, ast);
+    if(mod == NULL)
+        fprintf(stderr, "%d errors\n", get_sem_errors());
+
+    stats->globals = tab->global_count;
+    stats->functions = tab->function_count;
+    stats->structs = tab->struct_count;
+
+    destroy_symtab(tab);
+    return mod;
+}
+
+static module_t* compile(compile_stats_t* stats) {
+
+    init_token_queue();
+    ast_node_t* ast = parse();
+    if(ast == NULL)
+        return NULL;
+
+    return compile_ast(ast, stats, true);
+}
+
+// put the scanner and the passes back the way they were before a compile
+static void reset_compiler(void) {
+
+    destroy_token_queue();
+    reset_file_io();
+    reset_sem_errors();
+}
+
+static bool write_bytecode(module_t* mod) {
+
+    const char* fname = raw_string(get_cmd_opt("bytecode"));
+    if(*fname == '\0')
+        return true;
 
+    return write_image(mod, fname);
+}
+
+/*
+ * There is no virtual machine to run an image yet, so it is mapped and
+ * printed.
+ */
+static int dump_image(const char* fname) {
+
+    module_t* mod = load_image(find_file(fname, IMAGE_EXT));
+    if(mod == NULL)
+        return 1;
+
+    dump_module(stdout, mod);
+    destroy_module(mod);
     return 0;
 }
+
+/*
+ * Compile the file on the command line. The return value is the exit
+ * status. When the cache is used, a module that is up to date is not
+ * compiled again and a module that compiles is kept.
+ */
+static int compile_file(bool use_cache) {
+
+    const char* fname = raw_string(get_cmd_opt("files"));
+    if(fname == NULL) {
+        fprintf(stderr, "toy: no input file\n");
+        return 1;
+    }
+
+    const char* ext = strrchr(fname, '.');
+    if(ext != NULL && !strcmp(ext, IMAGE_EXT))
+        return dump_image(fname);
+
+    const char* path = find_file(fname, ".toy");
+    if(access(path, R_OK) != 0) {
+        fprintf(stderr, "toy: cannot open input file: %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    // the parser rules do not all have bodies yet, so compiling is asked for
+    if(get_cmd_int("tokens") || !get_cmd_int("compile")) {
+        open_file(path);
+        dump_tokens();
+        reset_compiler();
+        return 0;
+    }
+
+    // a trace has to see the compile
+    use_cache = use_cache && !tracing();
+
+    source_info_t info;
+    if(use_cache) {
+        cache_entry_t* entry = lookup_module_cache(path, &info);
+        if(entry != NULL) {
+            MSG(1, "cache: %s is up to date\n", info.path);
+            if(get_cmd_int("stats"))
+                print_stats(&entry->stats, entry->mod);
+            return write_bytecode(entry->mod) ? 0 : 1;
+        }
+    }
+
+    open_file(path);
+    compile_stats_t stats;
+    module_t* mod = compile(&stats);
+    reset_compiler();
+
+    if(mod == NULL)
+        return 1;
+
+    if(get_cmd_int("stats"))
+        print_stats(&stats, mod);
+
+    int status = write_bytecode(mod) ? 0 : 1;
+    if(use_cache)
+        store_module_cache(&info, mod, &stats);
+    else
+        destroy_module(mod);
+
+    return status;
+}
+
+// the watch compiles the AST that its buffer keeps
+static module_t* compile_watched(watch_module_t* wm) {
+
+    module_t* mod = compile_ast((ast_node_t*)wm->buf->unit, &wm->stats, false);
+    reset_sem_errors();
+
+    if(mod != NULL && get_cmd_int("stats"))
+        print_stats(&wm->stats, mod);
+
+    return mod;
+}
+
+static int serve_request(int argc, char** argv) {
+
+    destroy_cmdline();
+    cmdline(argc, argv, saved_env);
+
+    int status = compile_file(true);
+    MSG(2, "cache: %d hits, %d misses\n", get_cache_hits(), get_cache_misses());
+
+    // cmdline() pushed a trace state, in every build
+    pop_trace_state();
+    return status;
+}
+
+int main(int argc, char** argv, char** env) {
+
+    saved_env = env;
+    cmdline(argc, argv, env);
+    if(!set_prefetch())
+        return 1;
+
+#ifndef NO_TRACE
+    trace_file = intern_string(raw_string(get_cmd_opt("trace-file")));
+    if(*trace_file != '\0') {
+        start_trace_ring(get_token_index);
+        atexit(save_trace);
+    }
+#endif
+
+    if(get_cmd_int("watch")) {
+        if(!get_cmd_int("compile")) {
+            fprintf(stderr, "toy: watching needs --compile\n");
+            return 1;
+        }
+
+        // there are no more files than arguments
+        const char** files = _ALLOC_ARRAY(const char*, argc);
+        int nfiles = 0;
+        int mark = 0;
+        string_t* str;
+        while(NULL != (str = iterate_cmd_opt("files", &mark)))
+            files[nfiles++] = raw_string(str);
+
+        if(nfiles == 0) {
+            fprintf(stderr, "toy: no input file\n");
+            return 1;
+        }
+        int status = run_watch(files, nfiles, compile_watched);
+        _FREE(files);
+        return status;
+    }
+
+    const char* sock_path = server_socket_path(raw_string(get_cmd_opt("socket")));
+    if(get_cmd_int("server")) {
+        run_server(sock_path, serve_request);
+        destroy_module_cache();
+        return 0;
+    }
+
+    if(get_cmd_int("client")) {
+        int status = run_client(sock_path, argc, argv);
+        if(status >= 0)
+            return status;
+        MSG(0, "client: no server on %s, compiling here\n", sock_path);
+    }
+
+    return compile_file(false);
+}
@@ -0,0 +1,139 @@
+/**
+ * @file module_cache.c
+ *
+ * @brief The module cache of the compile server.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "alloc.h"
+#include "hash.h"
+#include "intern.h"
+#include "module_cache.h"
+
+static hash_table_t* cache = NULL;
+static int hits = 0;
+static int misses = 0;
+
+/*
+ * FNV-1a over the contents of the file. A file that cannot be read hashes
+ * to 0, which does not match a file that was compiled.
+ */
+static uint64_t hash_file(const char* path) {
+
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL)
+        return 0;
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    unsigned char buf[8192];
+    size_t len;
+    while((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+        for(size_t i = 0; i < len; i++) {
+            hash ^= buf[i];
+            hash *= 0x100000001b3ULL;
+        }
+
+    fclose(fp);
+    return hash;
+}
+
+static bool same_time(struct timespec* a, struct timespec* b) {
+
+    return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+/*
+ * Look up the module for a source file. The state of the file is returned
+ * in info whether it is found or not, so that a module compiled after a miss
+ * is stored with the state the file had before it was read.
+ */
+cache_entry_t* lookup_module_cache(const char* fname, source_info_t* info) {
+
+    char path[PATH_MAX];
+    struct stat st;
+
+    if(cache == NULL)
+        cache = create_hashtable();
+
+    memset(info, 0, sizeof(source_info_t));
+    if(realpath(fname, path) == NULL || stat(path, &st) != 0) {
+        info->path = intern_string(fname);
+        misses++;
+        return NULL;
+    }
+
+    info->path = intern_string(path);
+    info->mtime = st.st_mtim;
+    info->size = st.st_size;
+
+    cache_entry_t* entry;
+    find_hashtable(cache, info->path, (void**)&entry);
+    if(entry != NULL && same_time(&entry->source.mtime, &info->mtime) && entry->source.size == info->size) {
+        info->hash = entry->source.hash;
+        hits++;
+        return entry;
+    }
+
+    // touched, but maybe not changed
+    info->hash = hash_file(path);
+    if(entry != NULL && entry->source.hash == info->hash && entry->source.size == info->size) {
+        entry->source = *info;
+        hits++;
+        return entry;
+    }
+
+    misses++;
+    return NULL;
+}
+
+/*
+ * Keep a module. The cache owns it from now on and destroys the module that
+ * it replaces.
+ */
+void store_module_cache(source_info_t* info, module_t* mod, compile_stats_t* stats) {
+
+    if(cache == NULL)
+        cache = create_hashtable();
+
+    cache_entry_t* entry;
+    find_hashtable(cache, info->path, (void**)&entry);
+    if(entry == NULL) {
+        entry = _ALLOC_TYPE(cache_entry_t);
+        insert_hashtable(cache, info->path, entry);
+    }
+    else
+        destroy_module(entry->mod);
+
+    entry->source = *info;
+    entry->mod = mod;
+    entry->stats = *stats;
+}
+
+void destroy_module_cache(void) {
+
+    if(cache != NULL) {
+        for(int i = 0; i < cache->cap; i++) {
+            if(cache->table[i] != NULL && cache->table[i]->key != NULL) {
+                cache_entry_t* entry = cache->table[i]->data;
+                destroy_module(entry->mod);
+                _FREE(entry);
+            }
+        }
+        destroy_hashtable(cache);
+        cache = NULL;
+    }
+}
+
+int get_cache_hits(void) {
+
+    return hits;
+}
+
+int get_cache_misses(void) {
+
+    return misses;
+}
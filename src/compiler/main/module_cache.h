@@ -0,0 +1,49 @@
+/**
+ * @file module_cache.h
+ *
+ * @brief Compiled modules kept by the compile server, by the real path of
+ * their source file. An entry is still good when the file has the same
+ * modification time and size that it had when it was compiled. When those
+ * have changed, the contents are hashed, and an entry whose hash matches is
+ * still used. Only modules that compiled without errors are kept.
+ *
+ */
+#ifndef _MODULE_CACHE_H_
+#define _MODULE_CACHE_H_
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "passes.h"
+#include "module.h"
+
+// what --stats prints about a compile, kept so a cache hit can print it
+typedef struct {
+    int globals;
+    int functions;
+    int structs;
+    fold_stats_t fold;
+} compile_stats_t;
+
+// the state of a source file when it was looked up
+typedef struct {
+    const char* path;
+    struct timespec mtime;
+    off_t size;
+    uint64_t hash;
+} source_info_t;
+
+typedef struct {
+    source_info_t source;
+    module_t* mod;
+    compile_stats_t stats;
+} cache_entry_t;
+
+cache_entry_t* lookup_module_cache(const char* fname, source_info_t* info);
+void store_module_cache(source_info_t* info, module_t* mod, compile_stats_t* stats);
+void destroy_module_cache(void);
+
+int get_cache_hits(void);
+int get_cache_misses(void);
+
+#endif /* _MODULE_CACHE_H_ */
@@ -0,0 +1,432 @@
+/**
+ * @file server.c
+ *
+ * @brief Compile server over a Unix domain socket.
+ *
+ * A request is a request_header_t, sent with the client's stdout and stderr
+ * attached as SCM_RIGHTS, followed by the payload: the working directory and
+ * then each argument, all terminated by a '\0'. The reply is the exit status
+ * as an int32_t. A client that cannot connect, or that loses the server
+ * before the reply, returns -1 so that the caller can compile by itself.
+ *
+ * The requests are served by a worker process, so that the warm state is
+ * kept from one request to the next. A request can end in exit(), from the
+ * command line parser on --help or a bad option, or from a FATAL. Then the
+ * worker replies with status 1 before it goes, so the client does not
+ * compile again by itself, and the server starts a new worker.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "trace.h"
+#include "server.h"
+
+#define REQUEST_MAGIC 0x544f5952 // "TOYR"
+// the largest payload that is accepted
+#define MAX_PAYLOAD (1 << 20)
+// the exit status of a worker that a request made exit
+#define WORKER_LOST 75
+
+typedef struct {
+    uint32_t magic;
+    uint32_t argc;
+    uint32_t len;
+} request_header_t;
+
+static volatile sig_atomic_t stopping = 0;
+// the connection of the request that is running in the worker
+static int request_conn = -1;
+
+static void stop_server(int sig) {
+
+    (void)sig;
+    stopping = 1;
+}
+
+static bool write_all(int fd, const void* buf, size_t len) {
+
+    const char* ptr = buf;
+    while(len > 0) {
+        ssize_t n = write(fd, ptr, len);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        ptr += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+/*
+ * A request that exits still gets its reply. The output is flushed first,
+ * since it goes to the client's descriptors. The rest of the exit handlers
+ * belong to the request and are skipped.
+ */
+static void reply_on_exit(void) {
+
+    if(request_conn < 0)
+        return;
+
+    fflush(stdout);
+    fflush(stderr);
+    int32_t status = 1;
+    write_all(request_conn, &status, sizeof(status));
+    close(request_conn);
+    _exit(WORKER_LOST);
+}
+
+static bool read_all(int fd, void* buf, size_t len) {
+
+    char* ptr = buf;
+    while(len > 0) {
+        ssize_t n = read(fd, ptr, len);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        ptr += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+static void socket_address(struct sockaddr_un* addr, const char* path) {
+
+    if(strlen(path) >= sizeof(addr->sun_path))
+        FATAL("socket path is too long: %s", path);
+
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+}
+
+static int connect_socket(const char* path) {
+
+    struct sockaddr_un addr;
+    socket_address(&addr, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0)
+        return -1;
+
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+ * Read the header and the descriptors that came with it. Returns false for
+ * anything that is not a well formed request.
+ */
+static bool receive_header(int conn, request_header_t* hdr, int fds[2]) {
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+
+    struct iovec iov = {.iov_base = hdr, .iov_len = sizeof(request_header_t)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(conn, &msg, 0);
+    if(n <= 0)
+        return false;
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if(cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+       cmsg->cmsg_len != CMSG_LEN(2 * sizeof(int)))
+        return false;
+    memcpy(fds, CMSG_DATA(cmsg), 2 * sizeof(int));
+
+    if((size_t)n < sizeof(request_header_t) &&
+       !read_all(conn, (char*)hdr + n, sizeof(request_header_t) - n))
+        return false;
+
+    return hdr->magic == REQUEST_MAGIC && hdr->argc > 0 && hdr->len <= MAX_PAYLOAD;
+}
+
+/*
+ * Split the payload into the working directory and the arguments. The
+ * arguments point into the payload.
+ */
+static char** split_payload(char* payload, uint32_t len, uint32_t argc, const char** cwd) {
+
+    if(len == 0 || payload[len - 1] != '\0')
+        return NULL;
+
+    char** argv = _ALLOC_ARRAY(char*, argc + 1);
+    char* ptr = payload;
+    char* end = payload + len;
+
+    *cwd = ptr;
+    ptr += strlen(ptr) + 1;
+    for(uint32_t i = 0; i < argc; i++) {
+        if(ptr >= end) {
+            _FREE(argv);
+            return NULL;
+        }
+        argv[i] = ptr;
+        ptr += strlen(ptr) + 1;
+    }
+
+    return argv;
+}
+
+/*
+ * Run one request with stdout and stderr pointing at the client's.
+ */
+static int run_request(server_handler_t handler, const char* cwd, int argc, char** argv, int fds[2]) {
+
+    static int saved[2] = {-1, -1};
+    if(saved[0] < 0) {
+        saved[0] = dup(STDOUT_FILENO);
+        saved[1] = dup(STDERR_FILENO);
+    }
+
+    if(chdir(cwd) < 0) {
+        dprintf(fds[1], "toy: cannot change to directory: %s: %s\n", cwd, strerror(errno));
+        return 1;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(fds[0], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+
+    int status = handler(argc, argv);
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved[0], STDOUT_FILENO);
+    dup2(saved[1], STDERR_FILENO);
+
+    return status;
+}
+
+static void serve_connection(int conn, server_handler_t handler) {
+
+    request_header_t hdr;
+    int fds[2] = {-1, -1};
+    char** argv = NULL;
+
+    if(receive_header(conn, &hdr, fds)) {
+        char* payload = _ALLOC(hdr.len);
+        const char* cwd;
+        if(read_all(conn, payload, hdr.len))
+            argv = split_payload(payload, hdr.len, hdr.argc, &cwd);
+
+        if(argv != NULL) {
+            request_conn = conn;
+            int32_t status = run_request(handler, cwd, (int)hdr.argc, argv, fds);
+            request_conn = -1;
+            write_all(conn, &status, sizeof(status));
+            _FREE(argv);
+        }
+        _FREE(payload);
+    }
+
+    if(argv == NULL)
+        MSG(1, "server: dropped a malformed request\n");
+
+    for(int i = 0; i < 2; i++)
+        if(fds[i] >= 0)
+            close(fds[i]);
+    close(conn);
+}
+
+/*
+ * Serve requests until the server is stopped. This is the worker process.
+ */
+static void serve_requests(int fd, server_handler_t handler) {
+
+    atexit(reply_on_exit);
+
+    while(!stopping) {
+        int conn = accept(fd, NULL, NULL);
+        if(conn < 0) {
+            if(errno == EINTR)
+                continue;
+            FATAL("cannot accept connection: %s", strerror(errno));
+        }
+        serve_connection(conn, handler);
+    }
+}
+
+/*
+ * public interface
+ */
+
+/*
+ * The socket is the one given on the command line, or the one named in the
+ * environment, or one in /tmp that belongs to the user. The name is copied,
+ * because the command line does not outlive the first request.
+ */
+const char* server_socket_path(const char* opt) {
+
+    static char path[PATH_MAX];
+    const char* env = getenv(SERVER_SOCKET_ENV);
+
+    if(opt != NULL && *opt != '\0')
+        snprintf(path, sizeof(path), "%s", opt);
+    else if(env != NULL && *env != '\0')
+        snprintf(path, sizeof(path), "%s", env);
+    else
+        snprintf(path, sizeof(path), "/tmp/toy-%u.sock", (unsigned)getuid());
+
+    return path;
+}
+
+/*
+ * Serve requests until SIGINT or SIGTERM. Requests are run one at a time
+ * because the compiler keeps its state in globals. A worker that a request
+ * made exit, or that crashed, is replaced. The worker returns from here too
+ * when it is stopped, and only the server removes the socket.
+ */
+void run_server(const char* path, server_handler_t handler) {
+
+    struct sockaddr_un addr;
+    socket_address(&addr, path);
+
+    int probe = connect_socket(path);
+    if(probe >= 0) {
+        close(probe);
+        FATAL("a server is already listening on %s", path);
+    }
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0)
+        FATAL("cannot create socket: %s", strerror(errno));
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+        FATAL("cannot bind socket: %s: %s", path, strerror(errno));
+    if(listen(fd, 64) < 0)
+        FATAL("cannot listen on socket: %s: %s", path, strerror(errno));
+
+    // no SA_RESTART, so that a signal stops accept()
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_server;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    MSG(0, "server: listening on %s\n", path);
+    while(!stopping) {
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if(pid < 0)
+            FATAL("cannot start a worker: %s", strerror(errno));
+        if(pid == 0) {
+            serve_requests(fd, handler);
+            close(fd);
+            return;
+        }
+
+        int status = 0;
+        while(waitpid(pid, &status, 0) < 0) {
+            if(errno != EINTR)
+                FATAL("cannot wait for the worker: %s", strerror(errno));
+            if(stopping)
+                kill(pid, SIGTERM);
+        }
+
+        if(WIFEXITED(status) && WEXITSTATUS(status) == WORKER_LOST)
+            MSG(1, "server: a request exited, starting a new worker\n");
+        else if(WIFSIGNALED(status) && !stopping)
+            MSG(0, "server: the worker died of signal %d, starting a new one\n", WTERMSIG(status));
+        else
+            break;
+    }
+
+    close(fd);
+    unlink(path);
+}
+
+/*
+ * Forward the command line to the server. Returns the exit status of the
+ * compile, or -1 when there is no server to do it.
+ */
+int run_client(const char* path, int argc, char** argv) {
+
+    int fd = connect_socket(path);
+    if(fd < 0)
+        return -1;
+
+    char cwd[PATH_MAX];
+    if(getcwd(cwd, sizeof(cwd)) == NULL) {
+        close(fd);
+        return -1;
+    }
+
+    size_t len = strlen(cwd) + 1;
+    for(int i = 0; i < argc; i++)
+        len += strlen(argv[i]) + 1;
+
+    char* payload = _ALLOC(len);
+    char* ptr = payload;
+    ptr = stpcpy(ptr, cwd) + 1;
+    for(int i = 0; i < argc; i++)
+        ptr = stpcpy(ptr, argv[i]) + 1;
+
+    request_header_t hdr = {.magic = REQUEST_MAGIC, .argc = (uint32_t)argc, .len = (uint32_t)len};
+    int fds[2] = {STDOUT_FILENO, STDERR_FILENO};
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = {.iov_base = &hdr, .iov_len = sizeof(hdr)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    // the output of the compile goes to the same descriptors
+    fflush(stdout);
+    fflush(stderr);
+
+    int32_t status = -1;
+    if(sendmsg(fd, &msg, 0) == (ssize_t)sizeof(hdr) && write_all(fd, payload, len) &&
+       !read_all(fd, &status, sizeof(status)))
+        status = -1;
+
+    _FREE(payload);
+    close(fd);
+
+    return status;
+}
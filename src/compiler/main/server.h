@@ -0,0 +1,25 @@
+/**
+ * @file server.h
+ *
+ * @brief The compile server and its client. The server listens on a Unix
+ * domain socket and runs one compile at a time. A client sends its working
+ * directory, its command line and its stdout and stderr. The server writes
+ * the output of the compile straight to those, and sends back the exit
+ * status. Because the server process stays up, the interned strings, the
+ * file search path and the compiled modules stay warm between compiles.
+ *
+ */
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+// environment variable that names the socket
+#define SERVER_SOCKET_ENV "TOY_SERVER_SOCKET"
+
+// handles one request, the return value is the exit status of the client
+typedef int (*server_handler_t)(int argc, char** argv);
+
+const char* server_socket_path(const char* opt);
+void run_server(const char* path, server_handler_t handler);
+int run_client(const char* path, int argc, char** argv);
+
+#endif /* _SERVER_H_ */
@@ -0,0 +1,425 @@
+/**
+ * @file watch.c
+ *
+ * @brief Watch the sources of a program and compile what changes.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/inotify.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "trace.h"
+#include "hash.h"
+#include "intern.h"
+#include "fileio.h"
+#include "watch.h"
+
+// what a save looks like, whether the editor writes the file or renames
+// a new one over it. A file that is made again is read when it is closed,
+// not when it is created and still empty.
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+// how long to wait for the rest of the events of one save
+#define SETTLE_MS 20
+
+DEFINE_VEC(watch_dir_list, const char*)
+
+static hash_table_t* modules = NULL;
+static watch_list_t all;
+// the directory of each watch descriptor, by descriptor
+static watch_dir_list_t dirs;
+static hash_table_t* watched_dirs = NULL;
+static int notify_fd = -1;
+
+static volatile sig_atomic_t stopping = 0;
+
+static void stop_watch(int sig) {
+
+    (void)sig;
+    stopping = 1;
+}
+
+static double elapsed_ms(struct timespec* start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static char* read_source(const char* path, size_t* len) {
+
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL)
+        return NULL;
+
+    size_t cap = 4096;
+    char* text = _ALLOC(cap);
+    size_t n;
+    *len = 0;
+    while((n = fread(&text[*len], 1, cap - *len, fp)) > 0) {
+        *len += n;
+        if(*len == cap) {
+            cap <<= 1;
+            text = _REALLOC_ARRAY(text, char, cap);
+        }
+    }
+
+    fclose(fp);
+    return text;
+}
+
+static void watch_directory(const char* path) {
+
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    const char* dir = intern_string(dirname(tmp));
+
+    if(hash_name_exists(watched_dirs, dir))
+        return;
+
+    int wd = inotify_add_watch(notify_fd, dir, WATCH_EVENTS);
+    if(wd < 0) {
+        fprintf(stderr, "watch: cannot watch directory: %s: %s\n", dir, strerror(errno));
+        return;
+    }
+
+    insert_hashtable(watched_dirs, dir, NULL);
+    while(dirs.len <= wd)
+        append_watch_dir_list(&dirs, NULL);
+    *at_watch_dir_list(&dirs, wd) = dir;
+}
+
+static void remove_edge(watch_list_t* list, watch_module_t* wm) {
+
+    for(int i = 0; i < list->len; i++)
+        if(list->items[i] == wm) {
+            splice_watch_list(list, i, 1, NULL, 0);
+            return;
+        }
+}
+
+/*
+ * The same test that the code generator makes. A shared library is not a
+ * module to watch.
+ */
+static bool is_library(const char* name) {
+
+    const char* ext = strstr(name, ".so");
+    return (ext != NULL && (ext[3] == '\0' || ext[3] == '.')) || strstr(name, ".dylib") != NULL;
+}
+
+static watch_module_t* load_module(const char* fname);
+
+/*
+ * Make the import edges of a module from its AST. A module that is
+ * imported for the first time is loaded.
+ */
+static void find_imports(watch_module_t* wm) {
+
+    for(int i = 0; i < wm->imports.len; i++)
+        remove_edge(&wm->imports.items[i]->importers, wm);
+    clear_watch_list(&wm->imports);
+
+    unit_item_list_t* list = wm->buf->unit->list;
+    for(int i = 0; i < list->len; i++) {
+        ast_node_t* nterm = list->items[i]->nterm;
+        if(nterm == NULL || nterm->type != AST_IMPORT_STATEMENT)
+            continue;
+
+        const char* name = raw_string(((ast_import_statement_t*)nterm)->STRING_LITERAL->str);
+        if(is_library(name))
+            continue;
+
+        watch_module_t* dep = load_module(find_file(name, ".toy"));
+        if(dep == NULL)
+            fprintf(stderr, "watch: %s: cannot find import: %s\n", wm->path, name);
+        else {
+            append_watch_list(&wm->imports, dep);
+            append_watch_list(&dep->importers, wm);
+        }
+    }
+}
+
+static watch_module_t* load_module(const char* fname) {
+
+    char buf[PATH_MAX];
+    if(fname == NULL || realpath(fname, buf) == NULL)
+        return NULL;
+
+    const char* path = intern_string(buf);
+    watch_module_t* wm;
+    if(find_hashtable(modules, path, (void**)&wm))
+        return wm;
+
+    size_t len;
+    char* text = read_source(path, &len);
+    if(text == NULL)
+        return NULL;
+
+    wm = _ALLOC_TYPE(watch_module_t);
+    wm->path = path;
+    wm->buf = create_edit_buffer(path, text, len);
+    wm->changed = true;
+    init_watch_list(&wm->imports);
+    init_watch_list(&wm->importers);
+    _FREE(text);
+
+    insert_hashtable(modules, path, wm);
+    append_watch_list(&all, wm);
+    watch_directory(path);
+
+    find_imports(wm);
+    return wm;
+}
+
+/*
+ * Bring the buffer up to date with the file. The part that differs is
+ * given to the buffer as one edit. Returns false when nothing changed.
+ */
+static bool reload_module(watch_module_t* wm) {
+
+    size_t len;
+    char* text = read_source(wm->path, &len);
+    if(text == NULL)
+        return false;
+
+    edit_buffer_t* buf = wm->buf;
+    size_t prefix = 0;
+    size_t max = (len < buf->len) ? len : buf->len;
+    while(prefix < max && text[prefix] == buf->text[prefix])
+        prefix++;
+
+    size_t suffix = 0;
+    while(suffix < max - prefix && text[len - suffix - 1] == buf->text[buf->len - suffix - 1])
+        suffix++;
+
+    bool changed = prefix < max || len != buf->len;
+    if(changed)
+        edit_buffer(buf, prefix, buf->len - suffix, &text[prefix], len - prefix - suffix);
+
+    _FREE(text);
+    return changed;
+}
+
+static void mark_importers(watch_module_t* wm) {
+
+    if(!wm->dirty) {
+        wm->dirty = true;
+        for(int i = 0; i < wm->importers.len; i++)
+            mark_importers(wm->importers.items[i]);
+    }
+}
+
+// a run of tokens that did not parse has no element
+static bool has_syntax_errors(edit_buffer_t* buf) {
+
+    for(int i = 0; i < buf->spans.len; i++)
+        if(buf->spans.items[i].elem == NULL)
+            return true;
+
+    return false;
+}
+
+/*
+ * Compile a module after the modules that it imports. The mark is taken
+ * off first, so an import cycle ends.
+ */
+static int build_module(watch_module_t* wm, watch_compiler_t compile) {
+
+    if(!wm->dirty)
+        return 0;
+
+    wm->dirty = false;
+    int count = 0;
+    for(int i = 0; i < wm->imports.len; i++)
+        count += build_module(wm->imports.items[i], compile);
+
+    MSG(1, "watch: compiling %s\n", wm->path);
+    if(wm->mod != NULL)
+        destroy_module(wm->mod);
+    wm->mod = has_syntax_errors(wm->buf) ? NULL : compile(wm);
+    if(wm->mod == NULL)
+        fprintf(stderr, "watch: %s did not compile\n", wm->path);
+
+    return count + 1;
+}
+
+/*
+ * Compile the modules that changed and the ones that import them. The
+ * imports of a module that changed are found again first, which can load
+ * more modules.
+ */
+static int build(watch_compiler_t compile) {
+
+    for(int i = 0; i < all.len; i++)
+        if(all.items[i]->changed)
+            find_imports(all.items[i]);
+
+    for(int i = 0; i < all.len; i++)
+        if(all.items[i]->changed) {
+            all.items[i]->changed = false;
+            mark_importers(all.items[i]);
+        }
+
+    int count = 0;
+    for(int i = 0; i < all.len; i++)
+        count += build_module(all.items[i], compile);
+
+    int failed = 0;
+    for(int i = 0; i < all.len; i++)
+        if(all.items[i]->mod == NULL)
+            failed++;
+
+    return (failed > 0) ? -count : count;
+}
+
+/*
+ * Read the events that are waiting and mark the modules they are about as
+ * saved. They are read once the save has settled. The path of an event is
+ * looked up as it is, since most of them are about other files.
+ */
+static void read_events(void) {
+
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    ssize_t len = read(notify_fd, buf, sizeof(buf));
+    if(len < 0 && errno != EINTR && errno != EAGAIN)
+        FATAL("cannot read inotify events: %s", strerror(errno));
+
+    for(char* ptr = buf; len > 0 && ptr < buf + len;) {
+        struct inotify_event* ev = (struct inotify_event*)ptr;
+        ptr += sizeof(struct inotify_event) + ev->len;
+
+        if(ev->wd < 0 || ev->wd >= dirs.len || dirs.items[ev->wd] == NULL || ev->len == 0)
+            continue;
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", dirs.items[ev->wd], ev->name);
+
+        watch_module_t* wm;
+        if(find_hashtable(modules, path, (void**)&wm))
+            wm->saved = true;
+    }
+}
+
+/*
+ * Read the modules that were saved. Returns the number of them that
+ * changed.
+ */
+static int reload_saved(void) {
+
+    int changed = 0;
+    for(int i = 0; i < all.len; i++) {
+        watch_module_t* wm = all.items[i];
+        if(wm->saved) {
+            wm->saved = false;
+            if(reload_module(wm)) {
+                wm->changed = true;
+                changed++;
+            }
+        }
+    }
+
+    return changed;
+}
+
+/*
+ * The latency is from the first event of a save to the end of the build.
+ * The part of it that is spent compiling is given too, the rest is reading
+ * and waiting for the save to settle.
+ */
+static void report(const char* what, int count, struct timespec* start, struct timespec* build_start) {
+
+    printf("watch: %s %d of %d modules in %.3f ms (%.3f ms compiling)", what, abs(count), all.len,
+           elapsed_ms(start), elapsed_ms(build_start));
+    printf((count < 0) ? ", with errors\n" : "\n");
+    fflush(stdout);
+}
+
+/*
+ * public interface
+ */
+
+/*
+ * Build everything once and then every time that a source is saved, until
+ * SIGINT or SIGTERM. Returns the exit status.
+ */
+int run_watch(const char** fnames, int nfiles, watch_compiler_t compile) {
+
+    notify_fd = inotify_init1(IN_CLOEXEC);
+    if(notify_fd < 0)
+        FATAL("cannot start inotify: %s", strerror(errno));
+
+    modules = create_hashtable();
+    watched_dirs = create_hashtable();
+    init_watch_list(&all);
+    init_watch_dir_list(&dirs);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for(int i = 0; i < nfiles; i++)
+        if(load_module(find_file(fnames[i], ".toy")) == NULL)
+            fprintf(stderr, "watch: cannot open input file: %s\n", fnames[i]);
+
+    if(all.len == 0)
+        return 1;
+
+    struct timespec build_start;
+    clock_gettime(CLOCK_MONOTONIC, &build_start);
+    report("built", build(compile), &start, &build_start);
+
+    // no SA_RESTART, so that a signal stops read()
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_watch;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    struct pollfd pfd = {.fd = notify_fd, .events = POLLIN};
+    while(!stopping) {
+        if(poll(&pfd, 1, -1) <= 0)
+            continue;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        read_events();
+        // the rest of the save
+        while(!stopping && poll(&pfd, 1, SETTLE_MS) > 0)
+            read_events();
+
+        int changed = reload_saved();
+
+        if(changed > 0 && !stopping) {
+            clock_gettime(CLOCK_MONOTONIC, &build_start);
+            report("rebuilt", build(compile), &start, &build_start);
+        }
+    }
+
+    for(int i = 0; i < all.len; i++) {
+        watch_module_t* wm = all.items[i];
+        if(wm->mod != NULL)
+            destroy_module(wm->mod);
+        destroy_edit_buffer(wm->buf);
+        free_watch_list(&wm->imports);
+        free_watch_list(&wm->importers);
+        _FREE(wm);
+    }
+    free_watch_list(&all);
+    free_watch_dir_list(&dirs);
+    destroy_hashtable(modules);
+    destroy_hashtable(watched_dirs);
+    close(notify_fd);
+
+    return 0;
+}
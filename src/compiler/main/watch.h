@@ -0,0 +1,45 @@
+/**
+ * @file watch.h
+ *
+ * @brief Watch mode. The files on the command line and every Toy module
+ * that they import are kept in memory, scanned, parsed and compiled. The
+ * directories that hold them are watched with inotify. When a file is
+ * saved, its tokens and elements are brought up to date incrementally and
+ * only that module and the modules that import it, directly or not, are
+ * compiled again. Everything else keeps its AST and its module.
+ *
+ */
+#ifndef _WATCH_H_
+#define _WATCH_H_
+
+#include <stdbool.h>
+
+#include "vector.h"
+#include "incremental.h"
+#include "module_cache.h"
+
+DEFINE_VEC(watch_list, struct _watch_module_t_*)
+
+typedef struct _watch_module_t_ {
+    // the real path of the source
+    const char* path;
+    edit_buffer_t* buf;
+    // NULL when the last compile had errors
+    module_t* mod;
+    compile_stats_t stats;
+    watch_list_t imports;
+    watch_list_t importers;
+    // the file was saved and has not been read since
+    bool saved;
+    // the source changed since the last build
+    bool changed;
+    // the module is compiled in the build that is running
+    bool dirty;
+} watch_module_t;
+
+// compile the AST of a module, returns NULL when it has errors
+typedef module_t* (*watch_compiler_t)(watch_module_t* wm);
+
+int run_watch(const char** fnames, int nfiles, watch_compiler_t compile);
+
+#endif /* _WATCH_H_ */
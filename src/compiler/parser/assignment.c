@@ -34,6 +34,9 @@ ast_assignment_t* parse_assignment(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_ASSIGNMENT))
+        RETURN(NULL);
+
     ast_assignment_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -52,6 +55,8 @@ ast_assignment_t* parse_assignment(parser_state_t* pstate) {
                 // non-terminal rule element: compound_name
                 // terminal rule element: TOK_EQUAL
                 // non-terminal rule element: expression
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -64,10 +69,11 @@ ast_assignment_t* parse_assignment(parser_state_t* pstate) {
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
                 // retv->expression = expression;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
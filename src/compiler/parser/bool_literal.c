@@ -36,6 +36,9 @@ ast_bool_literal_t* parse_bool_literal(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_BOOL_LITERAL))
+        RETURN(NULL);
+
     ast_bool_literal_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -54,6 +57,8 @@ ast_bool_literal_t* parse_bool_literal(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -63,10 +68,11 @@ ast_bool_literal_t* parse_bool_literal(parser_state_t* pstate) {
                 consume_token_queue();
                 retv = (ast_bool_literal_t*)create_ast_node(AST_BOOL_LITERAL);
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -40,6 +40,9 @@ ast_compound_reference_element_t* parse_compound_reference_element(parser_state_
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_COMPOUND_REFERENCE_ELEMENT))
+        RETURN(NULL);
+
     ast_compound_reference_element_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -68,6 +71,8 @@ ast_compound_reference_element_t* parse_compound_reference_element(parser_state_
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -80,10 +85,11 @@ ast_compound_reference_element_t* parse_compound_reference_element(parser_state_
                 // retv->function_reference = function_reference;
                 // retv->list_reference = list_reference;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
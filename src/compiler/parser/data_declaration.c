@@ -33,6 +33,9 @@ ast_data_declaration_t* parse_data_declaration(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_DATA_DECLARATION))
+        RETURN(NULL);
+
     ast_data_declaration_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -49,6 +52,8 @@ ast_data_declaration_t* parse_data_declaration(parser_state_t* pstate) {
             case 1000:
                 // non-terminal rule element: type_name
                 // terminal rule element: TOK_IDENTIFIER
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -60,10 +65,11 @@ ast_data_declaration_t* parse_data_declaration(parser_state_t* pstate) {
                 // retv->type_name = type_name;
                 // retv->IDENTIFIER = IDENTIFIER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
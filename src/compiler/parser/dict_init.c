@@ -34,6 +34,9 @@ ast_dict_init_t* parse_dict_init(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_DICT_INIT))
+        RETURN(NULL);
+
     ast_dict_init_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -52,6 +55,8 @@ ast_dict_init_t* parse_dict_init(parser_state_t* pstate) {
                 // terminal rule element: TOK_OSBRACE
                 // non-terminal rule element: dss_initializer
                 // terminal rule element: TOK_CSBRACE
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -64,10 +69,11 @@ ast_dict_init_t* parse_dict_init(parser_state_t* pstate) {
                 // retv->dss_initializer = dss_initializer;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -43,6 +43,9 @@ ast_do_clause_t* parse_do_clause(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_DO_CLAUSE))
+        RETURN(NULL);
+
     ast_do_clause_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -80,6 +83,8 @@ ast_do_clause_t* parse_do_clause(parser_state_t* pstate) {
                 // terminal rule element: TOK_DO
                 // non-terminal rule element: loop_body
                 // terminal rule element: TOK_WHILE
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -93,10 +98,11 @@ ast_do_clause_t* parse_do_clause(parser_state_t* pstate) {
                 // retv->expression = expression;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
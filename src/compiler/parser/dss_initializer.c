@@ -38,6 +38,9 @@ ast_dss_initializer_t* parse_dss_initializer(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_DSS_INITIALIZER))
+        RETURN(NULL);
+
     ast_dss_initializer_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -66,6 +69,8 @@ ast_dss_initializer_t* parse_dss_initializer(parser_state_t* pstate) {
             // begin grouping_function rule at state 1000:0
             case 1000:
                 // non-terminal rule element: dss_initializer_item
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -78,10 +83,11 @@ ast_dss_initializer_t* parse_dss_initializer(parser_state_t* pstate) {
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
                 // retv->dss_initializer_item = dss_initializer_item;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
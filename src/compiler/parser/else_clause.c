@@ -36,6 +36,9 @@ ast_else_clause_t* parse_else_clause(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_ELSE_CLAUSE))
+        RETURN(NULL);
+
     ast_else_clause_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -57,6 +60,8 @@ ast_else_clause_t* parse_else_clause(parser_state_t* pstate) {
                 // non-terminal rule element: expression
                 // terminal rule element: TOK_CPAREN
                 // non-terminal rule element: function_body
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -70,10 +75,11 @@ ast_else_clause_t* parse_else_clause(parser_state_t* pstate) {
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
                 // retv->function_body = function_body;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
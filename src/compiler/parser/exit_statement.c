@@ -35,6 +35,9 @@ ast_exit_statement_t* parse_exit_statement(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_EXIT_STATEMENT))
+        RETURN(NULL);
+
     ast_exit_statement_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -54,6 +57,8 @@ ast_exit_statement_t* parse_exit_statement(parser_state_t* pstate) {
                 // terminal rule element: TOK_OPAREN
                 // non-terminal rule element: expression
                 // terminal rule element: TOK_CPAREN
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -66,10 +71,11 @@ ast_exit_statement_t* parse_exit_statement(parser_state_t* pstate) {
                 // retv->expression = expression;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
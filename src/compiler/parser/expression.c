@@ -171,6 +171,9 @@ ast_expression_t* parse_expression(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_EXPRESSION))
+        RETURN(NULL);
+
     ast_expression_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -456,6 +459,8 @@ ast_expression_t* parse_expression(parser_state_t* pstate) {
                 // terminal rule element: TOK_PLUS
                 // terminal rule element: TOK_MINUS
                 // terminal rule element: TOK_CARET
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -512,10 +517,11 @@ ast_expression_t* parse_expression(parser_state_t* pstate) {
                 // retv->expression = expression;
                 // retv->primary_expression = primary_expression;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -38,6 +38,9 @@ ast_expression_list_t* parse_expression_list(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_EXPRESSION_LIST))
+        RETURN(NULL);
+
     ast_expression_list_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -66,6 +69,8 @@ ast_expression_list_t* parse_expression_list(parser_state_t* pstate) {
             // begin grouping_function rule at state 1000:0
             case 1000:
                 // non-terminal rule element: expression
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -78,10 +83,11 @@ ast_expression_list_t* parse_expression_list(parser_state_t* pstate) {
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
                 // retv->expression = expression;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -0,0 +1,152 @@
+/**
+ * @file first_sets.c
+ *
+ * @brief The FIRST set of each rule as a bitset. Bit n is the token type
+ * TOK_END_OF_FILE + n. Made by "generate.py --first-sets" in
+ * tests/generate, do not edit it.
+ *
+ */
+
+#include "first_sets.h"
+
+const uint64_t first_sets[NUM_RULES] = {
+    // TOK_IDENTIFIER
+    [RULE_ASSIGNMENT] = 0x0000000001000000ULL,
+    // TOK_FALSE TOK_TRUE
+    [RULE_BOOL_LITERAL] = 0x0800008000000000ULL,
+    // TOK_IDENTIFIER
+    [RULE_COMPOUND_NAME] = 0x0000000001000000ULL,
+    // TOK_IDENTIFIER
+    [RULE_COMPOUND_REFERENCE] = 0x0000000001000000ULL,
+    // TOK_IDENTIFIER
+    [RULE_COMPOUND_REFERENCE_ELEMENT] = 0x0000000001000000ULL,
+    // TOK_IDENTIFIER TOK_BOOL TOK_DICT TOK_FLOAT TOK_INT TOK_LIST TOK_STRING
+    [RULE_DATA_DECLARATION] = 0x0201810501000000ULL,
+    // TOK_IDENTIFIER TOK_BOOL TOK_CONST TOK_DICT TOK_FLOAT TOK_INT TOK_LIST TOK_STRING
+    [RULE_DATA_DEFINITION] = 0x0201810701000000ULL,
+    // TOK_OSBRACE
+    [RULE_DICT_INIT] = 0x0000000010000000ULL,
+    // TOK_DO
+    [RULE_DO_CLAUSE] = 0x0000000800000000ULL,
+    // TOK_STRING_LITERAL
+    [RULE_DSS_INITIALIZER] = 0x0000000008000000ULL,
+    // TOK_STRING_LITERAL
+    [RULE_DSS_INITIALIZER_ITEM] = 0x0000000008000000ULL,
+    // TOK_ELSE
+    [RULE_ELSE_CLAUSE] = 0x0000001000000000ULL,
+    // TOK_EXIT
+    [RULE_EXIT_STATEMENT] = 0x0000004000000000ULL,
+    // TOK_BANG TOK_OPAREN TOK_MINUS TOK_FLOAT_LITERAL TOK_IDENTIFIER TOK_INT_LITERAL TOK_STRING_LITERAL TOK_FALSE TOK_NOT TOK_TRUE
+    [RULE_EXPRESSION] = 0x081000800d800844ULL,
+    // TOK_BANG TOK_OPAREN TOK_MINUS TOK_FLOAT_LITERAL TOK_IDENTIFIER TOK_INT_LITERAL TOK_STRING_LITERAL TOK_FALSE TOK_NOT TOK_TRUE
+    [RULE_EXPRESSION_LIST] = 0x081000800d800844ULL,
+    // TOK_ELSE
+    [RULE_FINAL_ELSE_CLAUSE] = 0x0000001000000000ULL,
+    // TOK_FOR
+    [RULE_FOR_CLAUSE] = 0x0000020000000000ULL,
+    // TOK_STRING_LITERAL
+    [RULE_FORMATTED_STRING] = 0x0000000008000000ULL,
+    // TOK_OCBRACE
+    [RULE_FUNCTION_BODY] = 0x2000000000000000ULL,
+    // TOK_IDENTIFIER TOK_INLINE TOK_BOOL TOK_CONST TOK_DICT TOK_DO TOK_EXIT TOK_FLOAT TOK_FOR TOK_IF TOK_INT TOK_LIST TOK_RETURN TOK_STRING TOK_STRUCT TOK_WHILE
+    [RULE_FUNCTION_BODY_ELEMENT] = 0x1681934f03000000ULL,
+    // TOK_IDENTIFIER TOK_INLINE TOK_BOOL TOK_CONST TOK_DICT TOK_DO TOK_EXIT TOK_FLOAT TOK_FOR TOK_IF TOK_INT TOK_LIST TOK_RETURN TOK_STRING TOK_STRUCT TOK_WHILE TOK_OCBRACE
+    [RULE_FUNCTION_BODY_LIST] = 0x3681934f03000000ULL,
+    // TOK_IDENTIFIER TOK_INLINE TOK_BOOL TOK_CONST TOK_DICT TOK_DO TOK_EXIT TOK_FLOAT TOK_FOR TOK_IF TOK_INT TOK_LIST TOK_RETURN TOK_STRING TOK_STRUCT TOK_WHILE TOK_OCBRACE
+    [RULE_FUNCTION_BODY_PRELIST] = 0x3681934f03000000ULL,
+    // TOK_IDENTIFIER TOK_BOOL TOK_DICT TOK_FLOAT TOK_INT TOK_LIST TOK_NOTHING TOK_STRING
+    [RULE_FUNCTION_DEFINITION] = 0x0221810501000000ULL,
+    // TOK_IDENTIFIER TOK_BOOL TOK_DICT TOK_FLOAT TOK_INT TOK_LIST TOK_NOTHING TOK_STRING
+    [RULE_FUNCTION_NAME] = 0x0221810501000000ULL,
+    // TOK_OPAREN
+    [RULE_FUNCTION_PARAMETERS] = 0x0000000000000040ULL,
+    // TOK_IDENTIFIER
+    [RULE_FUNCTION_REFERENCE] = 0x0000000001000000ULL,
+    // TOK_IF
+    [RULE_IF_CLAUSE] = 0x0000100000000000ULL,
+    // TOK_IMPORT
+    [RULE_IMPORT_STATEMENT] = 0x0000200000000000ULL,
+    // TOK_BANG TOK_OPAREN TOK_MINUS TOK_FLOAT_LITERAL TOK_IDENTIFIER TOK_INT_LITERAL TOK_STRING_LITERAL TOK_OSBRACE TOK_FALSE TOK_NOT TOK_TRUE TOK_OCBRACE
+    [RULE_INITIALIZER] = 0x281000801d800844ULL,
+    // TOK_OSBRACE
+    [RULE_LIST_INIT] = 0x0000000010000000ULL,
+    // TOK_IDENTIFIER
+    [RULE_LIST_REFERENCE] = 0x0000000001000000ULL,
+    // TOK_BOOL TOK_DICT TOK_FLOAT TOK_INT TOK_LIST TOK_STRING
+    [RULE_LITERAL_TYPE_NAME] = 0x0201810500000000ULL,
+    // TOK_OCBRACE
+    [RULE_LOOP_BODY] = 0x2000000000000000ULL,
+    // TOK_BREAK TOK_CONTINUE TOK_IDENTIFIER TOK_INLINE TOK_BOOL TOK_CONST TOK_DICT TOK_DO TOK_EXIT TOK_FLOAT TOK_FOR TOK_IF TOK_INT TOK_LIST TOK_RETURN TOK_STRING TOK_STRUCT TOK_WHILE
+    [RULE_LOOP_BODY_ELEMENT] = 0x1681934f03600000ULL,
+    // TOK_BREAK TOK_CONTINUE TOK_IDENTIFIER TOK_INLINE TOK_BOOL TOK_CONST TOK_DICT TOK_DO TOK_EXIT TOK_FLOAT TOK_FOR TOK_IF TOK_INT TOK_LIST TOK_RETURN TOK_STRING TOK_STRUCT TOK_WHILE TOK_OCBRACE
+    [RULE_LOOP_BODY_LIST] = 0x3681934f03600000ULL,
+    // TOK_BREAK TOK_CONTINUE TOK_IDENTIFIER TOK_INLINE TOK_BOOL TOK_CONST TOK_DICT TOK_DO TOK_EXIT TOK_FLOAT TOK_FOR TOK_IF TOK_INT TOK_LIST TOK_RETURN TOK_STRING TOK_STRUCT TOK_WHILE TOK_OCBRACE
+    [RULE_LOOP_BODY_PRELIST] = 0x3681934f03600000ULL,
+    // TOK_OPAREN TOK_FLOAT_LITERAL TOK_IDENTIFIER TOK_INT_LITERAL TOK_STRING_LITERAL TOK_FALSE TOK_TRUE
+    [RULE_PRIMARY_EXPRESSION] = 0x080000800d800040ULL,
+    // TOK_RETURN
+    [RULE_RETURN_STATEMENT] = 0x0080000000000000ULL,
+    // TOK_START
+    [RULE_START_BLOCK] = 0x0100000000000000ULL,
+    // TOK_STRUCT
+    [RULE_STRUCT_DEFINITION] = 0x0400000000000000ULL,
+    // TOK_OCBRACE
+    [RULE_STRUCT_INIT] = 0x2000000000000000ULL,
+    // translation_unit can match nothing
+    [RULE_TRANSLATION_UNIT] = 0xffffffffffffffffULL,
+    // TOK_IDENTIFIER TOK_BOOL TOK_CONST TOK_DICT TOK_FLOAT TOK_IMPORT TOK_INT TOK_LIST TOK_NOTHING TOK_START TOK_STRING TOK_STRUCT
+    [RULE_TRANSLATION_UNIT_ELEMENT] = 0x0721a10701000000ULL,
+    // TOK_IDENTIFIER TOK_BOOL TOK_DICT TOK_FLOAT TOK_INT TOK_LIST TOK_STRING
+    [RULE_TYPE_NAME] = 0x0201810501000000ULL,
+    // TOK_WHILE
+    [RULE_WHILE_CLAUSE] = 0x1000000000000000ULL,
+};
+
+// FIRST and FOLLOW of each rule, where a list of them can pick up again
+const uint64_t sync_sets[NUM_RULES] = {
+    [RULE_ASSIGNMENT] = 0xb681934f03600000ULL,
+    [RULE_BOOL_LITERAL] = 0xffefbfefe37dafb9ULL,
+    [RULE_COMPOUND_NAME] = 0x0000000001020000ULL,
+    [RULE_COMPOUND_REFERENCE] = 0xf7efbf6fe37dafb9ULL,
+    [RULE_COMPOUND_REFERENCE_ELEMENT] = 0xf7efbf6fe37dbfb9ULL,
+    [RULE_DATA_DECLARATION] = 0xb7a1b34f03620481ULL,
+    [RULE_DATA_DEFINITION] = 0xb7a1b34f03600001ULL,
+    [RULE_DICT_INIT] = 0xb7a1b34f13600001ULL,
+    [RULE_DO_CLAUSE] = 0xb681934f03600000ULL,
+    [RULE_DSS_INITIALIZER] = 0x8000000028000080ULL,
+    [RULE_DSS_INITIALIZER_ITEM] = 0x8000000028000480ULL,
+    [RULE_ELSE_CLAUSE] = 0xb681935f03600000ULL,
+    [RULE_EXIT_STATEMENT] = 0xb681934f03600000ULL,
+    [RULE_EXPRESSION] = 0xffffbfefeffdaffdULL,
+    [RULE_EXPRESSION_LIST] = 0x081000800d8008c4ULL,
+    [RULE_FINAL_ELSE_CLAUSE] = 0xb681935f03600000ULL,
+    [RULE_FOR_CLAUSE] = 0xb681934f03600000ULL,
+    [RULE_FORMATTED_STRING] = 0xf7efbf6feb7dafb9ULL,
+    [RULE_FUNCTION_BODY] = 0xb7a1b35f03600001ULL,
+    [RULE_FUNCTION_BODY_ELEMENT] = 0xb681934f03600000ULL,
+    [RULE_FUNCTION_BODY_LIST] = 0xb681934f03000000ULL,
+    [RULE_FUNCTION_BODY_PRELIST] = 0xb681934f03000000ULL,
+    [RULE_FUNCTION_DEFINITION] = 0x0721a10701000001ULL,
+    [RULE_FUNCTION_NAME] = 0x0221810501000040ULL,
+    [RULE_FUNCTION_PARAMETERS] = 0x2000000000000040ULL,
+    [RULE_FUNCTION_REFERENCE] = 0xf7efbf6fe37dbfb9ULL,
+    [RULE_IF_CLAUSE] = 0xb681934f03600000ULL,
+    [RULE_IMPORT_STATEMENT] = 0x0721a10701000001ULL,
+    [RULE_INITIALIZER] = 0xbfb1b3cf1fe00845ULL,
+    [RULE_LIST_INIT] = 0xb7a1b34f13600001ULL,
+    [RULE_LIST_REFERENCE] = 0xf7efbf6fe37dbfb9ULL,
+    [RULE_LITERAL_TYPE_NAME] = 0x0201810501000000ULL,
+    [RULE_LOOP_BODY] = 0xb681934f03600000ULL,
+    [RULE_LOOP_BODY_ELEMENT] = 0xb681934f03600000ULL,
+    [RULE_LOOP_BODY_LIST] = 0xb681934f03600000ULL,
+    [RULE_LOOP_BODY_PRELIST] = 0xb681934f03600000ULL,
+    [RULE_PRIMARY_EXPRESSION] = 0xffefbfefeffdaff9ULL,
+    [RULE_RETURN_STATEMENT] = 0xb681934f03600000ULL,
+    [RULE_START_BLOCK] = 0x0721a10701000001ULL,
+    [RULE_STRUCT_DEFINITION] = 0xb7a1b34f03600001ULL,
+    [RULE_STRUCT_INIT] = 0xb7a1b34f03600001ULL,
+    [RULE_TRANSLATION_UNIT] = 0x0721a10701000001ULL,
+    [RULE_TRANSLATION_UNIT_ELEMENT] = 0x0721a10701000001ULL,
+    [RULE_TYPE_NAME] = 0x0201810501000000ULL,
+    [RULE_WHILE_CLAUSE] = 0xb681934f03600000ULL,
+};
@@ -0,0 +1,88 @@
+/**
+ * @file first_sets.h
+ *
+ * @brief The token types that can begin each rule, from generate.py in
+ * tests/generate. Do not edit it, run "generate.py --first-sets" again
+ * when the grammar changes.
+ *
+ * A parse function calls can_start_rule() before it takes a mark, so a
+ * rule that cannot match the lookahead costs one test instead of a
+ * mark and a restore of the token queue. A rule that can match nothing
+ * has every bit set, it is always tried.
+ *
+ * The sync set of a rule is the tokens that can begin or follow it. After
+ * a syntax error, recover_parser_error() skips to one of them.
+ *
+ */
+
+#ifndef _FIRST_SETS_H_
+#define _FIRST_SETS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tokens.h"
+
+typedef enum {
+    RULE_ASSIGNMENT,
+    RULE_BOOL_LITERAL,
+    RULE_COMPOUND_NAME,
+    RULE_COMPOUND_REFERENCE,
+    RULE_COMPOUND_REFERENCE_ELEMENT,
+    RULE_DATA_DECLARATION,
+    RULE_DATA_DEFINITION,
+    RULE_DICT_INIT,
+    RULE_DO_CLAUSE,
+    RULE_DSS_INITIALIZER,
+    RULE_DSS_INITIALIZER_ITEM,
+    RULE_ELSE_CLAUSE,
+    RULE_EXIT_STATEMENT,
+    RULE_EXPRESSION,
+    RULE_EXPRESSION_LIST,
+    RULE_FINAL_ELSE_CLAUSE,
+    RULE_FOR_CLAUSE,
+    RULE_FORMATTED_STRING,
+    RULE_FUNCTION_BODY,
+    RULE_FUNCTION_BODY_ELEMENT,
+    RULE_FUNCTION_BODY_LIST,
+    RULE_FUNCTION_BODY_PRELIST,
+    RULE_FUNCTION_DEFINITION,
+    RULE_FUNCTION_NAME,
+    RULE_FUNCTION_PARAMETERS,
+    RULE_FUNCTION_REFERENCE,
+    RULE_IF_CLAUSE,
+    RULE_IMPORT_STATEMENT,
+    RULE_INITIALIZER,
+    RULE_LIST_INIT,
+    RULE_LIST_REFERENCE,
+    RULE_LITERAL_TYPE_NAME,
+    RULE_LOOP_BODY,
+    RULE_LOOP_BODY_ELEMENT,
+    RULE_LOOP_BODY_LIST,
+    RULE_LOOP_BODY_PRELIST,
+    RULE_PRIMARY_EXPRESSION,
+    RULE_RETURN_STATEMENT,
+    RULE_START_BLOCK,
+    RULE_STRUCT_DEFINITION,
+    RULE_STRUCT_INIT,
+    RULE_TRANSLATION_UNIT,
+    RULE_TRANSLATION_UNIT_ELEMENT,
+    RULE_TYPE_NAME,
+    RULE_WHILE_CLAUSE,
+    NUM_RULES
+} parser_rule_t;
+
+extern const uint64_t first_sets[NUM_RULES];
+extern const uint64_t sync_sets[NUM_RULES];
+extern unsigned long pruned_attempts;
+
+static inline bool can_start_rule(parser_rule_t rule) {
+
+    if((first_sets[rule] >> (get_token()->type - TOK_END_OF_FILE)) & 1)
+        return true;
+
+    pruned_attempts++;
+    return false;
+}
+
+#endif /* _FIRST_SETS_H_ */
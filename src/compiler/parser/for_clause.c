@@ -49,6 +49,9 @@ ast_for_clause_t* parse_for_clause(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FOR_CLAUSE))
+        RETURN(NULL);
+
     ast_for_clause_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -100,6 +103,8 @@ ast_for_clause_t* parse_for_clause(parser_state_t* pstate) {
             case 1000:
                 // terminal rule element: TOK_FOR
                 // non-terminal rule element: loop_body
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -115,10 +120,11 @@ ast_for_clause_t* parse_for_clause(parser_state_t* pstate) {
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
                 // retv->loop_body = loop_body;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -41,6 +41,9 @@ ast_formatted_string_t* parse_formatted_string(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FORMATTED_STRING))
+        RETURN(NULL);
+
     ast_formatted_string_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -76,6 +79,8 @@ ast_formatted_string_t* parse_formatted_string(parser_state_t* pstate) {
             // begin grouping_function rule at state 1000:0
             case 1000:
                 // terminal rule element: TOK_STRING_LITERAL
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -89,10 +94,11 @@ ast_formatted_string_t* parse_formatted_string(parser_state_t* pstate) {
                 // retv->dss_initializer = dss_initializer;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -72,6 +72,9 @@ ast_function_body_element_t* parse_function_body_element(parser_state_t* pstate)
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FUNCTION_BODY_ELEMENT))
+        RETURN(NULL);
+
     ast_function_body_element_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -156,6 +159,8 @@ ast_function_body_element_t* parse_function_body_element(parser_state_t* pstate)
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -176,10 +181,11 @@ ast_function_body_element_t* parse_function_body_element(parser_state_t* pstate)
                 // retv->exit_statement = exit_statement;
                 // retv->INLINE = INLINE;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
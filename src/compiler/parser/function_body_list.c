@@ -35,10 +35,14 @@ ast_function_body_list_t* parse_function_body_list(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FUNCTION_BODY_LIST))
+        RETURN(NULL);
+
     ast_function_body_list_t* retv = NULL;
     int state = 1000;
     bool finished = false;
     void* post = mark_token_queue();
+    push_parser_sync(pstate, RULE_FUNCTION_BODY_PRELIST);
 
     // ast_function_body_prelist_t* function_body_prelist = NULL;
     // ast_function_body_prelist_t* function_body_prelist = NULL;
@@ -56,6 +60,8 @@ ast_function_body_list_t* parse_function_body_list(parser_state_t* pstate) {
             // begin grouping_function rule at state 1000:0
             case 1000:
                 // non-terminal rule element: function_body_prelist
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -67,10 +73,11 @@ ast_function_body_list_t* parse_function_body_list(parser_state_t* pstate) {
                 // retv->function_body_prelist = function_body_prelist;
                 // retv->function_body_prelist = function_body_prelist;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -84,5 +91,6 @@ ast_function_body_list_t* parse_function_body_list(parser_state_t* pstate) {
         }
     }
 
+    pop_parser_sync(pstate);
     RETURN(retv);
 }
@@ -34,6 +34,9 @@ ast_function_definition_t* parse_function_definition(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FUNCTION_DEFINITION))
+        RETURN(NULL);
+
     ast_function_definition_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -52,6 +55,8 @@ ast_function_definition_t* parse_function_definition(parser_state_t* pstate) {
                 // non-terminal rule element: function_name
                 // non-terminal rule element: function_parameters
                 // non-terminal rule element: function_body
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -64,10 +69,11 @@ ast_function_definition_t* parse_function_definition(parser_state_t* pstate) {
                 // retv->function_parameters = function_parameters;
                 // retv->function_body = function_body;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
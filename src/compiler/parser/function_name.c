@@ -42,6 +42,9 @@ ast_function_name_t* parse_function_name(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FUNCTION_NAME))
+        RETURN(NULL);
+
     ast_function_name_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -76,6 +79,8 @@ ast_function_name_t* parse_function_name(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -88,10 +93,11 @@ ast_function_name_t* parse_function_name(parser_state_t* pstate) {
                 // retv->IDENTIFIER = IDENTIFIER;
                 // retv->IDENTIFIER = IDENTIFIER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
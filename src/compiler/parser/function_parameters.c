@@ -44,6 +44,9 @@ ast_function_parameters_t* parse_function_parameters(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FUNCTION_PARAMETERS))
+        RETURN(NULL);
+
     ast_function_parameters_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -86,6 +89,8 @@ ast_function_parameters_t* parse_function_parameters(parser_state_t* pstate) {
             case 1000:
                 // terminal rule element: TOK_OPAREN
                 // terminal rule element: TOK_CPAREN
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -100,10 +105,11 @@ ast_function_parameters_t* parse_function_parameters(parser_state_t* pstate) {
                 // retv->data_declaration = data_declaration;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
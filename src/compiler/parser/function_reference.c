@@ -35,6 +35,9 @@ ast_function_reference_t* parse_function_reference(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_FUNCTION_REFERENCE))
+        RETURN(NULL);
+
     ast_function_reference_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -55,6 +58,8 @@ ast_function_reference_t* parse_function_reference(parser_state_t* pstate) {
                 // terminal rule element: TOK_OPAREN
                 // non-terminal rule element: expression_list
                 // terminal rule element: TOK_CPAREN
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -68,10 +73,11 @@ ast_function_reference_t* parse_function_reference(parser_state_t* pstate) {
                 // retv->expression_list = expression_list;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
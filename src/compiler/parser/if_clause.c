@@ -42,6 +42,9 @@ ast_if_clause_t* parse_if_clause(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_IF_CLAUSE))
+        RETURN(NULL);
+
     ast_if_clause_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -77,6 +80,8 @@ ast_if_clause_t* parse_if_clause(parser_state_t* pstate) {
                 // non-terminal rule element: expression
                 // terminal rule element: TOK_CPAREN
                 // non-terminal rule element: function_body
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -92,10 +97,11 @@ ast_if_clause_t* parse_if_clause(parser_state_t* pstate) {
                 // retv->else_clause = else_clause;
                 // retv->final_else_clause = final_else_clause;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -33,6 +33,9 @@ ast_import_statement_t* parse_import_statement(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_IMPORT_STATEMENT))
+        RETURN(NULL);
+
     ast_import_statement_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -48,6 +51,8 @@ ast_import_statement_t* parse_import_statement(parser_state_t* pstate) {
             case 1000:
                 // terminal rule element: TOK_IMPORT
                 // terminal rule element: TOK_STRING_LITERAL
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -58,10 +63,11 @@ ast_import_statement_t* parse_import_statement(parser_state_t* pstate) {
                 retv = (ast_import_statement_t*)create_ast_node(AST_IMPORT_STATEMENT);
                 // retv->STRING_LITERAL = STRING_LITERAL;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -0,0 +1,393 @@
+/**
+ * @file incremental.c
+ *
+ * @brief Incremental scanning and parsing of a source file in memory.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "trace.h"
+#include "intern.h"
+#include "file_io.h"
+#include "parser_protos.h"
+#include "incremental.h"
+
+// kept by the scanner
+extern int yylineno;
+extern int yycolno;
+
+/*
+ * A string literal can be continued on the next line and "inline" can be
+ * followed by any amount of space before its '{', so the scanner can read
+ * past the end of the line after those.
+ */
+static bool reads_ahead(token_t* tok) {
+
+    return tok->type == TOK_STRING_LITERAL ||
+           (tok->type == TOK_IDENTIFIER && !strcmp(raw_string(tok->str), "inline"));
+}
+
+/*
+ * The number of tokens at the start that an edit at start cannot change.
+ * Within a line, the scanner can read well past a token before it decides
+ * on it. "1.5e+" is read before "1.5" is taken as a float and a comment
+ * that has no newline after it is read to the end of the file. So the
+ * tokens that are kept are the ones that end before the line of the edit.
+ */
+static int first_changed_token(edit_buffer_t* buf, size_t start) {
+
+    lex_item_t* items = buf->tokens.items;
+    int lo = 0;
+    int hi = buf->tokens.len;
+
+    size_t line = start;
+    while(line > 0 && buf->text[line - 1] != '\n')
+        line--;
+
+    while(lo < hi) {
+        int mid = (lo + hi) / 2;
+        if(items[mid].end < line)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    while(lo > 0 && reads_ahead(items[lo - 1].tok))
+        lo--;
+
+    return lo;
+}
+
+static void replace_text(edit_buffer_t* buf, size_t start, size_t end, const char* text, size_t len) {
+
+    size_t size = buf->len - (end - start) + len;
+    if(size + 2 > buf->cap) {
+        while(size + 2 > buf->cap)
+            buf->cap = (buf->cap == 0) ? 1024 : buf->cap << 1;
+        buf->text = _REALLOC_ARRAY(buf->text, char, buf->cap);
+    }
+
+    memmove(&buf->text[start + len], &buf->text[end], buf->len - end);
+    memcpy(&buf->text[start], text, len);
+    buf->len = size;
+    buf->text[size] = '\0';
+    buf->text[size + 1] = '\0';
+}
+
+/*
+ * Scan from the end of token first - 1 until a new token ends where an old
+ * one ended after the edit. The scanner is in its initial state after every
+ * token, so the tokens after that are the same as before. The new tokens
+ * are returned in scanned and the index of the last old token that they
+ * replace is returned.
+ */
+static int scan_changes(edit_buffer_t* buf, int first, size_t old_end, long delta, lex_item_list_t* scanned) {
+
+    lex_item_t* old = buf->tokens.items;
+    int nold = buf->tokens.len;
+    size_t offset = 0;
+    int line = 1;
+    int col = 1;
+
+    if(first > 0) {
+        offset = old[first - 1].end;
+        line = old[first - 1].end_line;
+        col = old[first - 1].end_col;
+    }
+
+    open_buffer(buf->name, &buf->text[offset], buf->len - offset, offset, line, col);
+
+    int last = first - 1;
+    int index = first;
+    while(true) {
+        token_t* tok = scan_token_queue();
+        if(tok == NULL) {
+            // the file ended inside a literal
+            tok = create_token(create_string(NULL), TOK_END_OF_FILE);
+            add_token_queue(tok);
+        }
+
+        lex_item_t item = {.tok = tok, .end = get_offset(), .end_line = yylineno, .end_col = yycolno};
+        append_lex_item_list(scanned, item);
+
+        // the end of file takes no room, so it only lines up with itself
+        while(index < nold && (long)old[index].end + delta < (long)item.end)
+            index++;
+        if(index < nold && old[index].end >= old_end && (long)old[index].end + delta == (long)item.end &&
+           (old[index].tok->type == TOK_END_OF_FILE) == (tok->type == TOK_END_OF_FILE)) {
+            last = index;
+            break;
+        }
+
+        if(tok->type == TOK_END_OF_FILE) {
+            last = nold - 1;
+            break;
+        }
+    }
+
+    release_token_queue();
+    reset_file_io();
+
+    return last;
+}
+
+/*
+ * Put the new tokens in place of the old ones from first to last, and move
+ * the tokens after them along with the text.
+ */
+static void splice_tokens(edit_buffer_t* buf, int first, int last, long delta, lex_item_list_t* scanned) {
+
+    lex_item_t* old = buf->tokens.items;
+    int nold = last - first + 1;
+    int line_delta = 0;
+    int col_delta = 0;
+    int sync_line = -1;
+
+    if(last >= first) {
+        lex_item_t* tail = &scanned->items[scanned->len - 1];
+        sync_line = old[last].end_line;
+        line_delta = tail->end_line - old[last].end_line;
+        col_delta = tail->end_col - old[last].end_col;
+    }
+
+    for(int i = first; i <= last; i++)
+        destroy_token(old[i].tok);
+
+    splice_lex_item_list(&buf->tokens, first, nold, scanned->items, scanned->len);
+
+    lex_item_t* items = buf->tokens.items;
+    int after = first + scanned->len;
+    if(first > 0)
+        items[first - 1].tok->next = items[first].tok;
+    items[after - 1].tok->next = (after < buf->tokens.len) ? items[after].tok : NULL;
+
+    for(int i = first; i < after; i++)
+        items[i].tok->index = i;
+
+    for(int i = after; i < buf->tokens.len; i++) {
+        lex_item_t* item = &items[i];
+        if(item->tok->line_no == sync_line)
+            item->tok->col_no += col_delta;
+        if(item->end_line == sync_line)
+            item->end_col += col_delta;
+        item->tok->line_no += line_delta;
+        item->end_line += line_delta;
+        item->end += delta;
+        item->tok->index = i;
+    }
+}
+
+/*
+ * Add the tokens from pos to index to the parsed spans. Tokens that could
+ * not be parsed are run together, like the parser would do it from the
+ * start of the file.
+ */
+static void add_span(unit_span_list_t* parsed, int* start, int pos, int index, int reach,
+                     ast_translation_unit_element_t* elem) {
+
+    if(elem == NULL && parsed->len > 0 && peek_unit_span_list(parsed).elem == NULL) {
+        unit_span_t* prev = at_unit_span_list(parsed, parsed->len - 1);
+        int prev_start = *start;
+        prev->ntokens += index - pos;
+        if(reach - prev_start > prev->reach)
+            prev->reach = reach - prev_start;
+    }
+    else {
+        append_unit_span_list(parsed, (unit_span_t){.ntokens = index - pos, .reach = reach - pos, .elem = elem});
+        *start = pos;
+    }
+}
+
+/*
+ * Two runs of tokens that could not be parsed are one run.
+ */
+static void join_spans(edit_buffer_t* buf, int index) {
+
+    unit_span_t* spans = buf->spans.items;
+    if(index > 0 && index < buf->spans.len && spans[index - 1].elem == NULL && spans[index].elem == NULL) {
+        int reach = spans[index - 1].ntokens + spans[index].reach;
+        spans[index - 1].ntokens += spans[index].ntokens;
+        if(reach > spans[index - 1].reach)
+            spans[index - 1].reach = reach;
+        splice_unit_span_list(&buf->spans, index, 1, NULL, 0);
+    }
+}
+
+/*
+ * Parse elements from token first until one ends on a boundary between old
+ * elements that comes after the changed tokens. The old elements from
+ * span to that boundary are replaced by the new ones.
+ */
+static void parse_changes(edit_buffer_t* buf, int span, int first, int last, int shift) {
+
+    unit_span_t* spans = buf->spans.items;
+    int nspans = buf->spans.len;
+    int eof = buf->tokens.len - 1;
+    unit_span_list_t parsed;
+    init_unit_span_list(&parsed);
+
+    borrow_token_queue(buf->tokens.items[first].tok, buf->tokens.items[eof].tok);
+
+    // the old boundary that is looked for, at the start of span next
+    int next = span;
+    int boundary = first;
+    int pos = first;
+    int start = first;
+    while(pos < eof) {
+        get_token_reach();
+        ast_translation_unit_element_t* elem = parse_translation_unit_element(buf->pstate);
+        // a region that backtracked too much is skipped like any other error
+        if(elem == NULL && buf->pstate->panic)
+            recover_parser_error(buf->pstate);
+        int reach = get_token_reach();
+        int index = get_token_index();
+        if(index < 0)
+            index = eof;
+
+        if(elem == NULL || index <= pos) {
+            // skip a token that does not start an element
+            elem = NULL;
+            restore_token_queue(buf->tokens.items[pos].tok);
+            consume_token();
+            index = pos + 1;
+        }
+        consume_token_queue();
+        add_span(&parsed, &start, pos, index, (reach > index) ? reach : index, elem);
+        pos = index;
+
+        while(next < nspans && (boundary <= last || boundary + shift < pos))
+            boundary += spans[next++].ntokens;
+        if(next < nspans && boundary > last && boundary + shift == pos)
+            break;
+    }
+
+    if(pos >= eof)
+        next = nspans;
+
+    release_token_queue();
+
+    // the elements in the unit are the spans that have one
+    int at = 0;
+    for(int i = 0; i < span; i++)
+        if(spans[i].elem != NULL)
+            at++;
+
+    int removed = 0;
+    for(int i = span; i < next; i++)
+        if(spans[i].elem != NULL)
+            removed++;
+
+    ast_translation_unit_element_t** elems = _ALLOC_ARRAY(ast_translation_unit_element_t*, parsed.len + 1);
+    int count = 0;
+    for(int i = 0; i < parsed.len; i++)
+        if(parsed.items[i].elem != NULL)
+            elems[count++] = parsed.items[i].elem;
+
+    splice_unit_item_list(buf->unit->list, at, removed, elems, count);
+    splice_unit_span_list(&buf->spans, span, next - span, parsed.items, parsed.len);
+    join_spans(buf, span + parsed.len);
+    join_spans(buf, span);
+
+    buf->stats.parsed = parsed.len;
+    buf->stats.kept = nspans - (next - span);
+
+    _FREE(elems);
+    free_unit_span_list(&parsed);
+}
+
+/*
+ * The first element to parse again is the first one whose parse looked at
+ * the first changed token. That is usually the one that holds it, or the
+ * one before, when the token is the one that ended it.
+ */
+static int first_changed_span(edit_buffer_t* buf, int first, int* start) {
+
+    unit_span_t* spans = buf->spans.items;
+    int span = 0;
+    int pos = 0;
+
+    while(span < buf->spans.len && pos + spans[span].reach < first)
+        pos += spans[span++].ntokens;
+
+    *start = pos;
+    return span;
+}
+
+/*
+ * public interface
+ */
+
+edit_buffer_t* create_edit_buffer(const char* name, const char* text, size_t len) {
+
+    ENTER;
+    edit_buffer_t* buf = _ALLOC_TYPE(edit_buffer_t);
+    buf->name = intern_string(name);
+    buf->unit = (ast_translation_unit_t*)create_ast_node(AST_TRANSLATION_UNIT);
+    buf->unit->list = create_unit_item_list();
+    buf->pstate = create_parser_state();
+    init_lex_item_list(&buf->tokens);
+    init_unit_span_list(&buf->spans);
+
+    // the whole file is an edit of an empty one
+    edit_buffer(buf, 0, 0, text, len);
+
+    RETURN(buf);
+}
+
+void destroy_edit_buffer(edit_buffer_t* buf) {
+
+    ENTER;
+    if(buf != NULL) {
+        for(int i = 0; i < buf->tokens.len; i++)
+            destroy_token(buf->tokens.items[i].tok);
+        free_lex_item_list(&buf->tokens);
+        free_unit_span_list(&buf->spans);
+        destroy_unit_item_list(buf->unit->list);
+        _FREE(buf->unit);
+        destroy_parser_state(buf->pstate);
+        if(buf->text != NULL)
+            _FREE(buf->text);
+        _FREE(buf);
+    }
+    RETURN();
+}
+
+/*
+ * Replace the text from start up to end with len bytes of text.
+ */
+void edit_buffer(edit_buffer_t* buf, size_t start, size_t end, const char* text, size_t len) {
+
+    ENTER;
+    ASSERT(buf != NULL, "null edit buffer is not allowed");
+    if(start > end || end > buf->len)
+        FATAL("edit out of range: %zu to %zu in %zu bytes", start, end, buf->len);
+
+    long delta = (long)len - (long)(end - start);
+    int first = first_changed_token(buf, start);
+
+    replace_text(buf, start, end, text, len);
+
+    lex_item_list_t scanned;
+    init_lex_item_list(&scanned);
+    int last = scan_changes(buf, first, end, delta, &scanned);
+    int shift = scanned.len - (last - first + 1);
+
+    buf->stats.scanned = scanned.len;
+
+    // the spans still count the old tokens, so find the span first
+    int pos;
+    int span = first_changed_span(buf, first, &pos);
+
+    splice_tokens(buf, first, last, delta, &scanned);
+    free_lex_item_list(&scanned);
+
+    parse_changes(buf, span, pos, last, shift);
+
+    TRACE("scanned %d tokens, parsed %d elements, kept %d", buf->stats.scanned, buf->stats.parsed,
+          buf->stats.kept);
+    RETURN();
+}
@@ -0,0 +1,75 @@
+/**
+ * @file incremental.h
+ *
+ * @brief Incremental scanning and parsing of a source file that is kept in
+ * memory, for an editor or for watching a file. An edit replaces a range of
+ * the text. The tokens are scanned again from a little before the edit
+ * until the new tokens line up with the old ones again. Then the top level
+ * elements are parsed again, starting with the first one whose parse looked
+ * at a changed token, until an element ends where an old element ended
+ * after the change. Every other token and every other element is kept. A
+ * function_definition is always a whole translation_unit_element, so that
+ * is the smallest unit that is parsed again.
+ *
+ * The text and the arrays of tokens and elements are flat, so an edit still
+ * moves the part of them that comes after it, but nothing after the edit is
+ * scanned or parsed. The tokens that are kept have their line numbers moved
+ * along with the text. The AST nodes that are kept are not visited, so
+ * their line numbers are the ones from the parse that made them.
+ *
+ */
+#ifndef _INCREMENTAL_H_
+#define _INCREMENTAL_H_
+
+#include <stddef.h>
+
+#include "ast.h"
+#include "parser.h"
+#include "vector.h"
+
+typedef struct {
+    token_t* tok;
+    // the offset just past the token, and the line and column there
+    size_t end;
+    int end_line;
+    int end_col;
+} lex_item_t;
+
+// a run of tokens that made a top level element, or that could not be
+// parsed, in which case elem is NULL
+typedef struct {
+    int ntokens;
+    // how many tokens past the first one the parser looked at
+    int reach;
+    ast_translation_unit_element_t* elem;
+} unit_span_t;
+
+DEFINE_VEC(lex_item_list, lex_item_t)
+DEFINE_VEC(unit_span_list, unit_span_t)
+
+// what the last edit did
+typedef struct {
+    int scanned;
+    int parsed;
+    int kept;
+} edit_stats_t;
+
+typedef struct {
+    const char* name;
+    // the text, followed by two '\0' bytes for the scanner
+    char* text;
+    size_t len;
+    size_t cap;
+    // every token, the last one is the end of file
+    lex_item_list_t tokens;
+    unit_span_list_t spans;
+    ast_translation_unit_t* unit;
+    parser_state_t* pstate;
+    edit_stats_t stats;
+} edit_buffer_t;
+
+edit_buffer_t* create_edit_buffer(const char* name, const char* text, size_t len);
+void destroy_edit_buffer(edit_buffer_t* buf);
+void edit_buffer(edit_buffer_t* buf, size_t start, size_t end, const char* text, size_t len);
+
+#endif /* _INCREMENTAL_H_ */
@@ -44,6 +44,9 @@ ast_initializer_t* parse_initializer(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_INITIALIZER))
+        RETURN(NULL);
+
     ast_initializer_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -79,6 +82,8 @@ ast_initializer_t* parse_initializer(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -92,10 +97,11 @@ ast_initializer_t* parse_initializer(parser_state_t* pstate) {
                 // retv->dict_init = dict_init;
                 // retv->struct_init = struct_init;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -42,6 +42,9 @@ ast_list_reference_t* parse_list_reference(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_LIST_REFERENCE))
+        RETURN(NULL);
+
     ast_list_reference_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -78,6 +81,8 @@ ast_list_reference_t* parse_list_reference(parser_state_t* pstate) {
                 // terminal rule element: TOK_OSBRACE
                 // non-terminal rule element: expression
                 // terminal rule element: TOK_CSBRACE
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -94,10 +99,11 @@ ast_list_reference_t* parse_list_reference(parser_state_t* pstate) {
                 // retv->expression = expression;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -52,6 +52,9 @@ ast_literal_type_name_t* parse_literal_type_name(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_LITERAL_TYPE_NAME))
+        RETURN(NULL);
+
     ast_literal_type_name_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -94,6 +97,8 @@ ast_literal_type_name_t* parse_literal_type_name(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -103,10 +108,11 @@ ast_literal_type_name_t* parse_literal_type_name(parser_state_t* pstate) {
                 consume_token_queue();
                 retv = (ast_literal_type_name_t*)create_ast_node(AST_LITERAL_TYPE_NAME);
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
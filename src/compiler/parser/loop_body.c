@@ -34,6 +34,9 @@ ast_loop_body_t* parse_loop_body(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_LOOP_BODY))
+        RETURN(NULL);
+
     ast_loop_body_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -52,6 +55,8 @@ ast_loop_body_t* parse_loop_body(parser_state_t* pstate) {
                 // terminal rule element: TOK_OCBRACE
                 // non-terminal rule element: loop_body_list
                 // terminal rule element: TOK_CCBRACE
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -64,10 +69,11 @@ ast_loop_body_t* parse_loop_body(parser_state_t* pstate) {
                 // retv->loop_body_list = loop_body_list;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -40,6 +40,9 @@ ast_loop_body_element_t* parse_loop_body_element(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_LOOP_BODY_ELEMENT))
+        RETURN(NULL);
+
     ast_loop_body_element_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -68,6 +71,8 @@ ast_loop_body_element_t* parse_loop_body_element(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -80,10 +85,11 @@ ast_loop_body_element_t* parse_loop_body_element(parser_state_t* pstate) {
                 // retv->CONTINUE = CONTINUE;
                 // retv->BREAK = BREAK;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
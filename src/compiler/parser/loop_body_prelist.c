@@ -36,6 +36,9 @@ ast_loop_body_prelist_t* parse_loop_body_prelist(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_LOOP_BODY_PRELIST))
+        RETURN(NULL);
+
     ast_loop_body_prelist_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -57,6 +60,8 @@ ast_loop_body_prelist_t* parse_loop_body_prelist(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -68,10 +73,11 @@ ast_loop_body_prelist_t* parse_loop_body_prelist(parser_state_t* pstate) {
                 // retv->loop_body_element = loop_body_element;
                 // retv->loop_body = loop_body;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -16,65 +16,190 @@
 #include "alloc.h"
 #include "parser_protos.h"
 
+// rule attempts that the lookahead could not begin, see first_sets.h
+unsigned long pruned_attempts = 0;
+
+// how many alternatives a region of tokens can give up before it is taken
+// to be an error, so a typo does not make the parser try every way there
+// is to read the rest of the file
+#define MAX_BACKTRACKS 4096
+
+// a token in the sync set only counts where a line begins, so the rest of
+// a broken statement is not taken for a new one
+static bool starts_line(token_t* tok, token_t* prev) {
+
+    return prev == NULL || tok->line_no != prev->line_no;
+}
+
 /*
  * PUBLIC INTERFACE
  */
 void push_parser_scope(parser_state_t* pstate, parser_scope_t scope) {
 
-    push_ptr_list(pstate->scope_stack, _COPY_TYPE(&scope, parser_scope_t));
+    push_scope_stack(&pstate->scope_stack, scope);
 }
 
 parser_scope_t pop_parser_scope(parser_state_t* pstate) {
 
-    parser_scope_t* tpt = pop_ptr_list(pstate->scope_stack);
-    parser_scope_t retv = *tpt;
-    _FREE(tpt);
-
-    return retv;
+    return pop_scope_stack(&pstate->scope_stack);
 }
 
 parser_scope_t peek_parser_scope(parser_state_t* pstate) {
 
-    parser_scope_t* tpt = peek_ptr_list(pstate->scope_stack);
-    return *tpt;
+    return peek_scope_stack(&pstate->scope_stack);
 }
 
 void push_parser_mode(parser_state_t* pstate, parser_mode_t mode) {
 
-    push_ptr_list(pstate->mode_stack, _COPY_TYPE(&mode, parser_mode_t));
+    push_mode_stack(&pstate->mode_stack, mode);
 }
 
 parser_mode_t pop_parser_mode(parser_state_t* pstate) {
 
-    parser_mode_t* tpt = pop_ptr_list(pstate->mode_stack);
-    parser_mode_t retv = *tpt;
-    _FREE(tpt);
-
-    return retv;
+    return pop_mode_stack(&pstate->mode_stack);
 }
 
 parser_mode_t peek_parser_mode(parser_state_t* pstate) {
 
-    parser_mode_t* tpt = peek_ptr_list(pstate->mode_stack);
-    return *tpt;
+    return peek_mode_stack(&pstate->mode_stack);
+}
+
+void push_parser_sync(parser_state_t* pstate, parser_rule_t rule) {
+
+    push_sync_stack(&pstate->sync_stack, rule);
+}
+
+parser_rule_t pop_parser_sync(parser_state_t* pstate) {
+
+    return pop_sync_stack(&pstate->sync_stack);
 }
 
 parser_state_t* create_parser_state(void) {
 
     parser_state_t* ptr = _ALLOC_TYPE(parser_state_t);
-    ptr->scope_stack = create_ptr_list();
-    ptr->mode_stack = create_ptr_list();
+    init_scope_stack(&ptr->scope_stack);
+    init_mode_stack(&ptr->mode_stack);
+    init_sync_stack(&ptr->sync_stack);
+    ptr->progress = -1;
 
     return ptr;
 }
 
+void destroy_parser_state(parser_state_t* pstate) {
+
+    if(pstate != NULL) {
+        free_scope_stack(&pstate->scope_stack);
+        free_mode_stack(&pstate->mode_stack);
+        free_sync_stack(&pstate->sync_stack);
+        _FREE(pstate);
+    }
+}
+
+/*
+ * Parse the tokens in the queue. When there are syntax errors, they are
+ * all reported and NULL is returned. NULL is returned too while the rules
+ * that have no body yet match nothing.
+ */
 ast_node_t* parse(void) {
 
     parser_state_t* pstate = create_parser_state();
-    return (ast_node_t*)parse_translation_unit(pstate);
+    ast_node_t* ast = (ast_node_t*)parse_translation_unit(pstate);
+
+    if(pstate->errors > 0) {
+        fprintf(stderr, "%d syntax errors\n", pstate->errors);
+        ast = NULL;
+    }
+    else if(ast == NULL)
+        fprintf(stderr, "syntax error: nothing in the file was parsed\n");
+
+    destroy_parser_state(pstate);
+    return ast;
+}
+
+unsigned long get_pruned_attempts(void) {
+
+    return pruned_attempts;
 }
 
+int get_syntax_errors(parser_state_t* pstate) {
+
+    return pstate->errors;
+}
+
+/*
+ * A rule that did not match gives its tokens back. The backtracks are
+ * counted since a rule last got further into the file than any before it,
+ * so a region that costs more than MAX_BACKTRACKS without going forward is
+ * given up as an error. Then every rule fails at once until the list that
+ * it is in calls recover_parser_error().
+ */
+void backtrack_parser(parser_state_t* pstate, void* mark) {
+
+    int index = get_token_index();
+    if(index > pstate->progress) {
+        pstate->progress = index;
+        pstate->backtracks = 0;
+    }
+
+    if(++pstate->backtracks > MAX_BACKTRACKS)
+        pstate->panic = true;
+
+    restore_token_queue(mark);
+}
+
+/*
+ * Panic mode. The error is reported at the furthest token that the parser
+ * looked at. The queue is back at the start of the element that failed and
+ * tokens are skipped from there up to one in the sync set of the list that
+ * is being parsed, outside of any braces that were opened on the way. The
+ * list carries on from that token, so a file with many errors is parsed
+ * once and they are all reported.
+ */
 void recover_parser_error(parser_state_t* pstate) {
 
-    (void)pstate;
+    ENTER;
+
+    char buf[64];
+    token_t* tok = get_reach_token();
+    fprintf(stderr, "syntax error: %s: %d: %d: unexpected %s\n",
+            (tok->fname != NULL) ? raw_string(tok->fname) : "unknown", tok->line_no, tok->col_no,
+            token_to_str(tok, buf, sizeof(buf)));
+    pstate->errors++;
+
+    parser_rule_t rule = (pstate->sync_stack.len > 0) ? peek_sync_stack(&pstate->sync_stack)
+                                                      : RULE_TRANSLATION_UNIT_ELEMENT;
+    uint64_t sync = sync_sets[rule];
+    int depth = 0;
+    token_t* prev = NULL;
+
+    while(true) {
+        tok = get_token();
+        if(tok->type == TOK_END_OF_FILE || tok->type == TOK_END_OF_INPUT)
+            break;
+
+        // the first token is skipped, so the list always moves forward
+        if(depth == 0 && prev != NULL) {
+            bool in_sync = (sync >> (tok->type - TOK_END_OF_FILE)) & 1;
+            // the end of the block that the list is in
+            if(in_sync && tok->type == TOK_CCBRACE)
+                break;
+            if(in_sync && starts_line(tok, prev))
+                break;
+        }
+
+        if(tok->type == TOK_OCBRACE)
+            depth++;
+        else if(tok->type == TOK_CCBRACE && depth > 0)
+            depth--;
+
+        prev = tok;
+        consume_token();
+    }
+
+    TRACE("resync at %d after %d errors", get_token_index(), pstate->errors);
+    pstate->panic = false;
+    pstate->backtracks = 0;
+    pstate->progress = get_token_index();
+
+    RETURN();
 }
@@ -14,7 +14,8 @@
 #define _PARSER_H_
 
 #include "ast.h"
-#include "pointer_list.h"
+#include "vector.h"
+#include "first_sets.h"
 
 typedef enum {
     PMODE_NORMAL,
@@ -28,19 +29,38 @@ typedef enum {
     SCOPE_PROTECTED,
 } parser_scope_t;
 
+DEFINE_STACK(scope_stack, parser_scope_t, 8)
+DEFINE_STACK(mode_stack, parser_mode_t, 8)
+DEFINE_STACK(sync_stack, parser_rule_t, 8)
+
 typedef struct {
-    pointer_list_t* scope_stack;
-    pointer_list_t* mode_stack;
+    scope_stack_t scope_stack;
+    mode_stack_t mode_stack;
+    // the element of the list that is being parsed, where an error resyncs
+    sync_stack_t sync_stack;
+    // syntax errors that were reported
+    int errors;
+    // alternatives that were given up since the parser last moved forward
+    int backtracks;
+    int progress;
+    // too many backtracks, every rule fails until the error is recovered
+    bool panic;
 } parser_state_t;
 
 ast_node_t* parse(void);
 parser_state_t* create_parser_state(void);
+void destroy_parser_state(parser_state_t* pstate);
 void push_parser_scope(parser_state_t* pstate, parser_scope_t scope);
 parser_scope_t pop_parser_scope(parser_state_t* pstate);
 parser_scope_t peek_parser_scope(parser_state_t* pstate);
 void push_parser_mode(parser_state_t* pstate, parser_mode_t mode);
 parser_mode_t pop_parser_mode(parser_state_t* pstate);
 parser_mode_t peek_parser_mode(parser_state_t* pstate);
+void push_parser_sync(parser_state_t* pstate, parser_rule_t rule);
+parser_rule_t pop_parser_sync(parser_state_t* pstate);
+void backtrack_parser(parser_state_t* pstate, void* mark);
 void recover_parser_error(parser_state_t* pstate);
+int get_syntax_errors(parser_state_t* pstate);
+unsigned long get_pruned_attempts(void);
 
 #endif /* _PARSER_H_ */
@@ -13,23 +13,21 @@
 #ifndef _PARSER_PROTOS_H_
 #define _PARSER_PROTOS_H_
 
+#include "trace.h"
 #include "ast.h"
 #include "parser.h"
+#include "first_sets.h"
 
 #define STATE_START 1000
 #define STATE_MATCH 9100
 #define STATE_NO_MATCH 9101
 #define STATE_ERROR 9102
 
-#ifdef USE_TRACE
-#define TRACE_STATE                \
-    {                              \
-        TRACE("state: %d", state); \
-    }                              \
-    while(0)
-#else
-#define TRACE_STATE
-#endif
+#define TRACE_STATE                         \
+    do {                                    \
+        TRACE_EVENT(TRACE_EV_STATE, state); \
+        TRACE("state: %d", state);          \
+    } while(0)
 
 ast_assignment_t* parse_assignment(parser_state_t* pstate);
 ast_bool_literal_t* parse_bool_literal(parser_state_t* pstate);
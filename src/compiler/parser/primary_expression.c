@@ -56,6 +56,9 @@ ast_primary_expression_t* parse_primary_expression(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_PRIMARY_EXPRESSION))
+        RETURN(NULL);
+
     ast_primary_expression_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -114,6 +117,8 @@ ast_primary_expression_t* parse_primary_expression(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -131,10 +136,11 @@ ast_primary_expression_t* parse_primary_expression(parser_state_t* pstate) {
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
                 // retv->compound_reference = compound_reference;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
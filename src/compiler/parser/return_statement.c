@@ -41,6 +41,9 @@ ast_return_statement_t* parse_return_statement(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_RETURN_STATEMENT))
+        RETURN(NULL);
+
     ast_return_statement_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -75,6 +78,8 @@ ast_return_statement_t* parse_return_statement(parser_state_t* pstate) {
             // begin grouping_function rule at state 1000:0
             case 1000:
                 // terminal rule element: TOK_RETURN
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -87,10 +92,11 @@ ast_return_statement_t* parse_return_statement(parser_state_t* pstate) {
                 // retv->expression = expression;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
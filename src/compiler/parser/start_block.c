@@ -33,6 +33,9 @@ ast_start_block_t* parse_start_block(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_START_BLOCK))
+        RETURN(NULL);
+
     ast_start_block_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -48,6 +51,8 @@ ast_start_block_t* parse_start_block(parser_state_t* pstate) {
             case 1000:
                 // terminal rule element: TOK_START
                 // non-terminal rule element: function_body
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -58,10 +63,11 @@ ast_start_block_t* parse_start_block(parser_state_t* pstate) {
                 retv = (ast_start_block_t*)create_ast_node(AST_START_BLOCK);
                 // retv->function_body = function_body;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
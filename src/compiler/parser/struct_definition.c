@@ -41,6 +41,9 @@ ast_struct_definition_t* parse_struct_definition(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_STRUCT_DEFINITION))
+        RETURN(NULL);
+
     ast_struct_definition_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -74,6 +77,8 @@ ast_struct_definition_t* parse_struct_definition(parser_state_t* pstate) {
                 // terminal rule element: TOK_OCBRACE
                 // non-terminal rule element: data_declaration
                 // terminal rule element: TOK_CCBRACE
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -88,10 +93,11 @@ ast_struct_definition_t* parse_struct_definition(parser_state_t* pstate) {
                 // retv->data_declaration = data_declaration;
                 // retv->TERMINAL_OPER = TERMINAL_OPER;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -38,6 +38,7 @@ ast_translation_unit_t* parse_translation_unit(parser_state_t* pstate) {
     int state = 1000;
     bool finished = false;
     void* post = mark_token_queue();
+    push_parser_sync(pstate, RULE_TRANSLATION_UNIT_ELEMENT);
 
     // ast_translation_unit_element_t* translation_unit_element = NULL;
 
@@ -53,6 +54,8 @@ ast_translation_unit_t* parse_translation_unit(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -63,10 +66,11 @@ ast_translation_unit_t* parse_translation_unit(parser_state_t* pstate) {
                 retv = (ast_translation_unit_t*)create_ast_node(AST_TRANSLATION_UNIT);
                 // retv->translation_unit_element = translation_unit_element;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
@@ -80,5 +84,6 @@ ast_translation_unit_t* parse_translation_unit(parser_state_t* pstate) {
         }
     }
 
+    pop_parser_sync(pstate);
     RETURN(retv);
 }
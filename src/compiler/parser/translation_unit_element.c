@@ -22,7 +22,8 @@
  *     import_statement |
  *     data_definition |
  *     function_definition |
- *     struct_definition start_block
+ *     struct_definition |
+ *     start_block
  * )
  *
  *
@@ -45,6 +46,9 @@ ast_translation_unit_element_t* parse_translation_unit_element(parser_state_t* p
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_TRANSLATION_UNIT_ELEMENT))
+        RETURN(NULL);
+
     ast_translation_unit_element_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -82,6 +86,8 @@ ast_translation_unit_element_t* parse_translation_unit_element(parser_state_t* p
             // begin grouping_function rule at state 1000:0
             case 1000:
                 // non-terminal rule element: start_block
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -96,10 +102,11 @@ ast_translation_unit_element_t* parse_translation_unit_element(parser_state_t* p
                 // retv->struct_definition = struct_definition;
                 // retv->start_block = start_block;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
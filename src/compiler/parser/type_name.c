@@ -36,6 +36,9 @@ ast_type_name_t* parse_type_name(parser_state_t* pstate) {
 
     ENTER;
     ASSERT(pstate != NULL, "null pstate is not allowed");
+    if(pstate->panic || !can_start_rule(RULE_TYPE_NAME))
+        RETURN(NULL);
+
     ast_type_name_t* retv = NULL;
     int state = 1000;
     bool finished = false;
@@ -57,6 +60,8 @@ ast_type_name_t* parse_type_name(parser_state_t* pstate) {
 
             // begin grouping_function rule at state 1000:0
             case 1000:
+                // the rule has no body yet, so it matches nothing
+                state = STATE_NO_MATCH;
                 break;
                 // end grouping_function rule at state 1000
 
@@ -68,10 +73,11 @@ ast_type_name_t* parse_type_name(parser_state_t* pstate) {
                 // retv->literal_type_name = literal_type_name;
                 // retv->compound_name = compound_name;
 
+                finished = true;
                 break;
             case STATE_NO_MATCH:
                 TRACE_STATE;
-                restore_token_queue(post);
+                backtrack_parser(pstate, post);
                 finished = true;
                 break;
             case STATE_ERROR:
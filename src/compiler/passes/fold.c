@@ -0,0 +1,838 @@
+/**
+ * @file fold.c
+ *
+ * @brief Constant folding. This runs after the type checker, so every item
+ * in an expression already has a type. An operator or a cast whose operands
+ * are all literals is evaluated here and replaced, together with its
+ * operands, by a single literal. A const whose initializer folds to a
+ * literal is replaced by that literal wherever it is read.
+ *
+ * An if, while, do or for whose condition folds to a literal is pruned. A
+ * branch that is never taken is removed, and a condition that is always
+ * true is dropped. An if without a condition is a block that always runs.
+ *
+ * Nothing is folded that would have a different result, or would fail, at
+ * run time. Integer division by zero, a float result that is not finite and
+ * conversions from strings are left for the virtual machine.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "trace.h"
+#include "cmdline.h"
+#include "alloc.h"
+#include "intern.h"
+#include "passes.h"
+#include "types.h"
+
+typedef struct {
+    type_kind_t kind;
+    union {
+        int64_t ival;
+        double fval;
+        bool bval;
+        const char* sval;
+    };
+} fold_value_t;
+
+// an entry on the stack that mirrors the run time stack
+typedef struct {
+    // index in the output list of the first item of this operand
+    int start;
+    bool is_const;
+    fold_value_t value;
+} operand_t;
+
+static bool fold_expression(ast_expression_t* node, fold_value_t* value);
+static void fold_function_body(ast_function_body_t* node);
+static void fold_loop_body(ast_loop_body_t* node);
+
+static fold_stats_t* stats = NULL;
+
+/*
+ * Read the value of a literal item. The scanner has converted numbers.
+ */
+static bool literal_value(ast_primary_expression_t* item, fold_value_t* value) {
+
+    if(item->token != NULL) {
+        const char* str = raw_string(item->token->str);
+        switch(item->token->type) {
+            case TOK_INT_LITERAL:
+                value->kind = TYPE_INT;
+                value->ival = item->token->ival;
+                return true;
+            case TOK_FLOAT_LITERAL:
+                value->kind = TYPE_FLOAT;
+                value->fval = item->token->fval;
+                return true;
+            case TOK_STRING_LITERAL:
+                value->kind = TYPE_STRING;
+                value->sval = str;
+                return true;
+            case TOK_TRUE:
+            case TOK_FALSE:
+                value->kind = TYPE_BOOL;
+                value->bval = (item->token->type == TOK_TRUE);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    switch(item->nterm->type) {
+        case AST_BOOL_LITERAL:
+            value->kind = TYPE_BOOL;
+            value->bval = (((ast_bool_literal_t*)item->nterm)->tok->type == TOK_TRUE);
+            return true;
+        case AST_FORMATTED_STRING: {
+            // a string literal with no values is not a template
+            ast_formatted_string_t* n = (ast_formatted_string_t*)item->nterm;
+            if(n->dss_initializer != NULL)
+                return false;
+            value->kind = TYPE_STRING;
+            value->sval = intern_string(raw_string(n->STRING_LITERAL->str));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/*
+ * Make a literal item that has the value. The location is taken from the
+ * item that it replaces.
+ */
+static ast_primary_expression_t* make_literal(ast_primary_expression_t* at, fold_value_t* value) {
+
+    ast_primary_expression_t* item = (ast_primary_expression_t*)create_ast_node(AST_PRIMARY_EXPRESSION);
+    item->node = at->node;
+    item->type = get_basic_type(value->kind);
+
+    token_t* tok = _ALLOC_SLAB(token_t);
+    tok->fname = create_string(at->node.fname);
+    tok->line_no = at->node.line_no;
+    tok->col_no = at->node.col_no;
+
+    switch(value->kind) {
+        case TYPE_INT:
+            tok->type = TOK_INT_LITERAL;
+            tok->ival = value->ival;
+            break;
+        case TYPE_FLOAT:
+            tok->type = TOK_FLOAT_LITERAL;
+            tok->fval = value->fval;
+            break;
+        case TYPE_STRING:
+            tok->type = TOK_STRING_LITERAL;
+            tok->str = create_string(value->sval);
+            break;
+        case TYPE_BOOL:
+            tok->type = value->bval ? TOK_TRUE : TOK_FALSE;
+            tok->str = create_string(value->bval ? "true" : "false");
+            break;
+        default:
+            FATAL("internal error: cannot make a literal of type %d", value->kind);
+    }
+
+    item->token = tok;
+    return item;
+}
+
+static int64_t int_pow(int64_t base, int64_t exp) {
+
+    uint64_t result = 1;
+    uint64_t b = (uint64_t)base;
+
+    while(exp > 0) {
+        if(exp & 1)
+            result *= b;
+        b *= b;
+        exp >>= 1;
+    }
+
+    return (int64_t)result;
+}
+
+/*
+ * Integers wrap on overflow, the same as they do in the virtual machine.
+ */
+static bool fold_int(operator_t op, int64_t a, int64_t b, fold_value_t* out) {
+
+    out->kind = TYPE_INT;
+    switch(op) {
+        case OPER_ADD:
+            out->ival = (int64_t)((uint64_t)a + (uint64_t)b);
+            return true;
+        case OPER_SUB:
+            out->ival = (int64_t)((uint64_t)a - (uint64_t)b);
+            return true;
+        case OPER_MUL:
+            out->ival = (int64_t)((uint64_t)a * (uint64_t)b);
+            return true;
+        case OPER_DIV:
+        case OPER_MOD:
+            if(b == 0 || (a == INT64_MIN && b == -1))
+                return false;
+            out->ival = (op == OPER_DIV) ? a / b : a % b;
+            return true;
+        case OPER_POW:
+            if(b < 0)
+                return false;
+            out->ival = int_pow(a, b);
+            return true;
+        case OPER_NEG:
+            out->ival = (int64_t)(0 - (uint64_t)a);
+            return true;
+        default:
+            break;
+    }
+
+    out->kind = TYPE_BOOL;
+    switch(op) {
+        case OPER_EQ:
+            out->bval = (a == b);
+            return true;
+        case OPER_NE:
+            out->bval = (a != b);
+            return true;
+        case OPER_LT:
+            out->bval = (a < b);
+            return true;
+        case OPER_LE:
+            out->bval = (a <= b);
+            return true;
+        case OPER_GT:
+            out->bval = (a > b);
+            return true;
+        case OPER_GE:
+            out->bval = (a >= b);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool fold_float(operator_t op, double a, double b, fold_value_t* out) {
+
+    out->kind = TYPE_FLOAT;
+    switch(op) {
+        case OPER_ADD:
+            out->fval = a + b;
+            return isfinite(out->fval);
+        case OPER_SUB:
+            out->fval = a - b;
+            return isfinite(out->fval);
+        case OPER_MUL:
+            out->fval = a * b;
+            return isfinite(out->fval);
+        case OPER_DIV:
+            out->fval = a / b;
+            return (b != 0.0) && isfinite(out->fval);
+        case OPER_NEG:
+            out->fval = -a;
+            return true;
+        default:
+            break;
+    }
+
+    out->kind = TYPE_BOOL;
+    switch(op) {
+        case OPER_EQ:
+            out->bval = (a == b);
+            return true;
+        case OPER_NE:
+            out->bval = (a != b);
+            return true;
+        case OPER_LT:
+            out->bval = (a < b);
+            return true;
+        case OPER_LE:
+            out->bval = (a <= b);
+            return true;
+        case OPER_GT:
+            out->bval = (a > b);
+            return true;
+        case OPER_GE:
+            out->bval = (a >= b);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool fold_string(operator_t op, const char* a, const char* b, fold_value_t* out) {
+
+    if(op == OPER_ADD) {
+        // the string is kept by the token that is made for it
+        static string_t* buf = NULL;
+        if(buf == NULL)
+            buf = create_string(NULL);
+        clear_string(buf);
+        append_string(buf, a);
+        append_string(buf, b);
+
+        out->kind = TYPE_STRING;
+        out->sval = raw_string(buf);
+        return true;
+    }
+
+    int cmp = strcmp(a, b);
+    out->kind = TYPE_BOOL;
+    switch(op) {
+        case OPER_EQ:
+            out->bval = (cmp == 0);
+            return true;
+        case OPER_NE:
+            out->bval = (cmp != 0);
+            return true;
+        case OPER_LT:
+            out->bval = (cmp < 0);
+            return true;
+        case OPER_LE:
+            out->bval = (cmp <= 0);
+            return true;
+        case OPER_GT:
+            out->bval = (cmp > 0);
+            return true;
+        case OPER_GE:
+            out->bval = (cmp >= 0);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool fold_bool(operator_t op, bool a, bool b, fold_value_t* out) {
+
+    out->kind = TYPE_BOOL;
+    switch(op) {
+        case OPER_AND:
+            out->bval = a && b;
+            return true;
+        case OPER_OR:
+            out->bval = a || b;
+            return true;
+        case OPER_NOT:
+            out->bval = !a;
+            return true;
+        case OPER_EQ:
+            out->bval = (a == b);
+            return true;
+        case OPER_NE:
+            out->bval = (a != b);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * The type checker has made sure that both operands have the same type.
+ */
+static bool fold_operator(operator_t op, fold_value_t* a, fold_value_t* b, fold_value_t* out) {
+
+    if(a->kind != b->kind)
+        return false;
+
+    switch(a->kind) {
+        case TYPE_INT:
+            return fold_int(op, a->ival, b->ival, out);
+        case TYPE_FLOAT:
+            return fold_float(op, a->fval, b->fval, out);
+        case TYPE_STRING:
+            return fold_string(op, a->sval, b->sval, out);
+        case TYPE_BOOL:
+            return fold_bool(op, a->bval, b->bval, out);
+        default:
+            return false;
+    }
+}
+
+static bool fold_cast(type_t* dest, fold_value_t* a, fold_value_t* out) {
+
+    static char buf[32];
+
+    out->kind = dest->kind;
+    if(a->kind == dest->kind) {
+        *out = *a;
+        return true;
+    }
+
+    switch(a->kind) {
+        case TYPE_INT:
+            if(IS_TYPE(dest, TYPE_FLOAT))
+                out->fval = (double)a->ival;
+            else if(IS_TYPE(dest, TYPE_BOOL))
+                out->bval = (a->ival != 0);
+            else if(IS_TYPE(dest, TYPE_STRING)) {
+                snprintf(buf, sizeof(buf), "%lld", (long long)a->ival);
+                out->sval = buf;
+            }
+            else
+                return false;
+            return true;
+        case TYPE_FLOAT:
+            if(IS_TYPE(dest, TYPE_INT) && a->fval > (double)INT64_MIN && a->fval < (double)INT64_MAX) {
+                out->ival = (int64_t)a->fval;
+                return true;
+            }
+            return false;
+        case TYPE_BOOL:
+            if(IS_TYPE(dest, TYPE_INT))
+                out->ival = a->bval ? 1 : 0;
+            else if(IS_TYPE(dest, TYPE_STRING))
+                out->sval = a->bval ? "true" : "false";
+            else
+                return false;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void fold_expression_list(ast_expression_list_t* node) {
+
+    fold_value_t value;
+
+    if(node == NULL)
+        return;
+
+    int mark = 0;
+    ast_expression_t* item;
+    while(iterate_expr_list(node->list, &mark, &item))
+        fold_expression(item, &value);
+}
+
+static void fold_dss_initializer(ast_dss_initializer_t* node) {
+
+    fold_value_t value;
+
+    if(node == NULL)
+        return;
+
+    int mark = 0;
+    ast_dss_initializer_item_t* item;
+    while(iterate_dss_item_list(node->list, &mark, &item))
+        fold_expression(item->expression, &value);
+}
+
+static void fold_reference_args(ast_compound_reference_t* node) {
+
+    fold_value_t value;
+
+    int mark = 0;
+    ast_compound_reference_element_t* item;
+    while(iterate_ref_element_list(node->list, &mark, &item)) {
+        if(item->function_reference != NULL)
+            fold_expression_list(item->function_reference->expression_list);
+        else if(item->list_reference != NULL) {
+            int m = 0;
+            ast_expression_t* index;
+            while(iterate_expr_list(item->list_reference->list, &m, &index))
+                fold_expression(index, &value);
+        }
+    }
+}
+
+/*
+ * A reference to a const that has a literal value is replaced by the
+ * literal. Otherwise the arguments and the indexes are folded.
+ */
+static ast_primary_expression_t* fold_compound_reference(ast_primary_expression_t* at, ast_compound_reference_t* node) {
+
+    fold_value_t value;
+
+    ast_compound_reference_element_t* first = index_ref_element_list(node->list, 0);
+    if(len_ref_element_list(node->list) == 1 && first->IDENTIFIER != NULL && first->sym != NULL && first->sym->value != NULL) {
+        literal_value(first->sym->value, &value);
+        stats->propagated++;
+        return make_literal(at, &value);
+    }
+
+    fold_reference_args(node);
+    return at;
+}
+
+/*
+ * Fold what is inside of an operand and return the item that replaces it,
+ * which is the same item if nothing changed.
+ */
+static ast_primary_expression_t* fold_operand(ast_primary_expression_t* item) {
+
+    fold_value_t value;
+
+    if(item->nterm == NULL)
+        return item;
+
+    switch(item->nterm->type) {
+        case AST_COMPOUND_REFERENCE:
+            return fold_compound_reference(item, (ast_compound_reference_t*)item->nterm);
+        case AST_FORMATTED_STRING:
+            fold_dss_initializer(((ast_formatted_string_t*)item->nterm)->dss_initializer);
+            return item;
+        case AST_EXPRESSION: {
+            ast_expression_t* sub = (ast_expression_t*)item->nterm;
+            if(fold_expression(sub, &value))
+                return index_expr_item_list(sub->list, 0);
+            return item;
+        }
+        default:
+            return item;
+    }
+}
+
+/*
+ * Walk the postfix list and build a new one. Each operand on the stack
+ * remembers where its items start in the new list, so when an operator is
+ * folded the items of its operands are cut off and the result is put in
+ * their place. Return true if the whole expression is a literal.
+ */
+static bool fold_expression(ast_expression_t* node, fold_value_t* value) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN(false);
+
+    int len = len_expr_item_list(node->list);
+    operand_t* stack = _ALLOC_ARRAY(operand_t, len + 1);
+    int sp = 0;
+    expr_item_list_t* out = create_expr_item_list();
+    int folded = 0;
+
+    int mark = 0;
+    ast_primary_expression_t* item;
+    while(iterate_expr_item_list(node->list, &mark, &item)) {
+        operator_t op = get_operator(item);
+        bool is_cast = (op == OPER_NONE && item->nterm != NULL && item->nterm->type == AST_TYPE_NAME);
+
+        if(op != OPER_NONE || is_cast) {
+            int nargs = (is_cast || is_unary_operator(op)) ? 1 : 2;
+            operand_t* left = &stack[sp - nargs];
+            operand_t* right = &stack[sp - 1];
+            fold_value_t result;
+            bool ok = false;
+
+            if(left->is_const && right->is_const) {
+                if(is_cast)
+                    ok = fold_cast(item->type, &left->value, &result);
+                else
+                    ok = fold_operator(op, &left->value, &right->value, &result);
+            }
+
+            sp -= nargs;
+            if(ok) {
+                ast_primary_expression_t* lit = make_literal(item, &result);
+                truncate_expr_item_list(out, stack[sp].start);
+                literal_value(lit, &stack[sp].value);
+                append_expr_item_list(out, lit);
+                stack[sp].is_const = true;
+                folded++;
+            }
+            else {
+                append_expr_item_list(out, item);
+                stack[sp].is_const = false;
+            }
+            sp++;
+        }
+        else {
+            item = fold_operand(item);
+            stack[sp].start = len_expr_item_list(out);
+            stack[sp].is_const = literal_value(item, &stack[sp].value);
+            sp++;
+            append_expr_item_list(out, item);
+        }
+    }
+
+    bool is_const = (sp == 1 && stack[0].is_const);
+    if(is_const)
+        *value = stack[0].value;
+
+    if(folded > 0) {
+        destroy_expr_item_list(node->list);
+        node->list = out;
+        stats->folded += folded;
+    }
+    else
+        destroy_expr_item_list(out);
+
+    _FREE(stack);
+
+    RETURN(is_const);
+}
+
+static void fold_initializer(ast_initializer_t* node) {
+
+    fold_value_t value;
+
+    if(node == NULL)
+        return;
+
+    switch(node->nterm->type) {
+        case AST_EXPRESSION:
+            fold_expression((ast_expression_t*)node->nterm, &value);
+            break;
+        case AST_LIST_INIT:
+            fold_expression_list(((ast_list_init_t*)node->nterm)->expression_list);
+            break;
+        case AST_DICT_INIT:
+            fold_dss_initializer(((ast_dict_init_t*)node->nterm)->dss_initializer);
+            break;
+        case AST_STRUCT_INIT:
+            fold_dss_initializer(((ast_struct_init_t*)node->nterm)->dss_initializer);
+            break;
+        default:
+            FATAL("internal AST error: Unknown initializer type: %d", node->nterm->type);
+    }
+}
+
+/*
+ * A const keeps its definition, because it may also be read as a global by
+ * a module that does not see the literal.
+ */
+static void fold_data_definition(ast_data_definition_t* node) {
+
+    fold_initializer(node->initializer);
+
+    symbol_t* sym = node->data_declaration->sym;
+    if(node->is_const && sym != NULL && node->initializer != NULL && node->initializer->nterm->type == AST_EXPRESSION) {
+        ast_expression_t* expr = (ast_expression_t*)node->initializer->nterm;
+        fold_value_t value;
+        ast_primary_expression_t* item = index_expr_item_list(expr->list, 0);
+        if(len_expr_item_list(expr->list) == 1 && literal_value(item, &value) && item->type == sym->type)
+            sym->value = item;
+    }
+}
+
+static bool fold_condition(ast_expression_t* node, bool* value) {
+
+    fold_value_t v;
+
+    if(node == NULL || !fold_expression(node, &v) || v.kind != TYPE_BOOL)
+        return false;
+
+    *value = v.bval;
+    stats->pruned++;
+    return true;
+}
+
+/*
+ * Return true if the whole statement can be removed.
+ */
+static bool fold_if_clause(ast_if_clause_t* node) {
+
+    bool value;
+
+    while(fold_condition(node->expression, &value)) {
+        if(value) {
+            node->expression = NULL;
+            node->else_clause = NULL;
+            node->final_else_clause = NULL;
+        }
+        else if(node->else_clause != NULL) {
+            node->expression = node->else_clause->expression;
+            node->function_body = node->else_clause->function_body;
+            node->else_clause = NULL;
+        }
+        else if(node->final_else_clause != NULL) {
+            node->expression = NULL;
+            node->function_body = node->final_else_clause->function_body;
+            node->final_else_clause = NULL;
+        }
+        else
+            return true;
+    }
+
+    fold_function_body(node->function_body);
+
+    if(node->else_clause != NULL && fold_condition(node->else_clause->expression, &value)) {
+        if(value) {
+            ast_final_else_clause_t* final = (ast_final_else_clause_t*)create_ast_node(AST_FINAL_ELSE_CLAUSE);
+            final->node = node->else_clause->node;
+            final->function_body = node->else_clause->function_body;
+            node->final_else_clause = final;
+        }
+        node->else_clause = NULL;
+    }
+
+    if(node->else_clause != NULL)
+        fold_function_body(node->else_clause->function_body);
+    if(node->final_else_clause != NULL)
+        fold_function_body(node->final_else_clause->function_body);
+
+    return false;
+}
+
+/*
+ * A loop whose condition is always false never runs. A condition that is
+ * always true is dropped, and the loop only ends with a break.
+ */
+static bool fold_loop_condition(ast_expression_t** cond) {
+
+    bool value;
+
+    if(!fold_condition(*cond, &value))
+        return false;
+
+    if(!value)
+        return true;
+
+    *cond = NULL;
+    return false;
+}
+
+static bool fold_for_clause(ast_for_clause_t* node) {
+
+    fold_value_t value;
+
+    if(node->IDENTIFIER == NULL && node->expression != NULL && IS_TYPE(node->expression->type, TYPE_BOOL)) {
+        if(fold_loop_condition(&node->expression))
+            return true;
+    }
+    else if(fold_expression(node->expression, &value) && value.kind == TYPE_INT && value.ival <= 0) {
+        stats->pruned++;
+        return true;
+    }
+
+    fold_loop_body(node->loop_body);
+    return false;
+}
+
+static bool fold_function_body_element(ast_function_body_element_t* node) {
+
+    fold_value_t value;
+
+    if(node == NULL || node->INLINE != NULL)
+        return false;
+
+    switch(node->nterm->type) {
+        case AST_ASSIGNMENT:
+            fold_expression(((ast_assignment_t*)node->nterm)->expression, &value);
+            break;
+        case AST_COMPOUND_REFERENCE:
+            fold_reference_args((ast_compound_reference_t*)node->nterm);
+            break;
+        case AST_DATA_DEFINITION:
+            fold_data_definition((ast_data_definition_t*)node->nterm);
+            break;
+        case AST_STRUCT_DEFINITION:
+            break;
+        case AST_IF_CLAUSE:
+            return fold_if_clause((ast_if_clause_t*)node->nterm);
+        case AST_WHILE_CLAUSE: {
+            ast_while_clause_t* n = (ast_while_clause_t*)node->nterm;
+            if(fold_loop_condition(&n->expression))
+                return true;
+            fold_loop_body(n->loop_body);
+        } break;
+        case AST_DO_CLAUSE: {
+            // the body runs once even if the condition is false
+            ast_do_clause_t* n = (ast_do_clause_t*)node->nterm;
+            fold_loop_body(n->loop_body);
+            bool cond;
+            if(fold_condition(n->expression, &cond) && cond)
+                n->expression = NULL;
+        } break;
+        case AST_FOR_CLAUSE:
+            return fold_for_clause((ast_for_clause_t*)node->nterm);
+        case AST_RETURN_STATEMENT:
+            fold_expression(((ast_return_statement_t*)node->nterm)->expression, &value);
+            break;
+        case AST_EXIT_STATEMENT:
+            fold_expression(((ast_exit_statement_t*)node->nterm)->expression, &value);
+            break;
+        default:
+            FATAL("internal AST error: Unknown body element type: %d", node->nterm->type);
+    }
+
+    return false;
+}
+
+static void fold_function_body(ast_function_body_t* node) {
+
+    if(node == NULL || node->function_body_list == NULL)
+        return;
+
+    // the items that are kept are moved down over the ones that are pruned
+    body_item_list_t* list = node->function_body_list->list;
+    int keep = 0;
+
+    int mark = 0;
+    ast_function_body_prelist_t* item;
+    while(iterate_body_item_list(list, &mark, &item)) {
+        if(item->nterm->type == AST_FUNCTION_BODY)
+            fold_function_body((ast_function_body_t*)item->nterm);
+        else if(fold_function_body_element((ast_function_body_element_t*)item->nterm))
+            continue;
+        *at_body_item_list(list, keep++) = item;
+    }
+
+    truncate_body_item_list(list, keep);
+}
+
+static void fold_loop_body(ast_loop_body_t* node) {
+
+    if(node == NULL || node->loop_body_list == NULL)
+        return;
+
+    loop_item_list_t* list = node->loop_body_list->list;
+    int keep = 0;
+
+    int mark = 0;
+    ast_loop_body_prelist_t* item;
+    while(iterate_loop_item_list(list, &mark, &item)) {
+        if(item->nterm->type == AST_LOOP_BODY)
+            fold_loop_body((ast_loop_body_t*)item->nterm);
+        else {
+            ast_loop_body_element_t* elem = (ast_loop_body_element_t*)item->nterm;
+            if(elem->tok == NULL && fold_function_body_element(elem->function_body_element))
+                continue;
+        }
+        *at_loop_item_list(list, keep++) = item;
+    }
+
+    truncate_loop_item_list(list, keep);
+}
+
+/*
+ * public interface
+ */
+void fold_constants(ast_node_t* node, fold_stats_t* st) {
+
+    if(in_cmd_list("trace", "fold"))
+        push_trace_state(1);
+    else
+        push_trace_state(0);
+
+    stats = st;
+    memset(stats, 0, sizeof(fold_stats_t));
+
+    // the global consts are known before any function is folded
+    int mark = 0;
+    ast_translation_unit_element_t* item;
+    while(node != NULL && iterate_unit_item_list(((ast_translation_unit_t*)node)->list, &mark, &item))
+        if(item->nterm->type == AST_DATA_DEFINITION)
+            fold_data_definition((ast_data_definition_t*)item->nterm);
+
+    mark = 0;
+    while(node != NULL && iterate_unit_item_list(((ast_translation_unit_t*)node)->list, &mark, &item)) {
+        switch(item->nterm->type) {
+            case AST_FUNCTION_DEFINITION:
+                fold_function_body(((ast_function_definition_t*)item->nterm)->function_body);
+                break;
+            case AST_START_BLOCK:
+                fold_function_body(((ast_start_block_t*)item->nterm)->function_body);
+                break;
+            default:
+                break;
+        }
+    }
+
+    MSG(5, "fold: %d folded, %d propagated, %d pruned\n", stats->folded, stats->propagated, stats->pruned);
+    stats = NULL;
+
+    pop_trace_state();
+}
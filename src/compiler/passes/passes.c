@@ -0,0 +1,40 @@
+/**
+ * @file passes.c
+ *
+ * @brief Things that are shared by all of the AST passes.
+ *
+ */
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "passes.h"
+
+static int sem_errors = 0;
+
+/*
+ * Report an error in the source code. The pass keeps going so that all of
+ * the errors in the module are reported in one run.
+ */
+void sem_error(const char* fname, int line, int col, const char* fmt, ...) {
+
+    va_list args;
+
+    fprintf(stderr, "error: %s: %d: %d: ", (fname != NULL) ? fname : "unknown", line, col);
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+
+    sem_errors++;
+}
+
+int get_sem_errors(void) {
+
+    return sem_errors;
+}
+
+void reset_sem_errors(void) {
+
+    sem_errors = 0;
+}
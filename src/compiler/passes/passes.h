@@ -0,0 +1,34 @@
+/**
+ * @file passes.h
+ *
+ * @brief Public interface for the passes that run over the AST after it
+ * has been parsed.
+ *
+ */
+#ifndef _PASSES_H_
+#define _PASSES_H_
+
+#include "ast.h"
+#include "symtab.h"
+
+#define NODE_ERROR(n, ...) \
+    sem_error(((ast_node_t*)(n))->fname, ((ast_node_t*)(n))->line_no, ((ast_node_t*)(n))->col_no, __VA_ARGS__)
+
+#define TOKEN_ERROR(t, ...) \
+    sem_error(raw_string((t)->fname), (t)->line_no, (t)->col_no, __VA_ARGS__)
+
+typedef struct {
+    int folded;
+    int propagated;
+    int pruned;
+} fold_stats_t;
+
+void sem_error(const char* fname, int line, int col, const char* fmt, ...);
+int get_sem_errors(void);
+void reset_sem_errors(void);
+
+symtab_t* resolve_names(ast_node_t* node);
+void check_types(symtab_t* tab, ast_node_t* node);
+void fold_constants(ast_node_t* node, fold_stats_t* stats);
+
+#endif /* _PASSES_H_ */
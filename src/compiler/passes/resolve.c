@@ -0,0 +1,587 @@
+/**
+ * @file resolve.c
+ *
+ * @brief Name resolution. This runs once, after the parse. Every name that
+ * declares or references a global, a local, a parameter, a function or a
+ * struct is bound to its symbol, and the symbol carries the slot that the
+ * code generator uses. Nothing after this pass looks up a name by string.
+ *
+ * Top level names are declared before any function body is resolved, so a
+ * function may refer to a global, a function or a struct that is defined
+ * further down in the file. Inside a function, a name is visible from its
+ * definition to the end of the enclosing block.
+ *
+ * The first element of a compound reference is resolved here. The elements
+ * that follow it are fields, and they are resolved by the type checker
+ * because that requires knowing the type of the element to the left.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "trace.h"
+#include "cmdline.h"
+#include "intern.h"
+#include "passes.h"
+
+static void resolve_expression(symtab_t* tab, ast_expression_t* node);
+static void resolve_function_body(symtab_t* tab, ast_function_body_t* node, bool new_scope);
+static void resolve_loop_body(symtab_t* tab, ast_loop_body_t* node);
+static void resolve_struct_definition(symtab_t* tab, ast_struct_definition_t* node, bool is_global);
+
+static const char* tok_name(token_t* tok) {
+
+    return intern_string(raw_string(tok->str));
+}
+
+static void resolve_type_name(symtab_t* tab, ast_type_name_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    if(node->nterm->type == AST_COMPOUND_NAME) {
+        // Qualified type names belong to imported modules, which are not
+        // resolved here yet. The first name has to be a struct.
+        ast_compound_name_t* name = (ast_compound_name_t*)node->nterm;
+        token_t* tok = index_token_list(name->list, 0);
+        symbol_t* sym = lookup_symbol(tab, tok_name(tok));
+
+        name->sym = NULL;
+        if(sym == NULL)
+            TOKEN_ERROR(tok, "undefined type name: \"%s\"", raw_string(tok->str));
+        else if(sym->kind != SYM_STRUCT)
+            TOKEN_ERROR(tok, "\"%s\" is a %s, not a type", raw_string(tok->str), sym_kind_to_str(sym->kind));
+        else
+            name->sym = sym;
+    }
+
+    RETURN();
+}
+
+static symbol_t* declare_data(symtab_t* tab, symbol_kind_t kind, ast_data_declaration_t* node, bool is_const) {
+
+    ENTER;
+    resolve_type_name(tab, node->type_name);
+
+    symbol_t* sym = declare_symbol(tab, kind, raw_string(node->IDENTIFIER->str), (ast_node_t*)node);
+    node->sym = sym;
+    if(sym == NULL) {
+        TOKEN_ERROR(node->IDENTIFIER, "redefinition of \"%s\"", raw_string(node->IDENTIFIER->str));
+        RETURN(NULL);
+    }
+
+    sym->is_const = is_const;
+
+    RETURN(sym);
+}
+
+static void resolve_expression_list(symtab_t* tab, ast_expression_list_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    int mark = 0;
+    ast_expression_t* item;
+    while(iterate_expr_list(node->list, &mark, &item))
+        resolve_expression(tab, item);
+
+    RETURN();
+}
+
+static void resolve_dss_initializer(symtab_t* tab, ast_dss_initializer_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    int mark = 0;
+    ast_dss_initializer_item_t* item;
+    while(iterate_dss_item_list(node->list, &mark, &item))
+        resolve_expression(tab, item->expression);
+
+    RETURN();
+}
+
+static void resolve_element_args(symtab_t* tab, ast_compound_reference_element_t* node) {
+
+    ENTER;
+    if(node->function_reference != NULL)
+        resolve_expression_list(tab, node->function_reference->expression_list);
+    else if(node->list_reference != NULL) {
+        int mark = 0;
+        ast_expression_t* item;
+        while(iterate_expr_list(node->list_reference->list, &mark, &item))
+            resolve_expression(tab, item);
+    }
+
+    RETURN();
+}
+
+static void resolve_compound_reference(symtab_t* tab, ast_compound_reference_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    int mark = 0;
+    ast_compound_reference_element_t* item;
+    while(iterate_ref_element_list(node->list, &mark, &item)) {
+        if(mark == 1) {
+            token_t* tok = (item->function_reference != NULL) ? item->function_reference->IDENTIFIER :
+                    (item->list_reference != NULL)            ? item->list_reference->IDENTIFIER :
+                                                                item->IDENTIFIER;
+            symbol_t* sym = lookup_symbol(tab, tok_name(tok));
+
+            item->sym = NULL;
+            if(sym == NULL)
+                TOKEN_ERROR(tok, "undefined name: \"%s\"", raw_string(tok->str));
+            else if(item->function_reference != NULL && sym->kind != SYM_FUNCTION)
+                TOKEN_ERROR(tok, "\"%s\" is a %s, not a function", raw_string(tok->str), sym_kind_to_str(sym->kind));
+            else if(item->function_reference == NULL && (sym->kind == SYM_FUNCTION || sym->kind == SYM_STRUCT))
+                TOKEN_ERROR(tok, "\"%s\" is a %s, not a value", raw_string(tok->str), sym_kind_to_str(sym->kind));
+            else
+                item->sym = sym;
+        }
+        resolve_element_args(tab, item);
+    }
+
+    RETURN();
+}
+
+static void resolve_primary_expression(symtab_t* tab, ast_primary_expression_t* node) {
+
+    ENTER;
+    if(node == NULL || node->nterm == NULL)
+        RETURN();
+
+    switch(node->nterm->type) {
+        case AST_COMPOUND_REFERENCE:
+            resolve_compound_reference(tab, (ast_compound_reference_t*)node->nterm);
+            break;
+        case AST_FORMATTED_STRING:
+            resolve_dss_initializer(tab, ((ast_formatted_string_t*)node->nterm)->dss_initializer);
+            break;
+        case AST_EXPRESSION:
+            resolve_expression(tab, (ast_expression_t*)node->nterm);
+            break;
+        case AST_TYPE_NAME:
+            // a cast
+            resolve_type_name(tab, (ast_type_name_t*)node->nterm);
+            break;
+        default:
+            break;
+    }
+
+    RETURN();
+}
+
+static void resolve_expression(symtab_t* tab, ast_expression_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    int mark = 0;
+    ast_primary_expression_t* item;
+    while(iterate_expr_item_list(node->list, &mark, &item))
+        resolve_primary_expression(tab, item);
+
+    RETURN();
+}
+
+static void resolve_initializer(symtab_t* tab, ast_initializer_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    switch(node->nterm->type) {
+        case AST_EXPRESSION:
+            resolve_expression(tab, (ast_expression_t*)node->nterm);
+            break;
+        case AST_LIST_INIT:
+            resolve_expression_list(tab, ((ast_list_init_t*)node->nterm)->expression_list);
+            break;
+        case AST_DICT_INIT:
+            resolve_dss_initializer(tab, ((ast_dict_init_t*)node->nterm)->dss_initializer);
+            break;
+        case AST_STRUCT_INIT:
+            resolve_dss_initializer(tab, ((ast_struct_init_t*)node->nterm)->dss_initializer);
+            break;
+        default:
+            FATAL("internal AST error: Unknown initializer type: %d", node->nterm->type);
+    }
+
+    RETURN();
+}
+
+/*
+ * The initializer is resolved before the name is declared, so that
+ * "int x = x" refers to an x in an enclosing scope.
+ */
+static void resolve_local_data(symtab_t* tab, ast_data_definition_t* node) {
+
+    ENTER;
+    resolve_initializer(tab, node->initializer);
+    declare_data(tab, SYM_LOCAL, node->data_declaration, node->is_const);
+
+    RETURN();
+}
+
+static void resolve_assignment(symtab_t* tab, ast_assignment_t* node) {
+
+    ENTER;
+    resolve_expression(tab, node->expression);
+
+    token_t* tok = index_token_list(node->compound_name->list, 0);
+    symbol_t* sym = lookup_symbol(tab, tok_name(tok));
+
+    node->compound_name->sym = NULL;
+    if(sym == NULL)
+        TOKEN_ERROR(tok, "undefined name: \"%s\"", raw_string(tok->str));
+    else if(sym->kind != SYM_GLOBAL && sym->kind != SYM_LOCAL && sym->kind != SYM_PARAM)
+        TOKEN_ERROR(tok, "cannot assign to %s \"%s\"", sym_kind_to_str(sym->kind), raw_string(tok->str));
+    else if(sym->is_const && len_token_list(node->compound_name->list) == 1)
+        TOKEN_ERROR(tok, "cannot assign to const \"%s\"", raw_string(tok->str));
+    else
+        node->compound_name->sym = sym;
+
+    RETURN();
+}
+
+static void resolve_function_body_element(symtab_t* tab, ast_function_body_element_t* node) {
+
+    ENTER;
+    if(node == NULL || node->INLINE != NULL)
+        RETURN();
+
+    switch(node->nterm->type) {
+        case AST_ASSIGNMENT:
+            resolve_assignment(tab, (ast_assignment_t*)node->nterm);
+            break;
+        case AST_COMPOUND_REFERENCE:
+            resolve_compound_reference(tab, (ast_compound_reference_t*)node->nterm);
+            break;
+        case AST_DATA_DEFINITION:
+            resolve_local_data(tab, (ast_data_definition_t*)node->nterm);
+            break;
+        case AST_STRUCT_DEFINITION:
+            resolve_struct_definition(tab, (ast_struct_definition_t*)node->nterm, false);
+            break;
+        case AST_IF_CLAUSE: {
+            ast_if_clause_t* n = (ast_if_clause_t*)node->nterm;
+            resolve_expression(tab, n->expression);
+            resolve_function_body(tab, n->function_body, true);
+            if(n->else_clause != NULL) {
+                resolve_expression(tab, n->else_clause->expression);
+                resolve_function_body(tab, n->else_clause->function_body, true);
+            }
+            if(n->final_else_clause != NULL)
+                resolve_function_body(tab, n->final_else_clause->function_body, true);
+        } break;
+        case AST_WHILE_CLAUSE: {
+            ast_while_clause_t* n = (ast_while_clause_t*)node->nterm;
+            resolve_expression(tab, n->expression);
+            resolve_loop_body(tab, n->loop_body);
+        } break;
+        case AST_DO_CLAUSE: {
+            ast_do_clause_t* n = (ast_do_clause_t*)node->nterm;
+            resolve_loop_body(tab, n->loop_body);
+            resolve_expression(tab, n->expression);
+        } break;
+        case AST_FOR_CLAUSE: {
+            ast_for_clause_t* n = (ast_for_clause_t*)node->nterm;
+            resolve_expression(tab, n->expression);
+            enter_scope(tab);
+            if(n->IDENTIFIER != NULL) {
+                n->sym = declare_symbol(tab, SYM_LOCAL, raw_string(n->IDENTIFIER->str), (ast_node_t*)n);
+                ASSERT(n->sym != NULL, "loop variable declared in a fresh scope");
+            }
+            resolve_loop_body(tab, n->loop_body);
+            leave_scope(tab);
+        } break;
+        case AST_RETURN_STATEMENT:
+            resolve_expression(tab, ((ast_return_statement_t*)node->nterm)->expression);
+            break;
+        case AST_EXIT_STATEMENT:
+            resolve_expression(tab, ((ast_exit_statement_t*)node->nterm)->expression);
+            break;
+        default:
+            FATAL("internal AST error: Unknown body element type: %d", node->nterm->type);
+    }
+
+    RETURN();
+}
+
+static void resolve_function_body(symtab_t* tab, ast_function_body_t* node, bool new_scope) {
+
+    ENTER;
+    if(node == NULL || node->function_body_list == NULL)
+        RETURN();
+
+    if(new_scope)
+        enter_scope(tab);
+
+    int mark = 0;
+    ast_function_body_prelist_t* item;
+    while(iterate_body_item_list(node->function_body_list->list, &mark, &item)) {
+        if(item->nterm->type == AST_FUNCTION_BODY)
+            resolve_function_body(tab, (ast_function_body_t*)item->nterm, true);
+        else
+            resolve_function_body_element(tab, (ast_function_body_element_t*)item->nterm);
+    }
+
+    if(new_scope)
+        leave_scope(tab);
+
+    RETURN();
+}
+
+static void resolve_loop_body(symtab_t* tab, ast_loop_body_t* node) {
+
+    ENTER;
+    if(node == NULL || node->loop_body_list == NULL)
+        RETURN();
+
+    enter_scope(tab);
+
+    int mark = 0;
+    ast_loop_body_prelist_t* item;
+    while(iterate_loop_item_list(node->loop_body_list->list, &mark, &item)) {
+        if(item->nterm->type == AST_LOOP_BODY)
+            resolve_loop_body(tab, (ast_loop_body_t*)item->nterm);
+        else {
+            ast_loop_body_element_t* elem = (ast_loop_body_element_t*)item->nterm;
+            if(elem->tok == NULL)
+                resolve_function_body_element(tab, elem->function_body_element);
+        }
+    }
+
+    leave_scope(tab);
+
+    RETURN();
+}
+
+/*
+ * Structs may be defined at the top level or inside of a function. Fields
+ * are not visible as names. They are reached through the struct. A struct
+ * at the top level was declared by the first pass. A struct in a function
+ * is declared here, even when the node has a symbol, since the watch
+ * resolves the same AST again with a new symbol table.
+ */
+static void resolve_struct_definition(symtab_t* tab, ast_struct_definition_t* node, bool is_global) {
+
+    ENTER;
+    if(!is_global) {
+        node->sym = declare_symbol(tab, SYM_STRUCT, raw_string(node->IDENTIFIER->str), (ast_node_t*)node);
+        if(node->sym == NULL) {
+            TOKEN_ERROR(node->IDENTIFIER, "redefinition of \"%s\"", raw_string(node->IDENTIFIER->str));
+            RETURN();
+        }
+    }
+    symbol_t* sym = node->sym;
+
+    int mark = 0;
+    ast_data_declaration_t* item;
+    while(iterate_decl_list(node->list, &mark, &item)) {
+        resolve_type_name(tab, item->type_name);
+        item->sym = add_member(tab, sym, raw_string(item->IDENTIFIER->str), (ast_node_t*)item);
+        if(item->sym == NULL)
+            TOKEN_ERROR(item->IDENTIFIER, "duplicate field \"%s\" in struct \"%s\"",
+                        raw_string(item->IDENTIFIER->str), sym->name);
+    }
+
+    RETURN();
+}
+
+static void resolve_function_definition(symtab_t* tab, ast_function_definition_t* node) {
+
+    ENTER;
+    symbol_t* func = node->function_name->sym;
+    if(func == NULL)
+        RETURN();
+
+    resolve_type_name(tab, node->function_name->type_name);
+    begin_function(tab, func);
+
+    if(node->function_parameters != NULL) {
+        int mark = 0;
+        ast_data_declaration_t* item;
+        while(iterate_decl_list(node->function_parameters->list, &mark, &item)) {
+            symbol_t* sym = declare_data(tab, SYM_PARAM, item, false);
+            if(sym != NULL)
+                append_ptr_list(func->members, sym);
+        }
+    }
+
+    // parameters and the outer block of the body share a scope
+    resolve_function_body(tab, node->function_body, false);
+    end_function(tab);
+
+    RETURN();
+}
+
+static void resolve_start_block(symtab_t* tab, ast_start_block_t* node) {
+
+    ENTER;
+    symbol_t* func = node->sym;
+    if(func == NULL)
+        RETURN();
+
+    begin_function(tab, func);
+    resolve_function_body(tab, node->function_body, false);
+    end_function(tab);
+
+    RETURN();
+}
+
+/*
+ * A function whose body is nothing but an inline block that holds a C
+ * identifier is implemented by the C function of that name. Return the
+ * interned name, or NULL if the function is implemented in Toy.
+ */
+static const char* foreign_symbol(ast_function_body_t* node) {
+
+    if(node == NULL || node->function_body_list == NULL || len_body_item_list(node->function_body_list->list) != 1)
+        return NULL;
+
+    ast_function_body_prelist_t* pre = index_body_item_list(node->function_body_list->list, 0);
+    if(pre->nterm->type != AST_FUNCTION_BODY_ELEMENT || ((ast_function_body_element_t*)pre->nterm)->INLINE == NULL)
+        return NULL;
+
+    const char* str = raw_string(((ast_function_body_element_t*)pre->nterm)->INLINE->str);
+    while(isspace((unsigned char)*str))
+        str++;
+
+    int len = 0;
+    char name[128];
+    while(isalnum((unsigned char)str[len]) || str[len] == '_') {
+        if(len + 1 >= (int)sizeof(name))
+            return NULL;
+        name[len] = str[len];
+        len++;
+    }
+    name[len] = '\0';
+
+    for(const char* ptr = &str[len]; *ptr != '\0'; ptr++)
+        if(!isspace((unsigned char)*ptr))
+            return NULL;
+
+    if(len == 0 || isdigit((unsigned char)name[0]))
+        return NULL;
+
+    return intern_string(name);
+}
+
+/*
+ * First pass over the module. Declare the top level names.
+ */
+static void declare_globals(symtab_t* tab, ast_translation_unit_t* node) {
+
+    ENTER;
+    int mark = 0;
+    ast_translation_unit_element_t* item;
+
+    while(iterate_unit_item_list(node->list, &mark, &item)) {
+        switch(item->nterm->type) {
+            case AST_DATA_DEFINITION: {
+                ast_data_definition_t* n = (ast_data_definition_t*)item->nterm;
+                ast_data_declaration_t* decl = n->data_declaration;
+                decl->sym = declare_symbol(tab, SYM_GLOBAL, raw_string(decl->IDENTIFIER->str), (ast_node_t*)decl);
+                if(decl->sym == NULL)
+                    TOKEN_ERROR(decl->IDENTIFIER, "redefinition of \"%s\"", raw_string(decl->IDENTIFIER->str));
+                else
+                    decl->sym->is_const = n->is_const;
+            } break;
+            case AST_FUNCTION_DEFINITION: {
+                ast_function_definition_t* def = (ast_function_definition_t*)item->nterm;
+                ast_function_name_t* n = def->function_name;
+                n->sym = declare_symbol(tab, SYM_FUNCTION, raw_string(n->IDENTIFIER->str), (ast_node_t*)n);
+                if(n->sym == NULL)
+                    TOKEN_ERROR(n->IDENTIFIER, "redefinition of \"%s\"", raw_string(n->IDENTIFIER->str));
+                else
+                    n->sym->foreign = foreign_symbol(def->function_body);
+            } break;
+            case AST_STRUCT_DEFINITION: {
+                ast_struct_definition_t* n = (ast_struct_definition_t*)item->nterm;
+                n->sym = declare_symbol(tab, SYM_STRUCT, raw_string(n->IDENTIFIER->str), (ast_node_t*)n);
+                if(n->sym == NULL)
+                    TOKEN_ERROR(n->IDENTIFIER, "redefinition of \"%s\"", raw_string(n->IDENTIFIER->str));
+            } break;
+            case AST_START_BLOCK: {
+                ast_start_block_t* n = (ast_start_block_t*)item->nterm;
+                n->sym = declare_symbol(tab, SYM_FUNCTION, "start", (ast_node_t*)n);
+                if(n->sym == NULL)
+                    NODE_ERROR(n, "redefinition of the start block");
+            } break;
+            default:
+                break;
+        }
+    }
+
+    RETURN();
+}
+
+/*
+ * Second pass over the module. Resolve everything else.
+ */
+static void resolve_globals(symtab_t* tab, ast_translation_unit_t* node) {
+
+    ENTER;
+    int mark = 0;
+    ast_translation_unit_element_t* item;
+
+    while(iterate_unit_item_list(node->list, &mark, &item)) {
+        switch(item->nterm->type) {
+            case AST_DATA_DEFINITION: {
+                ast_data_definition_t* n = (ast_data_definition_t*)item->nterm;
+                resolve_type_name(tab, n->data_declaration->type_name);
+                resolve_initializer(tab, n->initializer);
+            } break;
+            case AST_FUNCTION_DEFINITION:
+                resolve_function_definition(tab, (ast_function_definition_t*)item->nterm);
+                break;
+            case AST_STRUCT_DEFINITION: {
+                ast_struct_definition_t* n = (ast_struct_definition_t*)item->nterm;
+                if(n->sym != NULL)
+                    resolve_struct_definition(tab, n, true);
+            } break;
+            case AST_START_BLOCK:
+                resolve_start_block(tab, (ast_start_block_t*)item->nterm);
+                break;
+            default:
+                break;
+        }
+    }
+
+    RETURN();
+}
+
+/*
+ * public interface
+ */
+symtab_t* resolve_names(ast_node_t* node) {
+
+    if(in_cmd_list("trace", "resolve"))
+        push_trace_state(1);
+    else
+        push_trace_state(0);
+
+    symtab_t* tab = create_symtab();
+
+    if(node != NULL) {
+        declare_globals(tab, (ast_translation_unit_t*)node);
+        resolve_globals(tab, (ast_translation_unit_t*)node);
+    }
+
+    MSG(5, "names: %d globals, %d functions, %d structs, %d interned strings\n",
+        tab->global_count, tab->function_count, tab->struct_count, len_intern_table());
+
+    pop_trace_state();
+
+    return tab;
+}
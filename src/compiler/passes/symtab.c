@@ -0,0 +1,310 @@
+/**
+ * @file symtab.c
+ *
+ * @brief Scoped symbol table with an undo log.
+ *
+ * The table maps an interned name to the symbol that is currently visible
+ * under that name. A key is never removed once it has been added. When the
+ * last binding for a name goes out of scope the key stays and the binding
+ * becomes NULL, so there are no tombstones. The number of keys is bounded
+ * by the number of distinct names in the program.
+ *
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "intern.h"
+#include "symtab.h"
+
+static inline uint32_t hash_ptr(const char* key) {
+
+    uint64_t val = (uint64_t)(uintptr_t)key;
+
+    val ^= val >> 33;
+    val *= 0xff51afd7ed558ccdULL;
+    val ^= val >> 33;
+
+    return (uint32_t)val;
+}
+
+// requires an interned key
+static inline int find_slot(symtab_t* tab, const char* key) {
+
+    int slot = hash_ptr(key) & (tab->cap - 1);
+
+    while(tab->keys[slot] != NULL && tab->keys[slot] != key)
+        slot = (slot + 1) & (tab->cap - 1);
+
+    return slot;
+}
+
+static void grow_table(symtab_t* tab) {
+
+    if((tab->count + 1) * 4 >= tab->cap * 3) {
+        int oldcap = tab->cap;
+        const char** oldkeys = tab->keys;
+        symbol_t** oldbind = tab->bindings;
+
+        tab->cap <<= 1;
+        tab->keys = _ALLOC_ARRAY(const char*, tab->cap);
+        tab->bindings = _ALLOC_ARRAY(symbol_t*, tab->cap);
+
+        for(int i = 0; i < oldcap; i++) {
+            if(oldkeys[i] != NULL) {
+                int slot = find_slot(tab, oldkeys[i]);
+                tab->keys[slot] = oldkeys[i];
+                tab->bindings[slot] = oldbind[i];
+            }
+        }
+
+        _FREE(oldkeys);
+        _FREE(oldbind);
+    }
+}
+
+static void push_log(symtab_t* tab, symbol_t* sym) {
+
+    if(tab->log_len + 1 > tab->log_cap) {
+        tab->log_cap <<= 1;
+        tab->log = _REALLOC_ARRAY(tab->log, symbol_t*, tab->log_cap);
+    }
+
+    tab->log[tab->log_len] = sym;
+    tab->log_len++;
+}
+
+static symbol_t* create_symbol(symtab_t* tab, symbol_kind_t kind, const char* name, ast_node_t* decl) {
+
+    symbol_t* sym = _ALLOC_TYPE(symbol_t);
+    sym->kind = kind;
+    sym->name = name;
+    sym->decl = decl;
+    sym->depth = tab->depth;
+    sym->owner = tab->function;
+
+    append_ptr_list(tab->symbols, sym);
+
+    return sym;
+}
+
+static void assign_slot(symtab_t* tab, symbol_t* sym) {
+
+    switch(sym->kind) {
+        case SYM_GLOBAL:
+            sym->slot = tab->global_count++;
+            break;
+        case SYM_LOCAL:
+        case SYM_PARAM:
+            ASSERT(tab->function != NULL, "local symbol outside of a function");
+            sym->slot = tab->local_count++;
+            if(tab->local_count > tab->function->frame_size)
+                tab->function->frame_size = tab->local_count;
+            break;
+        case SYM_FUNCTION:
+            sym->slot = tab->function_count++;
+            sym->members = create_ptr_list();
+            break;
+        case SYM_STRUCT:
+            sym->slot = tab->struct_count++;
+            sym->members = create_ptr_list();
+            break;
+        default:
+            FATAL("internal error: cannot assign a slot to a %s", sym_kind_to_str(sym->kind));
+    }
+}
+
+/*
+ * public interface
+ */
+symtab_t* create_symtab(void) {
+
+    symtab_t* tab = _ALLOC_TYPE(symtab_t);
+
+    tab->cap = 1 << 6;
+    tab->keys = _ALLOC_ARRAY(const char*, tab->cap);
+    tab->bindings = _ALLOC_ARRAY(symbol_t*, tab->cap);
+
+    tab->log_cap = 1 << 6;
+    tab->log = _ALLOC_ARRAY(symbol_t*, tab->log_cap);
+
+    tab->mark_cap = 1 << 4;
+    tab->marks = _ALLOC_ARRAY(scope_mark_t, tab->mark_cap);
+
+    tab->symbols = create_ptr_list();
+
+    return tab;
+}
+
+void destroy_symtab(symtab_t* tab) {
+
+    if(tab != NULL) {
+        int mark = 0;
+        symbol_t* sym;
+
+        while(NULL != (sym = iterate_ptr_list(tab->symbols, &mark))) {
+            if(sym->members != NULL)
+                destroy_ptr_list(sym->members);
+            _FREE(sym);
+        }
+
+        destroy_ptr_list(tab->symbols);
+        _FREE(tab->keys);
+        _FREE(tab->bindings);
+        _FREE(tab->log);
+        _FREE(tab->marks);
+        _FREE(tab);
+    }
+}
+
+/*
+ * Push a scope marker. Nothing else is touched.
+ */
+void enter_scope(symtab_t* tab) {
+
+    if(tab->depth + 1 > tab->mark_cap) {
+        tab->mark_cap <<= 1;
+        tab->marks = _REALLOC_ARRAY(tab->marks, scope_mark_t, tab->mark_cap);
+    }
+
+    tab->marks[tab->depth].log_len = tab->log_len;
+    tab->marks[tab->depth].local_count = tab->local_count;
+    tab->depth++;
+}
+
+/*
+ * Undo every declaration made since the matching enter_scope(). Frame slots
+ * used by the scope are released so that sibling blocks can reuse them.
+ */
+void leave_scope(symtab_t* tab) {
+
+    ASSERT(tab->depth > 0, "scope stack underflow");
+
+    tab->depth--;
+    scope_mark_t* mark = &tab->marks[tab->depth];
+
+    while(tab->log_len > mark->log_len) {
+        tab->log_len--;
+        symbol_t* sym = tab->log[tab->log_len];
+        tab->bindings[find_slot(tab, sym->name)] = sym->shadow;
+    }
+
+    tab->local_count = mark->local_count;
+}
+
+/*
+ * Start allocating frame slots for the given function.
+ */
+void begin_function(symtab_t* tab, symbol_t* func) {
+
+    ASSERT(func->kind == SYM_FUNCTION, "expected a function symbol");
+
+    tab->function = func;
+    tab->local_count = 0;
+    func->frame_size = 0;
+    enter_scope(tab);
+}
+
+void end_function(symtab_t* tab) {
+
+    leave_scope(tab);
+    tab->function = NULL;
+    tab->local_count = 0;
+}
+
+/*
+ * Declare a name in the current scope. The name does not have to be
+ * interned by the caller. Returns NULL if the name is already declared in
+ * this scope.
+ */
+symbol_t* declare_symbol(symtab_t* tab, symbol_kind_t kind, const char* name, ast_node_t* decl) {
+
+    const char* key = intern_string(name);
+
+    grow_table(tab);
+    int slot = find_slot(tab, key);
+
+    if(tab->keys[slot] == NULL) {
+        tab->keys[slot] = key;
+        tab->count++;
+    }
+
+    symbol_t* prev = tab->bindings[slot];
+    if(prev != NULL && prev->depth == tab->depth)
+        return NULL;
+
+    symbol_t* sym = create_symbol(tab, kind, key, decl);
+    assign_slot(tab, sym);
+    sym->shadow = prev;
+
+    tab->bindings[slot] = sym;
+    push_log(tab, sym);
+
+    return sym;
+}
+
+/*
+ * Find the visible binding for an interned name, or NULL.
+ */
+symbol_t* lookup_symbol(symtab_t* tab, const char* name) {
+
+    return tab->bindings[find_slot(tab, name)];
+}
+
+/*
+ * Same as lookup_symbol() for a name that has not been interned.
+ */
+symbol_t* lookup_symbol_str(symtab_t* tab, const char* str) {
+
+    return lookup_symbol(tab, intern_string(str));
+}
+
+/*
+ * Add a parameter to a function or a field to a struct. Fields are not
+ * visible in any scope. They are found through the struct that owns them.
+ * Returns NULL if the owner already has a member by that name.
+ */
+symbol_t* add_member(symtab_t* tab, symbol_t* owner, const char* name, ast_node_t* decl) {
+
+    const char* key = intern_string(name);
+
+    if(find_member(owner, key) != NULL)
+        return NULL;
+
+    symbol_t* sym = create_symbol(tab, SYM_FIELD, key, decl);
+    sym->owner = owner;
+    sym->slot = len_ptr_list(owner->members);
+    append_ptr_list(owner->members, sym);
+
+    return sym;
+}
+
+/*
+ * Find a member by interned name.
+ */
+symbol_t* find_member(symbol_t* owner, const char* name) {
+
+    if(owner == NULL || owner->members == NULL)
+        return NULL;
+
+    for(int i = 0; i < owner->members->len; i++) {
+        symbol_t* sym = owner->members->buffer[i];
+        if(sym->name == name)
+            return sym;
+    }
+
+    return NULL;
+}
+
+const char* sym_kind_to_str(symbol_kind_t kind) {
+
+    return (kind == SYM_GLOBAL)    ? "global" :
+            (kind == SYM_LOCAL)    ? "local" :
+            (kind == SYM_PARAM)    ? "parameter" :
+            (kind == SYM_FUNCTION) ? "function" :
+            (kind == SYM_STRUCT)   ? "struct" :
+            (kind == SYM_FIELD)    ? "field" :
+                                     "UNKNOWN";
+}
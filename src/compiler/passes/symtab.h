@@ -0,0 +1,99 @@
+/**
+ * @file symtab.h
+ *
+ * @brief Scoped symbol table. Names are interned, so a lookup is a hash of
+ * the name pointer followed by a pointer compare. Every binding that hides
+ * an outer binding keeps a pointer to it, and every declaration is recorded
+ * in an undo log. Entering a scope pushes a marker. Leaving a scope unwinds
+ * the log back to the marker and restores the hidden bindings, so the cost
+ * of a scope change does not depend on the size of the table.
+ *
+ */
+#ifndef _SYMTAB_H_
+#define _SYMTAB_H_
+
+#include <stdbool.h>
+
+#include "ast.h"
+#include "pointer_list.h"
+
+typedef enum {
+    SYM_GLOBAL,
+    SYM_LOCAL,
+    SYM_PARAM,
+    SYM_FUNCTION,
+    SYM_STRUCT,
+    SYM_FIELD,
+} symbol_kind_t;
+
+/*
+ * The slot depends on the kind of the symbol. Globals are numbered in the
+ * global data area, locals and parameters are numbered in the frame of the
+ * function that owns them, functions and structs are numbered in their own
+ * tables and fields are numbered in the order they appear in the struct.
+ */
+typedef struct _symbol_t_ {
+    symbol_kind_t kind;
+    const char* name;
+    int slot;
+    int depth;
+    bool is_const;
+    ast_node_t* decl;
+    struct _symbol_t_* owner;
+    pointer_list_t* members;
+    int frame_size;
+    struct _type_t_* type;
+    // the literal value of a const, when it is known at compile time
+    struct _ast_primary_expression_t_* value;
+    // the name of the C function that implements a function, or NULL
+    const char* foreign;
+    struct _symbol_t_* shadow;
+} symbol_t;
+
+typedef struct {
+    int log_len;
+    int local_count;
+} scope_mark_t;
+
+typedef struct {
+    // open addressed, keyed on the interned name pointer
+    const char** keys;
+    symbol_t** bindings;
+    int cap;
+    int count;
+
+    // undo log of declarations and the scope markers into it
+    symbol_t** log;
+    int log_len;
+    int log_cap;
+    scope_mark_t* marks;
+    int depth;
+    int mark_cap;
+
+    symbol_t* function;
+    int local_count;
+    int global_count;
+    int function_count;
+    int struct_count;
+
+    pointer_list_t* symbols;
+} symtab_t;
+
+symtab_t* create_symtab(void);
+void destroy_symtab(symtab_t* tab);
+
+void enter_scope(symtab_t* tab);
+void leave_scope(symtab_t* tab);
+void begin_function(symtab_t* tab, symbol_t* func);
+void end_function(symtab_t* tab);
+
+symbol_t* declare_symbol(symtab_t* tab, symbol_kind_t kind, const char* name, ast_node_t* decl);
+symbol_t* lookup_symbol(symtab_t* tab, const char* name);
+symbol_t* lookup_symbol_str(symtab_t* tab, const char* str);
+
+symbol_t* add_member(symtab_t* tab, symbol_t* owner, const char* name, ast_node_t* decl);
+symbol_t* find_member(symbol_t* owner, const char* name);
+
+const char* sym_kind_to_str(symbol_kind_t kind);
+
+#endif /* _SYMTAB_H_ */
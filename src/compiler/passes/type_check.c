@@ -0,0 +1,770 @@
+/**
+ * @file type_check.c
+ *
+ * @brief Static type checking. This runs after name resolution. Every
+ * symbol is given its declared type, then every expression is given a type
+ * by walking its postfix list with a stack of types. The types are left in
+ * the AST so that the code generator can pick typed instructions.
+ *
+ * Fields after the first element of a compound reference are resolved here,
+ * because a field can only be found once the type to the left of it is
+ * known. A field of a dict, or of a value that came out of a list or a dict,
+ * is looked up by name when the program runs.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace.h"
+#include "cmdline.h"
+#include "alloc.h"
+#include "intern.h"
+#include "passes.h"
+#include "types.h"
+#include "format.h"
+#include "ffi.h"
+
+static type_t* check_expression(ast_expression_t* node);
+static void check_function_body(ast_function_body_t* node);
+static void check_loop_body(ast_loop_body_t* node);
+
+// the function whose body is being checked, for return statements
+static symbol_t* crnt_func = NULL;
+
+#define TYPE(k) get_basic_type(TYPE_##k)
+
+static const char* tok_name(token_t* tok) {
+
+    return intern_string(raw_string(tok->str));
+}
+
+/*
+ * Every symbol gets its type before any expression is looked at, so that a
+ * reference to something that is defined further down in the file works.
+ * Struct types come first because the other declarations refer to them.
+ */
+static void assign_symbol_types(symtab_t* tab) {
+
+    ENTER;
+    int mark = 0;
+    symbol_t* sym;
+
+    while(NULL != (sym = iterate_ptr_list(tab->symbols, &mark)))
+        if(sym->kind == SYM_STRUCT)
+            get_struct_type(sym);
+
+    mark = 0;
+    while(NULL != (sym = iterate_ptr_list(tab->symbols, &mark))) {
+        switch(sym->kind) {
+            case SYM_GLOBAL:
+            case SYM_LOCAL:
+            case SYM_PARAM:
+            case SYM_FIELD:
+                // loop variables are typed when the loop is checked
+                if(sym->decl->type == AST_DATA_DECLARATION)
+                    sym->type = type_from_type_name(((ast_data_declaration_t*)sym->decl)->type_name);
+                break;
+            case SYM_FUNCTION:
+                if(sym->decl->type == AST_FUNCTION_NAME)
+                    sym->type = type_from_type_name(((ast_function_name_t*)sym->decl)->type_name);
+                else
+                    sym->type = TYPE(NOTHING);
+                break;
+            default:
+                break;
+        }
+    }
+
+    RETURN();
+}
+
+/*
+ * A function that is implemented in C can only take and return values
+ * that the FFI knows how to pass.
+ */
+static void check_foreign(ast_function_definition_t* node) {
+
+    ENTER;
+    symbol_t* func = node->function_name->sym;
+
+    if(len_ptr_list(func->members) > FFI_MAX_PARAMS)
+        TOKEN_ERROR(node->function_name->IDENTIFIER, "C function \"%s\" has more than %d parameters", func->name,
+                    FFI_MAX_PARAMS);
+
+    if(!ffi_type_ok(type_to_val_type(func->type), true))
+        TOKEN_ERROR(node->function_name->IDENTIFIER, "C function \"%s\" cannot return %s", func->name,
+                    type_to_str(func->type));
+
+    int mark = 0;
+    symbol_t* param;
+    while(NULL != (param = iterate_ptr_list(func->members, &mark)))
+        if(!ffi_type_ok(type_to_val_type(param->type), false))
+            NODE_ERROR(param->decl, "cannot pass %s to C function \"%s\"", type_to_str(param->type), func->name);
+
+    RETURN();
+}
+
+static bool is_number(type_t* type) {
+
+    return IS_TYPE(type, TYPE_INT) || IS_TYPE(type, TYPE_FLOAT);
+}
+
+static bool is_ordered(type_t* type) {
+
+    return is_number(type) || IS_TYPE(type, TYPE_STRING);
+}
+
+/*
+ * The operands of a binary operator must have the same type. There are no
+ * implicit conversions. When one side is only known at run time the result
+ * is too, except for the comparisons, which are always bool.
+ */
+static type_t* check_operator(ast_primary_expression_t* item, operator_t op, type_t* left, type_t* right) {
+
+    ENTER;
+    if(IS_TYPE(left, TYPE_ERROR) || IS_TYPE(right, TYPE_ERROR))
+        RETURN(TYPE(ERROR));
+
+    bool unchecked = IS_TYPE(left, TYPE_ANY) || IS_TYPE(right, TYPE_ANY);
+    type_t* known = IS_TYPE(left, TYPE_ANY) ? right : left;
+    type_t* result = NULL;
+
+    switch(op) {
+        case OPER_ADD:
+            if(unchecked && (is_ordered(known) || IS_TYPE(known, TYPE_ANY)))
+                result = TYPE(ANY);
+            else if(left == right && is_ordered(left))
+                result = left;
+            break;
+        case OPER_SUB:
+        case OPER_MUL:
+        case OPER_DIV:
+        case OPER_POW:
+            if(unchecked && (is_number(known) || IS_TYPE(known, TYPE_ANY)))
+                result = TYPE(ANY);
+            else if(left == right && is_number(left))
+                result = left;
+            break;
+        case OPER_MOD:
+            if(unchecked && (IS_TYPE(known, TYPE_INT) || IS_TYPE(known, TYPE_ANY)))
+                result = TYPE(ANY);
+            else if(IS_TYPE(left, TYPE_INT) && IS_TYPE(right, TYPE_INT))
+                result = left;
+            break;
+        case OPER_NEG:
+            if(unchecked || is_number(left))
+                result = left;
+            break;
+        case OPER_LT:
+        case OPER_LE:
+        case OPER_GT:
+        case OPER_GE:
+            if((unchecked && (is_ordered(known) || IS_TYPE(known, TYPE_ANY))) || (left == right && is_ordered(left)))
+                result = TYPE(BOOL);
+            break;
+        case OPER_EQ:
+        case OPER_NE:
+            if(is_assignable(left, right))
+                result = TYPE(BOOL);
+            break;
+        case OPER_AND:
+        case OPER_OR:
+            if((IS_TYPE(left, TYPE_BOOL) || IS_TYPE(left, TYPE_ANY)) && (IS_TYPE(right, TYPE_BOOL) || IS_TYPE(right, TYPE_ANY)))
+                result = TYPE(BOOL);
+            break;
+        case OPER_NOT:
+            if(IS_TYPE(left, TYPE_BOOL) || IS_TYPE(left, TYPE_ANY))
+                result = TYPE(BOOL);
+            break;
+        default:
+            FATAL("internal error: unknown operator: %d", op);
+    }
+
+    if(result == NULL) {
+        if(is_unary_operator(op))
+            TOKEN_ERROR(item->token, "invalid operand type for \"%s\": %s", raw_string(item->token->str),
+                        type_to_str(left));
+        else
+            TOKEN_ERROR(item->token, "invalid operand types for \"%s\": %s and %s", raw_string(item->token->str),
+                        type_to_str(left), type_to_str(right));
+        result = TYPE(ERROR);
+    }
+
+    RETURN(result);
+}
+
+/*
+ * The parameters are typed, so the arguments are checked against them.
+ */
+static type_t* check_call(symbol_t* func, ast_function_reference_t* node) {
+
+    ENTER;
+    expr_list_t* args = (node->expression_list != NULL) ? node->expression_list->list : NULL;
+    int nargs = len_expr_list(args);
+    int nparams = len_ptr_list(func->members);
+
+    if(nargs != nparams)
+        TOKEN_ERROR(node->IDENTIFIER, "function \"%s\" takes %d arguments, but %d were given", func->name,
+                    nparams, nargs);
+
+    for(int i = 0; i < nargs; i++) {
+        ast_expression_t* arg = index_expr_list(args, i);
+        type_t* type = check_expression(arg);
+
+        if(i < nparams) {
+            symbol_t* param = index_ptr_list(func->members, i);
+            if(!is_assignable(param->type, type))
+                NODE_ERROR(arg, "argument %d of \"%s\" is a %s, but \"%s\" is a %s", i + 1, func->name,
+                           type_to_str(type), param->name, type_to_str(param->type));
+        }
+    }
+
+    RETURN(func->type);
+}
+
+static type_t* check_index(type_t* type, ast_expression_t* index) {
+
+    ENTER;
+    type_t* key = check_expression(index);
+
+    if(IS_UNCHECKED(type))
+        RETURN(type);
+
+    type_t* result = NULL;
+    switch(type->kind) {
+        case TYPE_LIST:
+            if(IS_TYPE(key, TYPE_INT) || IS_UNCHECKED(key))
+                result = TYPE(ANY);
+            break;
+        case TYPE_DICT:
+            if(IS_TYPE(key, TYPE_STRING) || IS_UNCHECKED(key))
+                result = TYPE(ANY);
+            break;
+        case TYPE_STRING:
+            if(IS_TYPE(key, TYPE_INT) || IS_UNCHECKED(key))
+                result = TYPE(STRING);
+            break;
+        default:
+            NODE_ERROR(index, "a %s cannot be indexed", type_to_str(type));
+            RETURN(TYPE(ERROR));
+    }
+
+    if(result == NULL) {
+        NODE_ERROR(index, "a %s cannot be indexed by a %s", type_to_str(type), type_to_str(key));
+        result = TYPE(ERROR);
+    }
+
+    RETURN(result);
+}
+
+/*
+ * Find a field of a struct. A field of a dict or of an unchecked value is
+ * found at run time, so there is nothing to resolve and the type is ANY.
+ */
+static type_t* check_field(type_t* type, token_t* tok, symbol_t** field) {
+
+    ENTER;
+    *field = NULL;
+
+    if(IS_UNCHECKED(type) || IS_TYPE(type, TYPE_DICT))
+        RETURN(IS_TYPE(type, TYPE_ERROR) ? type : TYPE(ANY));
+
+    if(!IS_TYPE(type, TYPE_STRUCT)) {
+        TOKEN_ERROR(tok, "a %s has no field \"%s\"", type_to_str(type), raw_string(tok->str));
+        RETURN(TYPE(ERROR));
+    }
+
+    *field = find_member(type->sym, tok_name(tok));
+    if(*field == NULL) {
+        TOKEN_ERROR(tok, "struct \"%s\" has no field \"%s\"", type->sym->name, raw_string(tok->str));
+        RETURN(TYPE(ERROR));
+    }
+
+    RETURN((*field)->type);
+}
+
+static type_t* check_compound_reference(ast_compound_reference_t* node) {
+
+    ENTER;
+    type_t* type = TYPE(ERROR);
+
+    int mark = 0;
+    ast_compound_reference_element_t* item;
+    while(iterate_ref_element_list(node->list, &mark, &item)) {
+        if(item->function_reference != NULL) {
+            if(mark == 1 && item->sym != NULL)
+                type = check_call(item->sym, item->function_reference);
+            else {
+                if(mark != 1)
+                    TOKEN_ERROR(item->function_reference->IDENTIFIER, "\"%s\" is not a function",
+                                raw_string(item->function_reference->IDENTIFIER->str));
+                // still look at the arguments for errors
+                if(item->function_reference->expression_list != NULL) {
+                    int m = 0;
+                    ast_expression_t* arg;
+                    while(iterate_expr_list(item->function_reference->expression_list->list, &m, &arg))
+                        check_expression(arg);
+                }
+                type = TYPE(ERROR);
+            }
+            continue;
+        }
+
+        token_t* tok = (item->list_reference != NULL) ? item->list_reference->IDENTIFIER : item->IDENTIFIER;
+        if(mark == 1)
+            type = (item->sym != NULL && item->sym->type != NULL) ? item->sym->type : TYPE(ERROR);
+        else
+            type = check_field(type, tok, &item->sym);
+
+        if(item->list_reference != NULL) {
+            int m = 0;
+            ast_expression_t* index;
+            while(iterate_expr_list(item->list_reference->list, &m, &index))
+                type = check_index(type, index);
+        }
+    }
+
+    RETURN(type);
+}
+
+/*
+ * The template is compiled here only to find placeholders that have no
+ * value. The code generator compiles it again with the types it knows. A
+ * string literal with no values is not a template.
+ */
+static type_t* check_formatted_string(ast_formatted_string_t* node) {
+
+    ENTER;
+    if(node->dss_initializer == NULL)
+        RETURN(TYPE(STRING));
+
+    int nargs = len_dss_item_list(node->dss_initializer->list);
+    const char** names = NULL;
+    value_type_t* types = NULL;
+
+    if(nargs > 0) {
+        names = _ALLOC_ARRAY(const char*, nargs);
+        types = _ALLOC_ARRAY(value_type_t, nargs);
+
+        int mark = 0;
+        ast_dss_initializer_item_t* item;
+        for(int i = 0; iterate_dss_item_list(node->dss_initializer->list, &mark, &item); i++) {
+            names[i] = raw_string(item->STRING_LITERAL->str);
+            types[i] = type_to_val_type(check_expression(item->expression));
+        }
+    }
+
+    format_t fmt;
+    const char* msg = compile_format(&fmt, raw_string(node->STRING_LITERAL->str), names, types, nargs);
+    if(msg != NULL)
+        TOKEN_ERROR(node->STRING_LITERAL, "formatted string: %s", msg);
+    else
+        free_format(&fmt);
+
+    if(nargs > 0) {
+        _FREE(names);
+        _FREE(types);
+    }
+
+    RETURN(TYPE(STRING));
+}
+
+static type_t* check_operand(ast_primary_expression_t* node) {
+
+    ENTER;
+    if(node->token != NULL) {
+        switch(node->token->type) {
+            case TOK_INT_LITERAL:
+                RETURN(TYPE(INT));
+            case TOK_FLOAT_LITERAL:
+                RETURN(TYPE(FLOAT));
+            case TOK_STRING_LITERAL:
+                RETURN(TYPE(STRING));
+            case TOK_TRUE:
+            case TOK_FALSE:
+                RETURN(TYPE(BOOL));
+            default:
+                FATAL("internal AST error: unexpected token in expression: %s", tok_type_to_str(node->token));
+        }
+    }
+
+    switch(node->nterm->type) {
+        case AST_COMPOUND_REFERENCE:
+            RETURN(check_compound_reference((ast_compound_reference_t*)node->nterm));
+        case AST_FORMATTED_STRING:
+            RETURN(check_formatted_string((ast_formatted_string_t*)node->nterm));
+        case AST_BOOL_LITERAL:
+            RETURN(TYPE(BOOL));
+        case AST_EXPRESSION:
+            RETURN(check_expression((ast_expression_t*)node->nterm));
+        default:
+            FATAL("internal AST error: unexpected node in expression: %d", node->nterm->type);
+    }
+
+    RETURN(TYPE(ERROR));
+}
+
+/*
+ * Walk the postfix list with a stack of types. The type of every item is
+ * kept in the item, which is the type of the value it leaves on the stack.
+ */
+static type_t* check_expression(ast_expression_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN(TYPE(NOTHING));
+
+    type_stack_t stack;
+    init_type_stack(&stack);
+
+    int mark = 0;
+    ast_primary_expression_t* item;
+    while(iterate_expr_item_list(node->list, &mark, &item)) {
+        operator_t op = get_operator(item);
+
+        if(op != OPER_NONE) {
+            type_t* right = is_unary_operator(op) ? NULL : pop_type_stack(&stack);
+            type_t* left = pop_type_stack(&stack);
+            ASSERT(left != NULL, "internal AST error: operand stack underflow");
+            item->type = check_operator(item, op, left, is_unary_operator(op) ? left : right);
+        }
+        else if(item->nterm != NULL && item->nterm->type == AST_TYPE_NAME) {
+            type_t* from = pop_type_stack(&stack);
+            ASSERT(from != NULL, "internal AST error: operand stack underflow");
+            item->type = type_from_type_name((ast_type_name_t*)item->nterm);
+            if(!is_castable(item->type, from)) {
+                NODE_ERROR(item, "cannot cast a %s to a %s", type_to_str(from), type_to_str(item->type));
+                item->type = TYPE(ERROR);
+            }
+        }
+        else
+            item->type = check_operand(item);
+
+        push_type_stack(&stack, item->type);
+    }
+
+    node->type = pop_type_stack(&stack);
+    ASSERT(node->type != NULL && len_type_stack(&stack) == 0, "internal AST error: malformed expression");
+    free_type_stack(&stack);
+
+    RETURN(node->type);
+}
+
+static void check_value(ast_node_t* where, type_t* dest, type_t* src) {
+
+    if(!is_assignable(dest, src))
+        NODE_ERROR(where, "cannot assign a %s to a %s", type_to_str(src), type_to_str(dest));
+}
+
+static void check_initializer(type_t* type, ast_initializer_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    int mark = 0;
+    switch(node->nterm->type) {
+        case AST_EXPRESSION:
+            check_value(node->nterm, type, check_expression((ast_expression_t*)node->nterm));
+            break;
+        case AST_LIST_INIT: {
+            ast_list_init_t* n = (ast_list_init_t*)node->nterm;
+            check_value((ast_node_t*)n, type, TYPE(LIST));
+            if(n->expression_list != NULL) {
+                ast_expression_t* item;
+                while(iterate_expr_list(n->expression_list->list, &mark, &item))
+                    check_expression(item);
+            }
+        } break;
+        case AST_DICT_INIT: {
+            ast_dict_init_t* n = (ast_dict_init_t*)node->nterm;
+            check_value((ast_node_t*)n, type, TYPE(DICT));
+            ast_dss_initializer_item_t* item;
+            while(iterate_dss_item_list(n->dss_initializer->list, &mark, &item))
+                check_expression(item->expression);
+        } break;
+        case AST_STRUCT_INIT: {
+            ast_struct_init_t* n = (ast_struct_init_t*)node->nterm;
+            if(!IS_TYPE(type, TYPE_STRUCT) && !IS_TYPE(type, TYPE_ERROR))
+                NODE_ERROR(n, "a struct initializer cannot initialize a %s", type_to_str(type));
+
+            ast_dss_initializer_item_t* item;
+            while(iterate_dss_item_list(n->dss_initializer->list, &mark, &item)) {
+                type_t* value = check_expression(item->expression);
+                if(!IS_TYPE(type, TYPE_STRUCT))
+                    continue;
+
+                item->sym = find_member(type->sym, tok_name(item->STRING_LITERAL));
+                if(item->sym == NULL)
+                    TOKEN_ERROR(item->STRING_LITERAL, "struct \"%s\" has no field \"%s\"", type->sym->name,
+                                raw_string(item->STRING_LITERAL->str));
+                else
+                    check_value((ast_node_t*)item, item->sym->type, value);
+            }
+        } break;
+        default:
+            FATAL("internal AST error: Unknown initializer type: %d", node->nterm->type);
+    }
+
+    RETURN();
+}
+
+static void check_data_definition(ast_data_definition_t* node) {
+
+    ENTER;
+    symbol_t* sym = node->data_declaration->sym;
+    type_t* type = (sym != NULL) ? sym->type : TYPE(ERROR);
+
+    if(node->is_const && node->initializer == NULL)
+        TOKEN_ERROR(node->data_declaration->IDENTIFIER, "const \"%s\" has no value",
+                    raw_string(node->data_declaration->IDENTIFIER->str));
+
+    check_initializer(type, node->initializer);
+
+    RETURN();
+}
+
+/*
+ * The left side of an assignment is a variable followed by fields. The
+ * fields of a struct are resolved and kept in the compound name, in the
+ * same order as the names. A field that is found at run time is NULL.
+ */
+static void check_assignment(ast_assignment_t* node) {
+
+    ENTER;
+    type_t* value = check_expression(node->expression);
+    ast_compound_name_t* name = node->compound_name;
+
+    if(name->sym == NULL)
+        RETURN();
+
+    type_t* type = name->sym->type;
+    name->fields = create_symbol_list();
+
+    int mark = 1;
+    token_t* tok;
+    while(iterate_token_list(name->list, &mark, &tok)) {
+        symbol_t* field;
+        type = check_field(type, tok, &field);
+        append_symbol_list(name->fields, field);
+    }
+
+    name->type = type;
+    check_value((ast_node_t*)node, type, value);
+
+    RETURN();
+}
+
+static void check_condition(ast_expression_t* node) {
+
+    ENTER;
+    if(node == NULL)
+        RETURN();
+
+    type_t* type = check_expression(node);
+    if(!IS_TYPE(type, TYPE_BOOL) && !IS_UNCHECKED(type))
+        NODE_ERROR(node, "a condition must be a bool, not a %s", type_to_str(type));
+
+    RETURN();
+}
+
+/*
+ * A for loop is one of three things. With a variable it iterates a list, a
+ * dict or a string. Without one, an int expression is a count and a bool
+ * expression is a condition, like a while loop.
+ */
+static void check_for_clause(ast_for_clause_t* node) {
+
+    ENTER;
+    type_t* type = (node->expression != NULL) ? check_expression(node->expression) : TYPE(BOOL);
+
+    if(node->IDENTIFIER == NULL) {
+        if(!IS_TYPE(type, TYPE_INT) && !IS_TYPE(type, TYPE_BOOL) && !IS_UNCHECKED(type))
+            NODE_ERROR(node->expression, "a for loop needs an int or a bool, not a %s", type_to_str(type));
+    }
+    else {
+        type_t* item = TYPE(ANY);
+        if(IS_TYPE(type, TYPE_STRING))
+            item = TYPE(STRING);
+        else if(!IS_TYPE(type, TYPE_LIST) && !IS_TYPE(type, TYPE_DICT) && !IS_UNCHECKED(type)) {
+            NODE_ERROR(node->expression, "a %s cannot be iterated", type_to_str(type));
+            item = TYPE(ERROR);
+        }
+
+        if(node->literal_type_name != NULL) {
+            type_t* declared = type_from_token(node->literal_type_name->tok);
+            check_value((ast_node_t*)node, declared, item);
+            item = declared;
+        }
+
+        if(node->sym != NULL)
+            node->sym->type = item;
+    }
+
+    check_loop_body(node->loop_body);
+
+    RETURN();
+}
+
+static void check_return(ast_return_statement_t* node) {
+
+    ENTER;
+    type_t* want = (crnt_func != NULL) ? crnt_func->type : TYPE(NOTHING);
+
+    if(node->expression == NULL) {
+        if(!IS_TYPE(want, TYPE_NOTHING))
+            NODE_ERROR(node, "function \"%s\" must return a %s", crnt_func->name, type_to_str(want));
+        RETURN();
+    }
+
+    type_t* type = check_expression(node->expression);
+    if(IS_TYPE(want, TYPE_NOTHING))
+        NODE_ERROR(node, "function \"%s\" does not return a value", (crnt_func != NULL) ? crnt_func->name : "");
+    else if(!is_assignable(want, type))
+        NODE_ERROR(node, "function \"%s\" returns a %s, not a %s", crnt_func->name, type_to_str(want),
+                   type_to_str(type));
+
+    RETURN();
+}
+
+static void check_function_body_element(ast_function_body_element_t* node) {
+
+    ENTER;
+    if(node == NULL || node->INLINE != NULL)
+        RETURN();
+
+    switch(node->nterm->type) {
+        case AST_ASSIGNMENT:
+            check_assignment((ast_assignment_t*)node->nterm);
+            break;
+        case AST_COMPOUND_REFERENCE:
+            check_compound_reference((ast_compound_reference_t*)node->nterm);
+            break;
+        case AST_DATA_DEFINITION:
+            check_data_definition((ast_data_definition_t*)node->nterm);
+            break;
+        case AST_STRUCT_DEFINITION:
+            // the fields were typed with the symbols
+            break;
+        case AST_IF_CLAUSE: {
+            ast_if_clause_t* n = (ast_if_clause_t*)node->nterm;
+            check_condition(n->expression);
+            check_function_body(n->function_body);
+            if(n->else_clause != NULL) {
+                check_condition(n->else_clause->expression);
+                check_function_body(n->else_clause->function_body);
+            }
+            if(n->final_else_clause != NULL)
+                check_function_body(n->final_else_clause->function_body);
+        } break;
+        case AST_WHILE_CLAUSE: {
+            ast_while_clause_t* n = (ast_while_clause_t*)node->nterm;
+            check_condition(n->expression);
+            check_loop_body(n->loop_body);
+        } break;
+        case AST_DO_CLAUSE: {
+            ast_do_clause_t* n = (ast_do_clause_t*)node->nterm;
+            check_loop_body(n->loop_body);
+            check_condition(n->expression);
+        } break;
+        case AST_FOR_CLAUSE:
+            check_for_clause((ast_for_clause_t*)node->nterm);
+            break;
+        case AST_RETURN_STATEMENT:
+            check_return((ast_return_statement_t*)node->nterm);
+            break;
+        case AST_EXIT_STATEMENT: {
+            ast_exit_statement_t* n = (ast_exit_statement_t*)node->nterm;
+            type_t* type = check_expression(n->expression);
+            if(!IS_TYPE(type, TYPE_INT) && !IS_UNCHECKED(type))
+                NODE_ERROR(n, "exit needs an int, not a %s", type_to_str(type));
+        } break;
+        default:
+            FATAL("internal AST error: Unknown body element type: %d", node->nterm->type);
+    }
+
+    RETURN();
+}
+
+static void check_function_body(ast_function_body_t* node) {
+
+    ENTER;
+    if(node == NULL || node->function_body_list == NULL)
+        RETURN();
+
+    int mark = 0;
+    ast_function_body_prelist_t* item;
+    while(iterate_body_item_list(node->function_body_list->list, &mark, &item)) {
+        if(item->nterm->type == AST_FUNCTION_BODY)
+            check_function_body((ast_function_body_t*)item->nterm);
+        else
+            check_function_body_element((ast_function_body_element_t*)item->nterm);
+    }
+
+    RETURN();
+}
+
+static void check_loop_body(ast_loop_body_t* node) {
+
+    ENTER;
+    if(node == NULL || node->loop_body_list == NULL)
+        RETURN();
+
+    int mark = 0;
+    ast_loop_body_prelist_t* item;
+    while(iterate_loop_item_list(node->loop_body_list->list, &mark, &item)) {
+        if(item->nterm->type == AST_LOOP_BODY)
+            check_loop_body((ast_loop_body_t*)item->nterm);
+        else {
+            ast_loop_body_element_t* elem = (ast_loop_body_element_t*)item->nterm;
+            if(elem->tok == NULL)
+                check_function_body_element(elem->function_body_element);
+        }
+    }
+
+    RETURN();
+}
+
+/*
+ * public interface
+ */
+void check_types(symtab_t* tab, ast_node_t* node) {
+
+    if(in_cmd_list("trace", "types"))
+        push_trace_state(1);
+    else
+        push_trace_state(0);
+
+    assign_symbol_types(tab);
+
+    int mark = 0;
+    ast_translation_unit_element_t* item;
+    while(node != NULL && iterate_unit_item_list(((ast_translation_unit_t*)node)->list, &mark, &item)) {
+        switch(item->nterm->type) {
+            case AST_DATA_DEFINITION:
+                crnt_func = NULL;
+                check_data_definition((ast_data_definition_t*)item->nterm);
+                break;
+            case AST_FUNCTION_DEFINITION: {
+                ast_function_definition_t* n = (ast_function_definition_t*)item->nterm;
+                crnt_func = n->function_name->sym;
+                if(crnt_func != NULL && crnt_func->foreign != NULL)
+                    check_foreign(n);
+                else
+                    check_function_body(n->function_body);
+            } break;
+            case AST_START_BLOCK: {
+                ast_start_block_t* n = (ast_start_block_t*)item->nterm;
+                crnt_func = n->sym;
+                check_function_body(n->function_body);
+            } break;
+            default:
+                break;
+        }
+    }
+
+    crnt_func = NULL;
+    MSG(5, "types: %d errors\n", get_sem_errors());
+
+    pop_trace_state();
+}
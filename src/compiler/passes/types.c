@@ -0,0 +1,215 @@
+/**
+ * @file types.c
+ *
+ * @brief Static types.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "types.h"
+
+static type_t basic_types[] = {
+    { TYPE_ERROR, NULL },
+    { TYPE_ANY, NULL },
+    { TYPE_NOTHING, NULL },
+    { TYPE_BOOL, NULL },
+    { TYPE_INT, NULL },
+    { TYPE_FLOAT, NULL },
+    { TYPE_STRING, NULL },
+    { TYPE_LIST, NULL },
+    { TYPE_DICT, NULL },
+};
+
+type_t* get_basic_type(type_kind_t kind) {
+
+    ASSERT(kind < TYPE_STRUCT, "not a basic type: %d", kind);
+    return &basic_types[kind];
+}
+
+/*
+ * The struct type is made the first time it is asked for and is kept in the
+ * struct symbol.
+ */
+type_t* get_struct_type(symbol_t* sym) {
+
+    ASSERT(sym->kind == SYM_STRUCT, "not a struct symbol: %s", sym->name);
+
+    if(sym->type == NULL) {
+        sym->type = _ALLOC_TYPE(type_t);
+        sym->type->kind = TYPE_STRUCT;
+        sym->type->sym = sym;
+    }
+
+    return sym->type;
+}
+
+type_t* type_from_token(token_t* tok) {
+
+    switch(tok->type) {
+        case TOK_INT:
+            return get_basic_type(TYPE_INT);
+        case TOK_FLOAT:
+            return get_basic_type(TYPE_FLOAT);
+        case TOK_STRING:
+            return get_basic_type(TYPE_STRING);
+        case TOK_BOOL:
+            return get_basic_type(TYPE_BOOL);
+        case TOK_LIST:
+            return get_basic_type(TYPE_LIST);
+        case TOK_DICT:
+            return get_basic_type(TYPE_DICT);
+        case TOK_NOTHING:
+            return get_basic_type(TYPE_NOTHING);
+        default:
+            return get_basic_type(TYPE_ERROR);
+    }
+}
+
+/*
+ * A NULL type name is the "nothing" of a function that does not return a
+ * value. An unresolved struct name has already been reported.
+ */
+type_t* type_from_type_name(ast_type_name_t* node) {
+
+    if(node == NULL)
+        return get_basic_type(TYPE_NOTHING);
+
+    if(node->nterm->type == AST_LITERAL_TYPE_NAME)
+        return type_from_token(((ast_literal_type_name_t*)node->nterm)->tok);
+
+    ast_compound_name_t* name = (ast_compound_name_t*)node->nterm;
+    if(name->sym != NULL)
+        return get_struct_type(name->sym);
+    else
+        return get_basic_type(TYPE_ERROR);
+}
+
+/*
+ * Return the operator for an item in a postfix expression, or OPER_NONE if
+ * the item is an operand. The scanner gives most operators two spellings.
+ */
+operator_t get_operator(ast_primary_expression_t* item) {
+
+    if(item->token == NULL)
+        return OPER_NONE;
+
+    switch(item->token->type) {
+        case TOK_PLUS:
+            return OPER_ADD;
+        case TOK_MINUS:
+            return item->is_unary ? OPER_NEG : OPER_SUB;
+        case TOK_STAR:
+            return OPER_MUL;
+        case TOK_SLASH:
+            return OPER_DIV;
+        case TOK_PERCENT:
+            return OPER_MOD;
+        case TOK_CARET:
+            return OPER_POW;
+        case TOK_EQUAL_EQUAL:
+        case TOK_EQU:
+            return OPER_EQ;
+        case TOK_BANG_EQUAL:
+        case TOK_NEQU:
+            return OPER_NE;
+        case TOK_OPBRACE:
+        case TOK_LT:
+            return OPER_LT;
+        case TOK_OPBRACE_EQUAL:
+        case TOK_LTE:
+            return OPER_LE;
+        case TOK_CPBRACE:
+        case TOK_GT:
+            return OPER_GT;
+        case TOK_CPBRACE_EQUAL:
+        case TOK_GTE:
+            return OPER_GE;
+        case TOK_AMP:
+        case TOK_AND:
+            return OPER_AND;
+        case TOK_BAR:
+        case TOK_OR:
+            return OPER_OR;
+        case TOK_BANG:
+        case TOK_NOT:
+            return OPER_NOT;
+        default:
+            return OPER_NONE;
+    }
+}
+
+bool is_unary_operator(operator_t op) {
+
+    return op == OPER_NEG || op == OPER_NOT;
+}
+
+/*
+ * Types are strong. A value can be stored where a value of the same type is
+ * expected, or where the type will be checked when the program runs.
+ */
+bool is_assignable(type_t* dest, type_t* src) {
+
+    return (dest == src) || IS_UNCHECKED(dest) || IS_UNCHECKED(src);
+}
+
+/*
+ * Explicit casts are allowed between the scalar types and strings.
+ */
+bool is_castable(type_t* dest, type_t* src) {
+
+    if(is_assignable(dest, src))
+        return true;
+
+    switch(dest->kind) {
+        case TYPE_INT:
+        case TYPE_FLOAT:
+        case TYPE_BOOL:
+        case TYPE_STRING:
+            return src->kind == TYPE_INT || src->kind == TYPE_FLOAT || src->kind == TYPE_BOOL || src->kind == TYPE_STRING;
+        default:
+            return false;
+    }
+}
+
+value_type_t type_to_val_type(type_t* type) {
+
+    switch(type->kind) {
+        case TYPE_BOOL:
+            return VAL_BOOL;
+        case TYPE_INT:
+            return VAL_INT;
+        case TYPE_FLOAT:
+            return VAL_FLOAT;
+        case TYPE_STRING:
+            return VAL_STRING;
+        case TYPE_LIST:
+            return VAL_LIST;
+        case TYPE_DICT:
+            return VAL_DICT;
+        case TYPE_STRUCT:
+            return VAL_STRUCT;
+        default:
+            return VAL_NOTHING;
+    }
+}
+
+const char* type_to_str(type_t* type) {
+
+    if(type == NULL)
+        return "NULL";
+
+    return (type->kind == TYPE_ERROR)    ? "<error>" :
+            (type->kind == TYPE_ANY)     ? "any" :
+            (type->kind == TYPE_NOTHING) ? "nothing" :
+            (type->kind == TYPE_BOOL)    ? "bool" :
+            (type->kind == TYPE_INT)     ? "int" :
+            (type->kind == TYPE_FLOAT)   ? "float" :
+            (type->kind == TYPE_STRING)  ? "string" :
+            (type->kind == TYPE_LIST)    ? "list" :
+            (type->kind == TYPE_DICT)    ? "dict" :
+            (type->kind == TYPE_STRUCT)  ? type->sym->name :
+                                           "UNKNOWN";
+}
@@ -0,0 +1,78 @@
+/**
+ * @file types.h
+ *
+ * @brief Static types. There is exactly one type object for each basic type
+ * and one for each struct, so types are compared by pointer.
+ *
+ * TYPE_ANY is the type of a value that comes out of a list or a dict. It
+ * is checked at run time. TYPE_ERROR is given to an expression that already
+ * has an error, so that one mistake is not reported over and over.
+ *
+ */
+#ifndef _TYPES_H_
+#define _TYPES_H_
+
+#include <stdbool.h>
+
+#include "symtab.h"
+#include "value.h"
+#include "vector.h"
+
+typedef enum {
+    TYPE_ERROR,
+    TYPE_ANY,
+    TYPE_NOTHING,
+    TYPE_BOOL,
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_STRING,
+    TYPE_LIST,
+    TYPE_DICT,
+    TYPE_STRUCT,
+} type_kind_t;
+
+typedef enum {
+    OPER_NONE,
+    OPER_ADD,
+    OPER_SUB,
+    OPER_MUL,
+    OPER_DIV,
+    OPER_MOD,
+    OPER_POW,
+    OPER_NEG,
+    OPER_EQ,
+    OPER_NE,
+    OPER_LT,
+    OPER_LE,
+    OPER_GT,
+    OPER_GE,
+    OPER_AND,
+    OPER_OR,
+    OPER_NOT,
+} operator_t;
+
+typedef struct _type_t_ {
+    type_kind_t kind;
+    struct _symbol_t_* sym;
+} type_t;
+
+// the static types of the operands of an expression while it is evaluated
+DEFINE_STACK(type_stack, struct _type_t_*, 16)
+
+type_t* get_basic_type(type_kind_t kind);
+type_t* get_struct_type(symbol_t* sym);
+type_t* type_from_type_name(ast_type_name_t* node);
+type_t* type_from_token(token_t* tok);
+
+operator_t get_operator(ast_primary_expression_t* item);
+bool is_unary_operator(operator_t op);
+
+bool is_assignable(type_t* dest, type_t* src);
+bool is_castable(type_t* dest, type_t* src);
+value_type_t type_to_val_type(type_t* type);
+const char* type_to_str(type_t* type);
+
+#define IS_TYPE(t, k) ((t)->kind == (k))
+#define IS_UNCHECKED(t) ((t)->kind == TYPE_ANY || (t)->kind == TYPE_ERROR)
+
+#endif /* _TYPES_H_ */
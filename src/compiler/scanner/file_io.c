@@ -32,6 +32,8 @@ typedef struct _file_t_ {
     FILE* fp;
     int line;
     int column;
+    // bytes scanned, up to the end of the current match
+    size_t offset;
     bool is_open;
     struct yy_buffer_state* buffer;
     struct _file_t_* next;
@@ -39,6 +41,10 @@ typedef struct _file_t_ {
 
 static file_t* file_stack = NULL;
 
+// the others are given by scanner.h
+extern int yycolno;
+extern int prev_lineno;
+
 /**
  * @brief Open a file for input and push it on the file stack.
  *
@@ -65,6 +71,38 @@ void open_file(const char* name) {
     file_stack = ptr;
 }
 
+/**
+ * @brief Scan text that is already in memory and push it on the file stack.
+ * The text is scanned in place, so it must be followed by two '\0' bytes
+ * that are not counted in len. The line, column and offset are those of
+ * the first byte of the text in the file that it came from.
+ *
+ * @param name
+ * @param text
+ * @param len
+ * @param offset
+ * @param line
+ * @param col
+ */
+void open_buffer(const char* name, char* text, size_t len, size_t offset, int line, int col) {
+
+    file_t* ptr = _ALLOC_TYPE(file_t);
+
+    ptr->name = create_string(name);
+    ptr->is_open = true;
+    ptr->fp = NULL;
+    ptr->offset = offset;
+    ptr->buffer = yy_scan_buffer(text, len + 2);
+    if(ptr->buffer == NULL)
+        FATAL("cannot scan buffer: %s", name);
+    ptr->next = file_stack;
+    file_stack = ptr;
+
+    yylineno = line;
+    prev_lineno = line;
+    yycolno = col;
+}
+
 /**
  * @brief Pop the current file off of the stack and destroy it.
  *
@@ -74,7 +112,8 @@ void close_file(void) {
     file_t* ptr = file_stack;
     if(ptr != NULL) {
         if(ptr->next != NULL) {
-            fclose(ptr->fp);
+            if(ptr->fp != NULL)
+                fclose(ptr->fp);
             destroy_string(ptr->name);
             yy_delete_buffer(ptr->buffer);
             file_stack = ptr->next;
@@ -88,6 +127,30 @@ void close_file(void) {
     }
 }
 
+/**
+ * @brief Close every file and put the scanner back in the state it had
+ * before the first file was opened, so that another compile can start.
+ *
+ */
+void reset_file_io(void) {
+
+    while(file_stack != NULL) {
+        file_t* ptr = file_stack;
+        file_stack = ptr->next;
+        if(ptr->fp != NULL)
+            fclose(ptr->fp);
+        destroy_string(ptr->name);
+        yy_delete_buffer(ptr->buffer);
+        _FREE(ptr);
+    }
+
+    reset_scanner();
+    yyin = NULL;
+    yylineno = 1;
+    yycolno = 1;
+    prev_lineno = 1;
+}
+
 int get_line_no(void) {
 
     if(file_stack != NULL)
@@ -104,6 +167,14 @@ int get_col_no(void) {
         return -1;
 }
 
+size_t get_offset(void) {
+
+    if(file_stack != NULL)
+        return file_stack->offset;
+    else
+        return 0;
+}
+
 string_t* get_file_name(void) {
 
     if(file_stack != NULL)
@@ -112,15 +183,24 @@ string_t* get_file_name(void) {
         return NULL;
 }
 
-// the others are given by scanner.h
-extern int yycolno;
-extern int prev_lineno;
+/*
+ * The end of the file is where the scanner stopped, after the last match.
+ */
+void end_numbers(void) {
+
+    if(file_stack != NULL) {
+        file_stack->column = yycolno;
+        file_stack->line = yylineno;
+    }
+}
 
 void update_numbers(void) {
 
     if(file_stack != NULL) {
         file_stack->column = yycolno;
-        file_stack->line = yylineno;
+        // the line where the match starts, yylineno is already past it
+        file_stack->line = prev_lineno;
+        file_stack->offset += yyleng;
         if(yylineno == prev_lineno)
             yycolno += yyleng;
         else {
@@ -13,14 +13,22 @@
 #ifndef _FILE_IO_H_
 #define _FILE_IO_H_
 
+#include <stddef.h>
+
 #include "string_buffer.h"
 
 void open_file(const char* name);
+void open_buffer(const char* name, char* text, size_t len, size_t offset, int line, int col);
 void close_file(void);
+void reset_file_io(void);
+// defined in scanner.l
+void reset_scanner(void);
 int get_char(void);
 int get_line_no(void);
 int get_col_no(void);
+size_t get_offset(void);
 string_t* get_file_name(void);
 void update_numbers(void);
+void end_numbers(void);
 
 #endif /* _FILE_IO_H_ */
@@ -0,0 +1,121 @@
+/**
+ * @file numbers.c
+ *
+ * @brief The scanner has already checked the syntax, so these only read
+ * digits. An integer is accumulated with a check for overflow. A float
+ * with at most 19 significant digits and a small exponent is converted
+ * with one exact multiply or divide (Clinger's fast path), which covers
+ * almost every literal that is written by hand. Everything else goes to
+ * strtod(), which rounds correctly.
+ *
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+
+#include "numbers.h"
+
+// every integer up to this is exact in a double
+#define MAX_EXACT_MANTISSA (1ULL << 53)
+// and so is every power of ten up to this one
+#define MAX_EXACT_POW10 22
+// digits that always fit in a uint64_t
+#define MAX_DIGITS 19
+
+static const double pow10_table[MAX_EXACT_POW10 + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/*
+ * Read decimal digits. Returns false when the value does not fit in an
+ * int64_t, the value is then INT64_MAX.
+ */
+bool scan_int(const char* text, int64_t* value) {
+
+    uint64_t val = 0;
+    for(; *text >= '0' && *text <= '9'; text++) {
+        unsigned digit = *text - '0';
+        if(val > (uint64_t)(INT64_MAX - digit) / 10) {
+            *value = INT64_MAX;
+            return false;
+        }
+        val = val * 10 + digit;
+    }
+
+    *value = (int64_t)val;
+    return true;
+}
+
+/*
+ * Read a float in the form that the scanner accepts, digits, a point,
+ * digits and an optional exponent. Returns false when it is too large for
+ * a double, the value is then infinity.
+ */
+bool scan_float(const char* text, double* value) {
+
+    uint64_t mant = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool frac = false;
+    const char* ptr = text;
+
+    for(; (*ptr >= '0' && *ptr <= '9') || *ptr == '.'; ptr++) {
+        if(*ptr == '.')
+            frac = true;
+        else if(digits == 0 && *ptr == '0') {
+            // a leading zero is not significant but it moves the point
+            if(frac)
+                exp10--;
+        }
+        else {
+            if(++digits > MAX_DIGITS)
+                goto slow;
+            mant = mant * 10 + (*ptr - '0');
+            if(frac)
+                exp10--;
+        }
+    }
+
+    if(*ptr == 'e' || *ptr == 'E') {
+        int exp = atoi(ptr + 1);
+        // past this the fast path cannot apply and atoi() could overflow
+        if(exp > 400 || exp < -400)
+            goto slow;
+        exp10 += exp;
+    }
+
+    if(mant == 0) {
+        *value = 0.0;
+        return true;
+    }
+
+    if(mant <= MAX_EXACT_MANTISSA) {
+        if(exp10 >= 0 && exp10 <= MAX_EXACT_POW10) {
+            *value = (double)mant * pow10_table[exp10];
+            return true;
+        }
+        if(exp10 < 0 && exp10 >= -MAX_EXACT_POW10) {
+            // a divide, the reciprocal of a power of ten is not exact
+            *value = (double)mant / pow10_table[-exp10];
+            return true;
+        }
+        // 123e25 is 123000e22, while the mantissa stays exact
+        if(exp10 > MAX_EXACT_POW10 && exp10 <= MAX_EXACT_POW10 + 15) {
+            uint64_t big = mant;
+            int shift = exp10 - MAX_EXACT_POW10;
+            for(; shift > 0 && big <= MAX_EXACT_MANTISSA / 10; shift--)
+                big *= 10;
+            if(shift == 0) {
+                *value = (double)big * pow10_table[MAX_EXACT_POW10];
+                return true;
+            }
+        }
+    }
+
+slow:
+    // not isinf(), a fast math build assumes that there is no infinity
+    errno = 0;
+    *value = strtod(text, NULL);
+    return !(errno == ERANGE && *value > 1.0);
+}
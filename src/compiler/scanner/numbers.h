@@ -0,0 +1,18 @@
+/**
+ * @file numbers.h
+ *
+ * @brief Convert the text of a numeric literal to its value when it is
+ * scanned, so no later pass has to read it again.
+ *
+ */
+
+#ifndef _NUMBERS_H_
+#define _NUMBERS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool scan_int(const char* text, int64_t* value);
+bool scan_float(const char* text, double* value);
+
+#endif /* _NUMBERS_H_ */
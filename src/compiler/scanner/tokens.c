@@ -10,25 +10,69 @@
  *
  */
 
+/*
+ * Benchmark build tokens, with the scanner made by flex:
+ * flex -o scanner.c --header-file=scanner.h scanner.l
+ * gcc -O2 -DBENCH_TOKENS -I. -I../../common -o bt tokens.c scanner.c file_io.c ../../common/[a-z]*.c -lm -lpthread
+ */
+
+#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "tokens.h"
 #include "alloc.h"
+#include "errors.h"
 #include "file_io.h"
 #include "scanner.h"
 
+// #define BENCH_TOKENS
+
+// tokens in a batch and slots in the pipeline, a power of 2
+#define BATCH_TOKENS 4096
+
 // there is one global token queue
 typedef struct _token_queue_t_ {
     token_t* head;
     token_t* tail;
     token_t* crnt;
+    // set when the tokens belong to the caller, the queue ends before it
+    token_t* stop;
+    bool borrowed;
+    // the index of the furthest token that the parser has looked at
+    int reach;
 } token_queue_t;
 
+/*
+ * The pipeline from the scanner thread to the parser. There is one writer
+ * and one reader, so the two counters are all the locking there is. The
+ * writer owns in and the reader owns out.
+ */
+typedef struct {
+    token_t* slots[BATCH_TOKENS];
+    _Atomic unsigned long in;
+    _Atomic unsigned long out;
+    // the scanner reached the end of the file
+    atomic_bool done;
+    // the reader is going away, the rest of the file is not wanted
+    atomic_bool stop;
+    pthread_t thread;
+    bool running;
+} token_pipe_t;
+
 static token_queue_t* token_queue = NULL;
 static token_t end_of_input;
+static int token_count = 0;
+
+static prefetch_mode_t prefetch = PREFETCH_DEMAND;
+static token_pipe_t token_pipe;
+// true on the scanner thread, where add_token_queue() writes to the pipe
+static __thread bool on_pipe_thread = false;
 
 token_t* create_token(string_t* str, token_type_t type) {
 
-    token_t* ptr = _ALLOC_TYPE(token_t);
+    token_t* ptr = _ALLOC_SLAB(token_t);
     ptr->str = str;
     ptr->type = type;
     ptr->fname = copy_string(get_file_name());
@@ -43,7 +87,7 @@ void destroy_token(token_t* tok) {
     if(tok != NULL) {
         destroy_string(tok->str);
         destroy_string(tok->fname);
-        _FREE(tok);
+        _FREE_SLAB(tok, token_t);
     }
 }
 
@@ -116,20 +160,214 @@ const char* tok_type_to_str(token_t* tok) {
                                                 "UNKNOWN";
 }
 
-void init_token_queue(void) {
+const char* prefetch_to_str(prefetch_mode_t mode) {
+
+    return (mode == PREFETCH_DEMAND)    ? "demand" :
+            (mode == PREFETCH_BATCH)    ? "batch" :
+            (mode == PREFETCH_FILE)     ? "file" :
+            (mode == PREFETCH_PIPELINE) ? "pipeline" :
+                                          "UNKNOWN";
+}
+
+/*
+ * The text of a token for a message. A number is printed in buf, which
+ * should have room for 32 characters.
+ */
+const char* token_to_str(token_t* tok, char* buf, size_t size) {
+
+    if(tok->type == TOK_INT_LITERAL)
+        snprintf(buf, size, "%lld", (long long)tok->ival);
+    else if(tok->type == TOK_FLOAT_LITERAL)
+        snprintf(buf, size, "%.17g", tok->fval);
+    else
+        return (tok->str != NULL) ? raw_string(tok->str) : "";
+
+    return buf;
+}
+
+static void push_token_pipe(token_t* tok) {
+
+    unsigned long in = atomic_load_explicit(&token_pipe.in, memory_order_relaxed);
+    while(in - atomic_load_explicit(&token_pipe.out, memory_order_acquire) == BATCH_TOKENS) {
+        if(atomic_load_explicit(&token_pipe.stop, memory_order_relaxed)) {
+            destroy_token(tok);
+            return;
+        }
+        sched_yield();
+    }
+
+    token_pipe.slots[in & (BATCH_TOKENS - 1)] = tok;
+    atomic_store_explicit(&token_pipe.in, in + 1, memory_order_release);
+}
+
+static void* run_token_pipe(void* arg) {
+
+    (void)arg;
+    on_pipe_thread = true;
+    // yylex() returns 0 after it makes the end of file token
+    while(!atomic_load_explicit(&token_pipe.stop, memory_order_relaxed) && yylex() != 0) {
+    }
+
+    flush_slab_cache();
+    atomic_store_explicit(&token_pipe.done, true, memory_order_release);
+    return NULL;
+}
+
+static void start_token_pipe(void) {
+
+    atomic_store(&token_pipe.in, 0);
+    atomic_store(&token_pipe.out, 0);
+    atomic_store(&token_pipe.done, false);
+    atomic_store(&token_pipe.stop, false);
+    if(pthread_create(&token_pipe.thread, NULL, run_token_pipe, NULL) != 0)
+        FATAL("cannot start the scanner thread");
+    token_pipe.running = true;
+}
+
+/*
+ * Wait for the scanner thread. The tokens that the parser never took are
+ * destroyed.
+ */
+static void stop_token_pipe(void) {
+
+    if(token_pipe.running) {
+        atomic_store(&token_pipe.stop, true);
+        pthread_join(token_pipe.thread, NULL);
+        token_pipe.running = false;
+
+        unsigned long in = atomic_load(&token_pipe.in);
+        for(unsigned long out = atomic_load(&token_pipe.out); out != in; out++)
+            destroy_token(token_pipe.slots[out & (BATCH_TOKENS - 1)]);
+        atomic_store(&token_pipe.out, in);
+    }
+}
+
+/*
+ * Move every token that is in the pipe to the queue. When it is empty,
+ * wait for at least one, or for the end of the file.
+ */
+static void drain_token_pipe(void) {
+
+    unsigned long out = atomic_load_explicit(&token_pipe.out, memory_order_relaxed);
+    unsigned long in;
+    while((in = atomic_load_explicit(&token_pipe.in, memory_order_acquire)) == out) {
+        if(atomic_load_explicit(&token_pipe.done, memory_order_acquire)) {
+            // the last tokens can land between the two loads
+            if((in = atomic_load_explicit(&token_pipe.in, memory_order_acquire)) != out)
+                break;
+            stop_token_pipe();
+            return;
+        }
+        sched_yield();
+    }
+
+    for(; out != in; out++)
+        add_token_queue(token_pipe.slots[out & (BATCH_TOKENS - 1)]);
+    atomic_store_explicit(&token_pipe.out, out, memory_order_release);
+}
+
+/*
+ * Scan more tokens into the queue, as many as the prefetch mode asks for.
+ * A batch or a file ends at the end of file token.
+ */
+static void fill_token_queue(void) {
+
+    if(token_pipe.running) {
+        drain_token_pipe();
+        return;
+    }
+
+    int count = (prefetch == PREFETCH_BATCH) ? BATCH_TOKENS : (prefetch == PREFETCH_FILE) ? -1 : 1;
+    token_t* tail;
+    do {
+        tail = token_queue->tail;
+        yylex();
+    } while(--count != 0 && token_queue->tail != tail && token_queue->tail->type != TOK_END_OF_FILE);
+}
+
+static void create_token_queue(void) {
 
     token_queue = _ALLOC_TYPE(token_queue_t);
-    // add_token_queue(get_scanner_token());
-    yylex();
+    token_queue->reach = -1;
 
     end_of_input.type = TOK_END_OF_INPUT;
     end_of_input.str = create_string(NULL);
+    end_of_input.index = -1;
     // everything else is NULL;
 }
 
-void destroy_token_queue(void) {
+void init_token_queue(void) {
+
+    create_token_queue();
+    // add_token_queue(get_scanner_token());
+    if(prefetch == PREFETCH_PIPELINE)
+        start_token_pipe();
+    fill_token_queue();
+}
+
+/*
+ * How init_token_queue() and consume_token() scan. Set it before the
+ * queue is made, the pipeline is started by init_token_queue().
+ */
+void set_token_prefetch(prefetch_mode_t mode) {
+
+    prefetch = mode;
+}
+
+/*
+ * Scan one more token into the queue and return it. Returns NULL when the
+ * scanner stopped without making a token.
+ */
+token_t* scan_token_queue(void) {
+
+    if(token_queue == NULL)
+        create_token_queue();
+
+    token_t* tail = token_queue->tail;
+    yylex();
+
+    return (token_queue->tail != tail) ? token_queue->tail : NULL;
+}
+
+/*
+ * Parse from tokens that the caller owns. The queue runs from first up to,
+ * but not including, stop. Nothing is scanned and nothing is destroyed.
+ */
+void borrow_token_queue(token_t* first, token_t* stop) {
+
+    destroy_token_queue();
+    create_token_queue();
+    token_queue->head = first;
+    token_queue->crnt = first;
+    token_queue->stop = stop;
+    token_queue->borrowed = true;
+}
+
+/*
+ * Free the queue but not the tokens in it. The tokens that were scanned are
+ * returned as a list linked by next.
+ */
+token_t* release_token_queue(void) {
 
+    stop_token_pipe();
+    token_t* head = NULL;
     if(token_queue != NULL) {
+        if(!token_queue->borrowed)
+            head = token_queue->head;
+        _FREE(token_queue);
+        token_queue = NULL;
+        destroy_string(end_of_input.str);
+        end_of_input.str = NULL;
+    }
+
+    token_count = 0;
+    return head;
+}
+
+void destroy_token_queue(void) {
+
+    stop_token_pipe();
+    if(token_queue != NULL && !token_queue->borrowed) {
         token_t* crnt;
         token_t* next;
         for(crnt = token_queue->head; crnt != NULL; crnt = next) {
@@ -137,11 +375,24 @@ void destroy_token_queue(void) {
             destroy_token(crnt);
         }
         _FREE(token_queue);
+        token_queue = NULL;
+        destroy_string(end_of_input.str);
+        end_of_input.str = NULL;
     }
+    else
+        release_token_queue();
+
+    token_count = 0;
 }
 
 void add_token_queue(token_t* tok) {
 
+    if(on_pipe_thread) {
+        push_token_pipe(tok);
+        return;
+    }
+
+    tok->index = token_count++;
     if(token_queue->tail != NULL)
         token_queue->tail->next = tok;
     else {
@@ -168,7 +419,9 @@ void restore_token_queue(void* mark) {
 void consume_token_queue(void) {
 
     if(token_queue != NULL) {
-        if(token_queue->crnt != NULL && token_queue->crnt != token_queue->head) {
+        if(token_queue->borrowed)
+            token_queue->head = token_queue->crnt;
+        else if(token_queue->crnt != NULL && token_queue->crnt != token_queue->head) {
             token_t* next;
             token_t* tok = token_queue->head;
             for(; tok != NULL && tok != token_queue->crnt; tok = next) {
@@ -183,24 +436,33 @@ void consume_token_queue(void) {
 
 token_t* get_token(void) {
 
-    if(token_queue != NULL && token_queue->crnt != NULL)
+    if(token_queue != NULL && token_queue->crnt != NULL && token_queue->crnt != token_queue->stop) {
+        if(token_queue->crnt->index > token_queue->reach)
+            token_queue->reach = token_queue->crnt->index;
         return token_queue->crnt;
-    else
+    }
+    else {
+        if(token_queue != NULL && token_queue->stop != NULL)
+            token_queue->reach = token_queue->stop->index;
         return &end_of_input;
+    }
 }
 
 token_t* consume_token(void) {
 
     if(token_queue != NULL)
-        if(token_queue->crnt != NULL)
+        if(token_queue->crnt != NULL && token_queue->crnt != token_queue->stop)
             token_queue->crnt = token_queue->crnt->next;
 
-    if(token_queue->crnt == NULL) {
+    if(token_queue->crnt == NULL && !token_queue->borrowed) {
         // accomodate a FLEX scanner
         // add_token_queue(get_scanner_token());
         // get_scanner_token();
-        yylex();
-        token_queue->crnt = token_queue->tail;
+        token_t* tail = token_queue->tail;
+        fill_token_queue();
+        // an empty queue gets crnt from add_token_queue()
+        if(tail != NULL)
+            token_queue->crnt = (tail->next != NULL) ? tail->next : tail;
     }
 
     return get_token();
@@ -211,3 +473,127 @@ bool expect_token(token_type_t type) {
     token_t* tok = get_token();
     return (tok->type == type) ? true : false;
 }
+
+int get_token_index(void) {
+
+    return (token_queue != NULL) ? get_token()->index : -1;
+}
+
+/*
+ * The index of the furthest token that was looked at since the last call,
+ * which is as far as what was parsed depends on.
+ */
+int get_token_reach(void) {
+
+    int reach = -1;
+    if(token_queue != NULL) {
+        reach = token_queue->reach;
+        token_queue->reach = -1;
+    }
+
+    return reach;
+}
+
+/*
+ * The furthest token that was looked at, for an error message. The reach
+ * is not started over. It is the current token when nothing after it was
+ * looked at.
+ */
+token_t* get_reach_token(void) {
+
+    token_t* tok = get_token();
+    if(token_queue != NULL)
+        for(token_t* ptr = token_queue->crnt; ptr != NULL && ptr != token_queue->stop; ptr = ptr->next) {
+            if(ptr->index > token_queue->reach)
+                break;
+            tok = ptr;
+        }
+
+    return tok;
+}
+
+/*
+ * Scan a few MB of source in each prefetch mode, the way the parser takes
+ * the tokens, and print the tokens per second.
+ */
+#ifdef BENCH_TOKENS
+
+#include <string.h>
+#include <time.h>
+
+static const char* bench_text = "import \"lib.toy\"\n"
+                                "; a comment line\n"
+                                "int count = 42\n"
+                                "float ratio = 3.14159e2\n"
+                                "string name = \"a string literal\"\n"
+                                "nothing add_all(list items, int limit) {\n"
+                                "    int total = 0\n"
+                                "    for(item in items) {\n"
+                                "        if(item >= limit and not done) {\n"
+                                "            total = total + item * 2 - (limit / 3) % 7\n"
+                                "        }\n"
+                                "    }\n"
+                                "    return(total)\n"
+                                "}\n";
+
+static double elapsed(struct timespec* start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static char* make_source(int mb, size_t* len) {
+
+    size_t text_len = strlen(bench_text);
+    size_t size = (size_t)mb * 1024 * 1024;
+    char* buf = _ALLOC(size + text_len + 2);
+
+    for(*len = 0; *len < size; *len += text_len)
+        memcpy(&buf[*len], bench_text, text_len);
+    buf[*len] = '\0';
+    buf[*len + 1] = '\0';
+
+    return buf;
+}
+
+int main(void) {
+
+    const int sizes[] = { 1, 4, 16 };
+    const prefetch_mode_t modes[] = { PREFETCH_DEMAND, PREFETCH_BATCH, PREFETCH_FILE, PREFETCH_PIPELINE };
+    struct timespec start;
+
+    for(int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+        size_t len;
+        char* source = make_source(sizes[i], &len);
+        char* text = _ALLOC(len + 2);
+
+        for(int j = 0; j < (int)(sizeof(modes) / sizeof(modes[0])); j++) {
+            memcpy(text, source, len + 2);
+            open_buffer("bench", text, len, 0, 1, 1);
+            set_token_prefetch(modes[j]);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            long count = 0;
+            init_token_queue();
+            while(get_token()->type != TOK_END_OF_FILE) {
+                consume_token();
+                consume_token_queue();
+                count++;
+            }
+            destroy_token_queue();
+            double secs = elapsed(&start);
+
+            printf("%2d MB %-9s %9ld tokens in %.3f sec, %.2f M tokens/sec\n", sizes[i], prefetch_to_str(modes[j]),
+                   count, secs, count / secs / 1e6);
+            reset_file_io();
+        }
+
+        _FREE(text);
+        _FREE(source);
+    }
+
+    return 0;
+}
+
+#endif
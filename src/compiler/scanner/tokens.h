@@ -14,6 +14,8 @@
 #define _TOKENS_H_
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "string_buffer.h"
 
 typedef enum {
@@ -90,12 +92,32 @@ typedef struct _token_t_ {
     string_t* fname;
     int line_no;
     int col_no;
+    // position in the token stream, counted from 0
+    int index;
     struct _token_t_* next;
+    // a number is converted when it is scanned and has no str
+    union {
+        int64_t ival;
+        double fval;
+    };
 } token_t;
 
+// how the queue is filled when the parser runs out of tokens
+typedef enum {
+    // one token at a time
+    PREFETCH_DEMAND,
+    // a few thousand tokens at a time
+    PREFETCH_BATCH,
+    // up to the end of the file
+    PREFETCH_FILE,
+    // a thread scans ahead of the parser
+    PREFETCH_PIPELINE,
+} prefetch_mode_t;
+
 token_t* create_token(string_t* str, token_type_t type);
 void destroy_token(token_t* tok);
 const char* tok_type_to_str(token_t* tok);
+const char* token_to_str(token_t* tok, char* buf, size_t size);
 
 void init_token_queue(void);
 void destroy_token_queue(void);
@@ -103,9 +125,17 @@ void add_token_queue(token_t* tok);
 void* mark_token_queue(void);
 void restore_token_queue(void* mark);
 void consume_token_queue(void);
+token_t* scan_token_queue(void);
+void borrow_token_queue(token_t* first, token_t* stop);
+token_t* release_token_queue(void);
+void set_token_prefetch(prefetch_mode_t mode);
+const char* prefetch_to_str(prefetch_mode_t mode);
 
 token_t* get_token(void);
 bool expect_token(token_type_t type);
 token_t* consume_token(void);
+int get_token_index(void);
+int get_token_reach(void);
+token_t* get_reach_token(void);
 
 #endif /* _TOKENS_H_ */
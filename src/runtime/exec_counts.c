@@ -0,0 +1,185 @@
+/**
+ * @file exec_counts.c
+ *
+ * @brief Per thread execution counts, added up and written as JSON when
+ * the program exits.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "exec_counts.h"
+
+#ifdef EXEC_COUNTS
+
+#include <stdatomic.h>
+
+_Thread_local exec_counts_t* local_counts = NULL;
+
+static _Atomic(exec_counts_t*) all_counts = NULL;
+static module_t* counted = NULL;
+static const char* json_name = NULL;
+static const char* profile_name = NULL;
+
+static void write_json(FILE* fp, exec_counts_t* total, int threads) {
+
+    fprintf(fp, "{\n  \"threads\": %d,\n  \"opcodes\": {", threads);
+    const char* sep = "";
+    for(int i = 0; i < OP_COUNT; i++)
+        if(total->ops[i] != 0) {
+            fprintf(fp, "%s\n    \"%s\": %llu", sep, opcode_to_str(i), (unsigned long long)total->ops[i]);
+            sep = ",";
+        }
+
+    fprintf(fp, "\n  },\n  \"functions\": [");
+    sep = "";
+    for(int i = 0; i < counted->nfunctions; i++)
+        if(total->calls[i] != 0) {
+            fprintf(fp, "%s\n    { \"name\": \"%s\", \"calls\": %llu }", sep, counted->functions[i].name,
+                    (unsigned long long)total->calls[i]);
+            sep = ",";
+        }
+
+    fprintf(fp, "\n  ],\n  \"loops\": [");
+    sep = "";
+    for(int i = 0; i < counted->nfunctions; i++) {
+        function_t* func = &counted->functions[i];
+        for(int pc = 0; total->loops[i] != NULL && pc <= func->len; pc++)
+            if(total->loops[i][pc] != 0) {
+                int line = 0;
+                int col = 0;
+                find_line(func, pc, &line, &col);
+                fprintf(fp, "%s\n    { \"function\": \"%s\", \"line\": %d, \"col\": %d, \"pc\": %d, \"passes\": %llu }",
+                        sep, func->name, line, col, pc, (unsigned long long)total->loops[i][pc]);
+                sep = ",";
+            }
+    }
+
+    fprintf(fp, "\n  ],\n  \"allocations\": {");
+    sep = "";
+    value_type_t kinds[] = { VAL_STRING, VAL_LIST, VAL_DICT, VAL_STRUCT };
+    for(int i = 0; i < (int)(sizeof(kinds) / sizeof(kinds[0])); i++) {
+        fprintf(fp, "%s\n    \"%s\": %llu", sep, val_type_to_str(kinds[i]), (unsigned long long)total->allocs[kinds[i]]);
+        sep = ",";
+    }
+    fprintf(fp, "\n  }\n}\n");
+}
+
+/*
+ * Add up the counts of all threads and write them. This reads the counts
+ * of other threads, so it runs at exit.
+ */
+static void save_exec_counts(void) {
+
+    exec_counts_t total;
+    memset(&total, 0, sizeof(exec_counts_t));
+    total.calls = _ALLOC_ARRAY(uint64_t, counted->nfunctions);
+    total.loops = _ALLOC_ARRAY(uint64_t*, counted->nfunctions);
+    memset(total.calls, 0, sizeof(uint64_t) * counted->nfunctions);
+    memset(total.loops, 0, sizeof(uint64_t*) * counted->nfunctions);
+
+    int threads = 0;
+    for(exec_counts_t* counts = atomic_load(&all_counts); counts != NULL; counts = counts->next) {
+        for(int i = 0; i < OP_COUNT; i++)
+            total.ops[i] += counts->ops[i];
+        for(int i = 0; i <= VAL_ITER; i++)
+            total.allocs[i] += counts->allocs[i];
+        for(int i = 0; i < counted->nfunctions; i++) {
+            total.calls[i] += counts->calls[i];
+            if(counts->loops[i] == NULL)
+                continue;
+            if(total.loops[i] == NULL)
+                total.loops[i] = create_loop_counts(&total, i);
+            for(int pc = 0; pc <= counted->functions[i].len; pc++)
+                total.loops[i][pc] += counts->loops[i][pc];
+        }
+
+        // saving adds to what is in the file, so the threads add up there
+        if(profile_name != NULL)
+            save_opcode_profile(counts->profile, profile_name);
+        threads++;
+    }
+
+    FILE* fp = fopen(json_name, "w");
+    if(fp == NULL)
+        fprintf(stderr, "counts: cannot open output file: %s: %s\n", json_name, strerror(errno));
+    else {
+        write_json(fp, &total, threads);
+        fclose(fp);
+    }
+
+    for(int i = 0; i < counted->nfunctions; i++)
+        if(total.loops[i] != NULL)
+            _FREE(total.loops[i]);
+    _FREE(total.loops);
+    _FREE(total.calls);
+}
+
+/*
+ * public interface
+ */
+
+exec_counts_t* create_local_counts(void) {
+
+    ASSERT(counted != NULL, "counting before start_exec_counts()");
+
+    exec_counts_t* counts = _ALLOC_TYPE(exec_counts_t);
+    memset(counts, 0, sizeof(exec_counts_t));
+    counts->calls = _ALLOC_ARRAY(uint64_t, counted->nfunctions);
+    counts->loops = _ALLOC_ARRAY(uint64_t*, counted->nfunctions);
+    memset(counts->calls, 0, sizeof(uint64_t) * counted->nfunctions);
+    memset(counts->loops, 0, sizeof(uint64_t*) * counted->nfunctions);
+    counts->profile = create_opcode_profile();
+
+    counts->next = atomic_load(&all_counts);
+    while(!atomic_compare_exchange_weak(&all_counts, &counts->next, counts))
+        ;
+
+    local_counts = counts;
+    return counts;
+}
+
+uint64_t* create_loop_counts(exec_counts_t* counts, int func) {
+
+    int len = counted->functions[func].len + 1;
+
+    counts->loops[func] = _ALLOC_ARRAY(uint64_t, len);
+    memset(counts->loops[func], 0, sizeof(uint64_t) * len);
+
+    return counts->loops[func];
+}
+
+/*
+ * Count the run of a module, and write the counts to json when the program
+ * exits. The opcode runs are added to the profile file when it is not
+ * NULL. Only one module is counted.
+ */
+bool start_exec_counts(module_t* mod, const char* json, const char* profile) {
+
+    if(counted != NULL)
+        return false;
+
+    counted = mod;
+    json_name = json;
+    profile_name = profile;
+    atexit(save_exec_counts);
+
+    return true;
+}
+
+#else /* EXEC_COUNTS */
+
+bool start_exec_counts(module_t* mod, const char* json, const char* profile) {
+
+    (void)mod;
+    (void)profile;
+    fprintf(stderr, "counts: not written to %s, use the counts build\n", json);
+
+    return false;
+}
+
+#endif /* EXEC_COUNTS */
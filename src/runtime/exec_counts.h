@@ -0,0 +1,98 @@
+/**
+ * @file exec_counts.h
+ *
+ * @brief Exact counts of what the VM does: how often each opcode runs, the
+ * calls of each function, the passes of each loop and the strings, lists,
+ * dicts and structs that are made. The counts are written as JSON when the
+ * program exits. The runs of opcodes go to an opcode profile too, which is
+ * what scripts/superinstructions reads.
+ *
+ * This is the "counts" build type, which defines EXEC_COUNTS. In any other
+ * build the COUNT_ macros are empty, and start_exec_counts() only says
+ * that the counts are not there.
+ *
+ * Every thread counts into its own exec_counts_t, which is made the first
+ * time it counts something and is pushed on a list of all of them with a
+ * compare and swap. They are added up at exit. A loop is known by the
+ * position of its top, which is where its backward jumps go, so the VM
+ * counts a pass every time it takes a backward jump.
+ *
+ */
+#ifndef _EXEC_COUNTS_H_
+#define _EXEC_COUNTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "module.h"
+#include "value.h"
+
+bool start_exec_counts(module_t* mod, const char* json, const char* profile);
+
+#ifdef EXEC_COUNTS
+
+#include "opcode_profile.h"
+
+typedef struct _exec_counts_t_ {
+    uint64_t ops[OP_COUNT];
+    uint64_t allocs[VAL_ITER + 1];
+    // by function index
+    uint64_t* calls;
+    // by function index, then by the position of the loop top, made when
+    // the function first loops
+    uint64_t** loops;
+    opcode_profile_t* profile;
+    struct _exec_counts_t_* next;
+} exec_counts_t;
+
+extern _Thread_local exec_counts_t* local_counts;
+
+exec_counts_t* create_local_counts(void);
+uint64_t* create_loop_counts(exec_counts_t* counts, int func);
+
+static inline exec_counts_t* get_local_counts(void) {
+
+    return (local_counts != NULL) ? local_counts : create_local_counts();
+}
+
+static inline void count_exec_op(opcode_t op) {
+
+    exec_counts_t* counts = get_local_counts();
+
+    counts->ops[op]++;
+    count_opcode(counts->profile, op);
+}
+
+static inline void count_exec_call(int func) {
+
+    exec_counts_t* counts = get_local_counts();
+
+    counts->calls[func]++;
+    break_opcode_run(counts->profile);
+}
+
+static inline void count_exec_loop(int func, int top) {
+
+    exec_counts_t* counts = get_local_counts();
+    uint64_t* loops = (counts->loops[func] != NULL) ? counts->loops[func] : create_loop_counts(counts, func);
+
+    loops[top]++;
+}
+
+#define COUNT_OP(op) count_exec_op(op)
+#define COUNT_CALL(func) count_exec_call(func)
+#define COUNT_RETURN() break_opcode_run(get_local_counts()->profile)
+#define COUNT_LOOP(func, top) count_exec_loop((func), (top))
+#define COUNT_ALLOC(type) (get_local_counts()->allocs[type]++)
+
+#else /* EXEC_COUNTS */
+
+#define COUNT_OP(op) ((void)0)
+#define COUNT_CALL(func) ((void)0)
+#define COUNT_RETURN() ((void)0)
+#define COUNT_LOOP(func, top) ((void)0)
+#define COUNT_ALLOC(type) ((void)0)
+
+#endif /* EXEC_COUNTS */
+
+#endif /* _EXEC_COUNTS_H_ */
@@ -0,0 +1,411 @@
+/**
+ * @file ffi.c
+ *
+ * @brief Binding and calling C functions.
+ *
+ * The C type of a function is one of a fixed set of shapes. Every parameter
+ * is passed either in an integer word or as a double, so with up to
+ * FFI_MAX_PARAMS parameters there are 31 parameter shapes, and each of them
+ * has an invoker for every kind of return value. Binding computes the shape
+ * from the signature and keeps the invoker, which is the only per function
+ * state a call needs.
+ *
+ * The shape of a signature is numbered by its length n and a mask with a
+ * bit set for every double parameter: (1 << n) - 1 + mask. FFI_SHAPES has to
+ * list the shapes in that order.
+ *
+ * Ints, strings and bools are all passed in an int64_t word. That is the
+ * same as passing a long or a pointer on the 64 bit ABIs this runs on.
+ *
+ * Benchmark build string:
+ * gcc -O2 -DBENCH_FFI -I../common -o bff ffi.c module.c format.c opcodes.c value.c ../common/alloc.c -ldl -lm
+ */
+#define _GNU_SOURCE // for RTLD_DEFAULT
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "ffi.h"
+
+// #define BENCH_FFI
+
+_Static_assert(sizeof(void*) == sizeof(int64_t), "pointers have to fit in an int64_t word");
+
+typedef enum {
+    RET_NOTHING,
+    RET_INT,
+    RET_FLOAT,
+    RET_BOOL,
+    RET_STRING,
+    RET_COUNT
+} ret_kind_t;
+
+#define FFI_SHAPES(X) \
+    X(none, (void), ()) \
+    X(W, (int64_t), (a[0].ival)) \
+    X(D, (double), (a[0].fval)) \
+    X(WW, (int64_t, int64_t), (a[0].ival, a[1].ival)) \
+    X(DW, (double, int64_t), (a[0].fval, a[1].ival)) \
+    X(WD, (int64_t, double), (a[0].ival, a[1].fval)) \
+    X(DD, (double, double), (a[0].fval, a[1].fval)) \
+    X(WWW, (int64_t, int64_t, int64_t), (a[0].ival, a[1].ival, a[2].ival)) \
+    X(DWW, (double, int64_t, int64_t), (a[0].fval, a[1].ival, a[2].ival)) \
+    X(WDW, (int64_t, double, int64_t), (a[0].ival, a[1].fval, a[2].ival)) \
+    X(DDW, (double, double, int64_t), (a[0].fval, a[1].fval, a[2].ival)) \
+    X(WWD, (int64_t, int64_t, double), (a[0].ival, a[1].ival, a[2].fval)) \
+    X(DWD, (double, int64_t, double), (a[0].fval, a[1].ival, a[2].fval)) \
+    X(WDD, (int64_t, double, double), (a[0].ival, a[1].fval, a[2].fval)) \
+    X(DDD, (double, double, double), (a[0].fval, a[1].fval, a[2].fval)) \
+    X(WWWW, (int64_t, int64_t, int64_t, int64_t), (a[0].ival, a[1].ival, a[2].ival, a[3].ival)) \
+    X(DWWW, (double, int64_t, int64_t, int64_t), (a[0].fval, a[1].ival, a[2].ival, a[3].ival)) \
+    X(WDWW, (int64_t, double, int64_t, int64_t), (a[0].ival, a[1].fval, a[2].ival, a[3].ival)) \
+    X(DDWW, (double, double, int64_t, int64_t), (a[0].fval, a[1].fval, a[2].ival, a[3].ival)) \
+    X(WWDW, (int64_t, int64_t, double, int64_t), (a[0].ival, a[1].ival, a[2].fval, a[3].ival)) \
+    X(DWDW, (double, int64_t, double, int64_t), (a[0].fval, a[1].ival, a[2].fval, a[3].ival)) \
+    X(WDDW, (int64_t, double, double, int64_t), (a[0].ival, a[1].fval, a[2].fval, a[3].ival)) \
+    X(DDDW, (double, double, double, int64_t), (a[0].fval, a[1].fval, a[2].fval, a[3].ival)) \
+    X(WWWD, (int64_t, int64_t, int64_t, double), (a[0].ival, a[1].ival, a[2].ival, a[3].fval)) \
+    X(DWWD, (double, int64_t, int64_t, double), (a[0].fval, a[1].ival, a[2].ival, a[3].fval)) \
+    X(WDWD, (int64_t, double, int64_t, double), (a[0].ival, a[1].fval, a[2].ival, a[3].fval)) \
+    X(DDWD, (double, double, int64_t, double), (a[0].fval, a[1].fval, a[2].ival, a[3].fval)) \
+    X(WWDD, (int64_t, int64_t, double, double), (a[0].ival, a[1].ival, a[2].fval, a[3].fval)) \
+    X(DWDD, (double, int64_t, double, double), (a[0].fval, a[1].ival, a[2].fval, a[3].fval)) \
+    X(WDDD, (int64_t, double, double, double), (a[0].ival, a[1].fval, a[2].fval, a[3].fval)) \
+    X(DDDD, (double, double, double, double), (a[0].fval, a[1].fval, a[2].fval, a[3].fval))
+
+#define FFI_SHAPE_COUNT 31
+
+#define DEFINE_INVOKERS(name, params, args)                                           \
+    static ffi_value_t invoke_n_##name(ffi_fn_t fn, const ffi_value_t* a) {            \
+        ffi_value_t r = { 0 };                                                        \
+        (void)a;                                                                      \
+        ((void(*) params)fn) args;                                                    \
+        return r;                                                                     \
+    }                                                                                 \
+    static ffi_value_t invoke_i_##name(ffi_fn_t fn, const ffi_value_t* a) {            \
+        ffi_value_t r;                                                                \
+        (void)a;                                                                      \
+        r.ival = ((int64_t(*) params)fn) args;                                        \
+        return r;                                                                     \
+    }                                                                                 \
+    static ffi_value_t invoke_f_##name(ffi_fn_t fn, const ffi_value_t* a) {            \
+        ffi_value_t r;                                                                \
+        (void)a;                                                                      \
+        r.fval = ((double(*) params)fn) args;                                         \
+        return r;                                                                     \
+    }                                                                                 \
+    static ffi_value_t invoke_b_##name(ffi_fn_t fn, const ffi_value_t* a) {            \
+        ffi_value_t r;                                                                \
+        (void)a;                                                                      \
+        r.ival = ((bool(*) params)fn) args ? 1 : 0;                                   \
+        return r;                                                                     \
+    }                                                                                 \
+    static ffi_value_t invoke_s_##name(ffi_fn_t fn, const ffi_value_t* a) {            \
+        ffi_value_t r;                                                                \
+        (void)a;                                                                      \
+        r.sval = ((const char* (*)params)fn) args;                                    \
+        return r;                                                                     \
+    }
+
+FFI_SHAPES(DEFINE_INVOKERS)
+
+#define ENTRY_N(name, params, args) invoke_n_##name,
+#define ENTRY_I(name, params, args) invoke_i_##name,
+#define ENTRY_F(name, params, args) invoke_f_##name,
+#define ENTRY_B(name, params, args) invoke_b_##name,
+#define ENTRY_S(name, params, args) invoke_s_##name,
+
+static const ffi_invoker_t invokers[RET_COUNT][FFI_SHAPE_COUNT] = {
+    [RET_NOTHING] = { FFI_SHAPES(ENTRY_N) },
+    [RET_INT] = { FFI_SHAPES(ENTRY_I) },
+    [RET_FLOAT] = { FFI_SHAPES(ENTRY_F) },
+    [RET_BOOL] = { FFI_SHAPES(ENTRY_B) },
+    [RET_STRING] = { FFI_SHAPES(ENTRY_S) },
+};
+
+/*
+ * Return true if a value of the type can cross into C.
+ */
+bool ffi_type_ok(value_type_t type, bool is_return) {
+
+    switch(type) {
+        case VAL_BOOL:
+        case VAL_INT:
+        case VAL_FLOAT:
+        case VAL_STRING:
+            return true;
+        case VAL_NOTHING:
+            return is_return;
+        default:
+            return false;
+    }
+}
+
+static int shape_index(const value_type_t* params, int nparams) {
+
+    int mask = 0;
+    for(int i = 0; i < nparams; i++)
+        if(params[i] == VAL_FLOAT)
+            mask |= 1 << i;
+
+    return (1 << nparams) - 1 + mask;
+}
+
+static ret_kind_t ret_kind(value_type_t type) {
+
+    return (type == VAL_INT)    ? RET_INT :
+            (type == VAL_FLOAT)  ? RET_FLOAT :
+            (type == VAL_BOOL)   ? RET_BOOL :
+            (type == VAL_STRING) ? RET_STRING :
+                                   RET_NOTHING;
+}
+
+/*
+ * Bind the address of a C function to its signature. Return NULL if the
+ * signature can not be called.
+ */
+ffi_func_t* ffi_bind(void* sym, value_type_t ret, const value_type_t* params, int nparams) {
+
+    if(sym == NULL || nparams > FFI_MAX_PARAMS || !ffi_type_ok(ret, true))
+        return NULL;
+
+    for(int i = 0; i < nparams; i++)
+        if(!ffi_type_ok(params[i], false))
+            return NULL;
+
+    ffi_func_t* func = _ALLOC_TYPE(ffi_func_t);
+    // ISO C has no cast from an object pointer to a function pointer
+    memcpy(&func->fn, &sym, sizeof(func->fn));
+    func->invoke = invokers[ret_kind(ret)][shape_index(params, nparams)];
+    func->nparams = nparams;
+
+    return func;
+}
+
+/*
+ * Load the libraries of the module and bind all of its C functions. A
+ * symbol is looked up in the libraries in the order they were imported,
+ * then in the libraries that are already loaded, which include the C
+ * library. Return NULL, or a message about the first thing that failed.
+ */
+const char* bind_foreign(module_t* mod) {
+
+    static char msg[256];
+
+    if(mod->nlibs > 0 && mod->handles == NULL) {
+        mod->handles = _ALLOC_ARRAY(void*, mod->nlibs);
+        memset(mod->handles, 0, sizeof(void*) * mod->nlibs);
+    }
+
+    for(int i = 0; i < mod->nlibs; i++) {
+        if(mod->handles[i] != NULL)
+            continue;
+
+        mod->handles[i] = dlopen(mod->libs[i], RTLD_NOW | RTLD_LOCAL);
+        if(mod->handles[i] == NULL) {
+            snprintf(msg, sizeof(msg), "cannot load library: %s", dlerror());
+            return msg;
+        }
+    }
+
+    for(int i = 0; i < mod->nfunctions; i++) {
+        foreign_t* foreign = mod->functions[i].foreign;
+        if(foreign == NULL || foreign->bound != NULL)
+            continue;
+
+        void* sym = NULL;
+        for(int j = 0; j < mod->nlibs && sym == NULL; j++)
+            sym = dlsym(mod->handles[j], foreign->symbol);
+        if(sym == NULL)
+            sym = dlsym(RTLD_DEFAULT, foreign->symbol);
+        if(sym == NULL) {
+            snprintf(msg, sizeof(msg), "undefined C function: %s", foreign->symbol);
+            return msg;
+        }
+
+        foreign->bound = ffi_bind(sym, foreign->ret, foreign->params, mod->functions[i].nparams);
+        if(foreign->bound == NULL) {
+            snprintf(msg, sizeof(msg), "cannot call C function %s with this signature", foreign->symbol);
+            return msg;
+        }
+    }
+
+    return NULL;
+}
+
+void unbind_foreign(module_t* mod) {
+
+    for(int i = 0; i < mod->nfunctions; i++) {
+        foreign_t* foreign = mod->functions[i].foreign;
+        if(foreign != NULL && foreign->bound != NULL) {
+            _FREE(foreign->bound);
+            foreign->bound = NULL;
+        }
+    }
+
+    if(mod->handles != NULL) {
+        for(int i = 0; i < mod->nlibs; i++)
+            if(mod->handles[i] != NULL)
+                dlclose(mod->handles[i]);
+        _FREE(mod->handles);
+        mod->handles = NULL;
+    }
+}
+
+/*
+ * Benchmark a bound call against calling C directly and against a call
+ * that converts its arguments and works out the signature every time.
+ */
+#ifdef BENCH_FFI
+
+#include <math.h>
+#include <time.h>
+
+/*
+ * What a call costs when nothing is done at bind time. The strings are
+ * copied because the callee is not trusted with the VM's memory.
+ */
+static ffi_value_t naive_call(void* sym, value_type_t ret, const value_type_t* params, int nparams,
+                              const ffi_value_t* args) {
+
+    ffi_value_t copy[FFI_MAX_PARAMS];
+
+    for(int i = 0; i < nparams; i++) {
+        if(!ffi_type_ok(params[i], false))
+            FATAL("bad parameter type");
+        if(params[i] == VAL_STRING)
+            copy[i].sval = _COPY_STRING(args[i].sval);
+        else
+            copy[i] = args[i];
+    }
+
+    ffi_fn_t fn;
+    memcpy(&fn, &sym, sizeof(fn));
+    ffi_value_t result = invokers[ret_kind(ret)][shape_index(params, nparams)](fn, copy);
+
+    for(int i = 0; i < nparams; i++)
+        if(params[i] == VAL_STRING)
+            _FREE(copy[i].sval);
+
+    return result;
+}
+
+static double elapsed(struct timespec* start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void report(const char* name, double direct, double bound, double naive, int count) {
+
+    printf("%-8s direct: %6.1f M/sec  bound: %6.1f M/sec  naive: %6.1f M/sec\n", name, count / direct / 1e6,
+           count / bound / 1e6, count / naive / 1e6);
+}
+
+int main(void) {
+
+    const int count = 20000000;
+    struct timespec start;
+    volatile int64_t isink = 0;
+    volatile double fsink = 0;
+
+    // int64_t labs(int64_t)
+    {
+        value_type_t params[] = { VAL_INT };
+        void* sym = dlsym(RTLD_DEFAULT, "labs");
+        ffi_func_t* func = ffi_bind(sym, VAL_INT, params, 1);
+        long (*volatile direct_fn)(long) = labs;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++)
+            isink += direct_fn(-i);
+        double direct = elapsed(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++) {
+            ffi_value_t args[1] = { { .ival = -i } };
+            isink += ffi_call(func, args).ival;
+        }
+        double bound = elapsed(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++) {
+            ffi_value_t args[1] = { { .ival = -i } };
+            isink += naive_call(sym, VAL_INT, params, 1, args).ival;
+        }
+        double naive = elapsed(&start);
+
+        report("labs", direct, bound, naive, count);
+        _FREE(func);
+    }
+
+    // double hypot(double, double)
+    {
+        value_type_t params[] = { VAL_FLOAT, VAL_FLOAT };
+        void* sym = dlsym(RTLD_DEFAULT, "hypot");
+        ffi_func_t* func = ffi_bind(sym, VAL_FLOAT, params, 2);
+        double (*volatile direct_fn)(double, double) = hypot;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++)
+            fsink += direct_fn(i, 4.0);
+        double direct = elapsed(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++) {
+            ffi_value_t args[2] = { { .fval = i }, { .fval = 4.0 } };
+            fsink += ffi_call(func, args).fval;
+        }
+        double bound = elapsed(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++) {
+            ffi_value_t args[2] = { { .fval = i }, { .fval = 4.0 } };
+            fsink += naive_call(sym, VAL_FLOAT, params, 2, args).fval;
+        }
+        double naive = elapsed(&start);
+
+        report("hypot", direct, bound, naive, count);
+        _FREE(func);
+    }
+
+    // size_t strlen(const char*)
+    {
+        const char* str = "the quick brown fox jumps over the lazy dog";
+        value_type_t params[] = { VAL_STRING };
+        void* sym = dlsym(RTLD_DEFAULT, "strlen");
+        ffi_func_t* func = ffi_bind(sym, VAL_INT, params, 1);
+        size_t (*volatile direct_fn)(const char*) = strlen;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++)
+            isink += direct_fn(str);
+        double direct = elapsed(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++) {
+            ffi_value_t args[1] = { { .sval = str } };
+            isink += ffi_call(func, args).ival;
+        }
+        double bound = elapsed(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < count; i++) {
+            ffi_value_t args[1] = { { .sval = str } };
+            isink += naive_call(sym, VAL_INT, params, 1, args).ival;
+        }
+        double naive = elapsed(&start);
+
+        report("strlen", direct, bound, naive, count);
+        _FREE(func);
+    }
+
+    printf("(%lld %g)\n", (long long)isink, fsink);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * @file ffi.h
+ *
+ * @brief Calling C functions in shared libraries.
+ *
+ * A function is bound once, when the module is loaded. Binding looks up the
+ * symbol and picks an invoker that calls it through a pointer of the exact
+ * C type of its signature, so a call does not look at the signature again.
+ * Arguments are passed as they are held by the VM: ints as int64_t, floats
+ * as double, strings as a pointer to the characters and bools as an int64_t
+ * that is 0 or 1. Nothing is copied on the way in. A string that C returns
+ * belongs to C and has to be copied by the caller if it is kept.
+ *
+ * An int that C returns is read as the whole int64_t, so a C function that
+ * is declared to return an int has to return an int64_t or a long. A C int
+ * only sets the low half of the register and the high half is garbage.
+ * Wrap such a function in one that returns a long to call it.
+ *
+ */
+#ifndef _FFI_H_
+#define _FFI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "value.h"
+#include "module.h"
+
+// the most parameters a C function can have
+#define FFI_MAX_PARAMS 4
+
+typedef union {
+    int64_t ival;
+    double fval;
+    const char* sval;
+} ffi_value_t;
+
+typedef void (*ffi_fn_t)(void);
+typedef ffi_value_t (*ffi_invoker_t)(ffi_fn_t fn, const ffi_value_t* args);
+
+typedef struct _ffi_func_t_ {
+    ffi_fn_t fn;
+    ffi_invoker_t invoke;
+    int nparams;
+} ffi_func_t;
+
+bool ffi_type_ok(value_type_t type, bool is_return);
+
+ffi_func_t* ffi_bind(void* sym, value_type_t ret, const value_type_t* params, int nparams);
+
+static inline ffi_value_t ffi_call(ffi_func_t* func, const ffi_value_t* args) {
+
+    return func->invoke(func->fn, args);
+}
+
+const char* bind_foreign(module_t* mod);
+void unbind_foreign(module_t* mod);
+
+#endif /* _FFI_H_ */
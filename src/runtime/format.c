@@ -0,0 +1,444 @@
+/**
+ * @file format.c
+ *
+ * @brief Compiling and rendering format programs.
+ *
+ * A template such as "x = {x}, y = {y}" is compiled into the segments
+ * LITERAL "x = ", INT 0, LITERAL ", y = ", FLOAT 1, where the numbers are
+ * the positions of the values on the stack. "{{" and "}}" are literal
+ * braces, and a "}" on its own is copied as it is.
+ *
+ * Rendering measures every slot first, then allocates the result once and
+ * copies the pieces into it. Numbers are converted into a scratch buffer
+ * while measuring so they are only converted once.
+ *
+ * Benchmark build string:
+ * gcc -O2 -DBENCH_FORMAT -I../common -o bf format.c value.c ../common/alloc.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "format.h"
+
+// #define BENCH_FORMAT
+
+// large enough for any int64_t and for a float in "%g" form
+#define FMT_NUM_SIZE 32
+// slots that can be measured without allocating scratch space
+#define FMT_STACK_SLOTS 16
+
+static fmt_kind_t slot_kind(value_type_t type) {
+
+    switch(type) {
+        case VAL_BOOL:
+            return FMT_BOOL;
+        case VAL_INT:
+            return FMT_INT;
+        case VAL_FLOAT:
+            return FMT_FLOAT;
+        case VAL_STRING:
+            return FMT_STRING;
+        default:
+            return FMT_VALUE;
+    }
+}
+
+static void add_segment(format_t* fmt, int* cap, fmt_kind_t kind, int offset, int len, int arg) {
+
+    if(kind == FMT_LITERAL && len == 0)
+        return;
+
+    // adjacent literals happen around "{{"
+    if(kind == FMT_LITERAL && fmt->nsegs > 0 && fmt->segs[fmt->nsegs - 1].kind == FMT_LITERAL) {
+        fmt->segs[fmt->nsegs - 1].len += len;
+        return;
+    }
+
+    if(fmt->nsegs + 1 > *cap) {
+        *cap = (*cap == 0) ? 4 : *cap << 1;
+        fmt->segs = _REALLOC_ARRAY(fmt->segs, fmt_segment_t, *cap);
+    }
+
+    fmt->segs[fmt->nsegs].kind = kind;
+    fmt->segs[fmt->nsegs].offset = offset;
+    fmt->segs[fmt->nsegs].len = len;
+    fmt->segs[fmt->nsegs].arg = arg;
+    fmt->nsegs++;
+}
+
+/*
+ * Compile the template. The names and types are those of the values that
+ * the caller will pass to the renderer, in the same order. Return NULL, or
+ * a message about the first placeholder that could not be compiled. The
+ * message is overwritten by the next call.
+ */
+const char* compile_format(format_t* fmt, const char* tmpl, const char** names, const value_type_t* types,
+                           int nargs) {
+
+    static char msg[128];
+    int cap = 0;
+
+    memset(fmt, 0, sizeof(format_t));
+    fmt->nargs = nargs;
+    // the text never gets longer than the template
+    fmt->text = _ALLOC(strlen(tmpl) + 1);
+
+    const char* ptr = tmpl;
+    int start = 0;
+    while(*ptr != '\0') {
+        if(*ptr == '}' && ptr[1] == '}') {
+            fmt->text[fmt->text_len++] = '}';
+            ptr += 2;
+            continue;
+        }
+
+        if(*ptr != '{') {
+            fmt->text[fmt->text_len++] = *ptr++;
+            continue;
+        }
+
+        if(ptr[1] == '{') {
+            fmt->text[fmt->text_len++] = '{';
+            ptr += 2;
+            continue;
+        }
+
+        const char* name = ptr + 1;
+        const char* end = strchr(name, '}');
+        if(end == NULL) {
+            snprintf(msg, sizeof(msg), "unterminated placeholder \"%.32s\"", ptr);
+            free_format(fmt);
+            return msg;
+        }
+
+        int len = (int)(end - name);
+        int arg = -1;
+        for(int i = 0; i < nargs; i++) {
+            if((int)strlen(names[i]) == len && strncmp(names[i], name, len) == 0) {
+                arg = i;
+                break;
+            }
+        }
+        if(arg < 0) {
+            snprintf(msg, sizeof(msg), "no value for placeholder \"{%.*s}\"", (len > 32) ? 32 : len, name);
+            free_format(fmt);
+            return msg;
+        }
+
+        add_segment(fmt, &cap, FMT_LITERAL, start, fmt->text_len - start, 0);
+        add_segment(fmt, &cap, slot_kind(types[arg]), 0, 0, arg);
+        start = fmt->text_len;
+        ptr = end + 1;
+    }
+
+    add_segment(fmt, &cap, FMT_LITERAL, start, fmt->text_len - start, 0);
+    fmt->text[fmt->text_len] = '\0';
+
+    return NULL;
+}
+
+void free_format(format_t* fmt) {
+
+    if(fmt->text != NULL)
+        _FREE(fmt->text);
+    if(fmt->segs != NULL)
+        _FREE(fmt->segs);
+    memset(fmt, 0, sizeof(format_t));
+}
+
+/*
+ * Convert a non-negative number to decimal at the end of the buffer and
+ * return the first character.
+ */
+static char* int_to_text(int64_t value, char* end) {
+
+    // negate in unsigned so that INT64_MIN works
+    uint64_t v = (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+
+    do {
+        *--end = (char)('0' + v % 10);
+        v /= 10;
+    } while(v != 0);
+
+    if(value < 0)
+        *--end = '-';
+
+    return end;
+}
+
+/*
+ * Find the text of one slot. Numbers are written into num, which has
+ * FMT_NUM_SIZE bytes.
+ */
+static const char* slot_text(fmt_kind_t kind, const fmt_arg_t* arg, char* num, int* len) {
+
+    if(kind == FMT_VALUE) {
+        switch(arg->type) {
+            case VAL_BOOL:
+                kind = FMT_BOOL;
+                break;
+            case VAL_INT:
+                kind = FMT_INT;
+                break;
+            case VAL_FLOAT:
+                kind = FMT_FLOAT;
+                break;
+            case VAL_STRING:
+                kind = FMT_STRING;
+                break;
+            default:
+                *len = snprintf(num, FMT_NUM_SIZE, "<%s>", val_type_to_str(arg->type));
+                return num;
+        }
+    }
+
+    ASSERT(slot_kind(arg->type) == kind, "format slot %s got a %s", fmt_kind_to_str(kind),
+           val_type_to_str(arg->type));
+
+    switch(kind) {
+        case FMT_BOOL:
+            *len = arg->bval ? 4 : 5;
+            return arg->bval ? "true" : "false";
+        case FMT_INT: {
+            char* str = int_to_text(arg->ival, num + FMT_NUM_SIZE);
+            *len = (int)(num + FMT_NUM_SIZE - str);
+            return str;
+        }
+        case FMT_FLOAT:
+            *len = snprintf(num, FMT_NUM_SIZE, "%g", arg->fval);
+            return num;
+        case FMT_STRING:
+            *len = (int)strlen(arg->sval);
+            return arg->sval;
+        default:
+            FATAL("invalid format slot: %d", kind);
+    }
+}
+
+/*
+ * Render the program with the given values. The result is allocated and
+ * belongs to the caller. The length is returned in len if it is not NULL.
+ */
+char* render_format(format_t* fmt, const fmt_arg_t* args, int* len) {
+
+    const char* stack_text[FMT_STACK_SLOTS];
+    int stack_lens[FMT_STACK_SLOTS];
+    char stack_nums[FMT_STACK_SLOTS][FMT_NUM_SIZE];
+
+    const char** text = stack_text;
+    int* lens = stack_lens;
+    char (*nums)[FMT_NUM_SIZE] = stack_nums;
+
+    if(fmt->nsegs > FMT_STACK_SLOTS) {
+        text = _ALLOC_ARRAY(const char*, fmt->nsegs);
+        lens = _ALLOC_ARRAY(int, fmt->nsegs);
+        nums = _ALLOC(sizeof(char[FMT_NUM_SIZE]) * fmt->nsegs);
+    }
+
+    // the literal text is known at compile time
+    int total = fmt->text_len;
+    for(int i = 0; i < fmt->nsegs; i++) {
+        fmt_segment_t* seg = &fmt->segs[i];
+        if(seg->kind == FMT_LITERAL)
+            continue;
+
+        ASSERT(seg->arg >= 0 && seg->arg < fmt->nargs, "format argument out of range: %d", seg->arg);
+        text[i] = slot_text(seg->kind, &args[seg->arg], nums[i], &lens[i]);
+        total += lens[i];
+    }
+
+    char* buf = _ALLOC(total + 1);
+    char* ptr = buf;
+    for(int i = 0; i < fmt->nsegs; i++) {
+        fmt_segment_t* seg = &fmt->segs[i];
+        if(seg->kind == FMT_LITERAL) {
+            memcpy(ptr, &fmt->text[seg->offset], seg->len);
+            ptr += seg->len;
+        }
+        else {
+            memcpy(ptr, text[i], lens[i]);
+            ptr += lens[i];
+        }
+    }
+    *ptr = '\0';
+
+    if(text != stack_text) {
+        _FREE(text);
+        _FREE(lens);
+        _FREE(nums);
+    }
+
+    if(len != NULL)
+        *len = total;
+
+    return buf;
+}
+
+const char* fmt_kind_to_str(fmt_kind_t kind) {
+
+    return (kind == FMT_LITERAL) ? "literal" :
+            (kind == FMT_BOOL)   ? "bool" :
+            (kind == FMT_INT)    ? "int" :
+            (kind == FMT_FLOAT)  ? "float" :
+            (kind == FMT_STRING) ? "string" :
+            (kind == FMT_VALUE)  ? "value" :
+                                   "UNKNOWN";
+}
+
+void dump_format(FILE* fp, format_t* fmt) {
+
+    fprintf(fp, "(args: %d)", fmt->nargs);
+    for(int i = 0; i < fmt->nsegs; i++) {
+        fmt_segment_t* seg = &fmt->segs[i];
+        if(seg->kind == FMT_LITERAL)
+            fprintf(fp, " \"%.*s\"", seg->len, &fmt->text[seg->offset]);
+        else
+            fprintf(fp, " {%s %d}", fmt_kind_to_str(seg->kind), seg->arg);
+    }
+}
+
+/*
+ * Benchmark the format programs against interpreting the template every
+ * time it is rendered, which is what OP_FORMAT did before the templates
+ * were compiled.
+ */
+#ifdef BENCH_FORMAT
+
+#include <time.h>
+
+/*
+ * Look up each placeholder by name and grow the result as it goes.
+ */
+static char* naive_format(const char* tmpl, const char** names, const fmt_arg_t* args, int nargs) {
+
+    int cap = 16;
+    int len = 0;
+    char* buf = _ALLOC(cap);
+    char num[FMT_NUM_SIZE];
+
+    for(const char* ptr = tmpl; *ptr != '\0';) {
+        const char* str = ptr;
+        int slen = 1;
+
+        if((*ptr == '{' || *ptr == '}') && ptr[1] == *ptr)
+            ptr += 2;
+        else if(*ptr == '{') {
+            const char* end = strchr(ptr, '}');
+            int n = (int)(end - ptr - 1);
+            const fmt_arg_t* arg = NULL;
+            for(int i = 0; i < nargs; i++)
+                if((int)strlen(names[i]) == n && strncmp(names[i], ptr + 1, n) == 0)
+                    arg = &args[i];
+
+            switch(arg->type) {
+                case VAL_BOOL:
+                    str = arg->bval ? "true" : "false";
+                    slen = (int)strlen(str);
+                    break;
+                case VAL_INT:
+                    slen = snprintf(num, sizeof(num), "%lld", (long long)arg->ival);
+                    str = num;
+                    break;
+                case VAL_FLOAT:
+                    slen = snprintf(num, sizeof(num), "%g", arg->fval);
+                    str = num;
+                    break;
+                default:
+                    str = arg->sval;
+                    slen = (int)strlen(str);
+                    break;
+            }
+            ptr = end + 1;
+        }
+        else
+            ptr++;
+
+        while(len + slen + 1 > cap) {
+            cap <<= 1;
+            buf = _REALLOC(buf, cap);
+        }
+        memcpy(&buf[len], str, slen);
+        len += slen;
+    }
+
+    buf[len] = '\0';
+    return buf;
+}
+
+static double elapsed(struct timespec* start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(void) {
+
+    const char* tmpl = "{{record}} name: {name}, id: {id}, score: {score}, active: {active}, "
+                       "tag: {name}-{id}";
+    const char* names[] = { "name", "id", "score", "active" };
+    value_type_t types[] = { VAL_STRING, VAL_INT, VAL_FLOAT, VAL_BOOL };
+    fmt_arg_t args[4] = {
+        { .type = VAL_STRING, .sval = "widget" },
+        { .type = VAL_INT, .ival = 0 },
+        { .type = VAL_FLOAT, .fval = 0.0 },
+        { .type = VAL_BOOL, .bval = true },
+    };
+    const int count = 2000000;
+
+    format_t fmt;
+    const char* err = compile_format(&fmt, tmpl, names, types, 4);
+    if(err != NULL)
+        FATAL("%s", err);
+
+    printf("program:  ");
+    dump_format(stdout, &fmt);
+    printf("\n");
+
+    char* expect = naive_format(tmpl, names, args, 4);
+    char* got = render_format(&fmt, args, NULL);
+    printf("result:   %s\n", got);
+    if(strcmp(expect, got) != 0)
+        FATAL("the two renderers do not agree: \"%s\"", expect);
+    _FREE(expect);
+    _FREE(got);
+
+    size_t check = 0;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < count; i++) {
+        args[1].ival = i;
+        args[2].fval = i * 0.25;
+        char* str = naive_format(tmpl, names, args, 4);
+        check += strlen(str);
+        _FREE(str);
+    }
+    double naive = elapsed(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < count; i++) {
+        args[1].ival = i;
+        args[2].fval = i * 0.25;
+        int len;
+        char* str = render_format(&fmt, args, &len);
+        check -= len;
+        _FREE(str);
+    }
+    double compiled = elapsed(&start);
+
+    if(check != 0)
+        FATAL("the two renderers do not agree");
+
+    printf("naive:    %.3f sec, %.0f per sec\n", naive, count / naive);
+    printf("compiled: %.3f sec, %.0f per sec\n", compiled, count / compiled);
+    printf("speedup:  %.2fx\n", naive / compiled);
+
+    free_format(&fmt);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file format.h
+ *
+ * @brief Format programs. The compiler parses the template of a formatted
+ * string once and stores the result in the module as a list of literal
+ * segments and substitution slots. The slots know the static type of the
+ * value that goes in them, so rendering does not look at the template and
+ * only dispatches on the type tag when the compiler could not know it.
+ *
+ */
+#ifndef _FORMAT_H_
+#define _FORMAT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "value.h"
+
+typedef enum {
+    FMT_LITERAL,
+    FMT_BOOL,
+    FMT_INT,
+    FMT_FLOAT,
+    FMT_STRING,
+    // type known only at run time
+    FMT_VALUE,
+} fmt_kind_t;
+
+typedef struct {
+    fmt_kind_t kind;
+    // literal: offset and length in the text, slot: argument index
+    int offset;
+    int len;
+    int arg;
+} fmt_segment_t;
+
+typedef struct {
+    // literal text with the "{{" and "}}" escapes already removed
+    char* text;
+    int text_len;
+    fmt_segment_t* segs;
+    int nsegs;
+    // number of values the program expects on the stack
+    int nargs;
+} format_t;
+
+// A value handed to the renderer. This is the part of a run time value that
+// a format slot can display.
+typedef struct {
+    value_type_t type;
+    union {
+        bool bval;
+        int64_t ival;
+        double fval;
+        const char* sval;
+    };
+} fmt_arg_t;
+
+const char* compile_format(format_t* fmt, const char* tmpl, const char** names, const value_type_t* types,
+                           int nargs);
+void free_format(format_t* fmt);
+
+char* render_format(format_t* fmt, const fmt_arg_t* args, int* len);
+
+const char* fmt_kind_to_str(fmt_kind_t kind);
+void dump_format(FILE* fp, format_t* fmt);
+
+#endif /* _FORMAT_H_ */
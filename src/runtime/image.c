@@ -0,0 +1,588 @@
+/**
+ * @file image.c
+ *
+ * @brief Writing a module to a bytecode image and mapping it back in. See
+ * image.h for the layout.
+ *
+ * The loader checks that every offset in the image lands in the part that
+ * it should, so a damaged image is refused instead of crashing later. The
+ * code itself is not checked, it is trusted like the output of the
+ * compiler.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "hash.h"
+#include "image.h"
+#include "ffi.h"
+
+// the constant pool and the parameter lists are used in place
+_Static_assert(sizeof(constant_t) == 16, "a constant has to be 16 bytes");
+_Static_assert(sizeof(value_type_t) == sizeof(int32_t), "a value type has to be 32 bits");
+_Static_assert(sizeof(fmt_segment_t) == 4 * sizeof(int32_t), "a format segment has to be four words");
+_Static_assert(sizeof(image_header_t) % 8 == 0, "the header has to end on an 8 byte boundary");
+
+#define BYTE_ORDER_MARK 0x01020304
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+} image_buf_t;
+
+typedef struct {
+    image_buf_t strings;
+    // string to its offset in the string table + 1
+    hash_table_t* offsets;
+    image_buf_t data;
+    // where the data section will be
+    uint32_t data_base;
+} image_writer_t;
+
+static size_t align8(size_t pos) {
+
+    return (pos + 7) & ~(size_t)7;
+}
+
+/*
+ * Append to a buffer and return where it went. The padding in front of an
+ * aligned part is zeroed, so the same module always makes the same image.
+ */
+static size_t put_bytes(image_buf_t* buf, const void* data, size_t len, bool aligned) {
+
+    size_t pos = aligned ? align8(buf->len) : buf->len;
+    if(pos + len > buf->cap) {
+        buf->cap = (buf->cap == 0) ? 4096 : buf->cap;
+        while(pos + len > buf->cap)
+            buf->cap <<= 1;
+        buf->data = _REALLOC_ARRAY(buf->data, uint8_t, buf->cap);
+    }
+
+    memset(&buf->data[buf->len], 0, pos - buf->len);
+    if(len > 0)
+        memcpy(&buf->data[pos], data, len);
+    buf->len = pos + len;
+
+    return pos;
+}
+
+static void add_string(image_writer_t* w, const char* str) {
+
+    if(str != NULL && !hash_name_exists(w->offsets, str)) {
+        size_t pos = put_bytes(&w->strings, str, strlen(str) + 1, false);
+        insert_hashtable(w->offsets, str, (void*)(intptr_t)(pos + 1));
+    }
+}
+
+static uint32_t string_offset(image_writer_t* w, const char* str) {
+
+    void* data;
+    if(str == NULL || !find_hashtable(w->offsets, str, &data))
+        return 0;
+
+    return (uint32_t)(sizeof(image_header_t) + (intptr_t)data - 1);
+}
+
+static uint32_t put_data(image_writer_t* w, const void* data, size_t len) {
+
+    if(len == 0)
+        return 0;
+
+    return w->data_base + (uint32_t)put_bytes(&w->data, data, len, true);
+}
+
+// every string goes in the table before anything is laid out after it
+static void collect_strings(image_writer_t* w, module_t* mod) {
+
+    for(int i = 0; i < mod->nfunctions; i++) {
+        add_string(w, mod->functions[i].name);
+        if(mod->functions[i].foreign != NULL)
+            add_string(w, mod->functions[i].foreign->symbol);
+    }
+
+    for(int i = 0; i < mod->nstructs; i++) {
+        add_string(w, mod->structs[i].name);
+        for(int j = 0; j < mod->structs[i].nfields; j++)
+            add_string(w, mod->structs[i].fields[j]);
+    }
+
+    for(int i = 0; i < mod->nconsts; i++)
+        if(mod->consts[i].type == VAL_STRING)
+            add_string(w, mod->consts[i].sval);
+
+    for(int i = 0; i < mod->nlibs; i++)
+        add_string(w, mod->libs[i]);
+}
+
+static void put_function(image_writer_t* w, function_t* func, image_function_t* out) {
+
+    out->name = string_offset(w, func->name);
+    out->nparams = func->nparams;
+    out->frame_size = func->frame_size;
+    out->returns_value = func->returns_value;
+    out->code = put_data(w, func->code, func->len);
+    out->len = func->len;
+    out->lines = put_data(w, func->lines, func->lines_len);
+    out->lines_len = func->lines_len;
+
+    if(func->foreign != NULL) {
+        out->symbol = string_offset(w, func->foreign->symbol);
+        out->ret = func->foreign->ret;
+        out->params = put_data(w, func->foreign->params, func->nparams * sizeof(value_type_t));
+    }
+}
+
+static void put_struct(image_writer_t* w, struct_info_t* info, image_struct_t* out) {
+
+    out->name = string_offset(w, info->name);
+    out->nfields = info->nfields;
+    if(info->nfields > 0) {
+        uint32_t* fields = _ALLOC_ARRAY(uint32_t, info->nfields);
+        for(int i = 0; i < info->nfields; i++)
+            fields[i] = string_offset(w, info->fields[i]);
+        out->fields = put_data(w, fields, info->nfields * sizeof(uint32_t));
+        _FREE(fields);
+    }
+}
+
+static void put_format(image_writer_t* w, format_t* fmt, image_format_t* out) {
+
+    out->text = put_data(w, fmt->text, fmt->text_len);
+    out->text_len = fmt->text_len;
+    out->segs = put_data(w, fmt->segs, fmt->nsegs * sizeof(fmt_segment_t));
+    out->nsegs = fmt->nsegs;
+    out->nargs = fmt->nargs;
+}
+
+static bool write_file(const char* fname, image_buf_t* buf) {
+
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", fname);
+
+    FILE* fp = fopen(tmp, "wb");
+    if(fp == NULL) {
+        fprintf(stderr, "image: cannot open output file: %s: %s\n", tmp, strerror(errno));
+        return false;
+    }
+
+    bool ok = fwrite(buf->data, 1, buf->len, fp) == buf->len;
+    ok = (fclose(fp) == 0) && ok;
+    // a loader never sees half of an image
+    if(ok)
+        ok = rename(tmp, fname) == 0;
+
+    if(!ok) {
+        fprintf(stderr, "image: cannot write output file: %s: %s\n", fname, strerror(errno));
+        remove(tmp);
+    }
+
+    return ok;
+}
+
+/*
+ * Check that a part of the image is inside it. Offset 0 is the header, so
+ * it is never a part.
+ */
+static bool in_image(size_t size, uint32_t off, size_t len) {
+
+    return off != 0 && off <= size && len <= size - off;
+}
+
+static const char* get_string(uint8_t* base, image_header_t* hdr, uint64_t off, const char** str) {
+
+    if(off == 0) {
+        *str = NULL;
+        return NULL;
+    }
+
+    if(off < hdr->strings || off >= (uint64_t)hdr->strings + hdr->strings_len)
+        return "string out of range";
+
+    *str = (const char*)&base[off];
+    return NULL;
+}
+
+static const char* check_header(image_header_t* hdr, size_t size) {
+
+    if(size < sizeof(image_header_t) || memcmp(hdr->magic, IMAGE_MAGIC, 4))
+        return "not a bytecode image";
+    if(hdr->version != IMAGE_VERSION)
+        return "wrong image version";
+    if(hdr->nopcodes != OP_COUNT)
+        return "made for another instruction set";
+    if(hdr->byte_order != BYTE_ORDER_MARK)
+        return "wrong byte order";
+    if(hdr->size != size)
+        return "image is truncated";
+
+    if(hdr->nfunctions < 0 || hdr->nstructs < 0 || hdr->nglobals < 0 || hdr->nconsts < 0 || hdr->nformats < 0 ||
+       hdr->nlibs < 0 || hdr->ncaches < 0)
+        return "negative count";
+    if(hdr->init < -1 || hdr->init >= hdr->nfunctions || hdr->start < -1 || hdr->start >= hdr->nfunctions)
+        return "entry point out of range";
+
+    // the string table ends with the end of a string
+    if(hdr->strings_len > 0 && !in_image(size, hdr->strings, hdr->strings_len))
+        return "string table out of range";
+    if(hdr->data_len > 0 && !in_image(size, hdr->data, hdr->data_len))
+        return "data out of range";
+
+    struct {
+        uint32_t off;
+        size_t len;
+    } tables[] = {
+        { hdr->functions, hdr->nfunctions * sizeof(image_function_t) },
+        { hdr->structs, hdr->nstructs * sizeof(image_struct_t) },
+        { hdr->consts, hdr->nconsts * sizeof(constant_t) },
+        { hdr->formats, hdr->nformats * sizeof(image_format_t) },
+        { hdr->libs, hdr->nlibs * sizeof(uint32_t) },
+    };
+    for(size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++)
+        if(tables[i].len > 0 && (!in_image(size, tables[i].off, tables[i].len) || tables[i].off % 8 != 0))
+            return "table out of range";
+
+    return NULL;
+}
+
+// a part of the data section, or NULL when it is empty
+static const char* get_data(uint8_t* base, image_header_t* hdr, uint32_t off, size_t len, void** ptr) {
+
+    *ptr = NULL;
+    if(len == 0)
+        return NULL;
+
+    if(off < hdr->data || off % 4 != 0 || !in_image((size_t)hdr->data + hdr->data_len, off, len))
+        return "data out of range";
+
+    *ptr = &base[off];
+    return NULL;
+}
+
+static const char* map_functions(module_t* mod, uint8_t* base, image_header_t* hdr) {
+
+    const char* err = NULL;
+    image_function_t* table = (image_function_t*)&base[hdr->functions];
+
+    mod->nfunctions = hdr->nfunctions;
+    if(mod->nfunctions > 0) {
+        mod->functions = _ALLOC_ARRAY(function_t, mod->nfunctions);
+        memset(mod->functions, 0, sizeof(function_t) * mod->nfunctions);
+    }
+
+    for(int i = 0; i < mod->nfunctions && err == NULL; i++) {
+        image_function_t* in = &table[i];
+        function_t* func = &mod->functions[i];
+
+        if(in->len < 0 || in->lines_len < 0 || in->nparams < 0)
+            return "negative length";
+
+        func->nparams = in->nparams;
+        func->frame_size = in->frame_size;
+        func->returns_value = in->returns_value != 0;
+        func->len = func->cap = in->len;
+        func->lines_len = func->lines_cap = in->lines_len;
+
+        err = get_string(base, hdr, in->name, &func->name);
+        if(err == NULL)
+            err = get_data(base, hdr, in->code, in->len, (void**)&func->code);
+        if(err == NULL)
+            err = get_data(base, hdr, in->lines, in->lines_len, (void**)&func->lines);
+
+        if(err == NULL && in->symbol != 0) {
+            func->foreign = _ALLOC_TYPE(foreign_t);
+            memset(func->foreign, 0, sizeof(foreign_t));
+            func->foreign->ret = (value_type_t)in->ret;
+            err = get_string(base, hdr, in->symbol, &func->foreign->symbol);
+            if(err == NULL)
+                err = get_data(base, hdr, in->params, in->nparams * sizeof(value_type_t),
+                               (void**)&func->foreign->params);
+        }
+    }
+
+    return err;
+}
+
+static const char* map_structs(module_t* mod, uint8_t* base, image_header_t* hdr) {
+
+    const char* err = NULL;
+    image_struct_t* table = (image_struct_t*)&base[hdr->structs];
+
+    mod->nstructs = hdr->nstructs;
+    if(mod->nstructs > 0) {
+        mod->structs = _ALLOC_ARRAY(struct_info_t, mod->nstructs);
+        memset(mod->structs, 0, sizeof(struct_info_t) * mod->nstructs);
+    }
+
+    for(int i = 0; i < mod->nstructs && err == NULL; i++) {
+        struct_info_t* info = &mod->structs[i];
+        uint32_t* fields;
+
+        if(table[i].nfields < 0)
+            return "negative length";
+
+        err = get_string(base, hdr, table[i].name, &info->name);
+        if(err == NULL)
+            err = get_data(base, hdr, table[i].fields, table[i].nfields * sizeof(uint32_t), (void**)&fields);
+        if(err != NULL)
+            break;
+
+        // the compiler leaves room for one more
+        info->fields = _ALLOC_ARRAY(const char*, table[i].nfields + 1);
+        for(int j = 0; j < table[i].nfields && err == NULL; j++) {
+            err = get_string(base, hdr, fields[j], &info->fields[j]);
+            info->nfields = j + 1;
+        }
+    }
+
+    return err;
+}
+
+static const char* map_formats(module_t* mod, uint8_t* base, image_header_t* hdr) {
+
+    const char* err = NULL;
+    image_format_t* table = (image_format_t*)&base[hdr->formats];
+
+    mod->nformats = mod->format_cap = hdr->nformats;
+    if(mod->nformats > 0)
+        mod->formats = _ALLOC_ARRAY(format_t, mod->nformats);
+
+    for(int i = 0; i < mod->nformats && err == NULL; i++) {
+        format_t* fmt = &mod->formats[i];
+        memset(fmt, 0, sizeof(format_t));
+
+        if(table[i].text_len < 0 || table[i].nsegs < 0)
+            return "negative length";
+
+        fmt->text_len = table[i].text_len;
+        fmt->nsegs = table[i].nsegs;
+        fmt->nargs = table[i].nargs;
+        err = get_data(base, hdr, table[i].text, table[i].text_len, (void**)&fmt->text);
+        if(err == NULL)
+            err = get_data(base, hdr, table[i].segs, table[i].nsegs * sizeof(fmt_segment_t), (void**)&fmt->segs);
+    }
+
+    return err;
+}
+
+/*
+ * The relocation. String constants hold the offset of their string until
+ * it is replaced by the address.
+ */
+static const char* map_constants(module_t* mod, uint8_t* base, image_header_t* hdr) {
+
+    const char* err = NULL;
+
+    mod->consts = (constant_t*)&base[hdr->consts];
+    mod->nconsts = mod->const_cap = hdr->nconsts;
+
+    for(int i = 0; i < mod->nconsts && err == NULL; i++)
+        if(mod->consts[i].type == VAL_STRING) {
+            err = get_string(base, hdr, (uint64_t)mod->consts[i].ival, &mod->consts[i].sval);
+            if(err == NULL && mod->consts[i].sval == NULL)
+                err = "string constant has no string";
+        }
+
+    return err;
+}
+
+static const char* map_libraries(module_t* mod, uint8_t* base, image_header_t* hdr) {
+
+    const char* err = NULL;
+    uint32_t* table = (uint32_t*)&base[hdr->libs];
+
+    mod->nlibs = mod->lib_cap = hdr->nlibs;
+    if(mod->nlibs > 0)
+        mod->libs = _ALLOC_ARRAY(const char*, mod->nlibs);
+
+    for(int i = 0; i < mod->nlibs && err == NULL; i++)
+        err = get_string(base, hdr, table[i], &mod->libs[i]);
+
+    return err;
+}
+
+/*
+ * public interface
+ */
+
+/*
+ * Write a module to an image file. The file is written next to its name
+ * and renamed over it, so a loader never maps a partial image.
+ */
+bool write_image(module_t* mod, const char* fname) {
+
+    image_writer_t w;
+    memset(&w, 0, sizeof(image_writer_t));
+    w.offsets = create_hashtable();
+
+    collect_strings(&w, mod);
+
+    image_header_t hdr;
+    memset(&hdr, 0, sizeof(image_header_t));
+    memcpy(hdr.magic, IMAGE_MAGIC, 4);
+    hdr.version = IMAGE_VERSION;
+    hdr.nopcodes = OP_COUNT;
+    hdr.byte_order = BYTE_ORDER_MARK;
+    hdr.nfunctions = mod->nfunctions;
+    hdr.nstructs = mod->nstructs;
+    hdr.nglobals = mod->nglobals;
+    hdr.nconsts = mod->nconsts;
+    hdr.nformats = mod->nformats;
+    hdr.nlibs = mod->nlibs;
+    hdr.init = mod->init;
+    hdr.start = mod->start;
+    hdr.ncaches = mod->ncaches;
+    hdr.strings = sizeof(image_header_t);
+    hdr.strings_len = w.strings.len;
+    hdr.data = w.data_base = align8(hdr.strings + hdr.strings_len);
+
+    image_function_t* functions = _ALLOC_ARRAY(image_function_t, mod->nfunctions + 1);
+    memset(functions, 0, sizeof(image_function_t) * (mod->nfunctions + 1));
+    for(int i = 0; i < mod->nfunctions; i++)
+        put_function(&w, &mod->functions[i], &functions[i]);
+
+    image_struct_t* structs = _ALLOC_ARRAY(image_struct_t, mod->nstructs + 1);
+    memset(structs, 0, sizeof(image_struct_t) * (mod->nstructs + 1));
+    for(int i = 0; i < mod->nstructs; i++)
+        put_struct(&w, &mod->structs[i], &structs[i]);
+
+    image_format_t* formats = _ALLOC_ARRAY(image_format_t, mod->nformats + 1);
+    memset(formats, 0, sizeof(image_format_t) * (mod->nformats + 1));
+    for(int i = 0; i < mod->nformats; i++)
+        put_format(&w, &mod->formats[i], &formats[i]);
+
+    // a string constant holds the offset of its string
+    constant_t* consts = _ALLOC_ARRAY(constant_t, mod->nconsts + 1);
+    memset(consts, 0, sizeof(constant_t) * (mod->nconsts + 1));
+    for(int i = 0; i < mod->nconsts; i++) {
+        consts[i].type = mod->consts[i].type;
+        if(mod->consts[i].type == VAL_STRING)
+            consts[i].ival = string_offset(&w, mod->consts[i].sval);
+        else
+            consts[i].ival = mod->consts[i].ival;
+    }
+
+    uint32_t* libs = _ALLOC_ARRAY(uint32_t, mod->nlibs + 1);
+    for(int i = 0; i < mod->nlibs; i++)
+        libs[i] = string_offset(&w, mod->libs[i]);
+
+    image_buf_t out;
+    memset(&out, 0, sizeof(image_buf_t));
+    put_bytes(&out, &hdr, sizeof(image_header_t), true);
+    put_bytes(&out, w.strings.data, w.strings.len, true);
+    hdr.data_len = w.data.len;
+    if(w.data.len > 0)
+        put_bytes(&out, w.data.data, w.data.len, true);
+    hdr.functions = put_bytes(&out, functions, sizeof(image_function_t) * mod->nfunctions, true);
+    hdr.structs = put_bytes(&out, structs, sizeof(image_struct_t) * mod->nstructs, true);
+    hdr.consts = put_bytes(&out, consts, sizeof(constant_t) * mod->nconsts, true);
+    hdr.formats = put_bytes(&out, formats, sizeof(image_format_t) * mod->nformats, true);
+    hdr.libs = put_bytes(&out, libs, sizeof(uint32_t) * mod->nlibs, true);
+    hdr.size = out.len;
+    memcpy(out.data, &hdr, sizeof(image_header_t));
+
+    bool ok = write_file(fname, &out);
+
+    _FREE(out.data);
+    _FREE(functions);
+    _FREE(structs);
+    _FREE(formats);
+    _FREE(consts);
+    _FREE(libs);
+    if(w.strings.data != NULL)
+        _FREE(w.strings.data);
+    if(w.data.data != NULL)
+        _FREE(w.data.data);
+    destroy_hashtable(w.offsets);
+
+    return ok;
+}
+
+/*
+ * Map an image and make a module of it, and bind its C functions. The
+ * module is destroyed with destroy_module(), which unmaps the image and
+ * unbinds them. Returns NULL when the image cannot be read, is damaged or
+ * has a C function that cannot be bound.
+ */
+module_t* load_image(const char* fname) {
+
+    int fd = open(fname, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        fprintf(stderr, "image: cannot open input file: %s: %s\n", fname, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(image_header_t)) {
+        fprintf(stderr, "image: %s: not a bytecode image\n", fname);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = st.st_size;
+    uint8_t* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        fprintf(stderr, "image: cannot map input file: %s: %s\n", fname, strerror(errno));
+        return NULL;
+    }
+
+    module_t* mod = _ALLOC_TYPE(module_t);
+    memset(mod, 0, sizeof(module_t));
+    mod->image = base;
+    mod->image_size = size;
+
+    image_header_t* hdr = (image_header_t*)base;
+    const char* err = check_header(hdr, size);
+    if(err == NULL && hdr->strings_len > 0 && base[hdr->strings + hdr->strings_len - 1] != '\0')
+        err = "string table is not terminated";
+
+    if(err == NULL) {
+        mod->nglobals = hdr->nglobals;
+        mod->init = hdr->init;
+        mod->start = hdr->start;
+        mod->ncaches = hdr->ncaches;
+        err = map_functions(mod, base, hdr);
+    }
+    if(err == NULL)
+        err = map_structs(mod, base, hdr);
+    if(err == NULL)
+        err = map_formats(mod, base, hdr);
+    if(err == NULL)
+        err = map_constants(mod, base, hdr);
+    if(err == NULL)
+        err = map_libraries(mod, base, hdr);
+    if(err == NULL)
+        err = bind_foreign(mod);
+
+    if(err != NULL) {
+        fprintf(stderr, "image: %s: %s\n", fname, err);
+        destroy_module(mod);
+        return NULL;
+    }
+
+    return mod;
+}
+
+// whether a file starts like an image
+bool is_image(const char* fname) {
+
+    char magic[4];
+    FILE* fp = fopen(fname, "rb");
+    if(fp == NULL)
+        return false;
+
+    bool ok = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) && !memcmp(magic, IMAGE_MAGIC, 4);
+    fclose(fp);
+
+    return ok;
+}
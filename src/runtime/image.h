@@ -0,0 +1,103 @@
+/**
+ * @file image.h
+ *
+ * @brief Bytecode images. A module is written to a file in the layout that
+ * the loader uses, so loading a module is mapping the file and pointing
+ * the module tables into it. The code, the constant pool, the strings, the
+ * format programs and the line tables are used in place.
+ *
+ * Every reference in the image is an offset from the start of the file, so
+ * the image does not depend on where it is mapped. The loader writes the
+ * address of the string into each string constant. The mapping is private,
+ * so that only copies the pages of the constant pool. The tables of
+ * functions, structs and formats are small and are made on the heap.
+ *
+ * The layout is the header, the string table, the data section with the
+ * code, line tables, parameter lists, field lists and format programs, and
+ * then the tables. Every part starts on an 8 byte boundary. The numbers are
+ * little endian, like the operands in the code.
+ *
+ */
+#ifndef _IMAGE_H_
+#define _IMAGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "module.h"
+
+#define IMAGE_MAGIC "TOYB"
+#define IMAGE_VERSION 2
+#define IMAGE_EXT ".tbc"
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    // OP_COUNT of the compiler that wrote it
+    uint16_t nopcodes;
+    // 0x01020304 as it was written
+    uint32_t byte_order;
+    uint32_t size;
+
+    int32_t nfunctions;
+    int32_t nstructs;
+    int32_t nglobals;
+    int32_t nconsts;
+    int32_t nformats;
+    int32_t nlibs;
+    int32_t init;
+    int32_t start;
+    int32_t ncaches;
+
+    // offsets of the parts of the image
+    uint32_t strings;
+    uint32_t strings_len;
+    uint32_t data;
+    uint32_t data_len;
+    uint32_t functions;
+    uint32_t structs;
+    uint32_t consts;
+    uint32_t formats;
+    uint32_t libs;
+} image_header_t;
+
+// 0 is never the offset of anything, so it stands for none
+typedef struct {
+    uint32_t name;
+    int32_t nparams;
+    int32_t frame_size;
+    int32_t returns_value;
+    uint32_t code;
+    int32_t len;
+    uint32_t lines;
+    int32_t lines_len;
+    // the C function, when the symbol is not 0
+    uint32_t symbol;
+    int32_t ret;
+    // nparams value types
+    uint32_t params;
+    uint32_t pad;
+} image_function_t;
+
+typedef struct {
+    uint32_t name;
+    int32_t nfields;
+    // nfields string offsets
+    uint32_t fields;
+    uint32_t pad;
+} image_struct_t;
+
+typedef struct {
+    uint32_t text;
+    int32_t text_len;
+    uint32_t segs;
+    int32_t nsegs;
+    int32_t nargs;
+    uint32_t pad;
+} image_format_t;
+
+bool write_image(module_t* mod, const char* fname);
+module_t* load_image(const char* fname);
+bool is_image(const char* fname);
+
+#endif /* _IMAGE_H_ */
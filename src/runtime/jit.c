@@ -0,0 +1,571 @@
+/**
+ * @file jit.c
+ *
+ * @brief Translating bytecode to x86-64 machine code, one template for
+ * each instruction.
+ *
+ * A template takes the top of the stack in rax and leaves it there. An
+ * instruction that pushes first pushes rax, even when the stack is empty,
+ * so the machine stack always holds what is below the top and a template
+ * does not depend on the depth. The stack pointer is put back from rbp on
+ * return.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "jit.h"
+
+// #define BENCH_JIT
+
+#if defined(__x86_64__)
+
+typedef struct {
+    // where the rel32 of a jump is, and the bytecode position it goes to
+    int pos;
+    int target;
+} fixup_t;
+
+typedef struct {
+    module_t* mod;
+    uint8_t* buf;
+    int len;
+    int cap;
+    fixup_t* fixups;
+    int nfixups;
+    int fixup_cap;
+} jit_t;
+
+#define PUT(j, bytes) put_bytes((j), (const uint8_t*)(bytes), (int)sizeof(bytes) - 1)
+
+static void put_bytes(jit_t* j, const uint8_t* bytes, int n) {
+
+    if(j->len + n > j->cap) {
+        j->cap = (j->cap == 0) ? 256 : j->cap;
+        while(j->len + n > j->cap)
+            j->cap <<= 1;
+        j->buf = _REALLOC_ARRAY(j->buf, uint8_t, j->cap);
+    }
+
+    memcpy(&j->buf[j->len], bytes, n);
+    j->len += n;
+}
+
+static void put_int32(jit_t* j, int32_t value) {
+
+    uint8_t bytes[4];
+    write_operand(bytes, value);
+    put_bytes(j, bytes, 4);
+}
+
+static void put_int64(jit_t* j, int64_t value) {
+
+    put_int32(j, (int32_t)(uint32_t)((uint64_t)value & 0xFFFFFFFF));
+    put_int32(j, (int32_t)(uint32_t)((uint64_t)value >> 32));
+}
+
+static void put_jump(jit_t* j, int target) {
+
+    if(j->nfixups + 1 > j->fixup_cap) {
+        j->fixup_cap = (j->fixup_cap == 0) ? 16 : j->fixup_cap << 1;
+        j->fixups = _REALLOC_ARRAY(j->fixups, fixup_t, j->fixup_cap);
+    }
+
+    j->fixups[j->nfixups++] = (fixup_t){ j->len, target };
+    put_int32(j, 0);
+}
+
+static void put_epilogue(jit_t* j) {
+
+    PUT(j, "\x48\x89\xEC"); // mov rsp, rbp
+    PUT(j, "\x41\x5C");     // pop r12
+    PUT(j, "\x5B");         // pop rbx
+    PUT(j, "\x5D");         // pop rbp
+    PUT(j, "\xC3");         // ret
+}
+
+// the left operand in rcx, the right one in rax
+static void put_compare_int(jit_t* j, const char* setcc) {
+
+    PUT(j, "\x59");         // pop rcx
+    PUT(j, "\x48\x39\xC1"); // cmp rcx, rax
+    put_bytes(j, (const uint8_t*)setcc, 3);
+    PUT(j, "\x0F\xB6\xC0"); // movzx eax, al
+}
+
+// the left operand in xmm0, the right one in xmm1
+static void put_float_operands(jit_t* j) {
+
+    PUT(j, "\x59");                 // pop rcx
+    PUT(j, "\x66\x48\x0F\x6E\xC1"); // movq xmm0, rcx
+    PUT(j, "\x66\x48\x0F\x6E\xC8"); // movq xmm1, rax
+}
+
+static void put_float_result(jit_t* j) {
+
+    PUT(j, "\x66\x48\x0F\x7E\xC0"); // movq rax, xmm0
+}
+
+/*
+ * Emit the template of one instruction. Returns false for an instruction
+ * that the JIT does not do. The target is the bytecode position that a
+ * jump goes to.
+ */
+static bool put_instruction(jit_t* j, opcode_t op, const uint8_t* operands, int target) {
+
+    int32_t a = (opcode_info[op].operands > 0) ? read_operand(operands) : 0;
+
+    switch(op) {
+        case OP_NOP:
+        case OP_BOOL_TO_INT:
+            break;
+
+        case OP_PUSH_INT:
+            PUT(j, "\x50\x48\xC7\xC0"); // push rax; mov rax, imm32
+            put_int32(j, a);
+            break;
+        case OP_PUSH_TRUE:
+            PUT(j, "\x50\xB8\x01\x00\x00\x00"); // push rax; mov eax, 1
+            break;
+        case OP_PUSH_FALSE:
+            PUT(j, "\x50\x31\xC0"); // push rax; xor eax, eax
+            break;
+        case OP_PUSH_CONST: {
+            constant_t* c = &j->mod->consts[a];
+            int64_t bits;
+            if(c->type == VAL_INT)
+                bits = c->ival;
+            else if(c->type == VAL_FLOAT)
+                memcpy(&bits, &c->fval, sizeof(bits));
+            else
+                return false;
+            PUT(j, "\x50\x48\xB8"); // push rax; mov rax, imm64
+            put_int64(j, bits);
+        } break;
+        case OP_POP:
+            PUT(j, "\x58"); // pop rax
+            break;
+
+        case OP_LOAD_LOCAL:
+            PUT(j, "\x50\x48\x8B\x83"); // push rax; mov rax, [rbx + disp32]
+            put_int32(j, a * (int32_t)sizeof(int64_t));
+            break;
+        case OP_STORE_LOCAL:
+            PUT(j, "\x48\x89\x83"); // mov [rbx + disp32], rax
+            put_int32(j, a * (int32_t)sizeof(int64_t));
+            PUT(j, "\x58");
+            break;
+        case OP_LOAD_GLOBAL:
+            PUT(j, "\x50\x49\x8B\x84\x24"); // push rax; mov rax, [r12 + disp32]
+            put_int32(j, a * (int32_t)sizeof(int64_t));
+            break;
+        case OP_STORE_GLOBAL:
+            PUT(j, "\x49\x89\x84\x24"); // mov [r12 + disp32], rax
+            put_int32(j, a * (int32_t)sizeof(int64_t));
+            PUT(j, "\x58");
+            break;
+
+        case OP_ADD_INT:
+            PUT(j, "\x59\x48\x01\xC8"); // pop rcx; add rax, rcx
+            break;
+        case OP_SUB_INT:
+            PUT(j, "\x59\x48\x29\xC1\x48\x89\xC8"); // pop rcx; sub rcx, rax; mov rax, rcx
+            break;
+        case OP_MUL_INT:
+            PUT(j, "\x59\x48\x0F\xAF\xC1"); // pop rcx; imul rax, rcx
+            break;
+        case OP_NEG_INT:
+            PUT(j, "\x48\xF7\xD8"); // neg rax
+            break;
+
+        case OP_EQ_INT:
+            put_compare_int(j, "\x0F\x94\xC0"); // sete al
+            break;
+        case OP_NE_INT:
+            put_compare_int(j, "\x0F\x95\xC0"); // setne al
+            break;
+        case OP_LT_INT:
+            put_compare_int(j, "\x0F\x9C\xC0"); // setl al
+            break;
+        case OP_LE_INT:
+            put_compare_int(j, "\x0F\x9E\xC0"); // setle al
+            break;
+        case OP_GT_INT:
+            put_compare_int(j, "\x0F\x9F\xC0"); // setg al
+            break;
+        case OP_GE_INT:
+            put_compare_int(j, "\x0F\x9D\xC0"); // setge al
+            break;
+
+        case OP_ADD_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\xF2\x0F\x58\xC1"); // addsd xmm0, xmm1
+            put_float_result(j);
+            break;
+        case OP_SUB_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\xF2\x0F\x5C\xC1"); // subsd xmm0, xmm1
+            put_float_result(j);
+            break;
+        case OP_MUL_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\xF2\x0F\x59\xC1"); // mulsd xmm0, xmm1
+            put_float_result(j);
+            break;
+        case OP_NEG_FLOAT:
+            PUT(j, "\x48\xB9"); // mov rcx, imm64
+            put_int64(j, INT64_MIN);
+            PUT(j, "\x48\x31\xC8"); // xor rax, rcx
+            break;
+
+        // a NaN is unordered, which sets CF, ZF and PF
+        case OP_EQ_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\x66\x0F\x2E\xC1");             // ucomisd xmm0, xmm1
+            PUT(j, "\x0F\x94\xC0\x0F\x9B\xC1\x20\xC8"); // sete al; setnp cl; and al, cl
+            PUT(j, "\x0F\xB6\xC0");
+            break;
+        case OP_NE_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\x66\x0F\x2E\xC1");             // ucomisd xmm0, xmm1
+            PUT(j, "\x0F\x95\xC0\x0F\x9A\xC1\x08\xC8"); // setne al; setp cl; or al, cl
+            PUT(j, "\x0F\xB6\xC0");
+            break;
+        case OP_LT_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\x66\x0F\x2E\xC8\x0F\x97\xC0\x0F\xB6\xC0"); // ucomisd xmm1, xmm0; seta al
+            break;
+        case OP_LE_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\x66\x0F\x2E\xC8\x0F\x93\xC0\x0F\xB6\xC0"); // ucomisd xmm1, xmm0; setae al
+            break;
+        case OP_GT_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\x66\x0F\x2E\xC1\x0F\x97\xC0\x0F\xB6\xC0"); // ucomisd xmm0, xmm1; seta al
+            break;
+        case OP_GE_FLOAT:
+            put_float_operands(j);
+            PUT(j, "\x66\x0F\x2E\xC1\x0F\x93\xC0\x0F\xB6\xC0"); // ucomisd xmm0, xmm1; setae al
+            break;
+
+        case OP_NOT:
+            PUT(j, "\x48\x83\xF0\x01"); // xor rax, 1
+            break;
+        case OP_AND:
+            PUT(j, "\x59\x48\x21\xC8"); // pop rcx; and rax, rcx
+            break;
+        case OP_OR:
+            PUT(j, "\x59\x48\x09\xC8"); // pop rcx; or rax, rcx
+            break;
+        case OP_INT_TO_FLOAT:
+            PUT(j, "\xF2\x48\x0F\x2A\xC0"); // cvtsi2sd xmm0, rax
+            put_float_result(j);
+            break;
+        case OP_INT_TO_BOOL:
+            PUT(j, "\x48\x85\xC0\x0F\x95\xC0\x0F\xB6\xC0"); // test rax, rax; setne al
+            break;
+
+        case OP_JUMP:
+            PUT(j, "\xE9"); // jmp rel32
+            put_jump(j, target);
+            break;
+        case OP_JUMP_FALSE:
+            PUT(j, "\x48\x89\xC1\x58\x48\x85\xC9"); // mov rcx, rax; pop rax; test rcx, rcx
+            PUT(j, "\x0F\x84");                     // jz rel32
+            put_jump(j, target);
+            break;
+        case OP_JUMP_TRUE:
+            PUT(j, "\x48\x89\xC1\x58\x48\x85\xC9"); // mov rcx, rax; pop rax; test rcx, rcx
+            PUT(j, "\x0F\x85");                     // jnz rel32
+            put_jump(j, target);
+            break;
+        case OP_RETURN:
+            PUT(j, "\x31\xC0");
+            put_epilogue(j);
+            break;
+        case OP_RETURN_VALUE:
+            put_epilogue(j);
+            break;
+
+        // the division can trap, the rest needs the interpreter
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * Emit a superinstruction as the run of instructions that it stands for.
+ */
+static bool put_fused(jit_t* j, opcode_t op, const uint8_t* operands, int target) {
+
+    for(int i = 0; i < fusion_count; i++)
+        if(fusion_table[i].op == op) {
+            const fusion_t* fuse = &fusion_table[i];
+            for(int k = 0; k < fuse->len; k++) {
+                if(!put_instruction(j, fuse->parts[k], operands, target))
+                    return false;
+                operands += opcode_info[fuse->parts[k]].operands * sizeof(int32_t);
+            }
+            return true;
+        }
+
+    return false;
+}
+
+static jit_code_t* install_code(jit_t* j) {
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = ((size_t)j->len + page - 1) & ~(page - 1);
+
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mem == MAP_FAILED)
+        return NULL;
+
+    memcpy(mem, j->buf, j->len);
+    if(mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, size);
+        return NULL;
+    }
+
+    jit_code_t* code = _ALLOC_TYPE(jit_code_t);
+    code->mem = mem;
+    code->size = size;
+    memcpy(&code->entry, &mem, sizeof(code->entry));
+
+    return code;
+}
+
+/*
+ * public interface
+ */
+
+/*
+ * Compile a function. Returns NULL when it has an instruction that the JIT
+ * does not do, and then the interpreter runs it.
+ */
+jit_code_t* jit_function(module_t* mod, function_t* func) {
+
+    if(func->foreign != NULL || func->code == NULL)
+        return NULL;
+
+    jit_t j;
+    memset(&j, 0, sizeof(jit_t));
+    j.mod = mod;
+
+    // where the machine code of each instruction starts, -1 inside of one
+    int* pc_map = _ALLOC_ARRAY(int, func->len + 1);
+    for(int i = 0; i <= func->len; i++)
+        pc_map[i] = -1;
+
+    PUT(&j, "\x55");         // push rbp
+    PUT(&j, "\x53");         // push rbx
+    PUT(&j, "\x41\x54");     // push r12
+    PUT(&j, "\x48\x89\xE5"); // mov rbp, rsp
+    PUT(&j, "\x48\x89\xFB"); // mov rbx, rdi
+    PUT(&j, "\x49\x89\xF4"); // mov r12, rsi
+
+    bool ok = true;
+    for(int pos = 0; ok && pos < func->len;) {
+        opcode_t op = (opcode_t)func->code[pos];
+        int size = OPCODE_SIZE(op);
+        int target = opcode_info[op].jump ? pos + size + read_operand(&func->code[pos + size - (int)sizeof(int32_t)]) : 0;
+
+        pc_map[pos] = j.len;
+        if(op > OP_EXIT)
+            ok = put_fused(&j, op, &func->code[pos + 1], target);
+        else
+            ok = put_instruction(&j, op, &func->code[pos + 1], target);
+        pos += size;
+    }
+
+    // running off the end returns nothing
+    pc_map[func->len] = j.len;
+    PUT(&j, "\x31\xC0");
+    put_epilogue(&j);
+
+    for(int i = 0; ok && i < j.nfixups; i++) {
+        fixup_t* fix = &j.fixups[i];
+        if(fix->target < 0 || fix->target > func->len || pc_map[fix->target] < 0)
+            ok = false;
+        else
+            write_operand(&j.buf[fix->pos], pc_map[fix->target] - (fix->pos + (int)sizeof(int32_t)));
+    }
+
+    jit_code_t* code = ok ? install_code(&j) : NULL;
+
+    _FREE(pc_map);
+    if(j.buf != NULL)
+        _FREE(j.buf);
+    if(j.fixups != NULL)
+        _FREE(j.fixups);
+
+    return code;
+}
+
+#else
+
+jit_code_t* jit_function(module_t* mod, function_t* func) {
+
+    (void)mod;
+    (void)func;
+    return NULL;
+}
+
+#endif
+
+/*
+ * Compile a function that became hot. It is only tried once, a function
+ * that cannot be compiled stays with the interpreter.
+ */
+jit_code_t* tier_up(module_t* mod, function_t* func, jit_tier_t* tier) {
+
+    tier->tried = true;
+    tier->code = jit_function(mod, func);
+
+    return tier->code;
+}
+
+void free_jit_code(jit_code_t* code) {
+
+    if(code != NULL) {
+        munmap(code->mem, code->size);
+        _FREE(code);
+    }
+}
+
+#ifdef BENCH_JIT
+
+#include <time.h>
+
+/*
+ * A switch loop over the same instructions, with the stack in memory. This
+ * is what the interpreter costs at the least, it has no type tags.
+ */
+static int64_t interpret(module_t* mod, function_t* func, int64_t* frame, int64_t* globals) {
+
+    int64_t stack[64];
+    int sp = 0;
+    int pos = 0;
+
+    (void)mod;
+    for(;;) {
+        opcode_t op = (opcode_t)func->code[pos];
+        int size = OPCODE_SIZE(op);
+        int32_t a = (opcode_info[op].operands > 0) ? read_operand(&func->code[pos + 1]) : 0;
+        pos += size;
+
+        switch(op) {
+            case OP_PUSH_INT:
+                stack[sp++] = a;
+                break;
+            case OP_LOAD_LOCAL:
+                stack[sp++] = frame[a];
+                break;
+            case OP_STORE_LOCAL:
+                frame[a] = stack[--sp];
+                break;
+            case OP_LOAD_GLOBAL:
+                stack[sp++] = globals[a];
+                break;
+            case OP_ADD_INT:
+                sp--;
+                stack[sp - 1] += stack[sp];
+                break;
+            case OP_SUB_INT:
+                sp--;
+                stack[sp - 1] -= stack[sp];
+                break;
+            case OP_MUL_INT:
+                sp--;
+                stack[sp - 1] *= stack[sp];
+                break;
+            case OP_GT_INT:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] > stack[sp];
+                break;
+            case OP_JUMP:
+                pos += read_operand(&func->code[pos - 4]);
+                break;
+            case OP_JUMP_FALSE:
+                if(!stack[--sp])
+                    pos += read_operand(&func->code[pos - 4]);
+                break;
+            case OP_RETURN_VALUE:
+                return stack[sp - 1];
+            default:
+                FATAL("not in the benchmark: %s", opcode_to_str(op));
+        }
+    }
+}
+
+static double elapsed(struct timespec* start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(void) {
+
+    // sum = 0; for n { sum = sum + n * n }; return sum
+    module_t* mod = create_module(1, 0, 1);
+    function_t* func = &mod->functions[0];
+    func->name = "squares";
+    func->frame_size = 2;
+
+    emit_code(func, OP_PUSH_INT, 0, 0);
+    emit_code(func, OP_STORE_LOCAL, 0, 0);
+    emit_code(func, OP_LOAD_GLOBAL, 0, 0);
+    emit_code(func, OP_STORE_LOCAL, 1, 0);
+    int top = func->len;
+    emit_code(func, OP_LOAD_LOCAL, 1, 0);
+    emit_code(func, OP_PUSH_INT, 0, 0);
+    emit_code(func, OP_GT_INT, 0, 0);
+    int done = emit_code(func, OP_JUMP_FALSE, 0, 0);
+    emit_code(func, OP_LOAD_LOCAL, 0, 0);
+    emit_code(func, OP_LOAD_LOCAL, 1, 0);
+    emit_code(func, OP_LOAD_LOCAL, 1, 0);
+    emit_code(func, OP_MUL_INT, 0, 0);
+    emit_code(func, OP_ADD_INT, 0, 0);
+    emit_code(func, OP_STORE_LOCAL, 0, 0);
+    emit_code(func, OP_LOAD_LOCAL, 1, 0);
+    emit_code(func, OP_PUSH_INT, 1, 0);
+    emit_code(func, OP_SUB_INT, 0, 0);
+    emit_code(func, OP_STORE_LOCAL, 1, 0);
+    patch_jump(func, emit_code(func, OP_JUMP, 0, 0), top);
+    patch_jump(func, done, func->len);
+    emit_code(func, OP_LOAD_LOCAL, 0, 0);
+    emit_code(func, OP_RETURN_VALUE, 0, 0);
+
+    jit_code_t* code = jit_function(mod, func);
+    if(code == NULL)
+        FATAL("the function did not compile");
+
+    int64_t frame[2];
+    int64_t globals[1] = { 100000000 };
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t expect = interpret(mod, func, frame, globals);
+    double slow = elapsed(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t result = code->entry(frame, globals);
+    double fast = elapsed(&start);
+
+    printf("switch: %6.1f M/sec  jit: %6.1f M/sec  %.1fx %s\n", globals[0] / slow / 1e6, globals[0] / fast / 1e6,
+           slow / fast, (result == expect) ? "ok" : "WRONG");
+
+    free_jit_code(code);
+    destroy_module(mod);
+    return 0;
+}
+
+#endif
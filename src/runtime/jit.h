@@ -0,0 +1,67 @@
+/**
+ * @file jit.h
+ *
+ * @brief A baseline JIT to x86-64 for hot functions. Every instruction is
+ * translated on its own, by a template of machine code, so the code is as
+ * good as the bytecode and no better. What it saves is the dispatch and
+ * the type tags.
+ *
+ * Only functions whose code is entirely typed int, float and bool work on
+ * locals and globals are compiled. That is the numeric loops. A function
+ * that calls, touches a string, a list, a dict or a struct, or that has an
+ * instruction that can fail at run time, is left to the interpreter. So
+ * compiled code never has to deoptimize, the interpreter is the fallback
+ * for everything else.
+ *
+ * The frame and the globals are arrays of 64 bit words: ints as int64_t,
+ * floats as the bits of a double and bools as 0 or 1. The compiled code
+ * keeps the frame pointer in rbx, the globals in r12 and the top of the
+ * stack in rax. The rest of the stack is the machine stack.
+ *
+ * The interpreter counts the calls and the backward jumps of a function
+ * in a jit_tier_t. When either passes its threshold the function is
+ * compiled, and the next call runs the machine code. Compiling is tried
+ * once per function.
+ *
+ * Benchmark build string:
+ * gcc -O2 -DBENCH_JIT -I../common -o bjit jit.c module.c format.c opcodes.c value.c ffi.c ../common/alloc.c -ldl -lm
+ */
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "module.h"
+
+#define JIT_CALL_THRESHOLD 1000
+#define JIT_LOOP_THRESHOLD 10000
+
+// returns the value of RETURN_VALUE, or 0
+typedef int64_t (*jit_entry_t)(int64_t* frame, int64_t* globals);
+
+typedef struct {
+    jit_entry_t entry;
+    void* mem;
+    size_t size;
+} jit_code_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t backedges;
+    // NULL until the function is compiled
+    jit_code_t* code;
+    bool tried;
+} jit_tier_t;
+
+jit_code_t* jit_function(module_t* mod, function_t* func);
+jit_code_t* tier_up(module_t* mod, function_t* func, jit_tier_t* tier);
+void free_jit_code(jit_code_t* code);
+
+static inline bool is_hot(jit_tier_t* tier) {
+
+    return !tier->tried && (tier->calls >= JIT_CALL_THRESHOLD || tier->backedges >= JIT_LOOP_THRESHOLD);
+}
+
+#endif /* _JIT_H_ */
@@ -0,0 +1,96 @@
+/**
+ * @file member_cache.c
+ *
+ * @brief The slow path of the member caches.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "member_cache.h"
+
+/*
+ * public interface
+ */
+
+member_caches_t* create_member_caches(module_t* mod) {
+
+    member_caches_t* caches = _ALLOC_TYPE(member_caches_t);
+    memset(caches, 0, sizeof(member_caches_t));
+
+    caches->nsites = mod->ncaches;
+    if(caches->nsites > 0) {
+        caches->sites = _ALLOC_ARRAY(member_cache_t, caches->nsites);
+        memset(caches->sites, 0, sizeof(member_cache_t) * caches->nsites);
+    }
+
+    return caches;
+}
+
+void destroy_member_caches(member_caches_t* caches) {
+
+    if(caches != NULL) {
+        if(caches->sites != NULL)
+            _FREE(caches->sites);
+        _FREE(caches);
+    }
+}
+
+/*
+ * Look the field up by name, and remember where it was unless the cache is
+ * megamorphic. A field that is not there is not cached, it is an error.
+ */
+int miss_member(member_caches_t* caches, module_t* mod, int site, int shape, const char* name) {
+
+    ASSERT(site >= 0 && site < caches->nsites, "invalid cache site: %d", site);
+    ASSERT(shape >= 0 && shape < mod->nstructs, "invalid struct index: %d", shape);
+
+    caches->misses++;
+
+    struct_info_t* info = &mod->structs[shape];
+    int slot = -1;
+    for(int i = 0; i < info->nfields; i++)
+        // an interned name is the same pointer, one from an image is not
+        if(info->fields[i] == name || !strcmp(info->fields[i], name)) {
+            slot = i;
+            break;
+        }
+
+    member_cache_t* cache = &caches->sites[site];
+    if(slot < 0 || cache->nways < 0)
+        return slot;
+
+    if(cache->nways == CACHE_WAYS) {
+        cache->nways = -1;
+        caches->megamorphic++;
+        return slot;
+    }
+
+    cache->shapes[cache->nways] = shape;
+    cache->slots[cache->nways] = slot;
+    cache->nways++;
+
+    return slot;
+}
+
+void print_member_cache_stats(FILE* fp, member_caches_t* caches) {
+
+    int mono = 0;
+    int poly = 0;
+    for(int i = 0; i < caches->nsites; i++)
+        if(caches->sites[i].nways == 1)
+            mono++;
+        else if(caches->sites[i].nways > 1)
+            poly++;
+
+    uint64_t total = caches->hits + caches->misses;
+    fprintf(fp, "%-19s%d\n", "member caches:", caches->nsites);
+    fprintf(fp, "%-19s%d/%d/%d\n", "  mono/poly/mega:", mono, poly, caches->megamorphic);
+    fprintf(fp, "%-19s%llu\n", "  hits:", (unsigned long long)caches->hits);
+    fprintf(fp, "%-19s%llu\n", "  misses:", (unsigned long long)caches->misses);
+    if(total > 0)
+        fprintf(fp, "%-19s%.1f%%\n", "  hit rate:", 100.0 * (double)caches->hits / (double)total);
+}
@@ -0,0 +1,64 @@
+/**
+ * @file member_cache.h
+ *
+ * @brief Inline caches for GET_MEMBER and SET_MEMBER. These are the field
+ * accesses that the compiler could not give a slot, because the struct
+ * came out of a list or a dict. Every such instruction has a cache of its
+ * own, numbered by its second operand.
+ *
+ * The fields of a struct are in the order that they were declared, so the
+ * struct index is the shape of the value and decides the slot. A cache
+ * remembers the slot for the last CACHE_WAYS struct indexes that it saw. A
+ * cache with one entry is monomorphic, one with more is polymorphic. A
+ * cache that is full and misses is megamorphic, and from then on the field
+ * is looked up by name every time.
+ *
+ */
+#ifndef _MEMBER_CACHE_H_
+#define _MEMBER_CACHE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "module.h"
+
+#define CACHE_WAYS 4
+
+typedef struct {
+    int32_t shapes[CACHE_WAYS];
+    int32_t slots[CACHE_WAYS];
+    // entries in use, -1 when the cache is megamorphic
+    int nways;
+} member_cache_t;
+
+typedef struct {
+    member_cache_t* sites;
+    int nsites;
+    uint64_t hits;
+    uint64_t misses;
+    int megamorphic;
+} member_caches_t;
+
+member_caches_t* create_member_caches(module_t* mod);
+void destroy_member_caches(member_caches_t* caches);
+int miss_member(member_caches_t* caches, module_t* mod, int site, int shape, const char* name);
+void print_member_cache_stats(FILE* fp, member_caches_t* caches);
+
+/*
+ * Return the slot of the field name in a struct with index shape, or -1
+ * when the struct has no such field.
+ */
+static inline int lookup_member(member_caches_t* caches, module_t* mod, int site, int shape, const char* name) {
+
+    member_cache_t* cache = &caches->sites[site];
+
+    for(int i = 0; i < cache->nways; i++)
+        if(cache->shapes[i] == shape) {
+            caches->hits++;
+            return cache->slots[i];
+        }
+
+    return miss_member(caches, mod, site, shape, name);
+}
+
+#endif /* _MEMBER_CACHE_H_ */
@@ -0,0 +1,440 @@
+/**
+ * @file module.c
+ *
+ * @brief Building and dumping compiled modules.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "module.h"
+#include "ffi.h"
+
+module_t* create_module(int nfunctions, int nstructs, int nglobals) {
+
+    module_t* mod = _ALLOC_TYPE(module_t);
+    memset(mod, 0, sizeof(module_t));
+
+    mod->const_cap = 16;
+    mod->consts = _ALLOC_ARRAY(constant_t, mod->const_cap);
+
+    mod->nfunctions = nfunctions;
+    if(nfunctions > 0) {
+        mod->functions = _ALLOC_ARRAY(function_t, nfunctions);
+        memset(mod->functions, 0, sizeof(function_t) * nfunctions);
+    }
+
+    mod->nstructs = nstructs;
+    if(nstructs > 0) {
+        mod->structs = _ALLOC_ARRAY(struct_info_t, nstructs);
+        memset(mod->structs, 0, sizeof(struct_info_t) * nstructs);
+    }
+
+    mod->nglobals = nglobals;
+    mod->init = -1;
+    mod->start = -1;
+
+    return mod;
+}
+
+/*
+ * Names and string constants are interned, so they are not freed here. A
+ * module that was loaded from an image has its code, line tables,
+ * constants, parameter lists and format programs in the mapping, so only
+ * the tables around them are freed and then the image is unmapped.
+ */
+void destroy_module(module_t* mod) {
+
+    if(mod == NULL)
+        return;
+
+    unbind_foreign(mod);
+
+    bool mapped = mod->image != NULL;
+    for(int i = 0; i < mod->nfunctions; i++) {
+        if(mod->functions[i].code != NULL && !mapped)
+            _FREE(mod->functions[i].code);
+        if(mod->functions[i].lines != NULL && !mapped)
+            _FREE(mod->functions[i].lines);
+        if(mod->functions[i].foreign != NULL) {
+            if(mod->functions[i].foreign->params != NULL && !mapped)
+                _FREE(mod->functions[i].foreign->params);
+            _FREE(mod->functions[i].foreign);
+        }
+    }
+
+    for(int i = 0; i < mod->nstructs; i++)
+        if(mod->structs[i].fields != NULL)
+            _FREE(mod->structs[i].fields);
+
+    for(int i = 0; i < mod->nformats && !mapped; i++)
+        free_format(&mod->formats[i]);
+
+    if(mod->functions != NULL)
+        _FREE(mod->functions);
+    if(mod->structs != NULL)
+        _FREE(mod->structs);
+    if(mod->formats != NULL)
+        _FREE(mod->formats);
+    if(mod->libs != NULL)
+        _FREE(mod->libs);
+    if(mapped)
+        munmap(mod->image, mod->image_size);
+    else
+        _FREE(mod->consts);
+    _FREE(mod);
+}
+
+/*
+ * Append a constant and return its index. The caller is responsible for not
+ * adding the same constant twice.
+ */
+int add_constant(module_t* mod, constant_t* value) {
+
+    if(mod->nconsts + 1 > mod->const_cap) {
+        mod->const_cap <<= 1;
+        mod->consts = _REALLOC_ARRAY(mod->consts, constant_t, mod->const_cap);
+    }
+
+    mod->consts[mod->nconsts] = *value;
+    return mod->nconsts++;
+}
+
+/*
+ * Take over a compiled format program and return its index.
+ */
+int add_format(module_t* mod, format_t* fmt) {
+
+    if(mod->nformats + 1 > mod->format_cap) {
+        mod->format_cap = (mod->format_cap == 0) ? 4 : mod->format_cap << 1;
+        mod->formats = _REALLOC_ARRAY(mod->formats, format_t, mod->format_cap);
+    }
+
+    mod->formats[mod->nformats] = *fmt;
+    return mod->nformats++;
+}
+
+/*
+ * Add a shared library once and return its index. The path is interned.
+ */
+int add_library(module_t* mod, const char* path) {
+
+    for(int i = 0; i < mod->nlibs; i++)
+        if(mod->libs[i] == path)
+            return i;
+
+    if(mod->nlibs + 1 > mod->lib_cap) {
+        mod->lib_cap = (mod->lib_cap == 0) ? 4 : mod->lib_cap << 1;
+        mod->libs = _REALLOC_ARRAY(mod->libs, const char*, mod->lib_cap);
+    }
+
+    mod->libs[mod->nlibs] = path;
+    return mod->nlibs++;
+}
+
+static void put_line_byte(function_t* func, uint8_t byte) {
+
+    if(func->lines_len + 1 > func->lines_cap) {
+        func->lines_cap = (func->lines_cap == 0) ? 32 : func->lines_cap << 1;
+        func->lines = _REALLOC_ARRAY(func->lines, uint8_t, func->lines_cap);
+    }
+
+    func->lines[func->lines_len++] = byte;
+}
+
+static void put_uvarint(function_t* func, uint32_t value) {
+
+    while(value >= 0x80) {
+        put_line_byte(func, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put_line_byte(func, (uint8_t)value);
+}
+
+static const uint8_t* get_uvarint(const uint8_t* ptr, const uint8_t* end, uint32_t* value) {
+
+    *value = 0;
+    for(int shift = 0; ptr < end && shift < 35; shift += 7) {
+        *value |= (uint32_t)(*ptr & 0x7F) << shift;
+        if(!(*ptr++ & 0x80))
+            return ptr;
+    }
+
+    return NULL;
+}
+
+/*
+ * The line table has an entry where the source position changes. An entry
+ * is three varints: the bytes of code since the last entry, the change of
+ * the line number, zigzag encoded, and the column.
+ */
+static void put_line(function_t* func, int pc, int line, int col) {
+
+    int delta = line - func->line_no;
+    put_uvarint(func, (uint32_t)(pc - func->line_pc));
+    put_uvarint(func, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+    put_uvarint(func, (uint32_t)col);
+
+    func->line_pc = pc;
+    func->line_no = line;
+}
+
+/*
+ * Decode the entry at ptr and add it to the position in pc, line and col.
+ * Returns NULL at the end of the table.
+ */
+static const uint8_t* next_line(const uint8_t* ptr, const uint8_t* end, uint32_t* pc, int32_t* line, int* col) {
+
+    uint32_t delta, zigzag, column;
+
+    if(ptr == NULL || ptr >= end)
+        return NULL;
+
+    ptr = get_uvarint(ptr, end, &delta);
+    if(ptr != NULL)
+        ptr = get_uvarint(ptr, end, &zigzag);
+    if(ptr != NULL)
+        ptr = get_uvarint(ptr, end, &column);
+    if(ptr == NULL)
+        return NULL;
+
+    *pc += delta;
+    *line += (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+    *col = (int)column;
+    return ptr;
+}
+
+/*
+ * Append an instruction and return its position. Operands that the opcode
+ * does not take are ignored.
+ */
+int emit_code(function_t* func, opcode_t op, int32_t a, int32_t b) {
+
+    ASSERT(op < OP_COUNT, "invalid opcode: %d", op);
+
+    if(func->next_line > 0) {
+        put_line(func, func->len, func->next_line, func->next_col);
+        func->next_line = 0;
+    }
+
+    int size = OPCODE_SIZE(op);
+    if(func->len + size > func->cap) {
+        func->cap = (func->cap == 0) ? 64 : func->cap;
+        while(func->len + size > func->cap)
+            func->cap <<= 1;
+        func->code = _REALLOC_ARRAY(func->code, uint8_t, func->cap);
+    }
+
+    int pos = func->len;
+    uint8_t* ptr = &func->code[pos];
+
+    *ptr++ = (uint8_t)op;
+    if(opcode_info[op].operands > 0) {
+        write_operand(ptr, a);
+        ptr += sizeof(int32_t);
+    }
+    if(opcode_info[op].operands > 1)
+        write_operand(ptr, b);
+
+    func->len += size;
+    return pos;
+}
+
+/*
+ * Overwrite an operand. The position is the byte offset of the operand, not
+ * of the instruction.
+ */
+void patch_operand(function_t* func, int pos, int32_t value) {
+
+    ASSERT(pos > 0 && pos + (int)sizeof(int32_t) <= func->len, "operand position out of range: %d", pos);
+    write_operand(&func->code[pos], value);
+}
+
+/*
+ * Point the jump at pos to the target. The offset is the last operand of
+ * every jump, and it is relative to the next instruction.
+ */
+void patch_jump(function_t* func, int pos, int target) {
+
+    opcode_t op = (opcode_t)func->code[pos];
+    int size = OPCODE_SIZE(op);
+
+    ASSERT(opcode_info[op].jump, "not a jump: %s", opcode_to_str(op));
+    patch_operand(func, pos + size - (int)sizeof(int32_t), target - (pos + size));
+}
+
+/*
+ * The code that is emitted next comes from this line and column. The entry
+ * is written with the next instruction, so a statement that makes no code
+ * leaves no entry.
+ */
+void add_line(function_t* func, int line, int col) {
+
+    func->next_line = line;
+    func->next_col = col;
+}
+
+/*
+ * Find the source position of the instruction at pc. Returns false when
+ * the function has no line table or it does not cover pc.
+ */
+bool find_line(function_t* func, int pc, int* line, int* col) {
+
+    const uint8_t* ptr = func->lines;
+    const uint8_t* end = ptr + func->lines_len;
+    uint32_t at = 0;
+    int32_t crnt = 0;
+    int column = 0;
+    bool found = false;
+
+    while(NULL != (ptr = next_line(ptr, end, &at, &crnt, &column)) && at <= (uint32_t)pc) {
+        *line = crnt;
+        *col = column;
+        found = true;
+    }
+
+    return found;
+}
+
+/*
+ * Move the line table to code that was rewritten. The new position of the
+ * instruction at old position pc is new_pos[pc], for every pc that an
+ * entry has.
+ */
+void remap_lines(function_t* func, const int* new_pos) {
+
+    if(func->lines_len == 0)
+        return;
+
+    uint8_t* old = func->lines;
+    const uint8_t* ptr = old;
+    const uint8_t* end = old + func->lines_len;
+    uint32_t at = 0;
+    int32_t line = 0;
+    int col = 0;
+
+    func->lines = NULL;
+    func->lines_len = func->lines_cap = 0;
+    func->line_pc = func->line_no = 0;
+    while(NULL != (ptr = next_line(ptr, end, &at, &line, &col)))
+        put_line(func, new_pos[at], line, col);
+
+    _FREE(old);
+}
+
+/*
+ * Set marks[pc] for every pc that a line table entry starts at. Code that
+ * is rewritten must keep an instruction there.
+ */
+void mark_lines(function_t* func, bool* marks) {
+
+    const uint8_t* ptr = func->lines;
+    const uint8_t* end = ptr + func->lines_len;
+    uint32_t at = 0;
+    int32_t line = 0;
+    int col = 0;
+
+    while(NULL != (ptr = next_line(ptr, end, &at, &line, &col)))
+        if(at < (uint32_t)func->len)
+            marks[at] = true;
+}
+
+void dump_constant(FILE* fp, constant_t* value) {
+
+    switch(value->type) {
+        case VAL_INT:
+            fprintf(fp, "%lld", (long long)value->ival);
+            break;
+        case VAL_FLOAT:
+            fprintf(fp, "%.17g", value->fval);
+            break;
+        case VAL_STRING:
+            fprintf(fp, "\"%s\"", value->sval);
+            break;
+        default:
+            fprintf(fp, "<%s>", val_type_to_str(value->type));
+            break;
+    }
+}
+
+static void dump_function(FILE* fp, module_t* mod, function_t* func, int index) {
+
+    if(func->foreign != NULL) {
+        fprintf(fp, "\nfunction %d: %s (params: %d, C: %s %s(", index, func->name, func->nparams,
+                val_type_to_str(func->foreign->ret), func->foreign->symbol);
+        for(int i = 0; i < func->nparams; i++)
+            fprintf(fp, "%s%s", (i == 0) ? "" : ", ", val_type_to_str(func->foreign->params[i]));
+        fprintf(fp, "))\n");
+        return;
+    }
+
+    fprintf(fp, "\nfunction %d: %s (params: %d, frame: %d)\n", index, func->name, func->nparams, func->frame_size);
+
+    int pos = 0;
+    int last_line = 0;
+    int last_col = 0;
+    while(pos < func->len) {
+        opcode_t op = (opcode_t)func->code[pos];
+        int size = OPCODE_SIZE(op);
+
+        int line, col;
+        if(find_line(func, pos, &line, &col) && (line != last_line || col != last_col)) {
+            fprintf(fp, "  line %d:%d\n", line, col);
+            last_line = line;
+            last_col = col;
+        }
+
+        fprintf(fp, "  %5d  %-14s", pos, opcode_to_str(op));
+        for(int i = 0; i < opcode_info[op].operands; i++)
+            fprintf(fp, " %d", read_operand(&func->code[pos + 1 + i * (int)sizeof(int32_t)]));
+
+        switch(op) {
+            case OP_PUSH_CONST:
+                fprintf(fp, "\t; ");
+                dump_constant(fp, &mod->consts[read_operand(&func->code[pos + 1])]);
+                break;
+            case OP_FORMAT:
+                fprintf(fp, "\t; ");
+                dump_format(fp, &mod->formats[read_operand(&func->code[pos + 1])]);
+                break;
+            case OP_CALL:
+                fprintf(fp, "\t; %s", mod->functions[read_operand(&func->code[pos + 1])].name);
+                break;
+            case OP_GET_MEMBER:
+            case OP_SET_MEMBER:
+                fprintf(fp, "\t; .%s", mod->consts[read_operand(&func->code[pos + 1])].sval);
+                break;
+            default:
+                // the jumps, and the superinstructions that end in one
+                if(opcode_info[op].jump)
+                    fprintf(fp, "\t; -> %d", pos + size + read_operand(&func->code[pos + size - (int)sizeof(int32_t)]));
+                break;
+        }
+        fputc('\n', fp);
+        pos += size;
+    }
+}
+
+void dump_module(FILE* fp, module_t* mod) {
+
+    fprintf(fp, "module: %d functions, %d structs, %d globals, %d constants\n", mod->nfunctions, mod->nstructs,
+            mod->nglobals, mod->nconsts);
+
+    for(int i = 0; i < mod->nlibs; i++)
+        fprintf(fp, "library %d: %s\n", i, mod->libs[i]);
+
+    for(int i = 0; i < mod->nstructs; i++) {
+        fprintf(fp, "struct %d: %s {", i, mod->structs[i].name);
+        for(int j = 0; j < mod->structs[i].nfields; j++)
+            fprintf(fp, "%s %s", (j == 0) ? "" : ",", mod->structs[i].fields[j]);
+        fprintf(fp, " }\n");
+    }
+
+    for(int i = 0; i < mod->nfunctions; i++)
+        if(mod->functions[i].name != NULL)
+            dump_function(fp, mod, &mod->functions[i], i);
+}
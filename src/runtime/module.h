@@ -0,0 +1,125 @@
+/**
+ * @file module.h
+ *
+ * @brief A compiled module. This is what the code generator produces and
+ * what the virtual machine runs. Functions are numbered by their symbol
+ * slot, structs by their struct slot and globals by their global slot, so
+ * the numbers in the instructions index directly into these tables.
+ *
+ */
+#ifndef _MODULE_H_
+#define _MODULE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "opcodes.h"
+#include "format.h"
+#include "value.h"
+
+typedef struct {
+    value_type_t type;
+    union {
+        int64_t ival;
+        double fval;
+        const char* sval;
+    };
+} constant_t;
+
+// A function that is implemented in C. The signature is kept so that the
+// function can be bound when the module is loaded.
+typedef struct {
+    const char* symbol;
+    value_type_t ret;
+    value_type_t* params;
+    // set by bind_foreign()
+    struct _ffi_func_t_* bound;
+} foreign_t;
+
+typedef struct {
+    const char* name;
+    int nparams;
+    // parameters, then locals, then temporaries of the code generator
+    int frame_size;
+    bool returns_value;
+    // NULL for a function that has code
+    foreign_t* foreign;
+    uint8_t* code;
+    int len;
+    int cap;
+    // source position of the code, see add_line()
+    uint8_t* lines;
+    int lines_len;
+    int lines_cap;
+    // the entry that the next instruction starts, and where the last one
+    // left off
+    int next_line;
+    int next_col;
+    int line_pc;
+    int line_no;
+} function_t;
+
+typedef struct {
+    const char* name;
+    int nfields;
+    const char** fields;
+} struct_info_t;
+
+typedef struct {
+    constant_t* consts;
+    int nconsts;
+    int const_cap;
+
+    function_t* functions;
+    int nfunctions;
+
+    struct_info_t* structs;
+    int nstructs;
+
+    format_t* formats;
+    int nformats;
+    int format_cap;
+
+    int nglobals;
+
+    // GET_MEMBER and SET_MEMBER instructions, see member_cache.h
+    int ncaches;
+
+    // shared libraries named by import statements, and their handles once
+    // they are loaded
+    const char** libs;
+    void** handles;
+    int nlibs;
+    int lib_cap;
+
+    // function index of the global initializers and of the start block, or -1
+    int init;
+    int start;
+
+    // the mapped bytecode image that the module lives in, or NULL when the
+    // tables were made by the compiler, see image.h
+    void* image;
+    size_t image_size;
+} module_t;
+
+module_t* create_module(int nfunctions, int nstructs, int nglobals);
+void destroy_module(module_t* mod);
+
+int add_constant(module_t* mod, constant_t* value);
+int add_format(module_t* mod, format_t* fmt);
+int add_library(module_t* mod, const char* path);
+
+int emit_code(function_t* func, opcode_t op, int32_t a, int32_t b);
+void patch_operand(function_t* func, int pos, int32_t value);
+void patch_jump(function_t* func, int pos, int target);
+void add_line(function_t* func, int line, int col);
+bool find_line(function_t* func, int pc, int* line, int* col);
+void remap_lines(function_t* func, const int* new_pos);
+void mark_lines(function_t* func, bool* marks);
+
+void dump_constant(FILE* fp, constant_t* value);
+void dump_module(FILE* fp, module_t* mod);
+
+#endif /* _MODULE_H_ */
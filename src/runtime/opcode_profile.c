@@ -0,0 +1,277 @@
+/**
+ * @file opcode_profile.c
+ *
+ * @brief Collecting, reading and saving opcode profiles.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "opcode_profile.h"
+
+// a loop is taken to run this many times for each level that it is nested
+#define LOOP_WEIGHT_SHIFT 3
+#define MAX_LOOP_DEPTH 6
+
+typedef struct {
+    uint64_t count;
+    int len;
+    opcode_t ops[3];
+} profile_run_t;
+
+static uint32_t triple_key(const opcode_t* ops) {
+
+    return ((uint32_t)ops[0] * OP_COUNT + ops[1]) * OP_COUNT + ops[2] + 1;
+}
+
+static void grow_triples(opcode_profile_t* prof) {
+
+    profile_triple_t* old = prof->triples;
+    int old_cap = prof->triple_cap;
+
+    prof->triple_cap = (old_cap == 0) ? 256 : old_cap << 1;
+    prof->triples = _ALLOC_ARRAY(profile_triple_t, prof->triple_cap);
+    memset(prof->triples, 0, sizeof(profile_triple_t) * prof->triple_cap);
+
+    for(int i = 0; i < old_cap; i++)
+        if(old[i].key != 0) {
+            uint32_t slot = old[i].key * 2654435761u & (prof->triple_cap - 1);
+            while(prof->triples[slot].key != 0)
+                slot = (slot + 1) & (prof->triple_cap - 1);
+            prof->triples[slot] = old[i];
+        }
+
+    if(old != NULL)
+        _FREE(old);
+}
+
+static int compare_runs(const void* a, const void* b) {
+
+    const profile_run_t* ra = a;
+    const profile_run_t* rb = b;
+
+    if(ra->count != rb->count)
+        return (ra->count < rb->count) ? 1 : -1;
+    if(ra->len != rb->len)
+        return ra->len - rb->len;
+    return memcmp(ra->ops, rb->ops, sizeof(ra->ops));
+}
+
+static bool find_opcode(const char* name, opcode_t* op) {
+
+    for(int i = 0; i < OP_COUNT; i++)
+        if(!strcmp(opcode_info[i].name, name)) {
+            *op = (opcode_t)i;
+            return true;
+        }
+
+    return false;
+}
+
+/*
+ * public interface
+ */
+
+opcode_profile_t* create_opcode_profile(void) {
+
+    opcode_profile_t* prof = _ALLOC_TYPE(opcode_profile_t);
+    memset(prof, 0, sizeof(opcode_profile_t));
+
+    prof->pairs = _ALLOC_ARRAY(uint64_t, OP_COUNT * OP_COUNT);
+    memset(prof->pairs, 0, sizeof(uint64_t) * OP_COUNT * OP_COUNT);
+    prof->prev = prof->prev2 = OP_COUNT;
+
+    return prof;
+}
+
+void destroy_opcode_profile(opcode_profile_t* prof) {
+
+    if(prof != NULL) {
+        _FREE(prof->pairs);
+        if(prof->triples != NULL)
+            _FREE(prof->triples);
+        _FREE(prof);
+    }
+}
+
+/*
+ * Count a run of two or three opcodes. A run of three does not count the
+ * runs of two in it.
+ */
+void add_opcode_run(opcode_profile_t* prof, const opcode_t* ops, int len, uint64_t count) {
+
+    ASSERT(len == 2 || len == 3, "invalid run length: %d", len);
+
+    if(len == 2) {
+        prof->pairs[ops[0] * OP_COUNT + ops[1]] += count;
+        return;
+    }
+
+    if((prof->ntriples + 1) * 4 > prof->triple_cap * 3)
+        grow_triples(prof);
+
+    uint32_t key = triple_key(ops);
+    uint32_t slot = key * 2654435761u & (prof->triple_cap - 1);
+    while(prof->triples[slot].key != 0 && prof->triples[slot].key != key)
+        slot = (slot + 1) & (prof->triple_cap - 1);
+
+    if(prof->triples[slot].key == 0) {
+        prof->triples[slot].key = key;
+        prof->ntriples++;
+    }
+    prof->triples[slot].count += count;
+}
+
+/*
+ * Estimate how often the runs of a function are executed. The code of a
+ * loop ends in a jump back to its top, and every level of loop around an
+ * instruction weighs it 1 << LOOP_WEIGHT_SHIFT more. A run ends at a jump
+ * target, where the code is reached from somewhere else too, and after
+ * an instruction that does not go on to the next one.
+ */
+void profile_function(opcode_profile_t* prof, function_t* func) {
+
+    if(func->code == NULL || func->len == 0)
+        return;
+
+    int* depth = _ALLOC_ARRAY(int, func->len + 1);
+    bool* target = _ALLOC_ARRAY(bool, func->len + 1);
+    memset(depth, 0, sizeof(int) * (func->len + 1));
+    memset(target, 0, sizeof(bool) * (func->len + 1));
+
+    for(int pos = 0; pos < func->len; pos += OPCODE_SIZE(func->code[pos])) {
+        opcode_t op = (opcode_t)func->code[pos];
+        int size = OPCODE_SIZE(op);
+        if(!opcode_info[op].jump)
+            continue;
+
+        int dest = pos + size + read_operand(&func->code[pos + size - (int)sizeof(int32_t)]);
+        if(dest < 0 || dest > func->len)
+            continue;
+
+        target[dest] = true;
+        if(dest <= pos) {
+            depth[dest]++;
+            depth[pos + size]--;
+        }
+    }
+
+    opcode_t run[3] = { OP_NOP, OP_NOP, OP_NOP };
+    int len = 0;
+    int level = 0;
+    for(int pos = 0; pos < func->len; pos += OPCODE_SIZE(func->code[pos])) {
+        opcode_t op = (opcode_t)func->code[pos];
+
+        // the depth changes only where an instruction starts
+        level += depth[pos];
+        if(target[pos])
+            len = 0;
+
+        uint64_t weight = 1ULL << (LOOP_WEIGHT_SHIFT * ((level < MAX_LOOP_DEPTH) ? level : MAX_LOOP_DEPTH));
+        run[0] = run[1];
+        run[1] = run[2];
+        run[2] = op;
+        if(len < 3)
+            len++;
+
+        if(len >= 2)
+            add_opcode_run(prof, &run[1], 2, weight);
+        if(len == 3)
+            add_opcode_run(prof, run, 3, weight);
+
+        if(op == OP_JUMP || op == OP_RETURN || op == OP_RETURN_VALUE || op == OP_EXIT)
+            len = 0;
+    }
+
+    _FREE(depth);
+    _FREE(target);
+}
+
+/*
+ * Add the counts in a profile file. A run with an opcode that this build
+ * does not have is left out. A file that does not exist is an empty
+ * profile.
+ */
+bool read_opcode_profile(opcode_profile_t* prof, const char* fname) {
+
+    FILE* fp = fopen(fname, "r");
+    if(fp == NULL)
+        return errno == ENOENT;
+
+    char line[256];
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        if(line[0] == '#')
+            continue;
+
+        char* save;
+        char* word = strtok_r(line, " \t\n", &save);
+        if(word == NULL)
+            continue;
+
+        uint64_t count = strtoull(word, NULL, 10);
+        opcode_t ops[3];
+        int len = 0;
+        bool known = true;
+        while(known && NULL != (word = strtok_r(NULL, " \t\n", &save)))
+            known = len < 3 && find_opcode(word, &ops[len++]);
+
+        if(known && len >= 2)
+            add_opcode_run(prof, ops, len, count);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+/*
+ * Add the counts in the file to the profile and write it over the file,
+ * the most frequent runs first.
+ */
+bool save_opcode_profile(opcode_profile_t* prof, const char* fname) {
+
+    if(!read_opcode_profile(prof, fname)) {
+        fprintf(stderr, "profile: cannot read %s: %s\n", fname, strerror(errno));
+        return false;
+    }
+
+    int cap = OP_COUNT * OP_COUNT + prof->ntriples;
+    profile_run_t* runs = _ALLOC_ARRAY(profile_run_t, cap);
+    int nruns = 0;
+
+    for(int i = 0; i < OP_COUNT * OP_COUNT; i++)
+        if(prof->pairs[i] != 0)
+            runs[nruns++] = (profile_run_t){ prof->pairs[i], 2, { i / OP_COUNT, i % OP_COUNT, OP_NOP } };
+
+    for(int i = 0; i < prof->triple_cap; i++)
+        if(prof->triples[i].key != 0) {
+            uint32_t key = prof->triples[i].key - 1;
+            runs[nruns++] = (profile_run_t){
+                prof->triples[i].count, 3, { key / (OP_COUNT * OP_COUNT), key / OP_COUNT % OP_COUNT, key % OP_COUNT }
+            };
+        }
+
+    qsort(runs, nruns, sizeof(profile_run_t), compare_runs);
+
+    FILE* fp = fopen(fname, "w");
+    if(fp == NULL) {
+        fprintf(stderr, "profile: cannot open output file: %s: %s\n", fname, strerror(errno));
+        _FREE(runs);
+        return false;
+    }
+
+    fprintf(fp, "# opcode profile, see src/runtime/opcode_profile.h\n");
+    for(int i = 0; i < nruns; i++) {
+        fprintf(fp, "%llu", (unsigned long long)runs[i].count);
+        for(int j = 0; j < runs[i].len; j++)
+            fprintf(fp, " %s", opcode_to_str(runs[i].ops[j]));
+        fputc('\n', fp);
+    }
+
+    bool ok = fclose(fp) == 0;
+    _FREE(runs);
+    return ok;
+}
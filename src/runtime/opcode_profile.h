@@ -0,0 +1,65 @@
+/**
+ * @file opcode_profile.h
+ *
+ * @brief Counts of the runs of two and three opcodes in a row, which
+ * scripts/superinstructions makes the superinstruction table from. A
+ * virtual machine calls count_opcode() for every instruction that it
+ * dispatches. Without one, the compiler estimates the counts from the code
+ * with profile_function().
+ *
+ * A profile is kept in a text file with a line for each run, the count and
+ * then the names of the opcodes. Saving a profile adds the counts that are
+ * in the file already, so one file collects a whole benchmark run.
+ *
+ */
+#ifndef _OPCODE_PROFILE_H_
+#define _OPCODE_PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "opcodes.h"
+#include "module.h"
+
+typedef struct {
+    // the three opcodes + 1, 0 is an empty slot
+    uint32_t key;
+    uint64_t count;
+} profile_triple_t;
+
+typedef struct {
+    // indexed by first * OP_COUNT + second
+    uint64_t* pairs;
+    profile_triple_t* triples;
+    int ntriples;
+    int triple_cap;
+    // the last two opcodes that were counted, OP_COUNT for none
+    opcode_t prev;
+    opcode_t prev2;
+} opcode_profile_t;
+
+opcode_profile_t* create_opcode_profile(void);
+void destroy_opcode_profile(opcode_profile_t* prof);
+void add_opcode_run(opcode_profile_t* prof, const opcode_t* ops, int len, uint64_t count);
+void profile_function(opcode_profile_t* prof, function_t* func);
+bool read_opcode_profile(opcode_profile_t* prof, const char* fname);
+bool save_opcode_profile(opcode_profile_t* prof, const char* fname);
+
+static inline void count_opcode(opcode_profile_t* prof, opcode_t op) {
+
+    if(prof->prev != OP_COUNT)
+        prof->pairs[prof->prev * OP_COUNT + op]++;
+    if(prof->prev2 != OP_COUNT)
+        add_opcode_run(prof, (opcode_t[]){ prof->prev2, prof->prev, op }, 3, 1);
+
+    prof->prev2 = prof->prev;
+    prof->prev = op;
+}
+
+// a call or a return is not a run with what comes after it
+static inline void break_opcode_run(opcode_profile_t* prof) {
+
+    prof->prev = prof->prev2 = OP_COUNT;
+}
+
+#endif /* _OPCODE_PROFILE_H_ */
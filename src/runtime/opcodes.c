@@ -0,0 +1,124 @@
+/**
+ * @file opcodes.c
+ *
+ * @brief Instruction table. The operand counts have to agree with the
+ * comments in opcodes.h. The superinstructions come from
+ * superinstructions.h.
+ *
+ */
+#include "opcodes.h"
+
+const opcode_info_t opcode_info[OP_COUNT] = {
+    [OP_NOP] = { "NOP", 0 },
+    [OP_PUSH_CONST] = { "PUSH_CONST", 1 },
+    [OP_PUSH_INT] = { "PUSH_INT", 1 },
+    [OP_PUSH_TRUE] = { "PUSH_TRUE", 0 },
+    [OP_PUSH_FALSE] = { "PUSH_FALSE", 0 },
+    [OP_PUSH_NOTHING] = { "PUSH_NOTHING", 0 },
+    [OP_POP] = { "POP", 0 },
+    [OP_LOAD_LOCAL] = { "LOAD_LOCAL", 1 },
+    [OP_STORE_LOCAL] = { "STORE_LOCAL", 1 },
+    [OP_LOAD_GLOBAL] = { "LOAD_GLOBAL", 1 },
+    [OP_STORE_GLOBAL] = { "STORE_GLOBAL", 1 },
+    [OP_GET_FIELD] = { "GET_FIELD", 1 },
+    [OP_SET_FIELD] = { "SET_FIELD", 1 },
+    [OP_GET_MEMBER] = { "GET_MEMBER", 2 },
+    [OP_SET_MEMBER] = { "SET_MEMBER", 2 },
+    [OP_GET_INDEX] = { "GET_INDEX", 0 },
+    [OP_SET_INDEX] = { "SET_INDEX", 0 },
+    [OP_NEW_LIST] = { "NEW_LIST", 1 },
+    [OP_NEW_DICT] = { "NEW_DICT", 1 },
+    [OP_NEW_STRUCT] = { "NEW_STRUCT", 1 },
+    [OP_ADD_INT] = { "ADD_INT", 0 },
+    [OP_SUB_INT] = { "SUB_INT", 0 },
+    [OP_MUL_INT] = { "MUL_INT", 0 },
+    [OP_DIV_INT] = { "DIV_INT", 0 },
+    [OP_MOD_INT] = { "MOD_INT", 0 },
+    [OP_POW_INT] = { "POW_INT", 0 },
+    [OP_NEG_INT] = { "NEG_INT", 0 },
+    [OP_ADD_FLOAT] = { "ADD_FLOAT", 0 },
+    [OP_SUB_FLOAT] = { "SUB_FLOAT", 0 },
+    [OP_MUL_FLOAT] = { "MUL_FLOAT", 0 },
+    [OP_DIV_FLOAT] = { "DIV_FLOAT", 0 },
+    [OP_POW_FLOAT] = { "POW_FLOAT", 0 },
+    [OP_NEG_FLOAT] = { "NEG_FLOAT", 0 },
+    [OP_CONCAT_STR] = { "CONCAT_STR", 0 },
+    [OP_EQ_INT] = { "EQ_INT", 0 },
+    [OP_NE_INT] = { "NE_INT", 0 },
+    [OP_LT_INT] = { "LT_INT", 0 },
+    [OP_LE_INT] = { "LE_INT", 0 },
+    [OP_GT_INT] = { "GT_INT", 0 },
+    [OP_GE_INT] = { "GE_INT", 0 },
+    [OP_EQ_FLOAT] = { "EQ_FLOAT", 0 },
+    [OP_NE_FLOAT] = { "NE_FLOAT", 0 },
+    [OP_LT_FLOAT] = { "LT_FLOAT", 0 },
+    [OP_LE_FLOAT] = { "LE_FLOAT", 0 },
+    [OP_GT_FLOAT] = { "GT_FLOAT", 0 },
+    [OP_GE_FLOAT] = { "GE_FLOAT", 0 },
+    [OP_EQ_STR] = { "EQ_STR", 0 },
+    [OP_NE_STR] = { "NE_STR", 0 },
+    [OP_LT_STR] = { "LT_STR", 0 },
+    [OP_LE_STR] = { "LE_STR", 0 },
+    [OP_GT_STR] = { "GT_STR", 0 },
+    [OP_GE_STR] = { "GE_STR", 0 },
+    [OP_NOT] = { "NOT", 0 },
+    [OP_AND] = { "AND", 0 },
+    [OP_OR] = { "OR", 0 },
+    [OP_ADD] = { "ADD", 0 },
+    [OP_SUB] = { "SUB", 0 },
+    [OP_MUL] = { "MUL", 0 },
+    [OP_DIV] = { "DIV", 0 },
+    [OP_MOD] = { "MOD", 0 },
+    [OP_POW] = { "POW", 0 },
+    [OP_NEG] = { "NEG", 0 },
+    [OP_EQ] = { "EQ", 0 },
+    [OP_NE] = { "NE", 0 },
+    [OP_LT] = { "LT", 0 },
+    [OP_LE] = { "LE", 0 },
+    [OP_GT] = { "GT", 0 },
+    [OP_GE] = { "GE", 0 },
+    [OP_INT_TO_FLOAT] = { "INT_TO_FLOAT", 0 },
+    [OP_FLOAT_TO_INT] = { "FLOAT_TO_INT", 0 },
+    [OP_INT_TO_STR] = { "INT_TO_STR", 0 },
+    [OP_FLOAT_TO_STR] = { "FLOAT_TO_STR", 0 },
+    [OP_BOOL_TO_STR] = { "BOOL_TO_STR", 0 },
+    [OP_STR_TO_INT] = { "STR_TO_INT", 0 },
+    [OP_STR_TO_FLOAT] = { "STR_TO_FLOAT", 0 },
+    [OP_STR_TO_BOOL] = { "STR_TO_BOOL", 0 },
+    [OP_INT_TO_BOOL] = { "INT_TO_BOOL", 0 },
+    [OP_BOOL_TO_INT] = { "BOOL_TO_INT", 0 },
+    [OP_CAST] = { "CAST", 1 },
+    [OP_CHECK_TYPE] = { "CHECK_TYPE", 2 },
+    [OP_FORMAT] = { "FORMAT", 1 },
+    [OP_JUMP] = { "JUMP", 1, true },
+    [OP_JUMP_FALSE] = { "JUMP_FALSE", 1, true },
+    [OP_JUMP_TRUE] = { "JUMP_TRUE", 1, true },
+    [OP_ITER_INIT] = { "ITER_INIT", 1 },
+    [OP_ITER_NEXT] = { "ITER_NEXT", 2, true },
+    [OP_CALL] = { "CALL", 2 },
+    [OP_RETURN] = { "RETURN", 0 },
+    [OP_RETURN_VALUE] = { "RETURN_VALUE", 0 },
+    [OP_EXIT] = { "EXIT", 0 },
+#define SUPERINSTRUCTION(name, operands, jump, ...) [OP_##name] = { #name, operands, jump },
+#include "superinstructions.h"
+#undef SUPERINSTRUCTION
+};
+
+// the empty entry at the end keeps the array from being empty
+const fusion_t fusion_table[] = {
+#define SUPERINSTRUCTION(name, operands, jump, ...) \
+    { OP_##name, sizeof((opcode_t[]){ __VA_ARGS__ }) / sizeof(opcode_t), { __VA_ARGS__ } },
+#include "superinstructions.h"
+#undef SUPERINSTRUCTION
+    { OP_NOP, 0, { OP_NOP } },
+};
+
+const int fusion_count = sizeof(fusion_table) / sizeof(fusion_table[0]) - 1;
+
+const char* opcode_to_str(opcode_t op) {
+
+    if(op < OP_COUNT)
+        return opcode_info[op].name;
+    else
+        return "UNKNOWN";
+}
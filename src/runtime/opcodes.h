@@ -0,0 +1,187 @@
+/**
+ * @file opcodes.h
+ *
+ * @brief The instruction set of the virtual machine.
+ *
+ * An instruction is one opcode byte followed by zero or more operands.
+ * Every operand is a 32 bit little endian integer. Jump offsets are
+ * relative to the first byte of the next instruction.
+ *
+ * Where the compiler knows the types of the operands it emits a typed
+ * instruction such as OP_ADD_INT, which does not have to look at the type
+ * tags at run time. The generic instructions dispatch on the type tags and
+ * are only used when a value comes out of a list or a dict.
+ *
+ * OP_FORMAT renders a format program of the module. The compiler parsed
+ * the template, so only the values of the placeholders are on the stack,
+ * in the order the program numbers them.
+ *
+ * A superinstruction does the work of a run of two or three instructions
+ * with one dispatch. Its operands are the operands of the run in order.
+ * The runs are picked from an opcode profile, see superinstructions.h.
+ *
+ */
+#ifndef _OPCODES_H_
+#define _OPCODES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    OP_NOP,
+
+    // stack and constants
+    OP_PUSH_CONST,   // const index
+    OP_PUSH_INT,     // immediate value
+    OP_PUSH_TRUE,
+    OP_PUSH_FALSE,
+    OP_PUSH_NOTHING,
+    OP_POP,
+
+    // variables
+    OP_LOAD_LOCAL,   // frame slot
+    OP_STORE_LOCAL,  // frame slot
+    OP_LOAD_GLOBAL,  // global slot
+    OP_STORE_GLOBAL, // global slot
+
+    // aggregates
+    OP_GET_FIELD,  // field slot
+    OP_SET_FIELD,  // field slot
+    OP_GET_MEMBER, // const index of the name, member cache
+    OP_SET_MEMBER, // const index of the name, member cache
+    OP_GET_INDEX,
+    OP_SET_INDEX,
+    OP_NEW_LIST,   // item count
+    OP_NEW_DICT,   // item count
+    OP_NEW_STRUCT, // struct index
+
+    // typed arithmetic
+    OP_ADD_INT,
+    OP_SUB_INT,
+    OP_MUL_INT,
+    OP_DIV_INT,
+    OP_MOD_INT,
+    OP_POW_INT,
+    OP_NEG_INT,
+    OP_ADD_FLOAT,
+    OP_SUB_FLOAT,
+    OP_MUL_FLOAT,
+    OP_DIV_FLOAT,
+    OP_POW_FLOAT,
+    OP_NEG_FLOAT,
+    OP_CONCAT_STR,
+
+    // typed comparisons
+    OP_EQ_INT,
+    OP_NE_INT,
+    OP_LT_INT,
+    OP_LE_INT,
+    OP_GT_INT,
+    OP_GE_INT,
+    OP_EQ_FLOAT,
+    OP_NE_FLOAT,
+    OP_LT_FLOAT,
+    OP_LE_FLOAT,
+    OP_GT_FLOAT,
+    OP_GE_FLOAT,
+    OP_EQ_STR,
+    OP_NE_STR,
+    OP_LT_STR,
+    OP_LE_STR,
+    OP_GT_STR,
+    OP_GE_STR,
+
+    // logic
+    OP_NOT,
+    OP_AND,
+    OP_OR,
+
+    // generic, dispatched on the type tags
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_POW,
+    OP_NEG,
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+
+    // conversions
+    OP_INT_TO_FLOAT,
+    OP_FLOAT_TO_INT,
+    OP_INT_TO_STR,
+    OP_FLOAT_TO_STR,
+    OP_BOOL_TO_STR,
+    OP_STR_TO_INT,
+    OP_STR_TO_FLOAT,
+    OP_STR_TO_BOOL,
+    OP_INT_TO_BOOL,
+    OP_BOOL_TO_INT,
+    OP_CAST,       // value type tag
+    OP_CHECK_TYPE, // value type tag, struct index or -1
+    OP_FORMAT,     // format index
+
+    // control
+    OP_JUMP,       // offset
+    OP_JUMP_FALSE, // offset
+    OP_JUMP_TRUE,  // offset
+    OP_ITER_INIT,  // frame slot for the iterator
+    OP_ITER_NEXT,  // frame slot for the iterator, offset when done
+    OP_CALL,       // function index, argument count
+    OP_RETURN,
+    OP_RETURN_VALUE,
+    OP_EXIT,
+
+    // superinstructions
+#define SUPERINSTRUCTION(name, operands, jump, ...) OP_##name,
+#include "superinstructions.h"
+#undef SUPERINSTRUCTION
+
+    OP_COUNT
+} opcode_t;
+
+typedef struct {
+    const char* name;
+    int operands;
+    // the last operand is a jump offset
+    bool jump;
+} opcode_info_t;
+
+// the longest run that a superinstruction stands for
+#define MAX_FUSED 3
+
+typedef struct {
+    opcode_t op;
+    int len;
+    opcode_t parts[MAX_FUSED];
+} fusion_t;
+
+extern const opcode_info_t opcode_info[OP_COUNT];
+extern const fusion_t fusion_table[];
+extern const int fusion_count;
+
+#define OPCODE_SIZE(op) (1 + opcode_info[op].operands * (int)sizeof(int32_t))
+
+static inline int32_t read_operand(const uint8_t* code) {
+
+    return (int32_t)((uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24));
+}
+
+static inline void write_operand(uint8_t* ptr, int32_t value) {
+
+    uint32_t v = (uint32_t)value;
+
+    ptr[0] = (uint8_t)(v & 0xFF);
+    ptr[1] = (uint8_t)((v >> 8) & 0xFF);
+    ptr[2] = (uint8_t)((v >> 16) & 0xFF);
+    ptr[3] = (uint8_t)((v >> 24) & 0xFF);
+}
+
+const char* opcode_to_str(opcode_t op);
+
+#endif /* _OPCODES_H_ */
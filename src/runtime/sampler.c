@@ -0,0 +1,401 @@
+/**
+ * @file sampler.c
+ *
+ * @brief Taking the samples in a signal handler, and counting them by
+ * stack and by line.
+ *
+ * The handler only copies words into a fixed buffer. A sample there is the
+ * number of frames and then the function and the position of each one. A
+ * sample that does not fit is dropped and counted. drain_samples() empties
+ * the buffer, with SIGPROF blocked while it takes the samples out, and is
+ * called by the interpreter at safe points and when the sampler stops.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "sampler.h"
+
+// #define BENCH_SAMPLER
+
+// words in the sample buffer
+#define SAMPLE_BUFFER (1 << 16)
+#define MAX_STACK_TEXT 4096
+
+volatile sample_stack_t sample_stack;
+
+static int32_t buffer[SAMPLE_BUFFER];
+static volatile int buffer_len;
+static volatile uint64_t dropped;
+static struct sigaction old_action;
+static sampler_t* running = NULL;
+
+static void on_sigprof(int sig) {
+
+    (void)sig;
+
+    int depth = sample_stack.depth;
+    int len = buffer_len;
+    int frames = (depth < SAMPLE_DEPTH) ? depth : SAMPLE_DEPTH;
+
+    if(depth <= 0)
+        return;
+    if(len + 1 + frames * 2 > SAMPLE_BUFFER) {
+        dropped++;
+        return;
+    }
+
+    // the outermost frames are not kept, so the first one is "..." and the
+    // rest are the innermost frames
+    volatile sample_frame_t* stack = sample_stack.frames;
+    int first = depth - frames;
+    int skip = 0;
+    if(depth > SAMPLE_DEPTH) {
+        buffer[len + 1] = -1;
+        buffer[len + 2] = 0;
+        first++;
+        skip = 1;
+    }
+
+    buffer[len] = frames;
+    for(int i = skip; i < frames; i++) {
+        buffer[len + 1 + i * 2] = stack[first + i - skip].func;
+        buffer[len + 2 + i * 2] = stack[first + i - skip].pc;
+    }
+
+    buffer_len = len + 1 + frames * 2;
+}
+
+static void block_sigprof(int how) {
+
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPROF);
+    sigprocmask(how, &set, NULL);
+}
+
+static int count_index(hash_table_t* index, const char* key, void** array, int* len, int* cap, size_t size) {
+
+    void* data;
+    if(find_hashtable(index, key, &data))
+        return (int)(intptr_t)data - 1;
+
+    if(*len + 1 > *cap) {
+        *cap = (*cap == 0) ? 64 : *cap << 1;
+        *array = _REALLOC_ARRAY(*array, uint8_t, *cap * size);
+    }
+    memset((uint8_t*)*array + *len * size, 0, size);
+    insert_hashtable(index, key, (void*)(intptr_t)(*len + 1));
+
+    return (*len)++;
+}
+
+static int frame_line(sampler_t* smp, int func, int pc) {
+
+    int line = 0;
+    int col;
+
+    if(func >= 0 && func < smp->mod->nfunctions)
+        find_line(&smp->mod->functions[func], pc, &line, &col);
+
+    return line;
+}
+
+static const char* frame_name(sampler_t* smp, int func) {
+
+    return (func >= 0 && func < smp->mod->nfunctions) ? smp->mod->functions[func].name : "...";
+}
+
+static void count_sample(sampler_t* smp, const int32_t* sample) {
+
+    int frames = sample[0];
+    char text[MAX_STACK_TEXT];
+    int len = 0;
+
+    for(int i = 0; i < frames && len < (int)sizeof(text); i++) {
+        int func = sample[1 + i * 2];
+        if(func < 0)
+            len += snprintf(&text[len], sizeof(text) - len, "%s...", (i > 0) ? ";" : "");
+        else
+            len += snprintf(&text[len], sizeof(text) - len, "%s%s (%s:%d)", (i > 0) ? ";" : "", frame_name(smp, func),
+                            smp->fname, frame_line(smp, func, sample[2 + i * 2]));
+    }
+
+    int index = count_index(smp->stack_index, text, (void**)&smp->stacks, &smp->nstacks, &smp->stack_cap,
+                            sizeof(stack_count_t));
+    if(smp->stacks[index].stack == NULL)
+        smp->stacks[index].stack = _COPY_STRING(text);
+    smp->stacks[index].count++;
+
+    // the line that was running is the innermost frame
+    int func = sample[1 + (frames - 1) * 2];
+    if(func >= 0) {
+        int line = frame_line(smp, func, sample[2 + (frames - 1) * 2]);
+        snprintf(text, sizeof(text), "%d:%d", func, line);
+        index = count_index(smp->line_index, text, (void**)&smp->lines, &smp->nlines, &smp->line_cap,
+                            sizeof(line_count_t));
+        smp->lines[index].func = func;
+        smp->lines[index].line = line;
+        smp->lines[index].count++;
+    }
+
+    smp->samples++;
+}
+
+static int compare_lines(const void* a, const void* b) {
+
+    const line_count_t* la = a;
+    const line_count_t* lb = b;
+
+    if(la->count != lb->count)
+        return (la->count < lb->count) ? 1 : -1;
+    return (la->line != lb->line) ? la->line - lb->line : la->func - lb->func;
+}
+
+/*
+ * public interface
+ */
+
+/*
+ * Start taking hz samples a second of the CPU time of the program. Only
+ * one sampler runs at a time. Returns NULL when one is running already or
+ * the timer cannot be set.
+ */
+sampler_t* start_sampler(module_t* mod, const char* fname, int hz) {
+
+    if(running != NULL || hz <= 0 || hz > 1000000)
+        return NULL;
+
+    sampler_t* smp = _ALLOC_TYPE(sampler_t);
+    memset(smp, 0, sizeof(sampler_t));
+    smp->mod = mod;
+    smp->fname = fname;
+    smp->stack_index = create_hashtable();
+    smp->line_index = create_hashtable();
+
+    buffer_len = 0;
+    dropped = 0;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_sigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    // tv_usec has to be less than a second
+    int usec = 1000000 / hz;
+    struct itimerval timer;
+    timer.it_interval.tv_sec = usec / 1000000;
+    timer.it_interval.tv_usec = usec % 1000000;
+    timer.it_value = timer.it_interval;
+
+    if(sigaction(SIGPROF, &action, &old_action) != 0 || setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+        fprintf(stderr, "sampler: cannot start the timer: %s\n", strerror(errno));
+        sigaction(SIGPROF, &old_action, NULL);
+        destroy_sampler(smp);
+        return NULL;
+    }
+
+    running = smp;
+    return smp;
+}
+
+void stop_sampler(sampler_t* smp) {
+
+    if(smp != running)
+        return;
+
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &old_action, NULL);
+
+    drain_samples(smp);
+    running = NULL;
+}
+
+/*
+ * Take the samples out of the buffer and count them. The buffer is copied
+ * with the signal blocked, and counted after.
+ */
+void drain_samples(sampler_t* smp) {
+
+    block_sigprof(SIG_BLOCK);
+    int len = buffer_len;
+    int32_t* copy = NULL;
+    if(len > 0) {
+        copy = _ALLOC_ARRAY(int32_t, len);
+        memcpy(copy, buffer, sizeof(int32_t) * len);
+    }
+    buffer_len = 0;
+    smp->dropped += dropped;
+    dropped = 0;
+    block_sigprof(SIG_UNBLOCK);
+
+    for(int pos = 0; pos < len; pos += 1 + copy[pos] * 2)
+        count_sample(smp, &copy[pos]);
+
+    if(copy != NULL)
+        _FREE(copy);
+}
+
+bool save_folded_stacks(sampler_t* smp, const char* out) {
+
+    FILE* fp = fopen(out, "w");
+    if(fp == NULL) {
+        fprintf(stderr, "sampler: cannot open output file: %s: %s\n", out, strerror(errno));
+        return false;
+    }
+
+    for(int i = 0; i < smp->nstacks; i++)
+        fprintf(fp, "%s %llu\n", smp->stacks[i].stack, (unsigned long long)smp->stacks[i].count);
+
+    return fclose(fp) == 0;
+}
+
+void print_hot_lines(sampler_t* smp, FILE* fp, int count) {
+
+    line_count_t* lines = NULL;
+    if(smp->nlines > 0) {
+        lines = _ALLOC_ARRAY(line_count_t, smp->nlines);
+        memcpy(lines, smp->lines, sizeof(line_count_t) * smp->nlines);
+        qsort(lines, smp->nlines, sizeof(line_count_t), compare_lines);
+    }
+
+    fprintf(fp, "%llu samples, %llu dropped\n", (unsigned long long)smp->samples, (unsigned long long)smp->dropped);
+    for(int i = 0; i < smp->nlines && i < count; i++) {
+        char where[256];
+        snprintf(where, sizeof(where), "%s:%d", smp->fname, lines[i].line);
+        fprintf(fp, "%8llu %5.1f%%  %-24s %s\n", (unsigned long long)lines[i].count,
+                100.0 * (double)lines[i].count / (double)smp->samples, where, frame_name(smp, lines[i].func));
+    }
+
+    if(lines != NULL)
+        _FREE(lines);
+}
+
+void destroy_sampler(sampler_t* smp) {
+
+    if(smp != NULL) {
+        stop_sampler(smp);
+        for(int i = 0; i < smp->nstacks; i++)
+            _FREE(smp->stacks[i].stack);
+        if(smp->stacks != NULL)
+            _FREE(smp->stacks);
+        if(smp->lines != NULL)
+            _FREE(smp->lines);
+        destroy_hashtable(smp->stack_index);
+        destroy_hashtable(smp->line_index);
+        _FREE(smp);
+    }
+}
+
+/*
+ * Make room for more frames on the stack of the interpreter. Called by
+ * sample_call() when the stack is full. The frames are copied to the new
+ * array with SIGPROF blocked, so the handler never reads one that is
+ * half done or freed.
+ */
+void grow_sample_stack(void) {
+
+    int cap = (sample_stack.cap == 0) ? 256 : sample_stack.cap << 1;
+    sample_frame_t* frames = _ALLOC_ARRAY(sample_frame_t, cap);
+
+    block_sigprof(SIG_BLOCK);
+    volatile sample_frame_t* old = sample_stack.frames;
+    for(int i = 0; i < sample_stack.depth; i++)
+        frames[i] = old[i];
+    sample_stack.frames = frames;
+    sample_stack.cap = cap;
+    block_sigprof(SIG_UNBLOCK);
+
+    if(old != NULL)
+        _FREE(old);
+}
+
+void free_sample_stack(void) {
+
+    block_sigprof(SIG_BLOCK);
+    volatile sample_frame_t* old = sample_stack.frames;
+    sample_stack.frames = NULL;
+    sample_stack.cap = 0;
+    sample_stack.depth = 0;
+    block_sigprof(SIG_UNBLOCK);
+
+    if(old != NULL)
+        _FREE(old);
+}
+
+#ifdef BENCH_SAMPLER
+
+#include <time.h>
+
+static double elapsed(struct timespec* start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * What the interpreter does for the sampler: a store of the position for
+ * every instruction, and a call now and then.
+ */
+static uint64_t busy(int count) {
+
+    uint64_t sum = 0;
+    for(int i = 0; i < count; i++) {
+        if((i & 1023) == 0)
+            sample_call(1);
+        sample_pc(i & 15);
+        sum += (uint64_t)i * i;
+        if((i & 1023) == 1023)
+            sample_return();
+    }
+
+    return sum;
+}
+
+int main(void) {
+
+    module_t* mod = create_module(2, 0, 0);
+    mod->functions[0].name = "main";
+    mod->functions[1].name = "work";
+    for(int i = 0; i < 16; i++) {
+        add_line(&mod->functions[1], 10 + i / 4, 1);
+        emit_code(&mod->functions[1], OP_NOP, 0, 0);
+    }
+
+    const int count = 500000000;
+    volatile uint64_t sink = 0;
+    struct timespec start;
+    int rates[] = { 0, SAMPLER_HZ, 1000, 10000 };
+
+    sample_call(0);
+    for(int i = 0; i < (int)(sizeof(rates) / sizeof(rates[0])); i++) {
+        sampler_t* smp = (rates[i] > 0) ? start_sampler(mod, "bench.toy", rates[i]) : NULL;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sink += busy(count);
+        double secs = elapsed(&start);
+
+        printf("%6d Hz: %.3f sec\n", rates[i], secs);
+        if(smp != NULL) {
+            stop_sampler(smp);
+            print_hot_lines(smp, stdout, 4);
+            destroy_sampler(smp);
+        }
+    }
+
+    free_sample_stack();
+    destroy_module(mod);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file sampler.h
+ *
+ * @brief A sampling profiler for Toy programs. A SIGPROF timer interrupts
+ * the program at a fixed rate, and the signal handler copies the call
+ * stack of the interpreter into a buffer. The samples are turned into
+ * source lines with the line tables later, outside of the handler, so a
+ * sample costs a copy of a few words and the profiler can stay on.
+ *
+ * The interpreter keeps its call stack where the handler can read it:
+ * sample_call() when a function is entered, sample_return() when it
+ * returns and sample_pc() with the position of the instruction it is
+ * about to run. The stack has a frame for every call, however deep, and
+ * grows in sample_call(), never in the handler. The handler copies the
+ * innermost SAMPLE_DEPTH frames of it.
+ *
+ * The samples are written as folded stacks, one line for each stack with
+ * the frames outermost first and the number of samples, which is what
+ * flamegraph.pl reads. The hot lines report counts the samples by the line
+ * that was running.
+ *
+ * Benchmark build string:
+ * gcc -O2 -DBENCH_SAMPLER -I../common -o bsmp sampler.c module.c format.c opcodes.c value.c ffi.c ../common/alloc.c ../common/hash.c -ldl -lm
+ */
+#ifndef _SAMPLER_H_
+#define _SAMPLER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "module.h"
+#include "hash.h"
+
+// a low rate that does not beat in step with the program
+#define SAMPLER_HZ 97
+// the innermost frames that are kept in a sample, the ones outside of them
+// are shown as one frame named "..."
+#define SAMPLE_DEPTH 64
+
+typedef struct {
+    int32_t func;
+    int32_t pc;
+} sample_frame_t;
+
+// written by the interpreter, read by the signal handler. frames has room
+// for cap frames and is only replaced with SIGPROF blocked.
+typedef struct {
+    volatile sample_frame_t* frames;
+    int cap;
+    int depth;
+} sample_stack_t;
+
+extern volatile sample_stack_t sample_stack;
+
+typedef struct {
+    char* stack;
+    uint64_t count;
+} stack_count_t;
+
+typedef struct {
+    int func;
+    int line;
+    uint64_t count;
+} line_count_t;
+
+typedef struct {
+    module_t* mod;
+    const char* fname;
+    // key to index + 1
+    hash_table_t* stack_index;
+    stack_count_t* stacks;
+    int nstacks;
+    int stack_cap;
+    hash_table_t* line_index;
+    line_count_t* lines;
+    int nlines;
+    int line_cap;
+    uint64_t samples;
+    uint64_t dropped;
+} sampler_t;
+
+sampler_t* start_sampler(module_t* mod, const char* fname, int hz);
+void stop_sampler(sampler_t* smp);
+void drain_samples(sampler_t* smp);
+bool save_folded_stacks(sampler_t* smp, const char* out);
+void print_hot_lines(sampler_t* smp, FILE* fp, int count);
+void destroy_sampler(sampler_t* smp);
+void grow_sample_stack(void);
+void free_sample_stack(void);
+
+static inline void sample_call(int func) {
+
+    int depth = sample_stack.depth;
+
+    if(depth >= sample_stack.cap)
+        grow_sample_stack();
+
+    volatile sample_frame_t* frame = &sample_stack.frames[depth];
+    frame->func = func;
+    frame->pc = 0;
+    sample_stack.depth = depth + 1;
+}
+
+static inline void sample_return(void) {
+
+    sample_stack.depth--;
+}
+
+static inline void sample_pc(int pc) {
+
+    int depth = sample_stack.depth;
+
+    if(depth > 0)
+        sample_stack.frames[depth - 1].pc = pc;
+}
+
+#endif /* _SAMPLER_H_ */
@@ -0,0 +1,45 @@
+/**
+ * @file superinstructions.h
+ *
+ * @brief The superinstructions, made by scripts/superinstructions from
+ * tests/opcode_profile.txt. Do not edit it, run the script again on a new
+ * profile.
+ *
+ * SUPERINSTRUCTION(name, operands, jump, instructions...) is defined by
+ * the file that includes this one. There is no include guard, it is
+ * included once for each table.
+ *
+ */
+
+// 4096 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_PUSH_INT, 2, false, OP_LOAD_LOCAL, OP_PUSH_INT)
+// 4096 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_PUSH_INT_SUB_INT, 2, false, OP_LOAD_LOCAL, OP_PUSH_INT, OP_SUB_INT)
+// 4096 dispatches saved
+SUPERINSTRUCTION(PUSH_INT_SUB_INT_STORE_LOCAL, 2, false, OP_PUSH_INT, OP_SUB_INT, OP_STORE_LOCAL)
+// 3584 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_LOAD_LOCAL, 2, false, OP_LOAD_LOCAL, OP_LOAD_LOCAL)
+// 3072 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_PUSH_INT_GT_INT, 2, false, OP_LOAD_LOCAL, OP_PUSH_INT, OP_GT_INT)
+// 3072 dispatches saved
+SUPERINSTRUCTION(PUSH_INT_GT_INT_JUMP_FALSE, 2, true, OP_PUSH_INT, OP_GT_INT, OP_JUMP_FALSE)
+// 2560 dispatches saved
+SUPERINSTRUCTION(PUSH_INT_SUB_INT, 1, false, OP_PUSH_INT, OP_SUB_INT)
+// 2560 dispatches saved
+SUPERINSTRUCTION(SUB_INT_STORE_LOCAL, 1, false, OP_SUB_INT, OP_STORE_LOCAL)
+// 2048 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_LOAD_LOCAL_ADD_INT, 2, false, OP_LOAD_LOCAL, OP_LOAD_LOCAL, OP_ADD_INT)
+// 2048 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_PUSH_INT_ADD_INT, 2, false, OP_LOAD_LOCAL, OP_PUSH_INT, OP_ADD_INT)
+// 2048 dispatches saved
+SUPERINSTRUCTION(PUSH_INT_ADD_INT_STORE_LOCAL, 2, false, OP_PUSH_INT, OP_ADD_INT, OP_STORE_LOCAL)
+// 1536 dispatches saved
+SUPERINSTRUCTION(GT_INT_JUMP_FALSE, 1, true, OP_GT_INT, OP_JUMP_FALSE)
+// 1536 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_LOAD_LOCAL_LT_INT, 2, false, OP_LOAD_LOCAL, OP_LOAD_LOCAL, OP_LT_INT)
+// 1536 dispatches saved
+SUPERINSTRUCTION(LOAD_LOCAL_LT_INT_JUMP_FALSE, 2, true, OP_LOAD_LOCAL, OP_LT_INT, OP_JUMP_FALSE)
+// 1536 dispatches saved
+SUPERINSTRUCTION(PUSH_INT_GT_INT, 1, false, OP_PUSH_INT, OP_GT_INT)
+// 1280 dispatches saved
+SUPERINSTRUCTION(ADD_INT_STORE_LOCAL, 1, false, OP_ADD_INT, OP_STORE_LOCAL)
@@ -0,0 +1,21 @@
+/**
+ * @file value.c
+ *
+ * @brief Runtime type tags.
+ *
+ */
+#include "value.h"
+
+const char* val_type_to_str(value_type_t type) {
+
+    return (type == VAL_NOTHING)  ? "nothing" :
+            (type == VAL_BOOL)    ? "bool" :
+            (type == VAL_INT)     ? "int" :
+            (type == VAL_FLOAT)   ? "float" :
+            (type == VAL_STRING)  ? "string" :
+            (type == VAL_LIST)    ? "list" :
+            (type == VAL_DICT)    ? "dict" :
+            (type == VAL_STRUCT)  ? "struct" :
+            (type == VAL_ITER)    ? "iterator" :
+                                    "UNKNOWN";
+}
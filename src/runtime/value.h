@@ -0,0 +1,25 @@
+/**
+ * @file value.h
+ *
+ * @brief Runtime type tags. These are shared by the compiler, which encodes
+ * them as instruction operands, and the virtual machine.
+ *
+ */
+#ifndef _VALUE_H_
+#define _VALUE_H_
+
+typedef enum {
+    VAL_NOTHING,
+    VAL_BOOL,
+    VAL_INT,
+    VAL_FLOAT,
+    VAL_STRING,
+    VAL_LIST,
+    VAL_DICT,
+    VAL_STRUCT,
+    VAL_ITER,
+} value_type_t;
+
+const char* val_type_to_str(value_type_t type);
+
+#endif /* _VALUE_H_ */
@@ -0,0 +1,187 @@
+/**
+ * @file fuzz.c
+ *
+ * @brief Entry points for libFuzzer. The input is scanned from memory with
+ * open_buffer(), so there is no file. Built with FUZZ_PARSER, the tokens
+ * are also parsed, otherwise only the scanner is run. The parser target is
+ * only built with TOY_FUZZ_PARSER, since most of the parser rules have no
+ * body yet.
+ *
+ * Every input is timed. One that takes longer than the limit per token is
+ * a slow input. It is reported and the process aborts, so the fuzzer keeps
+ * it like a crash. That finds the inputs that make the parser backtrack
+ * without end or recurse too deep before a compile finds them. The limit
+ * is TOY_FUZZ_SLOW_NS in nanoseconds per token. When the fuzzer exits, the
+ * number of tokens per second is printed.
+ *
+ * The AST is not freed, so run the parser with -detect_leaks=0. An input
+ * that never ends is caught by the -timeout of the fuzzer.
+ *
+ * Built with FUZZ_STANDALONE, there is a main() that runs each file on the
+ * command line once, for a compiler that has no libFuzzer or to run again
+ * an input that the fuzzer saved.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "tokens.h"
+#include "file_io.h"
+#ifdef FUZZ_PARSER
+#include "parser.h"
+#endif
+
+// nanoseconds per token
+#define SLOW_LIMIT 100000.0
+// an input that takes less than this is never slow, so that a page fault
+// does not make a small one look bad
+#define SLOW_FLOOR_NS 10000000.0
+
+typedef struct {
+    uint64_t inputs;
+    uint64_t tokens;
+    double ns;
+    double slowest;
+} fuzz_stats_t;
+
+static fuzz_stats_t stats;
+static double slow_limit = SLOW_LIMIT;
+
+static double now_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void print_stats(void) {
+
+    fprintf(stderr, "fuzz: %lu inputs, %lu tokens, %.0f tokens per second, slowest %.0f ns per token\n",
+            (unsigned long)stats.inputs, (unsigned long)stats.tokens,
+            (stats.ns > 0) ? stats.tokens / (stats.ns / 1e9) : 0.0, stats.slowest);
+}
+
+static void check_time(const char* what, size_t size, int ntokens, double ns) {
+
+    // there is always the end of file token
+    double per_token = ns / (ntokens > 0 ? ntokens : 1);
+
+    stats.inputs++;
+    stats.tokens += ntokens;
+    stats.ns += ns;
+    if(per_token > stats.slowest)
+        stats.slowest = per_token;
+
+    if(ns > SLOW_FLOOR_NS && per_token > slow_limit) {
+        fprintf(stderr, "fuzz: slow input: %s %zu bytes, %d tokens in %.3f ms, %.0f ns per token, limit is %.0f\n",
+                what, size, ntokens, ns / 1e6, per_token, slow_limit);
+        abort();
+    }
+}
+
+/*
+ * Scan the whole input into the token queue and return the tokens, linked
+ * by next. The text has to be writable and end in two '\0' bytes.
+ */
+static token_t* scan_input(char* text, size_t size, int* ntokens) {
+
+    open_buffer("fuzz", text, size, 0, 1, 1);
+
+    *ntokens = 0;
+    token_t* tok;
+    while(NULL != (tok = scan_token_queue())) {
+        (*ntokens)++;
+        if(tok->type == TOK_END_OF_FILE)
+            break;
+    }
+
+    token_t* head = release_token_queue();
+    reset_file_io();
+
+    return head;
+}
+
+static void destroy_tokens(token_t* head) {
+
+    token_t* next;
+    for(token_t* tok = head; tok != NULL; tok = next) {
+        next = tok->next;
+        destroy_token(tok);
+    }
+}
+
+/*
+ * public interface
+ */
+
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+
+    (void)argc;
+    (void)argv;
+
+    const char* str = getenv("TOY_FUZZ_SLOW_NS");
+    if(str != NULL && atof(str) > 0)
+        slow_limit = atof(str);
+
+    atexit(print_stats);
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+
+    char* text = _ALLOC(size + 2);
+    memcpy(text, data, size);
+    text[size] = '\0';
+    text[size + 1] = '\0';
+
+    int ntokens;
+#ifdef FUZZ_PARSER
+    token_t* head = scan_input(text, size, &ntokens);
+
+    double start = now_ns();
+    borrow_token_queue(head, NULL);
+    parse();
+    release_token_queue();
+    check_time("parse", size, ntokens, now_ns() - start);
+#else
+    double start = now_ns();
+    token_t* head = scan_input(text, size, &ntokens);
+    check_time("scan", size, ntokens, now_ns() - start);
+#endif
+
+    destroy_tokens(head);
+    _FREE(text);
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+int main(int argc, char** argv) {
+
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    for(int i = 1; i < argc; i++) {
+        FILE* fp = fopen(argv[i], "rb");
+        if(fp == NULL)
+            FATAL("cannot open input file: %s", argv[i]);
+
+        fseek(fp, 0, SEEK_END);
+        size_t size = ftell(fp);
+        rewind(fp);
+
+        uint8_t* data = _ALLOC(size + 1);
+        if(fread(data, 1, size, fp) != size)
+            FATAL("cannot read input file: %s", argv[i]);
+        fclose(fp);
+
+        LLVMFuzzerTestOneInput(data, size);
+        _FREE(data);
+    }
+
+    return 0;
+}
+#endif
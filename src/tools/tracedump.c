@@ -0,0 +1,176 @@
+/**
+ * @file tracedump.c
+ *
+ * @brief Decode a binary trace that was written by "toy --trace-file". By
+ * default every event is printed, indented by call depth. With --summary
+ * only the number of calls and the inclusive time of each function are
+ * printed.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "cmdline.h"
+#include "trace_ring.h"
+
+typedef struct {
+    char* name;
+    uint64_t calls;
+    // time from ENTER to RETURN, not counting recursive calls twice
+    uint64_t time;
+    int active;
+} func_info_t;
+
+static FILE* infile;
+static const char* infile_name;
+static func_info_t* funcs;
+static uint32_t nfuncs;
+
+static void read_block(void* ptr, size_t size) {
+
+    if(fread(ptr, 1, size, infile) != size)
+        FATAL("cannot read trace file: %s: %s", infile_name, feof(infile) ? "file is truncated" : strerror(errno));
+}
+
+static const char* func_name(int id) {
+
+    return (id > 0 && (uint32_t)id <= nfuncs) ? funcs[id].name : "?";
+}
+
+static void read_names(uint32_t nnames) {
+
+    nfuncs = nnames;
+    funcs = _ALLOC_ARRAY(func_info_t, nfuncs + 1);
+    for(uint32_t i = 1; i <= nfuncs; i++) {
+        uint16_t len;
+        read_block(&len, sizeof(len));
+        funcs[i].name = _ALLOC(len + 1);
+        read_block(funcs[i].name, len);
+    }
+}
+
+static void print_event(trace_event_t* ev, int* depth) {
+
+    if(ev->kind == TRACE_EV_RETURN && *depth > 0)
+        (*depth)--;
+
+    printf("%12.3f %6" PRId32 " %*s%-6s %s", ev->time / 1000.0, ev->token, *depth * 2, "",
+           trace_event_kind_to_str(ev->kind), func_name(ev->func));
+    if(ev->kind == TRACE_EV_STATE)
+        printf(" %" PRId32, ev->state);
+    fputc('\n', stdout);
+
+    if(ev->kind == TRACE_EV_ENTER)
+        (*depth)++;
+}
+
+/*
+ * The stack of ENTER times is only as deep as the calls that are seen. A
+ * RETURN whose ENTER was overwritten in the ring is skipped.
+ */
+static void count_event(trace_event_t* ev, uint64_t* stack, int* sp) {
+
+    if(ev->func == 0 || ev->func > nfuncs)
+        return;
+
+    func_info_t* f = &funcs[ev->func];
+    if(ev->kind == TRACE_EV_ENTER) {
+        stack[(*sp)++] = ev->time;
+        f->calls++;
+        f->active++;
+    }
+    else if(ev->kind == TRACE_EV_RETURN && *sp > 0) {
+        uint64_t start = stack[--(*sp)];
+        if(f->active > 0 && --f->active == 0)
+            f->time += ev->time - start;
+    }
+}
+
+static int by_time(const void* a, const void* b) {
+
+    const func_info_t* fa = a;
+    const func_info_t* fb = b;
+    return (fa->time < fb->time) ? 1 : (fa->time > fb->time) ? -1 : 0;
+}
+
+static void print_summary(void) {
+
+    qsort(&funcs[1], nfuncs, sizeof(func_info_t), by_time);
+
+    printf("%10s %14s  %s\n", "calls", "total us", "function");
+    for(uint32_t i = 1; i <= nfuncs; i++)
+        if(funcs[i].calls > 0)
+            printf("%10" PRIu64 " %14.3f  %s\n", funcs[i].calls, funcs[i].time / 1000.0, funcs[i].name);
+}
+
+static void cmdline(int argc, char** argv, char** env) {
+
+    init_cmdline("tracedump", "Print a binary trace that was recorded by the compiler", "0.1");
+    add_cmdline('s', "summary", "summary", "Print calls and time per function instead of the events", NULL, NULL,
+                CMD_SWITCH);
+    add_cmdline('h', "help", NULL, "Print this helpful information", NULL, cmdline_help, CMD_NONE);
+    add_cmdline('V', "version", NULL, "Show the program version", NULL, cmdline_vers, CMD_NONE);
+    add_cmdline(0, NULL, NULL, NULL, NULL, NULL, CMD_DIV);
+    add_cmdline(0, NULL, "files", "Trace file to decode", NULL, NULL, CMD_REQD | CMD_ANON);
+
+    parse_cmdline(argc, argv, env);
+}
+
+int main(int argc, char** argv, char** env) {
+
+    cmdline(argc, argv, env);
+    bool summary = get_cmd_int("summary");
+
+    infile_name = raw_string(get_cmd_opt("files"));
+    infile = fopen(infile_name, "rb");
+    if(infile == NULL)
+        FATAL("cannot open trace file: %s: %s", infile_name, strerror(errno));
+
+    trace_file_header_t hdr;
+    read_block(&hdr, sizeof(hdr));
+    if(memcmp(hdr.magic, TRACE_RING_MAGIC, sizeof(hdr.magic)))
+        FATAL("not a trace file: %s", infile_name);
+    if(hdr.version != TRACE_RING_VERSION)
+        FATAL("trace file version %u is not supported: %s", hdr.version, infile_name);
+
+    read_names(hdr.nnames);
+
+    trace_event_t* events = _ALLOC_ARRAY(trace_event_t, TRACE_RING_SIZE);
+    uint64_t* stack = _ALLOC_ARRAY(uint64_t, TRACE_RING_SIZE);
+
+    for(uint32_t r = 0; r < hdr.nrings; r++) {
+        trace_ring_header_t rh;
+        read_block(&rh, sizeof(rh));
+        if(rh.count > TRACE_RING_SIZE)
+            FATAL("corrupt trace file: %s: ring has %u events", infile_name, rh.count);
+        read_block(events, rh.count * sizeof(trace_event_t));
+
+        if(!summary)
+            printf("thread %u: %u events, %" PRIu64 " lost\n", rh.thread, rh.count, rh.lost);
+
+        int depth = 0;
+        int sp = 0;
+        for(uint32_t i = 1; i <= nfuncs; i++)
+            funcs[i].active = 0;
+        for(uint32_t i = 0; i < rh.count; i++) {
+            if(summary)
+                count_event(&events[i], stack, &sp);
+            else
+                print_event(&events[i], &depth);
+        }
+    }
+
+    if(summary)
+        print_summary();
+
+    fclose(infile);
+    _FREE(events);
+    _FREE(stack);
+
+    return 0;
+}
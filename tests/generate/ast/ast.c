@@ -3,12 +3,13 @@
  * @file exit_statement.c
  *
  * @brief AST implementation.
- * This file was generated on Wed Jul 16 21:15:55 2025.
+ * This file was generated on Mon Oct 19 14:51:14 2026.
  *
  */
 #include <stddef.h>
 
 #include "ast.h"
+#include "alloc.h"
 
 static size_t node_size(ast_node_type_t type) {
 
@@ -39,6 +40,7 @@ static size_t node_size(ast_node_type_t type) {
     (type == AST_COMPOUND_REFERENCE_ELEMENT)? sizeof(ast_compound_reference_element_t) : 
     (type == AST_FUNCTION_REFERENCE)? sizeof(ast_function_reference_t) : 
     (type == AST_LIST_REFERENCE)? sizeof(ast_list_reference_t) : 
+    (type == AST_LIST_REF_PARMS)? sizeof(ast_list_ref_parms_t) : 
     (type == AST_FUNCTION_BODY_ELEMENT)? sizeof(ast_function_body_element_t) : 
     (type == AST_FUNCTION_BODY_PRELIST)? sizeof(ast_function_body_prelist_t) : 
     (type == AST_FUNCTION_BODY_LIST)? sizeof(ast_function_body_list_t) : 
@@ -58,6 +60,7 @@ static size_t node_size(ast_node_type_t type) {
     (type == AST_FOR_CLAUSE)? sizeof(ast_for_clause_t) : 
     (type == AST_RETURN_STATEMENT)? sizeof(ast_return_statement_t) : 
     (type == AST_EXIT_STATEMENT)? sizeof(ast_exit_statement_t) : 
+    (type == AST_TERMINAL)? sizeof(ast_node_t) : 
     (size_t)-1; // error if we reach here
 }
 
@@ -68,6 +71,26 @@ ast_node_t* create_ast_node(ast_node_type_t type) {
     return node;
 }
 
+// the tokens belong to the token queue
+void destroy_ast_node(ast_node_t* node) {
+
+    ast_node_t* next;
+    for(ast_node_t* child = node->first; child != NULL; child = next) {
+        next = child->next;
+        destroy_ast_node(child);
+    }
+    _FREE(node);
+}
+
+void append_ast_node(ast_node_t* node, ast_node_t* child) {
+
+    if(node->last != NULL)
+        node->last->next = child;
+    else
+        node->first = child;
+    node->last = child;
+}
+
 void traverse_ast(ast_translation_unit_t* node) {
 
     traverse_translation_unit(node);
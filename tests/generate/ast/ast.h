@@ -3,13 +3,15 @@
  * @file ast.h
  *
  * @brief AST traverse public interface.
- * This file was generated on Wed Jul 16 21:15:55 2025.
+ * This file was generated on Mon Oct 19 14:51:14 2026.
  *
  */
 
 #ifndef _AST_H_
 #define _AST_H_
 
+#include "tokens.h"
+
 typedef enum {
     AST_TRANSLATION_UNIT,
     AST_TRANSLATION_UNIT_ELEMENT,
@@ -37,6 +39,7 @@ typedef enum {
     AST_COMPOUND_REFERENCE_ELEMENT,
     AST_FUNCTION_REFERENCE,
     AST_LIST_REFERENCE,
+    AST_LIST_REF_PARMS,
     AST_FUNCTION_BODY_ELEMENT,
     AST_FUNCTION_BODY_PRELIST,
     AST_FUNCTION_BODY_LIST,
@@ -56,10 +59,17 @@ typedef enum {
     AST_FOR_CLAUSE,
     AST_RETURN_STATEMENT,
     AST_EXIT_STATEMENT,
+    AST_TERMINAL,
 } ast_node_type_t;
 
 typedef struct _ast_node_ {
     ast_node_type_t type;
+    // the token of an AST_TERMINAL
+    token_t* token;
+    // what the rule matched, in order
+    struct _ast_node_* first;
+    struct _ast_node_* last;
+    struct _ast_node_* next;
 } ast_node_t;
 
 /**
@@ -363,8 +373,6 @@ typedef struct _ast_function_reference_t_ {
 /**
  * list_reference
  *     : IDENTIFIER list_ref_parms
- *     : OSBRACE expression CSBRACE
- *     | list_ref_parms OSBRACE expression CSBRACE
  *     ;
  */
 typedef struct _ast_list_reference_t_ {
@@ -372,6 +380,17 @@ typedef struct _ast_list_reference_t_ {
 
 } ast_list_reference_t;
 
+/**
+ * list_ref_parms
+ *     : OSBRACE expression CSBRACE
+ *     | list_ref_parms OSBRACE expression CSBRACE
+ *     ;
+ */
+typedef struct _ast_list_ref_parms_t_ {
+    ast_node_t node;
+
+} ast_list_ref_parms_t;
+
 /**
  * function_body_element
  *     : assignment
@@ -618,6 +637,7 @@ void traverse_compound_reference(ast_compound_reference_t* node);
 void traverse_compound_reference_element(ast_compound_reference_element_t* node);
 void traverse_function_reference(ast_function_reference_t* node);
 void traverse_list_reference(ast_list_reference_t* node);
+void traverse_list_ref_parms(ast_list_ref_parms_t* node);
 void traverse_function_body_element(ast_function_body_element_t* node);
 void traverse_function_body_prelist(ast_function_body_prelist_t* node);
 void traverse_function_body_list(ast_function_body_list_t* node);
@@ -639,6 +659,8 @@ void traverse_return_statement(ast_return_statement_t* node);
 void traverse_exit_statement(ast_exit_statement_t* node);
 
 ast_node_t* create_ast_node(ast_node_type_t type);
+void destroy_ast_node(ast_node_t* node);
+void append_ast_node(ast_node_t* node, ast_node_t* child);
 void traverse_ast(ast_translation_unit_t* node);
 
 
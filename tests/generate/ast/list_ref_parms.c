@@ -0,0 +1,23 @@
+/**
+ *
+ * @file list_ref_parms.c
+ *
+ * @brief Traverse AST for node list_ref_parms.
+ * This file was generated on Mon Oct 19 14:51:14 2026.
+ *
+ */
+#include "ast.h"
+#include "trace.h"
+
+/**
+ * list_ref_parms
+ *     : OSBRACE expression CSBRACE
+ *     | list_ref_parms OSBRACE expression CSBRACE
+ *     ;
+ */
+void traverse_list_ref_parms(ast_list_ref_parms_t* node) {
+
+    ENTER;
+    RETURN();
+}
+
@@ -3,7 +3,7 @@
  * @file list_reference.c
  *
  * @brief Traverse AST for node list_reference.
- * This file was generated on Wed Jul 16 21:15:55 2025.
+ * This file was generated on Mon Oct 19 14:51:14 2026.
  *
  */
 #include "ast.h"
@@ -12,8 +12,6 @@
 /**
  * list_reference
  *     : IDENTIFIER list_ref_parms
- *     : OSBRACE expression CSBRACE
- *     | list_ref_parms OSBRACE expression CSBRACE
  *     ;
  */
 void traverse_list_reference(ast_list_reference_t* node) {
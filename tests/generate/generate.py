@@ -1,8 +1,12 @@
 #!/usr/bin/env python3
 '''
-This script reads in a grammar file and emits templates for a parser and and
-AST. It does not attempt to actually generate the code. If this is run in the
-actual source tree, it will destroy all edits.
+This script reads in a grammar file and emits templates for an AST and a
+scanner, and a table driven parser that reads the grammar. The AST templates
+do not attempt to actually generate the code. If this is run in the actual
+source tree, it will destroy all edits.
+
+Run with --first-sets, it writes the lookahead guards of the hand written
+parser in src/compiler/parser instead, see gen_first_sets().
 '''
 
 import re
@@ -169,13 +173,22 @@ def gen_ast():
         fp.write(" *\n */\n")
         fp.write("\n#ifndef _AST_H_\n#define _AST_H_\n\n")
 
+        fp.write("#include \"tokens.h\"\n\n")
+
         fp.write("typedef enum {\n")
         for str in grules:
             fp.write("    AST_%s,\n"%(str.upper()))
+        fp.write("    AST_TERMINAL,\n")
         fp.write("} ast_node_type_t;\n\n")
 
         fp.write("typedef struct _ast_node_ {\n")
         fp.write("    ast_node_type_t type;\n")
+        fp.write("    // the token of an AST_TERMINAL\n")
+        fp.write("    token_t* token;\n")
+        fp.write("    // what the rule matched, in order\n")
+        fp.write("    struct _ast_node_* first;\n")
+        fp.write("    struct _ast_node_* last;\n")
+        fp.write("    struct _ast_node_* next;\n")
         fp.write("} ast_node_t;\n\n")
 
         for str in grules:
@@ -192,6 +205,8 @@ def gen_ast():
             fp.write("void traverse_%s(ast_%s_t* node);\n"%(str, str))
 
         fp.write("\nast_node_t* create_ast_node(ast_node_type_t type);\n")
+        fp.write("void destroy_ast_node(ast_node_t* node);\n")
+        fp.write("void append_ast_node(ast_node_t* node, ast_node_t* child);\n")
         fp.write("void traverse_ast(ast_%s_t* node);\n\n"%(non_terminals[0]))
         fp.write("\n#endif /* _AST_H_ */\n\n")
 
@@ -203,11 +218,13 @@ def gen_ast():
             fp.write(" *\n */\n")
             fp.write("#include <stddef.h>\n\n")
 
-            fp.write("#include \"ast.h\"\n\n")
+            fp.write("#include \"ast.h\"\n")
+            fp.write("#include \"alloc.h\"\n\n")
             fp.write("static size_t node_size(ast_node_type_t type) {\n\n")
             fp.write("    return\n")
             for str in grules:
                 fp.write("    (type == AST_%s)? sizeof(ast_%s_t) : \n"%(str.upper(), str))
+            fp.write("    (type == AST_TERMINAL)? sizeof(ast_node_t) : \n")
             fp.write("    (size_t)-1; // error if we reach here\n")
             fp.write("}\n\n")
             fp.write("ast_node_t* create_ast_node(ast_node_type_t type) {\n\n")
@@ -215,6 +232,22 @@ def gen_ast():
             fp.write("    node->type = type;\n")
             fp.write("    return node;\n")
             fp.write("}\n\n")
+            fp.write("// the tokens belong to the token queue\n")
+            fp.write("void destroy_ast_node(ast_node_t* node) {\n\n")
+            fp.write("    ast_node_t* next;\n")
+            fp.write("    for(ast_node_t* child = node->first; child != NULL; child = next) {\n")
+            fp.write("        next = child->next;\n")
+            fp.write("        destroy_ast_node(child);\n")
+            fp.write("    }\n")
+            fp.write("    _FREE(node);\n")
+            fp.write("}\n\n")
+            fp.write("void append_ast_node(ast_node_t* node, ast_node_t* child) {\n\n")
+            fp.write("    if(node->last != NULL)\n")
+            fp.write("        node->last->next = child;\n")
+            fp.write("    else\n")
+            fp.write("        node->first = child;\n")
+            fp.write("    node->last = child;\n")
+            fp.write("}\n\n")
             fp.write("void traverse_ast(ast_%s_t* node) {\n\n"%(non_terminals[0]))
             fp.write("    traverse_%s(node);\n"%(non_terminals[0]))
             fp.write("}\n\n")
@@ -238,8 +271,198 @@ def gen_ast():
             fp.write("    RETURN();\n")
             fp.write("}\n\n")
 
+# The parser is made of tables and one loop that reads them. Each rule of the
+# grammar is split in the productions that do not start with the rule, its
+# base, and the ones that do, its tail. A left recursive rule like
+#
+#     list : item | list ',' item
+#
+# becomes "an item, then ', item' as many times as it matches", which reads
+# the same input without the recursion. The FIRST and FOLLOW sets of the
+# rules give, for every rule and every token, the productions that can start
+# with that token. When there is only one, it is taken without looking any
+# further. When there are more, they are tried in order, longest first, and
+# the tokens are put back between them. One that matches but is followed by
+# a token that is not in the FOLLOW set of the rule is put back too, while
+# there are others to try. The grammar has few of those.
+
+# [rule, [symbol, ...], is_tail]
+productions = []
+first_sets = {}
+follow_sets = {}
+nullable = set()
+conflicts = []
+
+def is_rule(sym):
+    return sym in grules
+
+def sym_token(sym):
+    return "TOK_%s"%(sym)
+
+def build_productions():
+
+    for name in non_terminals:
+        for line in grules[name]:
+            line = line.strip()
+            if line[0] == ';':
+                continue
+            words = line[1:].split()
+            if '%prec' in words:
+                words = words[:words.index('%prec')]
+            for w in words:
+                if w.islower() and not is_rule(w):
+                    sys.stderr.write("%s: rule %s uses %s, which is not defined\n"%(sys.argv[0], name, w))
+                    exit(1)
+            if len(words) > 0 and words[0] == name:
+                if len(words) == 1:
+                    sys.stderr.write("%s: rule %s has a production that is only itself\n"%(sys.argv[0], name))
+                    exit(1)
+                productions.append([name, words[1:], True])
+            else:
+                productions.append([name, words, False])
+
+def base_of(name):
+    return [p for p in productions if p[0] == name and not p[2]]
+
+def tail_of(name):
+    return [p for p in productions if p[0] == name and p[2]]
+
+def seq_first(syms):
+    '''The tokens that can start syms, and whether syms can be empty.'''
+
+    res = set()
+    for sym in syms:
+        if is_rule(sym):
+            res |= first_sets[sym]
+            if not sym in nullable:
+                return res, False
+        else:
+            res.add(sym_token(sym))
+            return res, False
+    return res, True
+
+def find_left_recursion():
+    '''A rule that can start with itself other than through its tail cannot
+    be read by the tables.'''
+
+    starts = {}
+    for name in non_terminals:
+        starts[name] = set()
+        for p in base_of(name) + tail_of(name):
+            for sym in p[1]:
+                if not is_rule(sym):
+                    break
+                starts[name].add(sym)
+                if not sym in nullable:
+                    break
+
+    for name in non_terminals:
+        seen = set()
+        todo = list(starts[name])
+        while len(todo) > 0:
+            sym = todo.pop()
+            if sym == name:
+                sys.stderr.write("%s: rule %s is left recursive through another rule\n"%(sys.argv[0], name))
+                exit(1)
+            if not sym in seen:
+                seen.add(sym)
+                todo += list(starts[sym])
+
+def find_sets(end="TOK_END_OF_INPUT"):
+
+    for name in non_terminals:
+        first_sets[name] = set()
+        follow_sets[name] = set()
+    follow_sets[non_terminals[0]].add(end)
+
+    changed = True
+    while changed:
+        changed = False
+        for name in non_terminals:
+            for p in base_of(name):
+                toks, empty = seq_first(p[1])
+                if not toks <= first_sets[name]:
+                    first_sets[name] |= toks
+                    changed = True
+                if empty and not name in nullable:
+                    nullable.add(name)
+                    changed = True
+
+    find_left_recursion()
+
+    changed = True
+    while changed:
+        changed = False
+        for name, syms, tail in productions:
+            # what comes after a production of the rule
+            after = set(follow_sets[name])
+            for p in tail_of(name):
+                after |= seq_first(p[1])[0]
+
+            for i, sym in enumerate(syms):
+                if not is_rule(sym):
+                    continue
+                toks, empty = seq_first(syms[i+1:])
+                if empty:
+                    toks |= after
+                if not toks <= follow_sets[sym]:
+                    follow_sets[sym] |= toks
+                    changed = True
+
+def select_set(p):
+    '''The tokens that choose production p.'''
+
+    toks, empty = seq_first(p[1])
+    if empty:
+        toks |= follow_sets[p[0]]
+        for t in tail_of(p[0]):
+            toks |= seq_first(t[1])[0]
+    return toks
+
+def all_tokens():
+    return tokens + ["TOK_END_OF_INPUT", "TOK_END_OF_FILE", "TOK_ERROR"]
+
+def make_table(name, prods, candidates):
+    '''One row of a dispatch table. 0 is no production, n > 0 is production
+    n - 1 and n < 0 is the list of them at candidates[-n - 1].'''
+
+    row = []
+    for tok in all_tokens():
+        choice = [productions.index(p) for p in prods if tok in select_set(p)]
+        if len(choice) == 0:
+            row.append(0)
+        elif len(choice) == 1:
+            row.append(choice[0] + 1)
+        else:
+            choice.sort(key=lambda n: -len(productions[n][1]))
+            conflicts.append((name, tok, choice))
+            if not tuple(choice) in candidates:
+                candidates[tuple(choice)] = sum(len(c) + 1 for c in candidates)
+            row.append(-candidates[tuple(choice)] - 1)
+    return row
+
+def write_row(fp, row):
+
+    for i in range(0, len(row), 16):
+        fp.write("        %s,\n"%(", ".join("%d"%(n) for n in row[i:i+16])))
+
 def gen_parse():
 
+    build_productions()
+    find_sets()
+
+    candidates = {}
+    base_rows = []
+    tail_rows = []
+    tail_index = []
+    for name in non_terminals:
+        base_rows.append(make_table(name, base_of(name), candidates))
+        if len(tail_of(name)) > 0:
+            tail_index.append(len(tail_rows))
+            tail_rows.append(make_table(name, tail_of(name), candidates))
+        else:
+            tail_index.append(-1)
+
     with open("parser/parser.h", "w") as fp:
         fp.write("/**\n *\n")
         fp.write(" * @file parser.h\n *\n")
@@ -251,23 +474,7 @@ def gen_parse():
         fp.write("#include \"ast.h\"\n")
         fp.write("#include \"parser_prototypes.h\"\n\n")
 
-        fp.write("typedef enum {\n")
-        fp.write("    STATE_START = 0,\n")
-        fp.write("    STATE_MATCH = 1000,\n")
-        fp.write("    STATE_NO_MATCH = 1010,\n")
-        fp.write("    STATE_ERROR = 1020,\n")
-        fp.write("} parser_state_t;\n")
-
-        fp.write("typedef struct {\n")
-        fp.write("    int mode;\n")
-        fp.write("} parser_state_t;\n\n")
-        #fp.write("void recover_error(void);\n")
-
-        fp.write("#define STATE \\ \n")
-        fp.write("    do { \\ \n")
-        fp.write("        TRACE(\"STATE: %d\", state); \\ \n")
-        fp.write("    } while(0)\n\n")
-
+        fp.write("ast_node_t* parse_rule(parse_rule_t rule);\n")
         fp.write("ast_%s_t* parse(void);\n\n"%(non_terminals[0]))
 
         fp.write("#endif /* _PARSER_H_ */\n\n")
@@ -279,83 +486,491 @@ def gen_parse():
         fp.write(" * This file was generated on %s.\n"%(time.asctime()))
         fp.write(" *\n */\n")
         fp.write("#ifndef _PARSER_PROTOTYPES_H_\n#define _PARSER_PROTOTYPES_H_\n\n")
-        fp.write("#include \"parser.h\"\n")
         fp.write("#include \"ast.h\"\n\n")
-        for str in grules:
-            fp.write("ast_%s_t* parse_%s(void);\n"%(str, str))
+        fp.write("typedef enum {\n")
+        for str in non_terminals:
+            fp.write("    RULE_%s,\n"%(str.upper()))
+        fp.write("    NUM_RULES,\n")
+        fp.write("} parse_rule_t;\n\n")
+        for str in non_terminals:
+            fp.write("#define parse_%s() ((ast_%s_t*)parse_rule(RULE_%s))\n"%(str, str, str.upper()))
         fp.write("\n#endif /* _PARSER_PROTOTYPES_H_ */\n\n")
 
     with open("parser/parser.c", "w") as fp:
         fp.write("/**\n *\n")
         fp.write(" * @file parser.c\n *\n")
-        fp.write(" * @brief Parser external interface implementation.\n")
+        fp.write(" * @brief Table driven parser.\n")
         fp.write(" * This file was generated on %s.\n"%(time.asctime()))
         fp.write(" *\n */\n")
-        fp.write("#include \"ast.h\"\n")
-        fp.write("#include \"parser_prototypes.h\"\n\n")
-        #fp.write("#include \"trace.h\"\n\n")
-        #fp.write("void recover_error(void) {\n\n")
-        #fp.write("}\n\n")
-        fp.write("ast_%s_t* parse(void) {\n\n"%(non_terminals[0]))
-        #fp.write("    parser_state_t* pstate = _ALLOC_DS(parser_state_t);\n")
-        #fp.write("    pstate->mode = 0;\n")
-        fp.write("    ast_%s_t* %s = parse_%s();\n"%(non_terminals[0], non_terminals[0], non_terminals[0]))
-        fp.write("    return %s;\n"%(non_terminals[0]))
-        fp.write("}\n\n")
+        fp.write("#include <stdbool.h>\n")
+        fp.write("#include <stdint.h>\n\n")
+        fp.write("#include \"alloc.h\"\n")
+        fp.write("#include \"errors.h\"\n")
+        fp.write("#include \"trace.h\"\n")
+        fp.write("#include \"tokens.h\"\n")
+        fp.write("#include \"parser.h\"\n\n")
+
+        fp.write("#define FIRST_TOKEN %s\n"%(tokens[0]))
+        fp.write("#define NUM_TOKENS %d\n"%(len(all_tokens())))
+        fp.write("#define NUM_TAILS %d\n"%(len(tail_rows)))
+        fp.write("// a symbol below FIRST_TOKEN is a rule\n")
+        fp.write("#define IS_RULE(s) ((s) < FIRST_TOKEN)\n\n")
 
-    for str in grules:
-        with open("parser/%s.c"%(str), "w") as fp:
-            fp.write("/**\n *\n")
-            fp.write(" * @file %s.c\n *\n"%(str))
-            fp.write(" * @brief Parse grammar production %s.\n"%(str))
-            fp.write(" * This file was generated on %s.\n"%(time.asctime()))
-            fp.write(" *\n */\n")
-            #fp.write("#include \"common.h\"\n")
-            fp.write("#include \"tokens.h\"\n")
-            fp.write("#include \"trace.h\"\n")
-            fp.write("#include \"parser.h\"\n\n")
-            fp.write("/**\n")
-            fp.write(" * %s\n"%(str))
-            for s in grules[str]:
-                fp.write(" * %s\n"%(s))
-            fp.write(" */\n")
-            fp.write("ast_%s_t* parse_%s(void) {\n\n"%(str, str))
-            #fp.write("    ASSERT(pstate != NULL);\n")
-            fp.write("    ENTER;\n\n")
-            fp.write("    ast_%s_t* node = NULL;\n"%(str))
-            fp.write("    int state = STATE_START;\n")
-            fp.write("    bool finished = false;\n")
-            fp.write("    void* post = post_token_queue();\n\n")
-            fp.write("    while(!finished) {\n")
-            fp.write("        switch(state) {\n")
-            fp.write("            case STATE_START:\n")
-            fp.write("                // initial state\n")
-            fp.write("                STATE;\n")
-            fp.write("                break;\n\n")
-            fp.write("            case STATE_MATCH:\n")
-            fp.write("                // production recognized\n")
-            fp.write("                STATE;\n")
-            fp.write("                node = (ast_%s_t*)create_ast_node(AST_%s);\n"%(str, str.upper()))
-            fp.write("                finished = true;\n")
-            fp.write("                break;\n\n")
-            fp.write("            case STATE_NO_MATCH:\n")
-            fp.write("                // not a match, not an error\n")
-            fp.write("                STATE;\n")
-            fp.write("                reset_token_queue(post);\n")
-            fp.write("                finished = true;\n")
-            fp.write("                break;\n\n")
-            fp.write("            case STATE_ERROR:\n")
-            fp.write("                // error found\n")
-            fp.write("                STATE;\n")
-            fp.write("                recover_error();\n")
-            fp.write("                finished = true;\n")
-            fp.write("                break;\n\n")
-            fp.write("            default:\n")
-            fp.write("                FATAL(\"unknown state: %d\", state);\n")
-            fp.write("        }\n")
-            fp.write("    }\n\n")
-            fp.write("    RETURN(node);\n")
-            fp.write("}\n\n")
+        fp.write("typedef struct {\n")
+        fp.write("    uint8_t rule;\n")
+        fp.write("    uint8_t length;\n")
+        fp.write("    // index of the first symbol in symbols[]\n")
+        fp.write("    uint16_t first;\n")
+        fp.write("} production_t;\n\n")
+
+        syms = []
+        fp.write("static const production_t productions[] = {\n")
+        for n, (name, body, tail) in enumerate(productions):
+            fp.write("    // %d: %s%s:%s\n"%(n, name, " tail " if tail else " ", "".join(" " + w for w in body)))
+            fp.write("    {RULE_%s, %d, %d},\n"%(name.upper(), len(body), len(syms)))
+            syms += body
+        fp.write("};\n\n")
+
+        fp.write("static const uint16_t symbols[] = {\n")
+        line = []
+        for sym in syms:
+            line.append("RULE_%s"%(sym.upper()) if is_rule(sym) else sym_token(sym))
+        for i in range(0, len(line), 6):
+            fp.write("    %s,\n"%(", ".join(line[i:i+6])))
+        fp.write("};\n\n")
+
+        fp.write("// lists of productions that start with the same token, ended by -1\n")
+        fp.write("static const int16_t candidates[] = {\n")
+        for choice in candidates:
+            fp.write("    %s, -1,\n"%(", ".join("%d"%(n) for n in choice)))
+        fp.write("};\n\n")
+
+        fp.write("// the base production of a rule, by the token that comes next\n")
+        fp.write("static const int16_t base_table[NUM_RULES][NUM_TOKENS] = {\n")
+        for name, row in zip(non_terminals, base_rows):
+            fp.write("    // %s\n"%(name))
+            fp.write("    {\n")
+            write_row(fp, row)
+            fp.write("    },\n")
+        fp.write("};\n\n")
+
+        fp.write("// the row of tail_table of a left recursive rule, -1 for the others\n")
+        fp.write("static const int8_t tail_index[NUM_RULES] = {\n")
+        write_row(fp, tail_index)
+        fp.write("};\n\n")
+
+        fp.write("// the tokens that can come after each rule, a bit for each token\n")
+        fp.write("static const uint8_t follow_table[NUM_RULES][(NUM_TOKENS + 7) / 8] = {\n")
+        for name in non_terminals:
+            bits = [0] * ((len(all_tokens()) + 7) // 8)
+            for n, tok in enumerate(all_tokens()):
+                if tok in follow_sets[name]:
+                    bits[n >> 3] |= 1 << (n & 7)
+            fp.write("    {%s}, // %s\n"%(", ".join("0x%02X"%(b) for b in bits), name))
+        fp.write("};\n\n")
+
+        fp.write("static const int16_t tail_table[NUM_TAILS][NUM_TOKENS] = {\n")
+        for name, row in zip([n for n, t in zip(non_terminals, tail_index) if t >= 0], tail_rows):
+            fp.write("    // %s\n"%(name))
+            fp.write("    {\n")
+            write_row(fp, row)
+            fp.write("    },\n")
+        fp.write("};\n\n")
+
+        fp.write(parser_loop.replace("@START@", non_terminals[0]))
+
+    with open("first_follow.txt", "w") as fp:
+        for name in non_terminals:
+            fp.write("%s%s\n"%(name, " (nullable)" if name in nullable else ""))
+            fp.write("    first: %s\n"%(" ".join(sorted(first_sets[name]))))
+            fp.write("    follow: %s\n"%(" ".join(sorted(follow_sets[name]))))
+
+    with open("conflicts.txt", "w") as fp:
+        for name, tok, choice in conflicts:
+            fp.write("%s %s: %s\n"%(name, tok, " ".join("%d"%(n) for n in choice)))
+
+    print("productions:", len(productions))
+    print("entries that backtrack:", len(conflicts))
+
+parser_loop = r'''typedef struct {
+    parse_rule_t rule;
+    int16_t prod;
+    int16_t pos;
+    bool tail;
+    // the next production to try if this one fails, NULL if there is none
+    const int16_t* next;
+    // where the production started, to undo it
+    void* post;
+    ast_node_t* kept;
+    ast_node_t* node;
+} frame_t;
+
+typedef struct {
+    frame_t* frames;
+    int len;
+    int cap;
+} frame_stack_t;
+
+static const int16_t* choose(frame_t* frame, int16_t entry) {
+
+    if(entry > 0) {
+        frame->prod = entry - 1;
+        return NULL;
+    }
+
+    const int16_t* next = &candidates[-entry - 1];
+    frame->prod = *next++;
+    return (*next >= 0) ? next : NULL;
+}
+
+/*
+ * Start a production of the rule in the frame, the base or the tail, from
+ * the token that comes next. Returns false when none can start with it.
+ */
+static bool start_production(frame_t* frame, bool tail) {
+
+    int index = get_token()->type - FIRST_TOKEN;
+    int16_t entry = tail ? tail_table[tail_index[frame->rule]][index] : base_table[frame->rule][index];
+    if(entry == 0)
+        return false;
+
+    frame->next = choose(frame, entry);
+    frame->pos = 0;
+    frame->tail = tail;
+    frame->post = post_token_queue();
+    frame->kept = frame->node->last;
+    TRACE("rule %d: production %d", frame->rule, frame->prod);
+    return true;
+}
+
+static bool can_follow(parse_rule_t rule) {
+
+    int index = get_token()->type - FIRST_TOKEN;
+    return (follow_table[rule][index >> 3] & (1 << (index & 7))) != 0;
+}
+
+static bool push_rule(frame_stack_t* stack, parse_rule_t rule) {
+
+    if(stack->len == stack->cap) {
+        stack->cap = (stack->cap == 0) ? 32 : stack->cap << 1;
+        stack->frames = _REALLOC_ARRAY(stack->frames, frame_t, stack->cap);
+    }
+
+    frame_t* frame = &stack->frames[stack->len];
+    frame->rule = rule;
+    // the AST node types are in the same order as the rules
+    frame->node = create_ast_node((ast_node_type_t)rule);
+    if(!start_production(frame, false)) {
+        destroy_ast_node(frame->node);
+        return false;
+    }
+
+    stack->len++;
+    return true;
+}
+
+// take back what the production of the frame matched
+static void undo_production(frame_t* frame) {
+
+    ast_node_t* node = frame->node;
+    ast_node_t* next;
+    for(ast_node_t* child = (frame->kept != NULL) ? frame->kept->next : node->first; child != NULL; child = next) {
+        next = child->next;
+        destroy_ast_node(child);
+    }
+
+    if(frame->kept != NULL)
+        frame->kept->next = NULL;
+    else
+        node->first = NULL;
+    node->last = frame->kept;
+
+    reset_token_queue(frame->post);
+}
+
+/**
+ * @brief Parse one rule. The rules are kept on a stack of frames instead of
+ * the C stack, and the whole parse is one loop. A rule whose productions all
+ * fail leaves the tokens where they were and returns NULL.
+ *
+ * @param rule
+ * @return ast_node_t*
+ */
+ast_node_t* parse_rule(parse_rule_t rule) {
+
+    ENTER;
+
+    frame_stack_t stack = {NULL, 0, 0};
+    ast_node_t* result = NULL;
+    bool matched = push_rule(&stack, rule);
+
+    while(stack.len > 0) {
+        frame_t* frame = &stack.frames[stack.len - 1];
+        const production_t* prod = &productions[frame->prod];
+
+        if(matched && frame->pos < prod->length) {
+            uint16_t sym = symbols[prod->first + frame->pos];
+            if(IS_RULE(sym))
+                matched = push_rule(&stack, (parse_rule_t)sym);
+            else if(get_token()->type == sym) {
+                ast_node_t* leaf = create_ast_node(AST_TERMINAL);
+                leaf->token = get_token();
+                append_ast_node(frame->node, leaf);
+                advance_token();
+                frame->pos++;
+            }
+            else
+                matched = false;
+            continue;
+        }
+
+        if(!matched) {
+            undo_production(frame);
+            if(frame->next != NULL) {
+                // the next production that can start here
+                frame->prod = *frame->next++;
+                if(*frame->next < 0)
+                    frame->next = NULL;
+                frame->pos = 0;
+                matched = true;
+                continue;
+            }
+            if(!frame->tail) {
+                // the rule failed, so the production that wanted it fails
+                destroy_ast_node(frame->node);
+                stack.len--;
+                continue;
+            }
+            // a left recursive rule ends when its tail does not match
+            matched = true;
+        }
+        else if(tail_index[frame->rule] >= 0 && start_production(frame, true))
+            continue;
+        else if(frame->next != NULL && !can_follow(frame->rule)) {
+            // the production matched, but what comes next cannot follow
+            // the rule, so one that is left may read further
+            matched = false;
+            continue;
+        }
+
+        ast_node_t* node = frame->node;
+        stack.len--;
+        if(stack.len > 0) {
+            frame = &stack.frames[stack.len - 1];
+            append_ast_node(frame->node, node);
+            frame->pos++;
+        }
+        else
+            result = node;
+    }
+
+    _FREE(stack.frames);
+    RETURN(result);
+}
+
+ast_@START@_t* parse(void) {
+
+    return parse_@START@();
+}
+
+'''
+
+# The hand written parser in src/compiler/parser has a lookahead guard in
+# front of each rule. Its grammar is the comment at the top of each parse
+# function, with '*', '+', '?' and groups. Those rules are turned into plain
+# productions here, a group or a repeat becoming a rule of its own, and the
+# sets come from find_sets() like they do for the tables above. The FIRST
+# set of each rule is written as a bitset of token types to first_sets.c,
+# with the rule names and can_start_rule() in first_sets.h. The tokens that
+# can begin or follow each rule are written next to them, for the error
+# recovery in parser.c. Run "generate.py --first-sets" again when a rule or
+# a token changes.
+
+src_root = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "src", "compiler")
+parser_dir = os.path.join(src_root, "parser")
+
+def read_tokens():
+
+    toks = {}
+    with open(os.path.join(src_root, "scanner", "tokens.h"), "r") as fp:
+        for m in re.finditer(r"\b(TOK_\w+)\s*=\s*(\d+)", fp.read()):
+            toks[m.group(1)] = int(m.group(2))
+    return toks
+
+def read_parser_rules():
+
+    rules = {}
+    for fname in sorted(os.listdir(parser_dir)):
+        if not fname.endswith(".c"):
+            continue
+        with open(os.path.join(parser_dir, fname), "r") as fp:
+            text = fp.read()
+        m = re.search(r"/\*\n \* (\w+) \(\n(.*?)\n \* \)\n", text, re.S)
+        if m is None:
+            continue
+        body = " ".join(line.lstrip(" *") for line in m.group(2).split("\n"))
+        rules[m.group(1)] = body.replace("(", " ( ").replace(")", " ) ").split()
+    return rules
+
+def add_rule(name, alts):
+
+    non_terminals.append(name)
+    grules[name] = ["    : %s"%(" ".join(a)) for a in alts] + ["    ;"]
+
+def lower_alts(name, words, pos, count):
+    '''Read the alternatives at words[pos] up to a closing paren or the end.
+    The groups and the repeats in them are added as rules name_1, name_2...
+    and count[0] is the last number used.'''
+
+    alts = [[]]
+    while pos < len(words) and words[pos] != ")":
+        w = words[pos]
+        pos += 1
+        if w == "|":
+            alts.append([])
+            continue
+
+        if w == "(":
+            inner, pos = lower_alts(name, words, pos, count)
+            if pos >= len(words):
+                sys.stderr.write("%s: %s: missing \")\"\n"%(sys.argv[0], name))
+                exit(1)
+            pos += 1
+            count[0] += 1
+            sym = "%s_%d"%(name, count[0])
+            add_rule(sym, inner)
+        elif w.startswith("TOK_"):
+            sym = w[4:]
+        else:
+            sym = w
+
+        if pos < len(words) and words[pos] in ("*", "+", "?"):
+            rep = words[pos]
+            pos += 1
+            count[0] += 1
+            more = "%s_%d"%(name, count[0])
+            if rep == "?":
+                add_rule(more, [[], [sym]])
+            else:
+                add_rule(more, [[], [sym, more]])
+            if rep == "+":
+                alts[-1].append(sym)
+            sym = more
+        alts[-1].append(sym)
+
+    return alts, pos
+
+def gen_first_sets():
+
+    toks = read_tokens()
+    base = toks["TOK_END_OF_FILE"]
+    if max(toks.values()) - base >= 64:
+        sys.stderr.write("%s: the tokens do not fit in 64 bits\n"%(sys.argv[0]))
+        exit(1)
+
+    # the start rule has to be the first one
+    rules = read_parser_rules()
+    names = ["translation_unit"] + sorted(n for n in rules if n != "translation_unit")
+    non_terminals.extend(names)
+    for name in names:
+        alts, pos = lower_alts(name, rules[name], 0, [0])
+        if pos != len(rules[name]):
+            sys.stderr.write("%s: %s: cannot read the rule at \"%s\"\n"%(sys.argv[0], name, rules[name][pos]))
+            exit(1)
+        grules[name] = ["    : %s"%(" ".join(a)) for a in alts] + ["    ;"]
+
+    build_productions()
+    find_sets("TOK_END_OF_FILE")
+
+    for name in names:
+        for tok in first_sets[name] | follow_sets[name]:
+            if not tok in toks:
+                sys.stderr.write("%s: %s: unknown token: %s\n"%(sys.argv[0], name, tok))
+                exit(1)
+
+    def bits(syms):
+        return sum(1 << (toks[t] - base) for t in syms)
+
+    names.sort()
+    with open(os.path.join(parser_dir, "first_sets.h"), "w") as fp:
+        fp.write("""/**
+ * @file first_sets.h
+ *
+ * @brief The token types that can begin each rule, from generate.py in
+ * tests/generate. Do not edit it, run "generate.py --first-sets" again
+ * when the grammar changes.
+ *
+ * A parse function calls can_start_rule() before it takes a mark, so a
+ * rule that cannot match the lookahead costs one test instead of a
+ * mark and a restore of the token queue. A rule that can match nothing
+ * has every bit set, it is always tried.
+ *
+ * The sync set of a rule is the tokens that can begin or follow it. After
+ * a syntax error, recover_parser_error() skips to one of them.
+ *
+ */
+
+#ifndef _FIRST_SETS_H_
+#define _FIRST_SETS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tokens.h"
+
+typedef enum {
+""")
+        for name in names:
+            fp.write("    RULE_%s,\n"%(name.upper()))
+        fp.write("""    NUM_RULES
+} parser_rule_t;
+
+extern const uint64_t first_sets[NUM_RULES];
+extern const uint64_t sync_sets[NUM_RULES];
+extern unsigned long pruned_attempts;
+
+static inline bool can_start_rule(parser_rule_t rule) {
+
+    if((first_sets[rule] >> (get_token()->type - TOK_END_OF_FILE)) & 1)
+        return true;
+
+    pruned_attempts++;
+    return false;
+}
+
+#endif /* _FIRST_SETS_H_ */
+""")
+
+    with open(os.path.join(parser_dir, "first_sets.c"), "w") as fp:
+        fp.write("""/**
+ * @file first_sets.c
+ *
+ * @brief The FIRST set of each rule as a bitset. Bit n is the token type
+ * TOK_END_OF_FILE + n. Made by "generate.py --first-sets" in
+ * tests/generate, do not edit it.
+ *
+ */
+
+#include "first_sets.h"
+
+const uint64_t first_sets[NUM_RULES] = {
+""")
+        for name in names:
+            if name in nullable:
+                fp.write("    // %s can match nothing\n"%(name))
+                fp.write("    [RULE_%s] = 0x%016xULL,\n"%(name.upper(), (1 << 64) - 1))
+                continue
+            fp.write("    // %s\n"%(" ".join(sorted(first_sets[name], key=lambda t: toks[t]))))
+            fp.write("    [RULE_%s] = 0x%016xULL,\n"%(name.upper(), bits(first_sets[name])))
+        fp.write("};\n")
+
+        fp.write("""
+// FIRST and FOLLOW of each rule, where a list of them can pick up again
+const uint64_t sync_sets[NUM_RULES] = {
+""")
+        for name in names:
+            fp.write("    [RULE_%s] = 0x%016xULL,\n"%(name.upper(), bits(first_sets[name] | follow_sets[name])))
+        fp.write("};\n")
 
 def gen_scanner():
 
@@ -750,6 +1365,10 @@ if __name__ == '__main__':
         sys.stderr.write("%s: file name required\n"%(sys.argv[0]))
         exit(1)
 
+    if sys.argv[1] == "--first-sets":
+        gen_first_sets()
+        exit(0)
+
     gen_lists(sys.argv[1])
 
     count = 0
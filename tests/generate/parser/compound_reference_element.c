@@ -1,64 +0,0 @@
-/**
- *
- * @file compound_reference_element.c
- *
- * @brief Parse grammar production compound_reference_element.
- * This file was generated on Wed Jul 16 21:15:55 2025.
- *
- */
-#include "tokens.h"
-#include "trace.h"
-#include "parser.h"
-
-/**
- * compound_reference_element
- *     : IDENTIFIER
- *     | function_reference
- *     | list_reference
- *     ;
- */
-ast_compound_reference_element_t* parse_compound_reference_element(void) {
-
-    ENTER;
-
-    ast_compound_reference_element_t* node = NULL;
-    int state = STATE_START;
-    bool finished = false;
-    void* post = post_token_queue();
-
-    while(!finished) {
-        switch(state) {
-            case STATE_START:
-                // initial state
-                STATE;
-                break;
-
-            case STATE_MATCH:
-                // production recognized
-                STATE;
-                node = (ast_compound_reference_element_t*)create_ast_node(AST_COMPOUND_REFERENCE_ELEMENT);
-                finished = true;
-                break;
-
-            case STATE_NO_MATCH:
-                // not a match, not an error
-                STATE;
-                reset_token_queue(post);
-                finished = true;
-                break;
-
-            case STATE_ERROR:
-                // error found
-                STATE;
-                recover_error();
-                finished = true;
-                break;
-
-            default:
-                FATAL("unknown state: %d", state);
-        }
-    }
-
-    RETURN(node);
-}
-
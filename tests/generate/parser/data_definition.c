@@ -1,64 +0,0 @@
-/**
- *
- * @file data_definition.c
- *
- * @brief Parse grammar production data_definition.
- * This file was generated on Wed Jul 16 21:15:55 2025.
- *
- */
-#include "tokens.h"
-#include "trace.h"
-#include "parser.h"
-
-/**
- * data_definition
- *     : data_declaration
- *     | data_declaration EQUAL initializer
- *     | CONST data_declaration EQUAL initializer
- *     ;
- */
-ast_data_definition_t* parse_data_definition(void) {
-
-    ENTER;
-
-    ast_data_definition_t* node = NULL;
-    int state = STATE_START;
-    bool finished = false;
-    void* post = post_token_queue();
-
-    while(!finished) {
-        switch(state) {
-            case STATE_START:
-                // initial state
-                STATE;
-                break;
-
-            case STATE_MATCH:
-                // production recognized
-                STATE;
-                node = (ast_data_definition_t*)create_ast_node(AST_DATA_DEFINITION);
-                finished = true;
-                break;
-
-            case STATE_NO_MATCH:
-                // not a match, not an error
-                STATE;
-                reset_token_queue(post);
-                finished = true;
-                break;
-
-            case STATE_ERROR:
-                // error found
-                STATE;
-                recover_error();
-                finished = true;
-                break;
-
-            default:
-                FATAL("unknown state: %d", state);
-        }
-    }
-
-    RETURN(node);
-}
-
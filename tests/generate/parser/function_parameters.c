@@ -1,63 +0,0 @@
-/**
- *
- * @file function_parameters.c
- *
- * @brief Parse grammar production function_parameters.
- * This file was generated on Wed Jul 16 21:15:55 2025.
- *
- */
-#include "tokens.h"
-#include "trace.h"
-#include "parser.h"
-
-/**
- * function_parameters
- *     : OPAREN function_parameter_list CPAREN
- *     | OPAREN CPAREN
- *     ;
- */
-ast_function_parameters_t* parse_function_parameters(void) {
-
-    ENTER;
-
-    ast_function_parameters_t* node = NULL;
-    int state = STATE_START;
-    bool finished = false;
-    void* post = post_token_queue();
-
-    while(!finished) {
-        switch(state) {
-            case STATE_START:
-                // initial state
-                STATE;
-                break;
-
-            case STATE_MATCH:
-                // production recognized
-                STATE;
-                node = (ast_function_parameters_t*)create_ast_node(AST_FUNCTION_PARAMETERS);
-                finished = true;
-                break;
-
-            case STATE_NO_MATCH:
-                // not a match, not an error
-                STATE;
-                reset_token_queue(post);
-                finished = true;
-                break;
-
-            case STATE_ERROR:
-                // error found
-                STATE;
-                recover_error();
-                finished = true;
-                break;
-
-            default:
-                FATAL("unknown state: %d", state);
-        }
-    }
-
-    RETURN(node);
-}
-
@@ -1,64 +0,0 @@
-/**
- *
- * @file list_reference.c
- *
- * @brief Parse grammar production list_reference.
- * This file was generated on Wed Jul 16 21:15:55 2025.
- *
- */
-#include "tokens.h"
-#include "trace.h"
-#include "parser.h"
-
-/**
- * list_reference
- *     : IDENTIFIER list_ref_parms
- *     : OSBRACE expression CSBRACE
- *     | list_ref_parms OSBRACE expression CSBRACE
- *     ;
- */
-ast_list_reference_t* parse_list_reference(void) {
-
-    ENTER;
-
-    ast_list_reference_t* node = NULL;
-    int state = STATE_START;
-    bool finished = false;
-    void* post = post_token_queue();
-
-    while(!finished) {
-        switch(state) {
-            case STATE_START:
-                // initial state
-                STATE;
-                break;
-
-            case STATE_MATCH:
-                // production recognized
-                STATE;
-                node = (ast_list_reference_t*)create_ast_node(AST_LIST_REFERENCE);
-                finished = true;
-                break;
-
-            case STATE_NO_MATCH:
-                // not a match, not an error
-                STATE;
-                reset_token_queue(post);
-                finished = true;
-                break;
-
-            case STATE_ERROR:
-                // error found
-                STATE;
-                recover_error();
-                finished = true;
-                break;
-
-            default:
-                FATAL("unknown state: %d", state);
-        }
-    }
-
-    RETURN(node);
-}
-
@@ -2,16 +2,1005 @@
  *
  * @file parser.c
  *
- * @brief Parser external interface implementation.
- * This file was generated on Wed Jul 16 21:15:55 2025.
+ * @brief Table driven parser.
+ * This file was generated on Mon Oct 19 14:51:14 2026.
  *
  */
-#include "ast.h"
-#include "parser_prototypes.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "alloc.h"
+#include "errors.h"
+#include "trace.h"
+#include "tokens.h"
+#include "parser.h"
+
+#define FIRST_TOKEN TOK_IMPORT
+#define NUM_TOKENS 54
+#define NUM_TAILS 13
+// a symbol below FIRST_TOKEN is a rule
+#define IS_RULE(s) ((s) < FIRST_TOKEN)
+
+typedef struct {
+    uint8_t rule;
+    uint8_t length;
+    // index of the first symbol in symbols[]
+    uint16_t first;
+} production_t;
+
+static const production_t productions[] = {
+    // 0: translation_unit : translation_unit_element
+    {RULE_TRANSLATION_UNIT, 1, 0},
+    // 1: translation_unit tail : translation_unit_element
+    {RULE_TRANSLATION_UNIT, 1, 1},
+    // 2: translation_unit_element : import_statement
+    {RULE_TRANSLATION_UNIT_ELEMENT, 1, 2},
+    // 3: translation_unit_element : data_definition
+    {RULE_TRANSLATION_UNIT_ELEMENT, 1, 3},
+    // 4: translation_unit_element : function_definition
+    {RULE_TRANSLATION_UNIT_ELEMENT, 1, 4},
+    // 5: translation_unit_element : struct_definition
+    {RULE_TRANSLATION_UNIT_ELEMENT, 1, 5},
+    // 6: import_statement : IMPORT STRING_LITERAL
+    {RULE_IMPORT_STATEMENT, 2, 6},
+    // 7: data_declaration : type_name IDENTIFIER
+    {RULE_DATA_DECLARATION, 2, 8},
+    // 8: data_definition : data_declaration
+    {RULE_DATA_DEFINITION, 1, 10},
+    // 9: data_definition : data_declaration EQUAL initializer
+    {RULE_DATA_DEFINITION, 3, 11},
+    // 10: data_definition : CONST data_declaration EQUAL initializer
+    {RULE_DATA_DEFINITION, 4, 14},
+    // 11: initializer : expression
+    {RULE_INITIALIZER, 1, 18},
+    // 12: initializer : OSBRACE list_initializer CSBRACE
+    {RULE_INITIALIZER, 3, 19},
+    // 13: initializer : OSBRACE dss_initializer CSBRACE
+    {RULE_INITIALIZER, 3, 22},
+    // 14: initializer : OCBRACE dss_initializer CCBRACE
+    {RULE_INITIALIZER, 3, 25},
+    // 15: list_initializer : expression
+    {RULE_LIST_INITIALIZER, 1, 28},
+    // 16: list_initializer tail : COMMA expression
+    {RULE_LIST_INITIALIZER, 2, 29},
+    // 17: dss_initializer_item : STRING_LITERAL COLON expression
+    {RULE_DSS_INITIALIZER_ITEM, 3, 31},
+    // 18: dss_initializer : dss_initializer_item
+    {RULE_DSS_INITIALIZER, 1, 34},
+    // 19: dss_initializer tail : COMMA dss_initializer_item
+    {RULE_DSS_INITIALIZER, 2, 35},
+    // 20: formatted_string : STRING_LITERAL
+    {RULE_FORMATTED_STRING, 1, 37},
+    // 21: formatted_string : STRING_LITERAL OPAREN CPAREN
+    {RULE_FORMATTED_STRING, 3, 38},
+    // 22: formatted_string : STRING_LITERAL OPAREN dss_initializer CPAREN
+    {RULE_FORMATTED_STRING, 4, 41},
+    // 23: type_name : INT
+    {RULE_TYPE_NAME, 1, 45},
+    // 24: type_name : FLOAT
+    {RULE_TYPE_NAME, 1, 46},
+    // 25: type_name : STRING
+    {RULE_TYPE_NAME, 1, 47},
+    // 26: type_name : LIST
+    {RULE_TYPE_NAME, 1, 48},
+    // 27: type_name : DICT
+    {RULE_TYPE_NAME, 1, 49},
+    // 28: type_name : BOOL
+    {RULE_TYPE_NAME, 1, 50},
+    // 29: type_name : compound_name
+    {RULE_TYPE_NAME, 1, 51},
+    // 30: compound_name : IDENTIFIER
+    {RULE_COMPOUND_NAME, 1, 52},
+    // 31: compound_name tail : DOT IDENTIFIER
+    {RULE_COMPOUND_NAME, 2, 53},
+    // 32: function_name : type_name IDENTIFIER
+    {RULE_FUNCTION_NAME, 2, 55},
+    // 33: function_name : NOTHING IDENTIFIER
+    {RULE_FUNCTION_NAME, 2, 57},
+    // 34: function_definition : function_name function_parameters function_body
+    {RULE_FUNCTION_DEFINITION, 3, 59},
+    // 35: function_parameters : OPAREN function_parameter_list CPAREN
+    {RULE_FUNCTION_PARAMETERS, 3, 62},
+    // 36: function_parameters : OPAREN CPAREN
+    {RULE_FUNCTION_PARAMETERS, 2, 65},
+    // 37: function_parameter_list : data_declaration
+    {RULE_FUNCTION_PARAMETER_LIST, 1, 67},
+    // 38: function_parameter_list tail : COMMA data_declaration
+    {RULE_FUNCTION_PARAMETER_LIST, 2, 68},
+    // 39: struct_data_list : data_definition
+    {RULE_STRUCT_DATA_LIST, 1, 70},
+    // 40: struct_data_list tail : data_definition
+    {RULE_STRUCT_DATA_LIST, 1, 71},
+    // 41: struct_body : OCBRACE struct_data_list CCBRACE
+    {RULE_STRUCT_BODY, 3, 72},
+    // 42: struct_definition : STRUCT IDENTIFIER struct_body
+    {RULE_STRUCT_DEFINITION, 3, 75},
+    // 43: expression tail : STAR expression
+    {RULE_EXPRESSION, 2, 78},
+    // 44: expression tail : SLASH expression
+    {RULE_EXPRESSION, 2, 80},
+    // 45: expression tail : PERCENT expression
+    {RULE_EXPRESSION, 2, 82},
+    // 46: expression tail : PLUS expression
+    {RULE_EXPRESSION, 2, 84},
+    // 47: expression tail : MINUS expression
+    {RULE_EXPRESSION, 2, 86},
+    // 48: expression tail : GT expression
+    {RULE_EXPRESSION, 2, 88},
+    // 49: expression tail : LT expression
+    {RULE_EXPRESSION, 2, 90},
+    // 50: expression tail : GTE expression
+    {RULE_EXPRESSION, 2, 92},
+    // 51: expression tail : LTE expression
+    {RULE_EXPRESSION, 2, 94},
+    // 52: expression tail : EQU expression
+    {RULE_EXPRESSION, 2, 96},
+    // 53: expression tail : NEQU expression
+    {RULE_EXPRESSION, 2, 98},
+    // 54: expression tail : AND expression
+    {RULE_EXPRESSION, 2, 100},
+    // 55: expression tail : OR expression
+    {RULE_EXPRESSION, 2, 102},
+    // 56: expression tail : CARAT expression
+    {RULE_EXPRESSION, 2, 104},
+    // 57: expression : NOT expression
+    {RULE_EXPRESSION, 2, 106},
+    // 58: expression : MINUS expression
+    {RULE_EXPRESSION, 2, 108},
+    // 59: expression : primary_expression
+    {RULE_EXPRESSION, 1, 110},
+    // 60: primary_expression : INT_LITERAL
+    {RULE_PRIMARY_EXPRESSION, 1, 111},
+    // 61: primary_expression : FLOAT_LITERAL
+    {RULE_PRIMARY_EXPRESSION, 1, 112},
+    // 62: primary_expression : formatted_string
+    {RULE_PRIMARY_EXPRESSION, 1, 113},
+    // 63: primary_expression : OPAREN expression CPAREN
+    {RULE_PRIMARY_EXPRESSION, 3, 114},
+    // 64: primary_expression : compound_reference
+    {RULE_PRIMARY_EXPRESSION, 1, 117},
+    // 65: expression_list : expression
+    {RULE_EXPRESSION_LIST, 1, 118},
+    // 66: expression_list tail : COMMA expression
+    {RULE_EXPRESSION_LIST, 2, 119},
+    // 67: compound_reference : compound_reference_element
+    {RULE_COMPOUND_REFERENCE, 1, 121},
+    // 68: compound_reference tail : DOT compound_reference_element
+    {RULE_COMPOUND_REFERENCE, 2, 122},
+    // 69: compound_reference_element : IDENTIFIER
+    {RULE_COMPOUND_REFERENCE_ELEMENT, 1, 124},
+    // 70: compound_reference_element : function_reference
+    {RULE_COMPOUND_REFERENCE_ELEMENT, 1, 125},
+    // 71: compound_reference_element : list_reference
+    {RULE_COMPOUND_REFERENCE_ELEMENT, 1, 126},
+    // 72: function_reference : IDENTIFIER OPAREN expression_list CPAREN
+    {RULE_FUNCTION_REFERENCE, 4, 127},
+    // 73: list_reference : IDENTIFIER list_ref_parms
+    {RULE_LIST_REFERENCE, 2, 131},
+    // 74: list_ref_parms : OSBRACE expression CSBRACE
+    {RULE_LIST_REF_PARMS, 3, 133},
+    // 75: list_ref_parms tail : OSBRACE expression CSBRACE
+    {RULE_LIST_REF_PARMS, 3, 136},
+    // 76: function_body_element : assignment
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 139},
+    // 77: function_body_element : compound_reference
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 140},
+    // 78: function_body_element : data_definition
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 141},
+    // 79: function_body_element : struct_definition
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 142},
+    // 80: function_body_element : if_clause
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 143},
+    // 81: function_body_element : while_clause
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 144},
+    // 82: function_body_element : do_clause
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 145},
+    // 83: function_body_element : for_clause
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 146},
+    // 84: function_body_element : return_statement
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 147},
+    // 85: function_body_element : exit_statement
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 148},
+    // 86: function_body_element : INLINE
+    {RULE_FUNCTION_BODY_ELEMENT, 1, 149},
+    // 87: function_body_prelist : function_body_element
+    {RULE_FUNCTION_BODY_PRELIST, 1, 150},
+    // 88: function_body_prelist : function_body
+    {RULE_FUNCTION_BODY_PRELIST, 1, 151},
+    // 89: function_body_list : function_body_prelist
+    {RULE_FUNCTION_BODY_LIST, 1, 152},
+    // 90: function_body_list tail : function_body_prelist
+    {RULE_FUNCTION_BODY_LIST, 1, 153},
+    // 91: function_body : OCBRACE function_body_list CCBRACE
+    {RULE_FUNCTION_BODY, 3, 154},
+    // 92: loop_body_element : function_body_element
+    {RULE_LOOP_BODY_ELEMENT, 1, 157},
+    // 93: loop_body_element : CONTINUE
+    {RULE_LOOP_BODY_ELEMENT, 1, 158},
+    // 94: loop_body_element : BREAK
+    {RULE_LOOP_BODY_ELEMENT, 1, 159},
+    // 95: loop_body_prelist : loop_body_element
+    {RULE_LOOP_BODY_PRELIST, 1, 160},
+    // 96: loop_body_prelist : loop_body
+    {RULE_LOOP_BODY_PRELIST, 1, 161},
+    // 97: loop_body_list : loop_body_prelist
+    {RULE_LOOP_BODY_LIST, 1, 162},
+    // 98: loop_body_list tail : loop_body_prelist
+    {RULE_LOOP_BODY_LIST, 1, 163},
+    // 99: loop_body : OCBRACE loop_body_list CCBRACE
+    {RULE_LOOP_BODY, 3, 164},
+    // 100: assignment : compound_name EQUAL expression
+    {RULE_ASSIGNMENT, 3, 167},
+    // 101: if_clause : IF OPAREN expression CPAREN function_body
+    {RULE_IF_CLAUSE, 5, 170},
+    // 102: if_clause : IF OPAREN expression CPAREN function_body else_clause_follow
+    {RULE_IF_CLAUSE, 6, 175},
+    // 103: else_clause : ELSE OPAREN expression CPAREN function_body
+    {RULE_ELSE_CLAUSE, 5, 181},
+    // 104: else_clause_list : else_clause
+    {RULE_ELSE_CLAUSE_LIST, 1, 186},
+    // 105: else_clause_list tail : else_clause
+    {RULE_ELSE_CLAUSE_LIST, 1, 187},
+    // 106: final_else_clause : ELSE OPAREN CPAREN function_body
+    {RULE_FINAL_ELSE_CLAUSE, 4, 188},
+    // 107: final_else_clause : ELSE function_body
+    {RULE_FINAL_ELSE_CLAUSE, 2, 192},
+    // 108: else_clause_follow : else_clause_list final_else_clause
+    {RULE_ELSE_CLAUSE_FOLLOW, 2, 194},
+    // 109: else_clause_follow : final_else_clause
+    {RULE_ELSE_CLAUSE_FOLLOW, 1, 196},
+    // 110: while_clause : WHILE OPAREN expression CPAREN loop_body
+    {RULE_WHILE_CLAUSE, 5, 197},
+    // 111: while_clause : WHILE OPAREN CPAREN loop_body
+    {RULE_WHILE_CLAUSE, 4, 202},
+    // 112: while_clause : WHILE loop_body
+    {RULE_WHILE_CLAUSE, 2, 206},
+    // 113: do_clause : DO loop_body WHILE OPAREN expression CPAREN
+    {RULE_DO_CLAUSE, 6, 208},
+    // 114: do_clause : DO loop_body WHILE OPAREN CPAREN
+    {RULE_DO_CLAUSE, 5, 214},
+    // 115: do_clause : DO loop_body WHILE
+    {RULE_DO_CLAUSE, 3, 219},
+    // 116: for_clause : FOR loop_body
+    {RULE_FOR_CLAUSE, 2, 222},
+    // 117: for_clause : FOR OPAREN CPAREN loop_body
+    {RULE_FOR_CLAUSE, 4, 224},
+    // 118: for_clause : FOR OPAREN expression CPAREN loop_body
+    {RULE_FOR_CLAUSE, 5, 228},
+    // 119: for_clause : FOR OPAREN IDENTIFIER IN expression CPAREN loop_body
+    {RULE_FOR_CLAUSE, 7, 233},
+    // 120: for_clause : FOR OPAREN type_name IDENTIFIER IN expression CPAREN loop_body
+    {RULE_FOR_CLAUSE, 8, 240},
+    // 121: return_statement : RETURN
+    {RULE_RETURN_STATEMENT, 1, 248},
+    // 122: return_statement : RETURN OPAREN CPAREN
+    {RULE_RETURN_STATEMENT, 3, 249},
+    // 123: return_statement : RETURN OPAREN expression CPAREN
+    {RULE_RETURN_STATEMENT, 4, 252},
+    // 124: exit_statement : EXIT OPAREN expression CPAREN
+    {RULE_EXIT_STATEMENT, 4, 256},
+};
+
+static const uint16_t symbols[] = {
+    RULE_TRANSLATION_UNIT_ELEMENT, RULE_TRANSLATION_UNIT_ELEMENT, RULE_IMPORT_STATEMENT, RULE_DATA_DEFINITION, RULE_FUNCTION_DEFINITION, RULE_STRUCT_DEFINITION,
+    TOK_IMPORT, TOK_STRING_LITERAL, RULE_TYPE_NAME, TOK_IDENTIFIER, RULE_DATA_DECLARATION, RULE_DATA_DECLARATION,
+    TOK_EQUAL, RULE_INITIALIZER, TOK_CONST, RULE_DATA_DECLARATION, TOK_EQUAL, RULE_INITIALIZER,
+    RULE_EXPRESSION, TOK_OSBRACE, RULE_LIST_INITIALIZER, TOK_CSBRACE, TOK_OSBRACE, RULE_DSS_INITIALIZER,
+    TOK_CSBRACE, TOK_OCBRACE, RULE_DSS_INITIALIZER, TOK_CCBRACE, RULE_EXPRESSION, TOK_COMMA,
+    RULE_EXPRESSION, TOK_STRING_LITERAL, TOK_COLON, RULE_EXPRESSION, RULE_DSS_INITIALIZER_ITEM, TOK_COMMA,
+    RULE_DSS_INITIALIZER_ITEM, TOK_STRING_LITERAL, TOK_STRING_LITERAL, TOK_OPAREN, TOK_CPAREN, TOK_STRING_LITERAL,
+    TOK_OPAREN, RULE_DSS_INITIALIZER, TOK_CPAREN, TOK_INT, TOK_FLOAT, TOK_STRING,
+    TOK_LIST, TOK_DICT, TOK_BOOL, RULE_COMPOUND_NAME, TOK_IDENTIFIER, TOK_DOT,
+    TOK_IDENTIFIER, RULE_TYPE_NAME, TOK_IDENTIFIER, TOK_NOTHING, TOK_IDENTIFIER, RULE_FUNCTION_NAME,
+    RULE_FUNCTION_PARAMETERS, RULE_FUNCTION_BODY, TOK_OPAREN, RULE_FUNCTION_PARAMETER_LIST, TOK_CPAREN, TOK_OPAREN,
+    TOK_CPAREN, RULE_DATA_DECLARATION, TOK_COMMA, RULE_DATA_DECLARATION, RULE_DATA_DEFINITION, RULE_DATA_DEFINITION,
+    TOK_OCBRACE, RULE_STRUCT_DATA_LIST, TOK_CCBRACE, TOK_STRUCT, TOK_IDENTIFIER, RULE_STRUCT_BODY,
+    TOK_STAR, RULE_EXPRESSION, TOK_SLASH, RULE_EXPRESSION, TOK_PERCENT, RULE_EXPRESSION,
+    TOK_PLUS, RULE_EXPRESSION, TOK_MINUS, RULE_EXPRESSION, TOK_GT, RULE_EXPRESSION,
+    TOK_LT, RULE_EXPRESSION, TOK_GTE, RULE_EXPRESSION, TOK_LTE, RULE_EXPRESSION,
+    TOK_EQU, RULE_EXPRESSION, TOK_NEQU, RULE_EXPRESSION, TOK_AND, RULE_EXPRESSION,
+    TOK_OR, RULE_EXPRESSION, TOK_CARAT, RULE_EXPRESSION, TOK_NOT, RULE_EXPRESSION,
+    TOK_MINUS, RULE_EXPRESSION, RULE_PRIMARY_EXPRESSION, TOK_INT_LITERAL, TOK_FLOAT_LITERAL, RULE_FORMATTED_STRING,
+    TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN, RULE_COMPOUND_REFERENCE, RULE_EXPRESSION, TOK_COMMA,
+    RULE_EXPRESSION, RULE_COMPOUND_REFERENCE_ELEMENT, TOK_DOT, RULE_COMPOUND_REFERENCE_ELEMENT, TOK_IDENTIFIER, RULE_FUNCTION_REFERENCE,
+    RULE_LIST_REFERENCE, TOK_IDENTIFIER, TOK_OPAREN, RULE_EXPRESSION_LIST, TOK_CPAREN, TOK_IDENTIFIER,
+    RULE_LIST_REF_PARMS, TOK_OSBRACE, RULE_EXPRESSION, TOK_CSBRACE, TOK_OSBRACE, RULE_EXPRESSION,
+    TOK_CSBRACE, RULE_ASSIGNMENT, RULE_COMPOUND_REFERENCE, RULE_DATA_DEFINITION, RULE_STRUCT_DEFINITION, RULE_IF_CLAUSE,
+    RULE_WHILE_CLAUSE, RULE_DO_CLAUSE, RULE_FOR_CLAUSE, RULE_RETURN_STATEMENT, RULE_EXIT_STATEMENT, TOK_INLINE,
+    RULE_FUNCTION_BODY_ELEMENT, RULE_FUNCTION_BODY, RULE_FUNCTION_BODY_PRELIST, RULE_FUNCTION_BODY_PRELIST, TOK_OCBRACE, RULE_FUNCTION_BODY_LIST,
+    TOK_CCBRACE, RULE_FUNCTION_BODY_ELEMENT, TOK_CONTINUE, TOK_BREAK, RULE_LOOP_BODY_ELEMENT, RULE_LOOP_BODY,
+    RULE_LOOP_BODY_PRELIST, RULE_LOOP_BODY_PRELIST, TOK_OCBRACE, RULE_LOOP_BODY_LIST, TOK_CCBRACE, RULE_COMPOUND_NAME,
+    TOK_EQUAL, RULE_EXPRESSION, TOK_IF, TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN,
+    RULE_FUNCTION_BODY, TOK_IF, TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN, RULE_FUNCTION_BODY,
+    RULE_ELSE_CLAUSE_FOLLOW, TOK_ELSE, TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN, RULE_FUNCTION_BODY,
+    RULE_ELSE_CLAUSE, RULE_ELSE_CLAUSE, TOK_ELSE, TOK_OPAREN, TOK_CPAREN, RULE_FUNCTION_BODY,
+    TOK_ELSE, RULE_FUNCTION_BODY, RULE_ELSE_CLAUSE_LIST, RULE_FINAL_ELSE_CLAUSE, RULE_FINAL_ELSE_CLAUSE, TOK_WHILE,
+    TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN, RULE_LOOP_BODY, TOK_WHILE, TOK_OPAREN,
+    TOK_CPAREN, RULE_LOOP_BODY, TOK_WHILE, RULE_LOOP_BODY, TOK_DO, RULE_LOOP_BODY,
+    TOK_WHILE, TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN, TOK_DO, RULE_LOOP_BODY,
+    TOK_WHILE, TOK_OPAREN, TOK_CPAREN, TOK_DO, RULE_LOOP_BODY, TOK_WHILE,
+    TOK_FOR, RULE_LOOP_BODY, TOK_FOR, TOK_OPAREN, TOK_CPAREN, RULE_LOOP_BODY,
+    TOK_FOR, TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN, RULE_LOOP_BODY, TOK_FOR,
+    TOK_OPAREN, TOK_IDENTIFIER, TOK_IN, RULE_EXPRESSION, TOK_CPAREN, RULE_LOOP_BODY,
+    TOK_FOR, TOK_OPAREN, RULE_TYPE_NAME, TOK_IDENTIFIER, TOK_IN, RULE_EXPRESSION,
+    TOK_CPAREN, RULE_LOOP_BODY, TOK_RETURN, TOK_RETURN, TOK_OPAREN, TOK_CPAREN,
+    TOK_RETURN, TOK_OPAREN, RULE_EXPRESSION, TOK_CPAREN, TOK_EXIT, TOK_OPAREN,
+    RULE_EXPRESSION, TOK_CPAREN,
+};
+
+// lists of productions that start with the same token, ended by -1
+static const int16_t candidates[] = {
+    3, 4, -1,
+    9, 8, -1,
+    12, 13, -1,
+    22, 21, 20, -1,
+    35, 36, -1,
+    69, 70, 71, -1,
+    76, 77, 78, -1,
+    102, 101, -1,
+    106, 107, -1,
+    108, 109, -1,
+    110, 111, 112, -1,
+    113, 114, 115, -1,
+    120, 119, 118, 117, 116, -1,
+    123, 122, 121, -1,
+};
+
+// the base production of a rule, by the token that comes next
+static const int16_t base_table[NUM_RULES][NUM_TOKENS] = {
+    // translation_unit
+    {
+        1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1,
+        1, 1, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // translation_unit_element
+    {
+        3, 0, -1, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1,
+        -1, -1, -1, 0, 5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // import_statement
+    {
+        7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // data_declaration
+    {
+        0, 0, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8,
+        8, 8, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // data_definition
+    {
+        0, 0, -4, 0, 11, 0, 0, 0, 0, 0, 0, 0, 0, -4, -4, -4,
+        -4, -4, -4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // initializer
+    {
+        0, 12, 12, 0, 0, -7, 0, 15, 0, 0, 0, 12, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 12, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 12, 0, 12, 12, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // list_initializer
+    {
+        0, 16, 16, 0, 0, 0, 0, 0, 0, 0, 0, 16, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 16, 0, 16, 16, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // dss_initializer_item
+    {
+        0, 18, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // dss_initializer
+    {
+        0, 19, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // formatted_string
+    {
+        0, -10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // type_name
+    {
+        0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 24, 25, 26,
+        27, 28, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // compound_name
+    {
+        0, 0, 31, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_name
+    {
+        0, 0, 33, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 33, 33, 33,
+        33, 33, 33, 0, 34, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_definition
+    {
+        0, 0, 35, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 35, 35, 35,
+        35, 35, 35, 0, 35, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_parameters
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -14, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_parameter_list
+    {
+        0, 0, 38, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 38, 38, 38,
+        38, 38, 38, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // struct_data_list
+    {
+        0, 0, 40, 0, 40, 0, 0, 0, 0, 0, 0, 0, 0, 40, 40, 40,
+        40, 40, 40, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // struct_body
+    {
+        0, 0, 0, 0, 0, 0, 0, 42, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // struct_definition
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // expression
+    {
+        0, 60, 60, 0, 0, 0, 0, 0, 0, 0, 0, 60, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 59, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 58, 0, 60, 60, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // primary_expression
+    {
+        0, 63, 65, 0, 0, 0, 0, 0, 0, 0, 0, 64, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 61, 62, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // expression_list
+    {
+        0, 66, 66, 0, 0, 0, 0, 0, 0, 0, 0, 66, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 66, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 66, 0, 66, 66, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // compound_reference
+    {
+        0, 0, 68, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // compound_reference_element
+    {
+        0, 0, -17, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_reference
+    {
+        0, 0, 73, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // list_reference
+    {
+        0, 0, 74, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // list_ref_parms
+    {
+        0, 0, 0, 0, 0, 75, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_body_element
+    {
+        0, 0, -21, 0, 79, 0, 0, 0, 0, 0, 0, 0, 0, 79, 79, 79,
+        79, 79, 79, 0, 0, 80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 87, 0, 0, 81, 0, 82, 83, 84,
+        0, 85, 86, 0, 0, 0,
+    },
+    // function_body_prelist
+    {
+        0, 0, 88, 0, 88, 0, 0, 89, 0, 0, 0, 0, 0, 88, 88, 88,
+        88, 88, 88, 0, 0, 88, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 88, 0, 0, 88, 0, 88, 88, 88,
+        0, 88, 88, 0, 0, 0,
+    },
+    // function_body_list
+    {
+        0, 0, 90, 0, 90, 0, 0, 90, 0, 0, 0, 0, 0, 90, 90, 90,
+        90, 90, 90, 0, 0, 90, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 90, 0, 0, 90, 0, 90, 90, 90,
+        0, 90, 90, 0, 0, 0,
+    },
+    // function_body
+    {
+        0, 0, 0, 0, 0, 0, 0, 92, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // loop_body_element
+    {
+        0, 0, 93, 0, 93, 0, 0, 0, 0, 0, 0, 0, 0, 93, 93, 93,
+        93, 93, 93, 0, 0, 93, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 93, 94, 95, 93, 0, 93, 93, 93,
+        0, 93, 93, 0, 0, 0,
+    },
+    // loop_body_prelist
+    {
+        0, 0, 96, 0, 96, 0, 0, 97, 0, 0, 0, 0, 0, 96, 96, 96,
+        96, 96, 96, 0, 0, 96, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 96, 96, 96, 96, 0, 96, 96, 96,
+        0, 96, 96, 0, 0, 0,
+    },
+    // loop_body_list
+    {
+        0, 0, 98, 0, 98, 0, 0, 98, 0, 0, 0, 0, 0, 98, 98, 98,
+        98, 98, 98, 0, 0, 98, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 98, 98, 98, 98, 0, 98, 98, 98,
+        0, 98, 98, 0, 0, 0,
+    },
+    // loop_body
+    {
+        0, 0, 0, 0, 0, 0, 0, 100, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // assignment
+    {
+        0, 0, 101, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // if_clause
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -25, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // else_clause
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 104, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // else_clause_list
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 105, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // final_else_clause
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -28, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // else_clause_follow
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -31, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // while_clause
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -34, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // do_clause
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -38, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // for_clause
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -42,
+        0, 0, 0, 0, 0, 0,
+    },
+    // return_statement
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, -48, 0, 0, 0, 0,
+    },
+    // exit_statement
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 125, 0, 0, 0,
+    },
+};
+
+// the row of tail_table of a left recursive rule, -1 for the others
+static const int8_t tail_index[NUM_RULES] = {
+        0, -1, -1, -1, -1, -1, 1, -1, 2, -1, -1, 3, -1, -1, -1, 4,
+        5, -1, -1, 6, -1, 7, 8, -1, -1, -1, 9, -1, -1, 10, -1, -1,
+        -1, 11, -1, -1, -1, -1, 12, -1, -1, -1, -1, -1, -1, -1,
+};
+
+// the tokens that can come after each rule, a bit for each token
+static const uint8_t follow_table[NUM_RULES][(NUM_TOKENS + 7) / 8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08}, // translation_unit
+    {0x15, 0xE0, 0x37, 0x00, 0x00, 0x00, 0x08}, // translation_unit_element
+    {0x15, 0xE0, 0x37, 0x00, 0x00, 0x00, 0x08}, // import_statement
+    {0x9D, 0xF3, 0x37, 0x00, 0x00, 0xEF, 0x0E}, // data_declaration
+    {0x95, 0xE1, 0x37, 0x00, 0x00, 0xEF, 0x0E}, // data_definition
+    {0x95, 0xE1, 0x37, 0x00, 0x00, 0xEF, 0x0E}, // initializer
+    {0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // list_initializer
+    {0x40, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00}, // dss_initializer_item
+    {0x40, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00}, // dss_initializer
+    {0xD5, 0xF3, 0xF7, 0xFF, 0x0F, 0xEF, 0x0E}, // formatted_string
+    {0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // type_name
+    {0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // compound_name
+    {0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00}, // function_name
+    {0x15, 0xE0, 0x37, 0x00, 0x00, 0x00, 0x08}, // function_definition
+    {0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // function_parameters
+    {0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00}, // function_parameter_list
+    {0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00}, // struct_data_list
+    {0x95, 0xE1, 0x37, 0x00, 0x00, 0xEF, 0x0E}, // struct_body
+    {0x95, 0xE1, 0x37, 0x00, 0x00, 0xEF, 0x0E}, // struct_definition
+    {0xD5, 0xF3, 0xF7, 0xFF, 0x0F, 0xEF, 0x0E}, // expression
+    {0xD5, 0xF3, 0xF7, 0xFF, 0x0F, 0xEF, 0x0E}, // primary_expression
+    {0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00}, // expression_list
+    {0xD5, 0xF3, 0xF7, 0xFF, 0x0F, 0xEF, 0x0E}, // compound_reference
+    {0xD5, 0xF3, 0xFF, 0xFF, 0x0F, 0xEF, 0x0E}, // compound_reference_element
+    {0xD5, 0xF3, 0xFF, 0xFF, 0x0F, 0xEF, 0x0E}, // function_reference
+    {0xD5, 0xF3, 0xFF, 0xFF, 0x0F, 0xEF, 0x0E}, // list_reference
+    {0xD5, 0xF3, 0xFF, 0xFF, 0x0F, 0xEF, 0x0E}, // list_ref_parms
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // function_body_element
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xE9, 0x06}, // function_body_prelist
+    {0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00}, // function_body_list
+    {0x95, 0xE1, 0x37, 0x00, 0x00, 0xFF, 0x0E}, // function_body
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // loop_body_element
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // loop_body_prelist
+    {0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00}, // loop_body_list
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // loop_body
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // assignment
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // if_clause
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00}, // else_clause
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00}, // else_clause_list
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // final_else_clause
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // else_clause_follow
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // while_clause
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // do_clause
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // for_clause
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // return_statement
+    {0x94, 0xE1, 0x27, 0x00, 0x00, 0xEF, 0x06}, // exit_statement
+};
+
+static const int16_t tail_table[NUM_TAILS][NUM_TOKENS] = {
+    // translation_unit
+    {
+        2, 0, 2, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2,
+        2, 2, 2, 0, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // list_initializer
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 17, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // dss_initializer
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 20, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // compound_name
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 32, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_parameter_list
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 39, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // struct_data_list
+    {
+        0, 0, 41, 0, 41, 0, 0, 0, 0, 0, 0, 0, 0, 41, 41, 41,
+        41, 41, 41, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // expression
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53,
+        54, 55, 56, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // expression_list
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 67, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // compound_reference
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 69, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // list_ref_parms
+    {
+        0, 0, 0, 0, 0, 76, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+    // function_body_list
+    {
+        0, 0, 91, 0, 91, 0, 0, 91, 0, 0, 0, 0, 0, 91, 91, 91,
+        91, 91, 91, 0, 0, 91, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 91, 0, 0, 91, 0, 91, 91, 91,
+        0, 91, 91, 0, 0, 0,
+    },
+    // loop_body_list
+    {
+        0, 0, 99, 0, 99, 0, 0, 99, 0, 0, 0, 0, 0, 99, 99, 99,
+        99, 99, 99, 0, 0, 99, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 99, 99, 99, 99, 0, 99, 99, 99,
+        0, 99, 99, 0, 0, 0,
+    },
+    // else_clause_list
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 106, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+    },
+};
+
+typedef struct {
+    parse_rule_t rule;
+    int16_t prod;
+    int16_t pos;
+    bool tail;
+    // the next production to try if this one fails, NULL if there is none
+    const int16_t* next;
+    // where the production started, to undo it
+    void* post;
+    ast_node_t* kept;
+    ast_node_t* node;
+} frame_t;
+
+typedef struct {
+    frame_t* frames;
+    int len;
+    int cap;
+} frame_stack_t;
+
+static const int16_t* choose(frame_t* frame, int16_t entry) {
+
+    if(entry > 0) {
+        frame->prod = entry - 1;
+        return NULL;
+    }
+
+    const int16_t* next = &candidates[-entry - 1];
+    frame->prod = *next++;
+    return (*next >= 0) ? next : NULL;
+}
+
+/*
+ * Start a production of the rule in the frame, the base or the tail, from
+ * the token that comes next. Returns false when none can start with it.
+ */
+static bool start_production(frame_t* frame, bool tail) {
+
+    int index = get_token()->type - FIRST_TOKEN;
+    int16_t entry = tail ? tail_table[tail_index[frame->rule]][index] : base_table[frame->rule][index];
+    if(entry == 0)
+        return false;
+
+    frame->next = choose(frame, entry);
+    frame->pos = 0;
+    frame->tail = tail;
+    frame->post = post_token_queue();
+    frame->kept = frame->node->last;
+    TRACE("rule %d: production %d", frame->rule, frame->prod);
+    return true;
+}
+
+static bool can_follow(parse_rule_t rule) {
+
+    int index = get_token()->type - FIRST_TOKEN;
+    return (follow_table[rule][index >> 3] & (1 << (index & 7))) != 0;
+}
+
+static bool push_rule(frame_stack_t* stack, parse_rule_t rule) {
+
+    if(stack->len == stack->cap) {
+        stack->cap = (stack->cap == 0) ? 32 : stack->cap << 1;
+        stack->frames = _REALLOC_ARRAY(stack->frames, frame_t, stack->cap);
+    }
+
+    frame_t* frame = &stack->frames[stack->len];
+    frame->rule = rule;
+    // the AST node types are in the same order as the rules
+    frame->node = create_ast_node((ast_node_type_t)rule);
+    if(!start_production(frame, false)) {
+        destroy_ast_node(frame->node);
+        return false;
+    }
+
+    stack->len++;
+    return true;
+}
+
+// take back what the production of the frame matched
+static void undo_production(frame_t* frame) {
+
+    ast_node_t* node = frame->node;
+    ast_node_t* next;
+    for(ast_node_t* child = (frame->kept != NULL) ? frame->kept->next : node->first; child != NULL; child = next) {
+        next = child->next;
+        destroy_ast_node(child);
+    }
+
+    if(frame->kept != NULL)
+        frame->kept->next = NULL;
+    else
+        node->first = NULL;
+    node->last = frame->kept;
+
+    reset_token_queue(frame->post);
+}
+
+/**
+ * @brief Parse one rule. The rules are kept on a stack of frames instead of
+ * the C stack, and the whole parse is one loop. A rule whose productions all
+ * fail leaves the tokens where they were and returns NULL.
+ *
+ * @param rule
+ * @return ast_node_t*
+ */
+ast_node_t* parse_rule(parse_rule_t rule) {
+
+    ENTER;
+
+    frame_stack_t stack = {NULL, 0, 0};
+    ast_node_t* result = NULL;
+    bool matched = push_rule(&stack, rule);
+
+    while(stack.len > 0) {
+        frame_t* frame = &stack.frames[stack.len - 1];
+        const production_t* prod = &productions[frame->prod];
+
+        if(matched && frame->pos < prod->length) {
+            uint16_t sym = symbols[prod->first + frame->pos];
+            if(IS_RULE(sym))
+                matched = push_rule(&stack, (parse_rule_t)sym);
+            else if(get_token()->type == sym) {
+                ast_node_t* leaf = create_ast_node(AST_TERMINAL);
+                leaf->token = get_token();
+                append_ast_node(frame->node, leaf);
+                advance_token();
+                frame->pos++;
+            }
+            else
+                matched = false;
+            continue;
+        }
+
+        if(!matched) {
+            undo_production(frame);
+            if(frame->next != NULL) {
+                // the next production that can start here
+                frame->prod = *frame->next++;
+                if(*frame->next < 0)
+                    frame->next = NULL;
+                frame->pos = 0;
+                matched = true;
+                continue;
+            }
+            if(!frame->tail) {
+                // the rule failed, so the production that wanted it fails
+                destroy_ast_node(frame->node);
+                stack.len--;
+                continue;
+            }
+            // a left recursive rule ends when its tail does not match
+            matched = true;
+        }
+        else if(tail_index[frame->rule] >= 0 && start_production(frame, true))
+            continue;
+        else if(frame->next != NULL && !can_follow(frame->rule)) {
+            // the production matched, but what comes next cannot follow
+            // the rule, so one that is left may read further
+            matched = false;
+            continue;
+        }
+
+        ast_node_t* node = frame->node;
+        stack.len--;
+        if(stack.len > 0) {
+            frame = &stack.frames[stack.len - 1];
+            append_ast_node(frame->node, node);
+            frame->pos++;
+        }
+        else
+            result = node;
+    }
+
+    _FREE(stack.frames);
+    RETURN(result);
+}
 
 ast_translation_unit_t* parse(void) {
 
-    ast_translation_unit_t* translation_unit = parse_translation_unit();
-    return translation_unit;
+    return parse_translation_unit();
 }
 
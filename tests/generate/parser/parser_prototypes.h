@@ -3,60 +3,110 @@
  * @file parser_prototypes.h
  *
  * @brief Internal prototypes for parser.
- * This file was generated on Wed Jul 16 21:15:55 2025.
+ * This file was generated on Mon Oct 19 14:51:14 2026.
  *
  */
 #ifndef _PARSER_PROTOTYPES_H_
 #define _PARSER_PROTOTYPES_H_
 
-#include "parser.h"
 #include "ast.h"
 
-ast_translation_unit_t* parse_translation_unit(void);
-ast_translation_unit_element_t* parse_translation_unit_element(void);
-ast_import_statement_t* parse_import_statement(void);
-ast_data_declaration_t* parse_data_declaration(void);
-ast_data_definition_t* parse_data_definition(void);
-ast_initializer_t* parse_initializer(void);
-ast_list_initializer_t* parse_list_initializer(void);
-ast_dss_initializer_item_t* parse_dss_initializer_item(void);
-ast_dss_initializer_t* parse_dss_initializer(void);
-ast_formatted_string_t* parse_formatted_string(void);
-ast_type_name_t* parse_type_name(void);
-ast_compound_name_t* parse_compound_name(void);
-ast_function_name_t* parse_function_name(void);
-ast_function_definition_t* parse_function_definition(void);
-ast_function_parameters_t* parse_function_parameters(void);
-ast_function_parameter_list_t* parse_function_parameter_list(void);
-ast_struct_data_list_t* parse_struct_data_list(void);
-ast_struct_body_t* parse_struct_body(void);
-ast_struct_definition_t* parse_struct_definition(void);
-ast_expression_t* parse_expression(void);
-ast_primary_expression_t* parse_primary_expression(void);
-ast_expression_list_t* parse_expression_list(void);
-ast_compound_reference_t* parse_compound_reference(void);
-ast_compound_reference_element_t* parse_compound_reference_element(void);
-ast_function_reference_t* parse_function_reference(void);
-ast_list_reference_t* parse_list_reference(void);
-ast_function_body_element_t* parse_function_body_element(void);
-ast_function_body_prelist_t* parse_function_body_prelist(void);
-ast_function_body_list_t* parse_function_body_list(void);
-ast_function_body_t* parse_function_body(void);
-ast_loop_body_element_t* parse_loop_body_element(void);
-ast_loop_body_prelist_t* parse_loop_body_prelist(void);
-ast_loop_body_list_t* parse_loop_body_list(void);
-ast_loop_body_t* parse_loop_body(void);
-ast_assignment_t* parse_assignment(void);
-ast_if_clause_t* parse_if_clause(void);
-ast_else_clause_t* parse_else_clause(void);
-ast_else_clause_list_t* parse_else_clause_list(void);
-ast_final_else_clause_t* parse_final_else_clause(void);
-ast_else_clause_follow_t* parse_else_clause_follow(void);
-ast_while_clause_t* parse_while_clause(void);
-ast_do_clause_t* parse_do_clause(void);
-ast_for_clause_t* parse_for_clause(void);
-ast_return_statement_t* parse_return_statement(void);
-ast_exit_statement_t* parse_exit_statement(void);
+typedef enum {
+    RULE_TRANSLATION_UNIT,
+    RULE_TRANSLATION_UNIT_ELEMENT,
+    RULE_IMPORT_STATEMENT,
+    RULE_DATA_DECLARATION,
+    RULE_DATA_DEFINITION,
+    RULE_INITIALIZER,
+    RULE_LIST_INITIALIZER,
+    RULE_DSS_INITIALIZER_ITEM,
+    RULE_DSS_INITIALIZER,
+    RULE_FORMATTED_STRING,
+    RULE_TYPE_NAME,
+    RULE_COMPOUND_NAME,
+    RULE_FUNCTION_NAME,
+    RULE_FUNCTION_DEFINITION,
+    RULE_FUNCTION_PARAMETERS,
+    RULE_FUNCTION_PARAMETER_LIST,
+    RULE_STRUCT_DATA_LIST,
+    RULE_STRUCT_BODY,
+    RULE_STRUCT_DEFINITION,
+    RULE_EXPRESSION,
+    RULE_PRIMARY_EXPRESSION,
+    RULE_EXPRESSION_LIST,
+    RULE_COMPOUND_REFERENCE,
+    RULE_COMPOUND_REFERENCE_ELEMENT,
+    RULE_FUNCTION_REFERENCE,
+    RULE_LIST_REFERENCE,
+    RULE_LIST_REF_PARMS,
+    RULE_FUNCTION_BODY_ELEMENT,
+    RULE_FUNCTION_BODY_PRELIST,
+    RULE_FUNCTION_BODY_LIST,
+    RULE_FUNCTION_BODY,
+    RULE_LOOP_BODY_ELEMENT,
+    RULE_LOOP_BODY_PRELIST,
+    RULE_LOOP_BODY_LIST,
+    RULE_LOOP_BODY,
+    RULE_ASSIGNMENT,
+    RULE_IF_CLAUSE,
+    RULE_ELSE_CLAUSE,
+    RULE_ELSE_CLAUSE_LIST,
+    RULE_FINAL_ELSE_CLAUSE,
+    RULE_ELSE_CLAUSE_FOLLOW,
+    RULE_WHILE_CLAUSE,
+    RULE_DO_CLAUSE,
+    RULE_FOR_CLAUSE,
+    RULE_RETURN_STATEMENT,
+    RULE_EXIT_STATEMENT,
+    NUM_RULES,
+} parse_rule_t;
+
+#define parse_translation_unit() ((ast_translation_unit_t*)parse_rule(RULE_TRANSLATION_UNIT))
+#define parse_translation_unit_element() ((ast_translation_unit_element_t*)parse_rule(RULE_TRANSLATION_UNIT_ELEMENT))
+#define parse_import_statement() ((ast_import_statement_t*)parse_rule(RULE_IMPORT_STATEMENT))
+#define parse_data_declaration() ((ast_data_declaration_t*)parse_rule(RULE_DATA_DECLARATION))
+#define parse_data_definition() ((ast_data_definition_t*)parse_rule(RULE_DATA_DEFINITION))
+#define parse_initializer() ((ast_initializer_t*)parse_rule(RULE_INITIALIZER))
+#define parse_list_initializer() ((ast_list_initializer_t*)parse_rule(RULE_LIST_INITIALIZER))
+#define parse_dss_initializer_item() ((ast_dss_initializer_item_t*)parse_rule(RULE_DSS_INITIALIZER_ITEM))
+#define parse_dss_initializer() ((ast_dss_initializer_t*)parse_rule(RULE_DSS_INITIALIZER))
+#define parse_formatted_string() ((ast_formatted_string_t*)parse_rule(RULE_FORMATTED_STRING))
+#define parse_type_name() ((ast_type_name_t*)parse_rule(RULE_TYPE_NAME))
+#define parse_compound_name() ((ast_compound_name_t*)parse_rule(RULE_COMPOUND_NAME))
+#define parse_function_name() ((ast_function_name_t*)parse_rule(RULE_FUNCTION_NAME))
+#define parse_function_definition() ((ast_function_definition_t*)parse_rule(RULE_FUNCTION_DEFINITION))
+#define parse_function_parameters() ((ast_function_parameters_t*)parse_rule(RULE_FUNCTION_PARAMETERS))
+#define parse_function_parameter_list() ((ast_function_parameter_list_t*)parse_rule(RULE_FUNCTION_PARAMETER_LIST))
+#define parse_struct_data_list() ((ast_struct_data_list_t*)parse_rule(RULE_STRUCT_DATA_LIST))
+#define parse_struct_body() ((ast_struct_body_t*)parse_rule(RULE_STRUCT_BODY))
+#define parse_struct_definition() ((ast_struct_definition_t*)parse_rule(RULE_STRUCT_DEFINITION))
+#define parse_expression() ((ast_expression_t*)parse_rule(RULE_EXPRESSION))
+#define parse_primary_expression() ((ast_primary_expression_t*)parse_rule(RULE_PRIMARY_EXPRESSION))
+#define parse_expression_list() ((ast_expression_list_t*)parse_rule(RULE_EXPRESSION_LIST))
+#define parse_compound_reference() ((ast_compound_reference_t*)parse_rule(RULE_COMPOUND_REFERENCE))
+#define parse_compound_reference_element() ((ast_compound_reference_element_t*)parse_rule(RULE_COMPOUND_REFERENCE_ELEMENT))
+#define parse_function_reference() ((ast_function_reference_t*)parse_rule(RULE_FUNCTION_REFERENCE))
+#define parse_list_reference() ((ast_list_reference_t*)parse_rule(RULE_LIST_REFERENCE))
+#define parse_list_ref_parms() ((ast_list_ref_parms_t*)parse_rule(RULE_LIST_REF_PARMS))
+#define parse_function_body_element() ((ast_function_body_element_t*)parse_rule(RULE_FUNCTION_BODY_ELEMENT))
+#define parse_function_body_prelist() ((ast_function_body_prelist_t*)parse_rule(RULE_FUNCTION_BODY_PRELIST))
+#define parse_function_body_list() ((ast_function_body_list_t*)parse_rule(RULE_FUNCTION_BODY_LIST))
+#define parse_function_body() ((ast_function_body_t*)parse_rule(RULE_FUNCTION_BODY))
+#define parse_loop_body_element() ((ast_loop_body_element_t*)parse_rule(RULE_LOOP_BODY_ELEMENT))
+#define parse_loop_body_prelist() ((ast_loop_body_prelist_t*)parse_rule(RULE_LOOP_BODY_PRELIST))
+#define parse_loop_body_list() ((ast_loop_body_list_t*)parse_rule(RULE_LOOP_BODY_LIST))
+#define parse_loop_body() ((ast_loop_body_t*)parse_rule(RULE_LOOP_BODY))
+#define parse_assignment() ((ast_assignment_t*)parse_rule(RULE_ASSIGNMENT))
+#define parse_if_clause() ((ast_if_clause_t*)parse_rule(RULE_IF_CLAUSE))
+#define parse_else_clause() ((ast_else_clause_t*)parse_rule(RULE_ELSE_CLAUSE))
+#define parse_else_clause_list() ((ast_else_clause_list_t*)parse_rule(RULE_ELSE_CLAUSE_LIST))
+#define parse_final_else_clause() ((ast_final_else_clause_t*)parse_rule(RULE_FINAL_ELSE_CLAUSE))
+#define parse_else_clause_follow() ((ast_else_clause_follow_t*)parse_rule(RULE_ELSE_CLAUSE_FOLLOW))
+#define parse_while_clause() ((ast_while_clause_t*)parse_rule(RULE_WHILE_CLAUSE))
+#define parse_do_clause() ((ast_do_clause_t*)parse_rule(RULE_DO_CLAUSE))
+#define parse_for_clause() ((ast_for_clause_t*)parse_rule(RULE_FOR_CLAUSE))
+#define parse_return_statement() ((ast_return_statement_t*)parse_rule(RULE_RETURN_STATEMENT))
+#define parse_exit_statement() ((ast_exit_statement_t*)parse_rule(RULE_EXIT_STATEMENT))
 
 #endif /* _PARSER_PROTOTYPES_H_ */
 
@@ -1,65 +0,0 @@
-/**
- *
- * @file translation_unit_element.c
- *
- * @brief Parse grammar production translation_unit_element.
- * This file was generated on Wed Jul 16 21:15:55 2025.
- *
- */
-#include "tokens.h"
-#include "trace.h"
-#include "parser.h"
-
-/**
- * translation_unit_element
- *     : import_statement
- *     | data_definition
- *     | function_definition
- *     | struct_definition
- *     ;
- */
-ast_translation_unit_element_t* parse_translation_unit_element(void) {
-
-    ENTER;
-
-    ast_translation_unit_element_t* node = NULL;
-    int state = STATE_START;
-    bool finished = false;
-    void* post = post_token_queue();
-
-    while(!finished) {
-        switch(state) {
-            case STATE_START:
-                // initial state
-                STATE;
-                break;
-
-            case STATE_MATCH:
-                // production recognized
-                STATE;
-                node = (ast_translation_unit_element_t*)create_ast_node(AST_TRANSLATION_UNIT_ELEMENT);
-                finished = true;
-                break;
-
-            case STATE_NO_MATCH:
-                // not a match, not an error
-                STATE;
-                reset_token_queue(post);
-                finished = true;
-                break;
-
-            case STATE_ERROR:
-                // error found
-                STATE;
-                recover_error();
-                finished = true;
-                break;
-
-            default:
-                FATAL("unknown state: %d", state);
-        }
-    }
-
-    RETURN(node);
-}
-
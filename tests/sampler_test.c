@@ -0,0 +1,87 @@
+/**
+ * @file sampler_test.c
+ *
+ * @brief Check that the sampler puts the samples on the right function
+ * after a deep recursion has returned. "hot" is called at a depth of 100,
+ * calls "deep" until the stack is 300 frames, and then runs by itself once
+ * they have returned. All of the samples taken then have to be in "hot".
+ *
+ */
+#include <stdio.h>
+#include <time.h>
+
+#include "sampler.h"
+
+#define FUNC_MAIN 0
+#define FUNC_FILL 1
+#define FUNC_HOT 2
+#define FUNC_DEEP 3
+
+static double cpu_time(void) {
+
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void deep(int count) {
+
+    sample_call(FUNC_DEEP);
+    sample_pc(0);
+    if(count > 0)
+        deep(count - 1);
+    sample_return();
+}
+
+static void hot(void) {
+
+    sample_call(FUNC_HOT);
+    deep(200);
+
+    volatile unsigned long sum = 0;
+    double start = cpu_time();
+    while(cpu_time() - start < 0.5) {
+        for(int i = 0; i < 100000; i++) {
+            sample_pc(i & 3);
+            sum += (unsigned long)i * i;
+        }
+    }
+    sample_return();
+}
+
+int main(void) {
+
+    module_t* mod = create_module(4, 0, 0);
+    const char* names[] = { "main", "fill", "hot", "deep" };
+    for(int i = 0; i < 4; i++) {
+        mod->functions[i].name = names[i];
+        add_line(&mod->functions[i], 10 * (i + 1), 1);
+        for(int j = 0; j < 4; j++)
+            emit_code(&mod->functions[i], OP_NOP, 0, 0);
+    }
+
+    sampler_t* smp = start_sampler(mod, "test.toy", 1000);
+    if(smp == NULL)
+        return 1;
+
+    sample_call(FUNC_MAIN);
+    for(int i = 1; i < 100; i++)
+        sample_call(FUNC_FILL);
+    hot();
+    stop_sampler(smp);
+
+    int status = 0;
+    uint64_t in_hot = 0;
+    for(int i = 0; i < smp->nlines; i++) {
+        if(smp->lines[i].func == FUNC_HOT)
+            in_hot += smp->lines[i].count;
+    }
+    print_hot_lines(smp, stdout, 4);
+    if(in_hot == 0 || in_hot * 10 < smp->samples * 9) {
+        printf("%llu of %llu samples in hot\n", (unsigned long long)in_hot, (unsigned long long)smp->samples);
+        status = 1;
+    }
+
+    destroy_sampler(smp);
+    free_sample_stack();
+    destroy_module(mod);
+    return status;
+}